@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "dead_reckoning.h"
+#include "gpsmod.h"
+
+// Reads the fixes of a GPS from gpsd, e.g. of a log replayed by gpsfake, and compares the Location at
+// the time of each fix that the transmitter extrapolates from the previous fix, or holds without dead
+// reckoning, with the fix itself.
+
+#define BENCH_DEFAULT_FIXES 100
+#define BENCH_MAX_FIXES 10000
+#define BENCH_TIMEOUT_SECS 5 // Without a new fix
+
+struct fix_record {
+    ODID_Location_data location;
+    double time;    // Of the fix, in seconds
+};
+
+struct errors {
+    double sum, max;
+    int count;
+};
+
+static struct fix_record fixes[BENCH_MAX_FIXES];
+
+static void add_error(struct errors *errors, double error) {
+    errors->sum += error;
+    if (error > errors->max)
+        errors->max = error;
+    errors->count++;
+}
+
+static void print_errors(const char *name, const struct errors *errors) {
+    if (errors->count)
+        printf("  %-28s avg %7.2f m, max %7.2f m\n", name, errors->sum / errors->count, errors->max);
+}
+
+static int read_fixes(int wanted) {
+    struct fixsource_t source;
+    struct gps_data_t gpsdata;
+    struct gps_last_fix last_fix = { 0 };
+    char message[GPS_JSON_RESPONSE_MAX];
+    ODID_UAS_Data uasData;
+    int count = 0, idle = 0;
+
+    if (init_gps(&source, &gpsdata, true) != 0) {
+        fprintf(stderr, "No gpsd running or network error: %d, %s\n", errno, gps_errstr(errno));
+        return -1;
+    }
+
+    odid_initUasData(&uasData);
+    while (count < wanted && idle < BENCH_TIMEOUT_SECS * 2) {
+        if (!wait_gps_data(&gpsdata, &last_fix, GPS_WAIT_TIME_MICROSECS)) {
+            idle++;
+            continue;
+        }
+        if (gps_read(&gpsdata, message, sizeof(message)) == -1)
+            break;
+        if (!is_new_gps_fix(&gpsdata, &last_fix) || !process_gps_data(&gpsdata, &uasData))
+            continue;
+
+        idle = 0;
+        fixes[count].location = uasData.Location;
+        fixes[count].time = (double) gpsdata.fix.time.tv_sec + (double) gpsdata.fix.time.tv_nsec * 1e-9;
+        count++;
+    }
+
+    gps_close(&gpsdata);
+    return count;
+}
+
+int main(int argc, char *argv[]) {
+    int wanted = BENCH_DEFAULT_FIXES;
+
+    if (argc > 1)
+        wanted = atoi(argv[1]);
+    if (wanted < 2 || wanted > BENCH_MAX_FIXES) {
+        fprintf(stderr, "Usage: %s [fixes, 2 - %d]\n", argv[0], BENCH_MAX_FIXES);
+        return 1;
+    }
+
+    int count = read_fixes(wanted);
+    if (count < 2) {
+        fprintf(stderr, "Not enough fixes from gpsd\n");
+        return 1;
+    }
+
+    struct errors held = { 0 }, extrapolated = { 0 }, held_alt = { 0 }, extrapolated_alt = { 0 };
+    int moving = 0, within = 0, known = 0;
+    double interval = 0;
+    for (int i = 1; i < count; i++) {
+        const struct fix_record *last = &fixes[i - 1], *next = &fixes[i];
+        double secs = next->time - last->time;
+        if (!(secs > 0) || secs > DEAD_RECKONING_MAX_SECS)
+            continue;
+
+        ODID_Location_data location;
+        dead_reckoning_extrapolate(&last->location, secs, &location);
+        interval += secs;
+        if (last->location.SpeedHorizontal <= MAX_SPEED_H && last->location.SpeedHorizontal > 0)
+            moving++;
+
+        double error = dead_reckoning_distance(&location, &next->location);
+        add_error(&held, dead_reckoning_distance(&last->location, &next->location));
+        add_error(&extrapolated, error);
+        if (location.HorizAccuracy != ODID_HOR_ACC_UNKNOWN) {
+            known++;
+            if (error <= decodeHorizontalAccuracy(location.HorizAccuracy))
+                within++;
+        }
+
+        if (last->location.AltitudeGeo > INV_ALT && next->location.AltitudeGeo > INV_ALT) {
+            add_error(&held_alt, fabsf(next->location.AltitudeGeo - last->location.AltitudeGeo));
+            add_error(&extrapolated_alt, fabsf(next->location.AltitudeGeo - location.AltitudeGeo));
+        }
+    }
+
+    if (!held.count) {
+        fprintf(stderr, "No fixes within %.1f s of each other\n", DEAD_RECKONING_MAX_SECS);
+        return 1;
+    }
+    printf("%d fixes, %.2f s apart on average, %d moving, Location at the time of the next fix\n",
+           count, interval / held.count, moving);
+    print_errors("held position:", &held);
+    print_errors("extrapolated position:", &extrapolated);
+    print_errors("held altitude:", &held_alt);
+    print_errors("extrapolated altitude:", &extrapolated_alt);
+    if (known)
+        printf("  %d of %d extrapolated positions within their horizontal accuracy\n", within, known);
+    return 0;
+}
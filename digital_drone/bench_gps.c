@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "gpsmod.h"
+
+// Compares reading the fixes from the gpsd shared memory export with the JSON socket. Both readers run at
+// the same time against one gpsd, e.g. started by gpsfake, so they see the same fixes.
+
+#define BENCH_DEFAULT_FIXES 200
+#define BENCH_MAX_FIXES 10000
+#define BENCH_TIMEOUT_SECS 5 // Without a new fix
+
+struct fix_record {
+    timespec_t time;    // Of the fix
+    timespec_t online;  // When gpsd read the data from the GPS, only known in the shared memory
+    timespec_t seen;    // When the reader had the fix
+};
+
+struct reader {
+    const char *name;
+    bool shm;
+    struct gps_data_t gpsdata;
+    struct fix_record fixes[BENCH_MAX_FIXES];
+    int count;
+    double cpu_seconds;
+    int status;
+};
+
+static int wanted_fixes = BENCH_DEFAULT_FIXES;
+static struct reader readers[2] = {
+    { .name = "shared memory", .shm = true },
+    { .name = "JSON socket", .shm = false },
+};
+
+static double seconds(const timespec_t *ts) {
+    return (double) ts->tv_sec + (double) ts->tv_nsec * 1e-9;
+}
+
+static void *read_fixes(void *arg) {
+    struct reader *reader = arg;
+    struct gps_data_t *gpsdata = &reader->gpsdata;
+    char message[GPS_JSON_RESPONSE_MAX];
+    struct gps_last_fix last_fix = { 0 };
+    timespec_t start, end;
+    int idle = 0;
+
+    if (reader->shm) {
+        if (gps_open(GPSD_SHARED_MEMORY, NULL, gpsdata) != 0) {
+            fprintf(stderr, "No gpsd shared memory export\n");
+            reader->status = 1;
+            return NULL;
+        }
+    } else {
+        if (gps_open("localhost", DEFAULT_GPSD_PORT, gpsdata) != 0) {
+            fprintf(stderr, "No gpsd socket: %s\n", gps_errstr(errno));
+            reader->status = 1;
+            return NULL;
+        }
+        gps_stream(gpsdata, WATCH_ENABLE | WATCH_JSON, NULL);
+    }
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+    while (reader->count < wanted_fixes && idle < BENCH_TIMEOUT_SECS * 2) {
+        if (!wait_gps_data(gpsdata, &last_fix, GPS_WAIT_TIME_MICROSECS)) {
+            idle++;
+            continue;
+        }
+        if (gps_read(gpsdata, message, sizeof(message)) == -1) {
+            reader->status = 1;
+            break;
+        }
+        if (gpsdata->fix.mode < MODE_2D || !is_new_gps_fix(gpsdata, &last_fix))
+            continue;
+
+        idle = 0;
+        struct fix_record *record = &reader->fixes[reader->count++];
+        clock_gettime(CLOCK_REALTIME, &record->seen);
+        record->time = gpsdata->fix.time;
+        record->online = gpsdata->online;
+    }
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+    reader->cpu_seconds = seconds(&end) - seconds(&start);
+
+    gps_close(gpsdata);
+    return NULL;
+}
+
+// gpsd's time of reading a fix from the GPS, as seen in the shared memory
+static const struct fix_record *find_shm_fix(const timespec_t *time) {
+    for (int i = 0; i < readers[0].count; i++) {
+        const struct fix_record *record = &readers[0].fixes[i];
+        if (record->time.tv_sec == time->tv_sec && record->time.tv_nsec == time->tv_nsec)
+            return record;
+    }
+    return NULL;
+}
+
+static void print_results(struct reader *reader) {
+    double sum = 0, max = 0;
+    int matched = 0;
+
+    for (int i = 0; i < reader->count; i++) {
+        const struct fix_record *shm = find_shm_fix(&reader->fixes[i].time);
+        if (!shm || (shm->online.tv_sec == 0 && shm->online.tv_nsec == 0))
+            continue;
+        double latency = seconds(&reader->fixes[i].seen) - seconds(&shm->online);
+        sum += latency;
+        if (latency > max)
+            max = latency;
+        matched++;
+    }
+
+    printf("  %-14s %5d fixes", reader->name, reader->count);
+    if (matched)
+        printf(", latency avg %7.1f us, max %7.1f us", sum / matched * 1e6, max * 1e6);
+    if (reader->count)
+        printf(", CPU %6.1f us per fix", reader->cpu_seconds / reader->count * 1e6);
+    printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+    pthread_t threads[2];
+
+    if (argc > 1)
+        wanted_fixes = atoi(argv[1]);
+    if (wanted_fixes < 1 || wanted_fixes > BENCH_MAX_FIXES) {
+        fprintf(stderr, "Usage: %s [fixes, 1 - %d]\n", argv[0], BENCH_MAX_FIXES);
+        return 1;
+    }
+
+    for (int i = 0; i < 2; i++)
+        pthread_create(&threads[i], NULL, read_fixes, &readers[i]);
+    for (int i = 0; i < 2; i++)
+        pthread_join(threads[i], NULL);
+
+    printf("Reading %d GPS fixes from gpsd, latency from gpsd reading the GPS to the reader having the fix\n",
+           wanted_fixes);
+    for (int i = 0; i < 2; i++)
+        print_results(&readers[i]);
+
+    return readers[0].status || readers[1].status;
+}
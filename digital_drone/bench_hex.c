@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "utils.h"
+
+// The largest vendor specific element of a Beacon: header and a message pack of 9 messages
+#define BENCH_SIZE (7 + 3 + ODID_PACK_MAX_MESSAGES*ODID_MESSAGE_SIZE)
+#define BENCH_ROUNDS 200000
+#define BENCH_DUMP_ROUNDS 20000
+
+static uint8_t data[BENCH_SIZE];
+static uint8_t decoded[BENCH_SIZE];
+static char hex[2*BENCH_SIZE + 1];
+static char reference[2*BENCH_SIZE + 1];
+static char spaced[3*BENCH_SIZE + 1];
+static char dump[HEX_DUMP_SIZE(BENCH_SIZE)];
+
+// The encoding before the table, one branch per nibble
+static void branch_encode(char *out, const uint8_t *in, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        unsigned char high = in[i] >> 4, low = in[i] & 0x0F;
+        out[2*i] = (char) (high < 0xA ? 0x30 + high : 0x41 + high - 0xA);
+        out[2*i + 1] = (char) (low < 0xA ? 0x30 + low : 0x41 + low - 0xA);
+    }
+}
+
+static double elapsed_seconds(struct timespec *start, struct timespec *end) {
+    return (double) (end->tv_sec - start->tv_sec) + (double) (end->tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+typedef void (*encode_fn)(char *out, const uint8_t *in, size_t len);
+
+static double bench_encode(encode_fn encode, int *failures) {
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        data[0] = (uint8_t) r; // As the message counter changes
+        encode(hex, data, BENCH_SIZE);
+        __asm__ volatile("" : : "r"(hex) : "memory");
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    branch_encode(reference, data, BENCH_SIZE);
+    if (memcmp(hex, reference, 2*BENCH_SIZE) != 0)
+        (*failures)++;
+    return elapsed_seconds(&start, &end);
+}
+
+int main(int argc __attribute__((unused)), char const *argv[] __attribute__((unused))) {
+    struct timespec start, end;
+    double branchTime, tableTime, simdTime, sscanfTime, decodeTime, fprintfTime, dumpTime;
+    int failures = 0;
+    FILE *null = fopen("/dev/null", "w");
+
+    for (int i = 0; i < BENCH_SIZE; i++)
+        data[i] = (uint8_t) (i * 37 + 11);
+
+    branchTime = bench_encode(branch_encode, &failures);
+    tableTime = bench_encode(hex_encode_scalar, &failures);
+    simdTime = bench_encode(hex_encode, &failures);
+
+    // Decoding the space separated dumps, as the ESP32 test sketch did with sscanf
+    for (int i = 0; i < BENCH_SIZE; i++)
+        snprintf(&spaced[3*i], 4, "%02X ", data[i]);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_DUMP_ROUNDS; r++) {
+        for (int i = 0; i < BENCH_SIZE; i++)
+            sscanf(&spaced[3*i], "%2hhx", &decoded[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    sscanfTime = elapsed_seconds(&start, &end);
+    if (memcmp(decoded, data, BENCH_SIZE) != 0)
+        failures++;
+
+    memset(decoded, 0, sizeof(decoded));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_DUMP_ROUNDS; r++) {
+        if (hex_decode(decoded, sizeof(decoded), spaced, 3*BENCH_SIZE) != BENCH_SIZE)
+            failures++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    decodeTime = elapsed_seconds(&start, &end);
+    if (memcmp(decoded, data, BENCH_SIZE) != 0)
+        failures++;
+
+    // Dumping captured payloads, as payload_scan did with one fprintf per byte
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_DUMP_ROUNDS; r++) {
+        for (int i = 0; i < BENCH_SIZE; i++) {
+            fprintf(null, "%02x ", data[i]);
+            if ((i + 1) % HEX_DUMP_LINE_BYTES == 0)
+                fprintf(null, "\n");
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fprintfTime = elapsed_seconds(&start, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_DUMP_ROUNDS; r++)
+        fwrite(dump, hex_dump(dump, data, BENCH_SIZE), 1, null);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    dumpTime = elapsed_seconds(&start, &end);
+    fclose(null);
+
+    printf("Hex encoding of a %d byte vendor specific element, %d rounds\n", BENCH_SIZE, BENCH_ROUNDS);
+    printf("  branch per nibble: %8.1f MB/s\n", BENCH_SIZE * (double) BENCH_ROUNDS / branchTime / 1e6);
+    printf("  table:             %8.1f MB/s\n", BENCH_SIZE * (double) BENCH_ROUNDS / tableTime / 1e6);
+    printf("  hex_encode:        %8.1f MB/s\n", BENCH_SIZE * (double) BENCH_ROUNDS / simdTime / 1e6);
+
+    printf("\nHex decoding of the space separated dump, %d rounds\n", BENCH_DUMP_ROUNDS);
+    printf("  sscanf per byte:   %8.1f MB/s\n", BENCH_SIZE * (double) BENCH_DUMP_ROUNDS / sscanfTime / 1e6);
+    printf("  hex_decode:        %8.1f MB/s\n", BENCH_SIZE * (double) BENCH_DUMP_ROUNDS / decodeTime / 1e6);
+
+    printf("\nHex dump to a file, %d rounds\n", BENCH_DUMP_ROUNDS);
+    printf("  fprintf per byte:  %8.1f MB/s\n", BENCH_SIZE * (double) BENCH_DUMP_ROUNDS / fprintfTime / 1e6);
+    printf("  hex_dump + fwrite: %8.1f MB/s\n", BENCH_SIZE * (double) BENCH_DUMP_ROUNDS / dumpTime / 1e6);
+
+    if (failures) {
+        printf("  FAILURES: %d\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -10,6 +10,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <errno.h>
 #include <time.h>
@@ -20,9 +21,35 @@
 #include <lib/hci_lib.h>
 
 #include "bluetooth.h"
+#include "hci_engine.h"
 #include "print_bt_features.h"
 
 int device_descriptor = 0;
+static int supported_advertising_sets = 0;
+static int advertising_sets = 0; // The sets of bluetooth_add_advertising_set() have the handles 0 to advertising_sets - 1
+
+// LE Set Extended Advertising Enable enables each set with { Advertising_Handle, Duration (2 octets),
+// Max_Extended_Advertising_Events } in at most 255 octets of command parameters
+#define MAX_ENABLE_SETS ((255 - 2) / 4)
+static struct hci_engine engine;
+
+/*
+ * The message packs of a set with Periodic Advertising. The HCI engine holds the command of the
+ * pack on its way to the controller, the back buffer the next one. A newer pack replaces a
+ * waiting one, so the controller always gets the latest pack and outdated packs don't pile up.
+ */
+struct periodic_set {
+    bool enabled;
+    bool busy;          // A LE Set Periodic Advertising Data command is in flight
+    bool waiting;       // The back buffer holds the next pack
+    uint8_t back[3 + BT_ADVERTISING_DATA_MAX]; // Command parameters of the next pack
+    int back_length;
+    uint64_t sent;
+    uint64_t replaced;  // Packs that were replaced by a newer one before they were sent
+};
+
+static struct periodic_set periodic_sets[MAX_ENABLE_SETS];
+static pthread_mutex_t periodic_lock = PTHREAD_MUTEX_INITIALIZER;
 
 static int open_hci_device() {
     struct hci_filter flt; // Host Controller Interface filter
@@ -48,53 +75,42 @@ static int open_hci_device() {
     return dd;
 }
 
-static void send_cmd(int dd, uint8_t ogf, uint16_t ocf, uint8_t *cmd_data, int length) {
-    if (hci_send_cmd(dd, ogf, ocf, length, cmd_data) < 0)
-        exit(EXIT_FAILURE);
+static void print_command_error(uint16_t opcode, uint8_t status) {
+    uint16_t ocf = cmd_opcode_ocf(opcode);
+    if (status && ocf != 0x3D) // Clearing the sets fails on controllers without Extended Advertising
+        printf("Command 0x%X returned error 0x%X\n", ocf, status);
+}
 
-    unsigned char buf[HCI_MAX_EVENT_SIZE] = { 0 }, *ptr;
-    uint16_t opcode = htobs(cmd_opcode_pack(ogf, ocf));
-    hci_event_hdr *hdr = (void *) (buf + 1);
-    evt_cmd_complete *cc;
-    ssize_t len;
-    while ((len = read(dd, buf, sizeof(buf))) < 0) {
-        if (errno == EAGAIN || errno == EINTR)
-            continue;
-        printf("While loop for reading event failed\n");
+// Sends a command and waits for its completion. Used for the setup, which depends on the results
+static void send_cmd(uint8_t ogf, uint16_t ocf, uint8_t *cmd_data, int length) {
+    uint8_t rparam[HCI_MAX_EVENT_SIZE];
+    int status = hci_engine_request(&engine, cmd_opcode_pack(ogf, ocf), cmd_data, length, rparam, sizeof(rparam));
+    if (status < 0)
         return;
-    }
 
-    hdr = (void *) (buf + 1);
-    ptr = buf + (1 + HCI_EVENT_HDR_SIZE);
-    len -= (1 + HCI_EVENT_HDR_SIZE);
-
-    switch (hdr->evt) {
-        case EVT_CMD_COMPLETE:
-            cc = (void *) ptr;
-
-            if (cc->opcode != opcode)
-                printf("Received event with invalid opcode 0x%X. Expected 0x%X\n", cc->opcode, opcode);
-
-            ptr += EVT_CMD_COMPLETE_SIZE;
-            len -= EVT_CMD_COMPLETE_SIZE;
-
-            uint8_t rparam[10] = { 0 };
-            memcpy(rparam, ptr, len);
-            if (rparam[0] && ocf != 0x3C)
-                printf("Command 0x%X returned error 0x%X\n", ocf, rparam[0]);
-            if (ocf == OCF_LE_READ_LOCAL_SUPPORTED_FEATURES) {
-                printf("Supported Low Energy Bluetooth features:\n");
-                print_bt_le_features(&rparam[1]);
-            }
-            if (ocf == 0x36)
-                printf("The transmit power is set to %d dBm\n", (unsigned char) rparam[1]);
-            fflush(stdout);
-            return;
-
-        default:
-            printf("Received unknown event: 0x%X\n", hdr->evt);
-            return;
+    print_command_error(cmd_opcode_pack(ogf, ocf), status);
+    if (ocf == OCF_LE_READ_LOCAL_SUPPORTED_FEATURES) {
+        printf("Supported Low Energy Bluetooth features:\n");
+        print_bt_le_features(&rparam[1]);
     }
+    if (ocf == 0x36)
+        printf("The transmit power is set to %d dBm\n", (unsigned char) rparam[1]);
+    if (ocf == 0x3B && status == 0)
+        supported_advertising_sets = rparam[1];
+    fflush(stdout);
+}
+
+static void command_done(void *arg __attribute__((unused)), uint16_t opcode, uint8_t status,
+                         const uint8_t *rparams __attribute__((unused)), int len __attribute__((unused))) {
+    print_command_error(opcode, status);
+}
+
+/*
+ * Queues a command without waiting for the controller, so the advertising data of several
+ * sets can be updated back to back. Errors are printed when the command completes.
+ */
+static void send_cmd_async(uint8_t ogf, uint16_t ocf, uint8_t *cmd_data, int length) {
+    hci_engine_send(&engine, cmd_opcode_pack(ogf, ocf), cmd_data, length, command_done, NULL);
 }
 
 static void generate_random_mac_address(uint8_t *mac) {
@@ -114,19 +130,19 @@ static void generate_random_mac_address(uint8_t *mac) {
  * (In version 5.2, they appear to have been moved to Vol 4, Part E, Chapter 7.8).
  */
 
-static void hci_reset(int dd) {
+static void hci_reset() {
     uint8_t ogf = OGF_HOST_CTL; // Opcode Group Field. LE Controller Commands
     uint16_t ocf = OCF_RESET;
-    send_cmd(dd, ogf, ocf, NULL, 0);
+    send_cmd(ogf, ocf, NULL, 0);
 }
 
-static void hci_le_read_local_supported_features(int dd) {
+static void hci_le_read_local_supported_features() {
     uint8_t ogf = OGF_LE_CTL; // Opcode Group Field. LE Controller Commands
     uint16_t ocf = OCF_LE_READ_LOCAL_SUPPORTED_FEATURES;
-    send_cmd(dd, ogf, ocf, NULL, 0);
+    send_cmd(ogf, ocf, NULL, 0);
 }
 
-static void hci_le_set_random_address(int dd, const uint8_t *mac) {
+static void hci_le_set_random_address(const uint8_t *mac) {
     if (!mac)
         return;
     uint8_t ogf = OGF_LE_CTL; // Opcode Group Field. LE Controller Commands
@@ -134,10 +150,10 @@ static void hci_le_set_random_address(int dd, const uint8_t *mac) {
     uint8_t buf[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }; // Random_Address:
     for (int i = 0; i < 6; i++)
         buf[i] = mac[i];
-    send_cmd(dd, ogf, ocf, buf, sizeof(buf));
+    send_cmd(ogf, ocf, buf, sizeof(buf));
 }
 
-static void hci_le_set_advertising_parameters(int dd, int interval_ms) {
+static void hci_le_set_advertising_parameters(int interval_ms) {
     uint8_t ogf = OGF_LE_CTL;     // Opcode Group Field. LE Controller Commands
     uint16_t ocf = OCF_LE_SET_ADVERTISING_PARAMETERS;
     uint8_t buf[] = { 0x00, 0x08, // Advertising_Interval_Min: N * 0.625 ms. 0x000800 = 1280 ms
@@ -153,7 +169,7 @@ static void hci_le_set_advertising_parameters(int dd, int interval_ms) {
     buf[0] = buf[2] = interval_ms & 0xFF;
     buf[1] = buf[3] = (interval_ms >> 8) & 0xFF;
 
-    send_cmd(dd, ogf, ocf, buf, sizeof(buf));
+    send_cmd(ogf, ocf, buf, sizeof(buf));
 }
 
 /*
@@ -165,42 +181,46 @@ static void hci_le_set_advertising_parameters(int dd, int interval_ms) {
  *     xx = 8-bit message counter starting at 0x00 and wrapping around at 0xFF
  *     https://www.bluetooth.com/specifications/assigned-numbers/ -> "Generic Access Profile"
  *     https://www.bluetooth.com/specifications/assigned-numbers/ -> "16-bit UUIDs"
+ * Bluetooth 5 uses the same header in front of a message pack.
  */
-static void hci_le_set_advertising_data(int dd, const union ODID_Message_encoded *encoded, uint8_t msg_counter) {
+int build_bluetooth_advertising_data(uint8_t *ad, const uint8_t *data, int size, uint8_t msg_counter) {
+    ad[0] = 5 + size; // Length of the service data element
+    ad[1] = 0x16;     // 16 = GAP AD Type = "Service Data - 16-bit UUID"
+    ad[2] = 0xFA;     // 0xFFFA = ASTM International, ASTM Remote ID
+    ad[3] = 0xFF;
+    ad[4] = 0x0D;     // 0x0D = AD Application Code within the ASTM address space = Open Drone ID
+    ad[5] = msg_counter;
+    memcpy(&ad[6], data, size);
+    return 6 + size;
+}
+
+static void hci_le_set_advertising_data(const union ODID_Message_encoded *encoded, uint8_t msg_counter) {
     uint8_t ogf = OGF_LE_CTL; // Opcode Group Field. LE Controller Commands
     uint16_t ocf = OCF_LE_SET_ADVERTISING_DATA;
-    uint8_t buf[] = { 0x1F, // Advertising_Data_Length: The number of significant octets in the Advertising_Data.
-                      0x1E, // Length of the service data element
-                      0x16, // 16 = GAP AD Type = "Service Data - 16-bit UUID"
-                      0xFA, 0xFF, // 0xFFFA = ASTM International, ASTM Remote ID
-                      0x0D, // 0x0D = AD Application Code within the ASTM address space = Open Drone ID
-                      0x00, // xx = 8-bit message counter starting at 0x00 and wrapping around at 0xFF
-                      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-                      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };  // 25-byte Drone ID message data
-    buf[6] = msg_counter;
-    for (int i = 0; i < ODID_MESSAGE_SIZE; i++)
-        buf[7 + i] = encoded->rawData[i];
-
-    send_cmd(dd, ogf, ocf, buf, sizeof(buf));
-}
-
-static void hci_le_set_advertising_disable(int dd) {
+    uint8_t buf[1 + 6 + ODID_MESSAGE_SIZE]; // Advertising_Data_Length + Advertising_Data
+
+    buf[0] = build_bluetooth_advertising_data(&buf[1], encoded->rawData, ODID_MESSAGE_SIZE, msg_counter);
+
+    send_cmd_async(ogf, ocf, buf, sizeof(buf));
+}
+
+static void hci_le_set_advertising_disable() {
     uint8_t ogf = OGF_LE_CTL; // Opcode Group Field. LE Controller Commands
     uint16_t ocf = OCF_LE_SET_ADVERTISE_ENABLE;
     uint8_t buf[] = { 0x00 }; // Enable: 0 = Advertising is disabled (default)
 
-    send_cmd(dd, ogf, ocf, buf, sizeof(buf));
+    send_cmd(ogf, ocf, buf, sizeof(buf));
 }
 
-static void hci_le_set_advertising_enable(int dd) {
+static void hci_le_set_advertising_enable() {
     uint8_t ogf = OGF_LE_CTL; // Opcode Group Field. LE Controller Commands
     uint16_t ocf = OCF_LE_SET_ADVERTISE_ENABLE;
     uint8_t buf[] = { 0x01 }; // Enable: 1 = Advertising is enabled
 
-    send_cmd(dd, ogf, ocf, buf, sizeof(buf));
+    send_cmd(ogf, ocf, buf, sizeof(buf));
 }
 
-static void hci_le_set_advertising_set_random_address(int dd, uint8_t set, const uint8_t *mac) {
+static void hci_le_set_advertising_set_random_address(uint8_t set, const uint8_t *mac) {
     if (!mac)
         return;
     uint8_t ogf = OGF_LE_CTL; // Opcode Group Field. LE Controller Commands
@@ -210,10 +230,10 @@ static void hci_le_set_advertising_set_random_address(int dd, uint8_t set, const
     buf[0] = set;
     for (int i = 0; i < 6; i++)
         buf[i + 1] = mac[i];
-    send_cmd(dd, ogf, ocf, buf, sizeof(buf));
+    send_cmd(ogf, ocf, buf, sizeof(buf));
 }
 
-static void hci_le_set_extended_advertising_parameters(int dd, uint8_t set, int interval_ms, bool long_range) {
+static void hci_le_set_extended_advertising_parameters(uint8_t set, int interval_ms, bool long_range) {
     uint8_t ogf = OGF_LE_CTL;     // Opcode Group Field. LE Controller Commands
     uint16_t ocf = 0x36;          // Opcode Command Field: LE Set Extended Advertising Parameters
     uint8_t buf[] = { 0x00,       // Advertising_Handle: Used to identify an advertising set
@@ -244,107 +264,172 @@ static void hci_le_set_extended_advertising_parameters(int dd, uint8_t set, int
         buf[22] = 0x03; // Secondary_Advertising_PHY: 3 = Secondary advertisement PHY is LE Coded
     }
 
-    send_cmd(dd, ogf, ocf, buf, sizeof(buf));
+    send_cmd(ogf, ocf, buf, sizeof(buf));
 }
 
-// See hci_le_set_advertising_data for further details
-static void hci_le_set_extended_advertising_data(int dd, uint8_t set,
+// See build_bluetooth_advertising_data for further details
+static void hci_le_set_extended_advertising_data(uint8_t set,
                                                  const union ODID_Message_encoded *encoded,
-                                                 uint8_t msg_counter) {
+                                                 uint8_t msg_counter){
     uint8_t ogf = OGF_LE_CTL; // Opcode Group Field. LE Controller Commands
     uint16_t ocf = 0x37;      // Opcode Command Field: LE Set Extended Advertising Data
-    uint8_t buf[] = { 0x00,   // Advertising_Handle: Used to identify an advertising set
+    uint8_t buf[4 + 6 + ODID_MESSAGE_SIZE] =
+                    { 0x00,   // Advertising_Handle: Used to identify an advertising set
                       0x03,   // Operation: 3 = Complete extended advertising data
                       0x01,   // Fragment_Preference: 1 = The Controller should not fragment or should minimize fragmentation of Host advertising data
-                      0x1F,   // Advertising_Data_Length: The number of octets in the Advertising Data parameter
-                      0x1E,   // The length of the following data field
-                      0x16,   // 16 = GAP AD Type = "Service Data - 16-bit UUID"
-                      0xFA, 0xFF, // 0xFFFA = ASTM International, ASTM Remote ID
-                      0x0D,   // 0x0D = AD Application Code within the ASTM address space = Open Drone ID
-                      0x00,   // xx = 8-bit message counter starting at 0x00 and wrapping around at 0xFF
-                      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-                      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };  // 25-byte Drone ID message data
+                      0x00 }; // Advertising_Data_Length: The number of octets in the Advertising Data parameter
     buf[0] = set;
-    buf[9] = msg_counter;
-    for (int i = 0; i < ODID_MESSAGE_SIZE; i++)
-        buf[10 + i] = encoded->rawData[i];
+    buf[3] = build_bluetooth_advertising_data(&buf[4], encoded->rawData, ODID_MESSAGE_SIZE, msg_counter);
 
-    send_cmd(dd, ogf, ocf, buf, sizeof(buf));
+    send_cmd_async(ogf, ocf, buf, sizeof(buf));
 }
 
-// See hci_le_set_advertising_data for further details
-static void hci_le_set_extended_advertising_data_pack(int dd, uint8_t set,
+// See build_bluetooth_advertising_data for further details
+static void hci_le_set_extended_advertising_data_pack(uint8_t set,
                                                       const struct ODID_MessagePack_encoded *pack_enc,
-                                                      uint8_t msg_counter) {
+                                                      uint8_t msg_counter){
     uint8_t ogf = OGF_LE_CTL; // Opcode Group Field. LE Controller Commands
     uint16_t ocf = 0x37;      // Opcode Command Field: LE Set Extended Advertising Data
-    uint8_t buf[10 + 3 + ODID_PACK_MAX_MESSAGES*ODID_MESSAGE_SIZE] =
+    uint8_t buf[4 + BT_ADVERTISING_DATA_MAX] =
                     { 0x00,   // Advertising_Handle: Used to identify an advertising set
                       0x03,   // Operation: 3 = Complete extended advertising data
                       0x01,   // Fragment_Preference: 1 = The Controller should not fragment or should minimize fragmentation of Host advertising data
-                      0x1F,   // Advertising_Data_Length: The number of octets in the Advertising Data parameter
-                      0x1E,   // The length of the following data field
-                      0x16,   // 16 = GAP AD Type = "Service Data - 16-bit UUID"
-                      0xFA, 0xFF, // 0xFFFA = ASTM International, ASTM Remote ID
-                      0x0D,   // 0x0D = AD Application Code within the ASTM address space = Open Drone ID
-                      0x00,   // xx = 8-bit message counter starting at 0x00 and wrapping around at 0xFF
-                      0x00 }; // 3 + ODID_PACK_MAX_MESSAGES*ODID_MESSAGE_SIZE byte Drone ID message pack data
+                      0x00 }; // Advertising_Data_Length: The number of octets in the Advertising Data parameter
     buf[0] = set;
-    buf[9] = msg_counter;
 
     int amount = pack_enc->MsgPackSize;
-    buf[3] = 1 + 5 + 3 + amount*ODID_MESSAGE_SIZE;
-    buf[4] = 5 + 3 + amount*ODID_MESSAGE_SIZE;
+    buf[3] = build_bluetooth_advertising_data(&buf[4], (const uint8_t *) pack_enc,
+                                              3 + amount*ODID_MESSAGE_SIZE, msg_counter);
 
-    for (int i = 0; i < 3 + amount*ODID_MESSAGE_SIZE; i++)
-        buf[10 + i] = ((char *) pack_enc)[i];
+    send_cmd_async(ogf, ocf, buf, sizeof(buf));
+}
 
-    send_cmd(dd, ogf, ocf, buf, sizeof(buf));
+// The Extended Advertising of a set with Periodic Advertising only tells receivers that the
+// periodic advertisements it points to are Open Drone ID, so they can decide to synchronize
+static void hci_le_set_extended_advertising_data_uuid(uint8_t set) {
+    uint8_t ogf = OGF_LE_CTL; // Opcode Group Field. LE Controller Commands
+    uint16_t ocf = 0x37;      // Opcode Command Field: LE Set Extended Advertising Data
+    uint8_t buf[] = { 0x00,   // Advertising_Handle: Used to identify an advertising set
+                      0x03,   // Operation: 3 = Complete extended advertising data
+                      0x01,   // Fragment_Preference: 1 = The Controller should not fragment or should minimize fragmentation of Host advertising data
+                      0x04,   // Advertising_Data_Length: The number of octets in the Advertising Data parameter
+                      0x03,   // The length of the data element
+                      0x03,   // 03 = GAP AD Type = "Complete List of 16-bit Service Class UUIDs"
+                      0xFA, 0xFF }; // 0xFFFA = ASTM International, ASTM Remote ID
+    buf[0] = set;
+    send_cmd(ogf, ocf, buf, sizeof(buf));
 }
 
-static void hci_le_set_extended_advertising_disable(int dd) {
+static void hci_le_set_extended_advertising_disable() {
     uint8_t ogf = OGF_LE_CTL; // Opcode Group Field. LE Controller Commands
     uint16_t ocf = 0x39;      // Opcode Command Field: LE Set Extended Advertising Enable
     uint8_t buf[] = { 0x00,   // Enable: 0 = Advertising is disabled
                       0x00 }; // Number_of_Sets: 0 = Disable all advertising sets
-    send_cmd(dd, ogf, ocf, buf, sizeof(buf));
+    send_cmd(ogf, ocf, buf, sizeof(buf));
 }
 
-// Max two advertising sets is supported by this function currently
-static void hci_le_set_extended_advertising_enable(int dd, struct config_data *config) {
+// Enables the sets 0 to count - 1 at once, see MAX_ENABLE_SETS
+static void hci_le_set_extended_advertising_enable_sets(int count) {
     uint8_t ogf = OGF_LE_CTL; // Opcode Group Field. LE Controller Commands
     uint16_t ocf = 0x39;      // Opcode Command Field: LE Set Extended Advertising Enable
-    uint8_t buf[] = { 0x01,   // Enable: 1 = Advertising is enabled
-                      0x01,   // Number_of_Sets: Number of advertising sets to enable or disable
-                      0x00, 0x00,   // Advertising_Handle[i]:
-                      0x00, 0x00,   // Duration[i]: 0 = No advertising duration. Advertising to continue until the Host disables it
-                      0x00, 0x00 }; // Max_Extended_Advertising_Events[i]: 0 = No maximum number of advertising events
-
-    if (config->use_bt4 && config->use_bt5) {
-        buf[1] = 2;
-        buf[2] = config->handle_bt4;
-        buf[3] = config->handle_bt5;
-    } else if (config->use_bt4) {
-        buf[2] = config->handle_bt4;
-    } else if (config->use_bt5) {
-        buf[2] = config->handle_bt5;
-    }
-    send_cmd(dd, ogf, ocf, buf, sizeof(buf));
+    uint8_t buf[2 + 4*MAX_ENABLE_SETS] = { 0x01,   // Enable: 1 = Advertising is enabled
+                                           0x00 }; // Number_of_Sets: Number of advertising sets to enable or disable
+    count = MIN(count, MAX_ENABLE_SETS);
+    buf[1] = count;
+    for (int i = 0; i < count; i++)
+        buf[2 + 4*i] = i;   // Advertising_Handle[i]. Duration and Max_Extended_Advertising_Events stay 0 = No limit
+    send_cmd(ogf, ocf, buf, 2 + 4*count);
 }
 
-static void hci_le_remove_advertising_set(int dd, uint8_t set) {
+static void hci_le_read_number_of_supported_advertising_sets() {
     uint8_t ogf = OGF_LE_CTL; // Opcode Group Field. LE Controller Commands
-    uint16_t ocf = 0x3C;      // Opcode Command Field: LE Remove Advertising Set
-    uint8_t buf[] = { 0x00 }; // Advertising_Handle: Used to identify an advertising set
+    uint16_t ocf = 0x3B;      // Opcode Command Field: LE Read Number of Supported Advertising Sets
+    send_cmd(ogf, ocf, NULL, 0);
+}
+
+static void hci_le_set_periodic_advertising_parameters(uint8_t set, int interval_ms) {
+    uint8_t ogf = OGF_LE_CTL;     // Opcode Group Field. LE Controller Commands
+    uint16_t ocf = 0x3E;          // Opcode Command Field: LE Set Periodic Advertising Parameters
+    uint8_t buf[] = { 0x00,       // Advertising_Handle: Used to identify an advertising set
+                      0x00, 0x08, // Periodic_Advertising_Interval_Min: N * 1.25 ms. 0x0800 = 2560 ms
+                      0x00, 0x08, // Periodic_Advertising_Interval_Max: N * 1.25 ms. 0x0800 = 2560 ms
+                      0x00, 0x00 }; // Periodic_Advertising_Properties: 0 = Do not include TxPower in the advertising PDU
     buf[0] = set;
-    send_cmd(dd, ogf, ocf, buf, sizeof(buf));
+
+    interval_ms = MIN(MAX((1000 * interval_ms) / 1250, 0x0006), 0xFFFF);
+    buf[1] = buf[3] = interval_ms & 0xFF;
+    buf[2] = buf[4] = (interval_ms >> 8) & 0xFF;
+
+    send_cmd(ogf, ocf, buf, sizeof(buf));
+}
+
+static void periodic_data_done(void *arg, uint16_t opcode, uint8_t status, const uint8_t *rparams, int len);
+
+/*
+ * Queues a LE Set Periodic Advertising Data command. Must be called with periodic_lock, so it never
+ * waits for room in the queue: The event thread, which empties the queue, needs periodic_lock in
+ * periodic_data_done(). Returns false if the queue is full.
+ */
+static bool hci_le_set_periodic_advertising_data(uint8_t set, const uint8_t *params, int length) {
+    uint8_t ogf = OGF_LE_CTL; // Opcode Group Field. LE Controller Commands
+    uint16_t ocf = 0x3F;      // Opcode Command Field: LE Set Periodic Advertising Data
+    if (hci_engine_try_send(&engine, cmd_opcode_pack(ogf, ocf), params, length,
+                            periodic_data_done, &periodic_sets[set]) < 0)
+        return false;
+    periodic_sets[set].busy = true;
+    periodic_sets[set].sent++;
+    return true;
 }
 
-static void stop_transmit(struct config_data *config) {
-    hci_le_set_advertising_disable(device_descriptor);
-    hci_le_set_extended_advertising_disable(device_descriptor);
-    hci_le_remove_advertising_set(device_descriptor, config->handle_bt4);
-    hci_le_remove_advertising_set(device_descriptor, config->handle_bt5);
+static void hci_le_set_periodic_advertising_enable(uint8_t set, bool enable) {
+    uint8_t ogf = OGF_LE_CTL; // Opcode Group Field. LE Controller Commands
+    uint16_t ocf = 0x40;      // Opcode Command Field: LE Set Periodic Advertising Enable
+    uint8_t buf[] = { 0x00,   // Enable: 0 = Periodic advertising is disabled, 1 = enabled
+                      0x00 }; // Advertising_Handle: Used to identify an advertising set
+    buf[0] = enable ? 0x01 : 0x00;
+    buf[1] = set;
+    send_cmd(ogf, ocf, buf, sizeof(buf));
+}
+
+static void hci_le_clear_advertising_sets() {
+    uint8_t ogf = OGF_LE_CTL; // Opcode Group Field. LE Controller Commands
+    uint16_t ocf = 0x3D;      // Opcode Command Field: LE Clear Advertising Sets
+    send_cmd(ogf, ocf, NULL, 0);
+}
+
+// Called from the event thread of the HCI engine when the controller completed the previous pack
+static void periodic_data_done(void *arg, uint16_t opcode __attribute__((unused)), uint8_t status,
+                               const uint8_t *rparams __attribute__((unused)), int len __attribute__((unused))) {
+    struct periodic_set *periodic = arg;
+
+    print_command_error(opcode, status);
+    pthread_mutex_lock(&periodic_lock);
+    periodic->busy = false;
+    // With a full queue, the pack stays in the back buffer for the next send_bluetooth_message_pack()
+    if (periodic->waiting && periodic->enabled &&
+        hci_le_set_periodic_advertising_data((uint8_t) (periodic - periodic_sets), periodic->back, periodic->back_length))
+        periodic->waiting = false;
+    pthread_mutex_unlock(&periodic_lock);
+}
+
+static void stop_periodic_advertising() {
+    for (int i = 0; i < MAX_ENABLE_SETS; i++) {
+        pthread_mutex_lock(&periodic_lock);
+        bool enabled = periodic_sets[i].enabled;
+        periodic_sets[i].enabled = false;
+        periodic_sets[i].waiting = false;
+        pthread_mutex_unlock(&periodic_lock);
+        if (enabled)
+            hci_le_set_periodic_advertising_enable(i, false);
+    }
+}
+
+static void stop_transmit() {
+    stop_periodic_advertising();
+    hci_le_set_advertising_disable();
+    hci_le_set_extended_advertising_disable();
+    hci_le_clear_advertising_sets();
+    advertising_sets = 0;
 }
 
 void init_bluetooth(struct config_data *config) {
@@ -352,60 +437,133 @@ void init_bluetooth(struct config_data *config) {
     generate_random_mac_address(mac);
 
     device_descriptor = open_hci_device();
-    hci_reset(device_descriptor);
-    stop_transmit(config);
+    if (hci_engine_start(&engine, device_descriptor) < 0)
+        exit(EXIT_FAILURE);
+    hci_reset();
+    stop_transmit();
 
-    hci_le_read_local_supported_features(device_descriptor);
+    hci_le_read_local_supported_features();
 
     if (config->use_btl) {
-        hci_reset(device_descriptor);
-        hci_le_set_advertising_parameters(device_descriptor, 100);
-        hci_le_set_random_address(device_descriptor, mac);
+        hci_le_set_advertising_parameters(100);
+        hci_le_set_random_address(mac);
+        hci_le_set_advertising_enable();
+        return;
     }
 
-    if (config->use_bt4) {
-        hci_reset(device_descriptor);
-        hci_le_set_extended_advertising_parameters(device_descriptor, config->handle_bt4, 300, false);
-        hci_le_set_advertising_set_random_address(device_descriptor, config->handle_bt4, mac);
-    }
+    hci_le_read_number_of_supported_advertising_sets();
+
+    // The drones of a swarm get their own sets, see bluetooth_add_advertising_set()
+    if (config->swarm_size || config->swarm_file)
+        return;
 
-    if (config->use_bt5) {
-        hci_reset(device_descriptor);
-        hci_le_set_extended_advertising_parameters(device_descriptor, config->handle_bt5, 950, true);
-        hci_le_set_advertising_set_random_address(device_descriptor, config->handle_bt5, mac);
+    if (bluetooth_available_advertising_sets() < (config->use_bt4 ? 1 : 0) + (config->use_bt5 ? 1 : 0)) {
+        fprintf(stderr, "Error: The controller supports %d Extended Advertising sets\n", supported_advertising_sets);
+        exit(EXIT_FAILURE);
     }
+    if (config->use_bt4)
+        config->handle_bt4 = bluetooth_add_advertising_set(mac, BT4_ADVERTISING_INTERVAL_MS, false);
+    if (config->use_bt5)
+        config->handle_bt5 = bluetooth_add_advertising_set(mac, BT5_ADVERTISING_INTERVAL_MS, true);
+    if (config->use_bt5 && config->use_periodic) // A new pack in every periodic advertisement
+        bluetooth_enable_periodic_advertising(config->handle_bt5, (int) (1000 / config->rates[TRANSPORT_BT5]));
+    bluetooth_enable_advertising_sets();
+}
 
-    if (config->use_btl)
-        hci_le_set_advertising_enable(device_descriptor);
+int bluetooth_available_advertising_sets() {
+    return MIN(supported_advertising_sets, MAX_ENABLE_SETS) - advertising_sets;
+}
 
-    if (config->use_bt4)
-        hci_le_set_extended_advertising_enable(device_descriptor, config);
+int bluetooth_add_advertising_set(const uint8_t *address, int interval_ms, bool long_range) {
+    if (bluetooth_available_advertising_sets() <= 0)
+        return -1;
 
-    if (config->use_bt5)
-        hci_le_set_extended_advertising_enable(device_descriptor, config);
+    uint8_t set = advertising_sets++;
+    hci_le_set_extended_advertising_parameters(set, interval_ms, long_range);
+    hci_le_set_advertising_set_random_address(set, address);
+    return set;
+}
+
+void bluetooth_enable_periodic_advertising(uint8_t set, int interval_ms) {
+    if (set >= MAX_ENABLE_SETS)
+        return;
+
+    hci_le_set_extended_advertising_data_uuid(set);
+    hci_le_set_periodic_advertising_parameters(set, interval_ms);
+    hci_le_set_periodic_advertising_enable(set, true);
+
+    pthread_mutex_lock(&periodic_lock);
+    memset(&periodic_sets[set], 0, sizeof(periodic_sets[set]));
+    periodic_sets[set].enabled = true;
+    pthread_mutex_unlock(&periodic_lock);
+}
+
+void bluetooth_enable_advertising_sets() {
+    if (advertising_sets > 0)
+        hci_le_set_extended_advertising_enable_sets(advertising_sets);
 }
 
 void send_bluetooth_message(const union ODID_Message_encoded *encoded, uint8_t msg_counter, struct config_data *config) {
     if (config->use_btl)
-        hci_le_set_advertising_data(device_descriptor, encoded, msg_counter);
+        hci_le_set_advertising_data(encoded, msg_counter);
 }
 
-void send_bluetooth_message_extended_api(const union ODID_Message_encoded *encoded, uint8_t msg_counter, struct config_data *config) {
-    if (config->use_bt4)
-        hci_le_set_extended_advertising_data(device_descriptor, config->handle_bt4, encoded, msg_counter);
-    if (config->use_bt5)
-        hci_le_set_extended_advertising_data(device_descriptor, config->handle_bt5, encoded, msg_counter);
+void send_bluetooth_message_extended_api(const union ODID_Message_encoded *encoded, uint8_t msg_counter, uint8_t set) {
+    hci_le_set_extended_advertising_data(set, encoded, msg_counter);
 }
 
-void send_bluetooth_message_pack(const struct ODID_MessagePack_encoded *pack_enc, uint8_t msg_counter, struct config_data *config) {
-    if (config->use_bt5)
-        hci_le_set_extended_advertising_data_pack(device_descriptor, config->handle_bt5, pack_enc, msg_counter);
+void send_bluetooth_message_pack(const struct ODID_MessagePack_encoded *pack_enc, uint8_t msg_counter, uint8_t set) {
+    struct periodic_set *periodic = set < MAX_ENABLE_SETS ? &periodic_sets[set] : NULL;
+
+    pthread_mutex_lock(&periodic_lock);
+    if (!periodic || !periodic->enabled) {
+        pthread_mutex_unlock(&periodic_lock);
+        hci_le_set_extended_advertising_data_pack(set, pack_enc, msg_counter);
+        return;
+    }
+
+    // LE Set Periodic Advertising Data: Advertising_Handle, Operation: 3 = Complete periodic
+    // advertising data, Advertising_Data_Length and Advertising_Data as in build_bluetooth_advertising_data()
+    uint8_t buf[3 + BT_ADVERTISING_DATA_MAX] = { set, 0x03 };
+    buf[2] = build_bluetooth_advertising_data(&buf[3], (const uint8_t *) pack_enc,
+                                              3 + pack_enc->MsgPackSize*ODID_MESSAGE_SIZE, msg_counter);
+
+    if (periodic->busy || !hci_le_set_periodic_advertising_data(set, buf, 3 + buf[2])) {
+        if (periodic->waiting)
+            periodic->replaced++;
+        memcpy(periodic->back, buf, 3 + buf[2]);
+        periodic->back_length = 3 + buf[2];
+        periodic->waiting = true;
+    } else if (periodic->waiting) {
+        // A pack left in the back buffer by a full queue is older than this one
+        periodic->replaced++;
+        periodic->waiting = false;
+    }
+    pthread_mutex_unlock(&periodic_lock);
 }
-void close_bluetooth(struct config_data *config) {
-    stop_transmit(config);
+void close_bluetooth() {
+    stop_transmit();
+    hci_engine_stop(&engine);
     hci_close_dev(device_descriptor);
 }
 
+void print_bluetooth_stats() {
+    uint64_t sent = 0, replaced = 0;
+
+    hci_engine_flush(&engine);
+    hci_engine_print_stats(&engine);
+
+    pthread_mutex_lock(&periodic_lock);
+    for (int i = 0; i < MAX_ENABLE_SETS; i++) {
+        sent += periodic_sets[i].sent;
+        replaced += periodic_sets[i].replaced;
+    }
+    pthread_mutex_unlock(&periodic_lock);
+    if (sent || replaced)
+        printf("Periodic Advertising: %llu packs sent, %llu replaced by a newer pack before they were sent\n",
+               (unsigned long long) sent, (unsigned long long) replaced);
+}
+
 // The below function was an early experiment in trying to use the higher SW layers of Bluez.
 // It turned out not to work very well. Only by using direct HCI commands is all functionality available.
 void send_bluetooth_message_btmgmt(const union ODID_Message_encoded *encoded, uint8_t msg_counter) {
@@ -418,8 +576,7 @@ void send_bluetooth_message_btmgmt(const union ODID_Message_encoded *encoded, ui
     uchar_to_ascii((char *) &data[28], msg_counter); // Insert the message counter
 
     // Insert the encoded message data
-    for (int i = 0; i < ODID_MESSAGE_SIZE; i++)
-        uchar_to_ascii(&data[30 + 2*i], encoded->rawData[i]);
+    hex_encode(&data[30], encoded->rawData, ODID_MESSAGE_SIZE);
 
     const char instance_id[] = " 1";
     memcpy(&data[sizeof(cmd) - 1 + 2*ODID_MESSAGE_SIZE], instance_id, sizeof(instance_id));
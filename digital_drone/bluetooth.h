@@ -14,10 +14,53 @@
 
 #include "utils.h"
 
+// Advertising data of a message pack with the maximum number of messages
+#define BT_ADVERTISING_DATA_MAX (6 + 3 + ODID_PACK_MAX_MESSAGES*ODID_MESSAGE_SIZE)
+
+// The intervals of the sets of a single drone. The advertising data is updated at the rates of the schedule
+#define BT4_ADVERTISING_INTERVAL_MS 300
+#define BT5_ADVERTISING_INTERVAL_MS 950
+
+/*
+ * Resets the controller and, with the Extended Advertising API, creates and enables the BT4 and BT5
+ * advertising sets in config->handle_bt4 and config->handle_bt5. For a swarm, the sets of its drones
+ * are created with bluetooth_add_advertising_set() and enabled with bluetooth_enable_advertising_sets().
+ */
 void init_bluetooth(struct config_data *config);
+
+// The number of advertising sets that can still be created, as far as the controller supports them
+int bluetooth_available_advertising_sets();
+
+/*
+ * Creates the next Extended Advertising set with its own random address and interval. Long range
+ * sets use LE Coded PHY, the others legacy advertising PDUs on LE 1M. Returns the handle of the set,
+ * or -1 when the controller supports no more sets.
+ */
+int bluetooth_add_advertising_set(const uint8_t *address, int interval_ms, bool long_range);
+
+/*
+ * Starts Periodic Advertising on a long range set, to which receivers synchronize to get its
+ * message packs at the interval without scanning. From then on, send_bluetooth_message_pack()
+ * updates the periodic advertising data of the set and its Extended Advertising only carries
+ * the ASTM Remote ID service UUID and where the periodic advertisements are.
+ */
+void bluetooth_enable_periodic_advertising(uint8_t set, int interval_ms);
+
+// Enables all created sets with one LE Set Extended Advertising Enable command
+void bluetooth_enable_advertising_sets();
+
 void send_bluetooth_message(const union ODID_Message_encoded *encoded, uint8_t msg_counter, struct config_data *config);
-void send_bluetooth_message_extended_api(const union ODID_Message_encoded *encoded, uint8_t msg_counter, struct config_data *config);
-void send_bluetooth_message_pack(const struct ODID_MessagePack_encoded *pack_enc, uint8_t msg_counter, struct config_data *config);
-void close_bluetooth(struct config_data *config);
+void send_bluetooth_message_extended_api(const union ODID_Message_encoded *encoded, uint8_t msg_counter, uint8_t set);
+void send_bluetooth_message_pack(const struct ODID_MessagePack_encoded *pack_enc, uint8_t msg_counter, uint8_t set);
+void close_bluetooth();
+
+// Prints the number and completion time of the HCI commands
+void print_bluetooth_stats();
+
+/*
+ * Writes the advertising data with the Open Drone ID header in front of an encoded message
+ * or message pack to ad, as it is sent on air. Returns the length of the advertising data.
+ */
+int build_bluetooth_advertising_data(uint8_t *ad, const uint8_t *data, int size, uint8_t msg_counter);
 
 #endif //_BLUETOOTH_H_
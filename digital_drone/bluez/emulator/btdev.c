@@ -156,6 +156,13 @@ struct btdev {
 	uint8_t  sync_train_service_data;
 
 	uint16_t le_ext_adv_type;
+
+	uint8_t  le_pa_enable;
+	uint16_t le_pa_properties;
+	uint16_t le_pa_min_interval;
+	uint16_t le_pa_max_interval;
+	uint8_t  le_pa_data_len;
+	uint8_t  le_pa_data[252];
 };
 
 struct inquiry_data {
@@ -585,6 +592,7 @@ static void set_bredrle_features(struct btdev *btdev)
 		btdev->le_features[1] |= 0x01;	/* LE 2M PHY */
 		btdev->le_features[1] |= 0x08;	/* LE Coded PHY */
 		btdev->le_features[1] |= 0x10;  /* LE EXT ADV */
+		btdev->le_features[1] |= 0x20;  /* LE PA */
 	}
 
 	if (btdev->type >= BTDEV_TYPE_BREDRLE60) {
@@ -2415,6 +2423,7 @@ static void btdev_reset(struct btdev *btdev)
 
 	btdev->le_scan_enable		= 0x00;
 	btdev->le_adv_enable		= 0x00;
+	btdev->le_pa_enable		= 0x00;
 }
 
 static void default_cmd(struct btdev *btdev, uint16_t opcode,
@@ -2468,6 +2477,9 @@ static void default_cmd(struct btdev *btdev, uint16_t opcode,
 	const struct bt_hci_cmd_le_set_ext_adv_params *lseap;
 	const struct bt_hci_cmd_le_set_ext_adv_enable *lseae;
 	const struct bt_hci_cmd_le_set_ext_adv_data *lsead;
+	const struct bt_hci_cmd_le_set_periodic_adv_params *lspap;
+	const struct bt_hci_cmd_le_set_periodic_adv_data *lspad;
+	const struct bt_hci_cmd_le_set_periodic_adv_enable *lspae;
 	const struct bt_hci_cmd_le_set_ext_scan_rsp_data *lsesrd;
 	const struct bt_hci_cmd_le_set_default_phy *phys;
 	const struct bt_hci_cmd_le_set_ext_scan_params *lsesp;
@@ -3740,6 +3752,7 @@ static void default_cmd(struct btdev *btdev, uint16_t opcode,
 				btdev->type != BTDEV_TYPE_BREDRLE60)
 			goto unsupported;
 
+		btdev->le_pa_enable = 0x00;
 		status = BT_HCI_ERR_SUCCESS;
 		cmd_complete(btdev, opcode, &status, sizeof(status));
 		break;
@@ -3748,9 +3761,78 @@ static void default_cmd(struct btdev *btdev, uint16_t opcode,
 				btdev->type != BTDEV_TYPE_BREDRLE60)
 			goto unsupported;
 
+		btdev->le_pa_enable = 0x00;
 		status = BT_HCI_ERR_SUCCESS;
 		cmd_complete(btdev, opcode, &status, sizeof(status));
 		break;
+	case BT_HCI_CMD_LE_SET_PERIODIC_ADV_PARAMS:
+		if (btdev->type != BTDEV_TYPE_BREDRLE50 &&
+				btdev->type != BTDEV_TYPE_BREDRLE60)
+			goto unsupported;
+
+		lspap = data;
+		if (btdev->le_pa_enable)
+			status = BT_HCI_ERR_COMMAND_DISALLOWED;
+		else if (le16_to_cpu(lspap->min_interval) < 0x0006 ||
+				le16_to_cpu(lspap->max_interval) <
+					le16_to_cpu(lspap->min_interval))
+			status = BT_HCI_ERR_INVALID_PARAMETERS;
+		else {
+			btdev->le_pa_min_interval =
+					le16_to_cpu(lspap->min_interval);
+			btdev->le_pa_max_interval =
+					le16_to_cpu(lspap->max_interval);
+			btdev->le_pa_properties = le16_to_cpu(lspap->properties);
+			status = BT_HCI_ERR_SUCCESS;
+		}
+		cmd_complete(btdev, opcode, &status, sizeof(status));
+		break;
+	case BT_HCI_CMD_LE_SET_PERIODIC_ADV_DATA:
+		if (btdev->type != BTDEV_TYPE_BREDRLE50 &&
+				btdev->type != BTDEV_TYPE_BREDRLE60)
+			goto unsupported;
+
+		lspad = data;
+		/* Operation 0x03 replaces the data, the others add fragments
+		 * of it, which is only allowed while advertising is disabled.
+		 */
+		if (lspad->operation > 0x03 ||
+				len < sizeof(*lspad) + lspad->data_len)
+			status = BT_HCI_ERR_INVALID_PARAMETERS;
+		else if (btdev->le_pa_enable && lspad->operation != 0x03)
+			status = BT_HCI_ERR_COMMAND_DISALLOWED;
+		else {
+			if (lspad->operation == 0x01 ||
+					lspad->operation == 0x03)
+				btdev->le_pa_data_len = 0;
+
+			if (btdev->le_pa_data_len + lspad->data_len >
+						sizeof(btdev->le_pa_data))
+				status = BT_HCI_ERR_INVALID_PARAMETERS;
+			else {
+				memcpy(btdev->le_pa_data +
+						btdev->le_pa_data_len,
+						lspad->data, lspad->data_len);
+				btdev->le_pa_data_len += lspad->data_len;
+				status = BT_HCI_ERR_SUCCESS;
+			}
+		}
+		cmd_complete(btdev, opcode, &status, sizeof(status));
+		break;
+	case BT_HCI_CMD_LE_SET_PERIODIC_ADV_ENABLE:
+		if (btdev->type != BTDEV_TYPE_BREDRLE50 &&
+				btdev->type != BTDEV_TYPE_BREDRLE60)
+			goto unsupported;
+
+		lspae = data;
+		if (lspae->enable > 0x01)
+			status = BT_HCI_ERR_INVALID_PARAMETERS;
+		else {
+			btdev->le_pa_enable = lspae->enable;
+			status = BT_HCI_ERR_SUCCESS;
+		}
+		cmd_complete(btdev, opcode, &status, sizeof(status));
+		break;
 	case BT_HCI_CMD_LE_SET_DEFAULT_PHY:
 		if (btdev->type == BTDEV_TYPE_BREDR)
 			goto unsupported;
@@ -10,29 +10,18 @@ Soren Friis
 soren.friis@intel.com
 */
 
+#include <stdbool.h>
+#include <string.h>
 #include "mav2odid.h"
 
 /**
-* Set up the schedule in which messages are broadcast and init the structures
-* for converting Mavlink messages to Open Drone ID data
+* Init the structures for converting Mavlink messages to Open Drone ID data and
+* set the default rates of the schedule in which messages are broadcast
 *
-* Every second message is a Location message, since it is declared dynamic
-* in the specification and thus must be broadcast more often than the rest.
-*
-* If more than one BasicID message type is used, it will probably be desirable
-* to add more of those in the schedule to avoid using multiple full cycles to
-* get them all transmitted.
-*
-* If one or more of the optional message types (Authentication, SelfID, System,
-* OperatorID) are not used in a particular implementation, they should be
-* excluded from the schedule list.
-*
-* If ODID_AUTH_MAX_PAGES is equal to the default value of 16, the size/default
-* layout of the schedule list will be very large and take a long time to go
-* through. If authentication messages are not being used, it is recommended
-* to define a smaller value of ODID_AUTH_MAX_PAGES and/or initialize the
-* schedule list with other than the below default values. See also the
-* definition of DRONEID_SCHEDULER_SIZE in mav2odid.h.
+* By default every second message is a Location message, since it is declared
+* dynamic in the specification and thus must be broadcast more often than the
+* rest. Each of the other valid messages, incl. each Basic ID and each
+* Authentication page, is broadcast once per cycle. See m2o_setScheduleRates().
 *
 * Note: The MessagePack message type is not included, since the pack already
 * contains all the message data and there is no need to cycle through individual
@@ -48,16 +37,9 @@ int m2o_init(mav2odid_t *m2o)
 
     memset(m2o, 0, sizeof(mav2odid_t));
 
-    memset(m2o->droneidSchedule, ODID_MESSAGETYPE_LOCATION, DRONEID_SCHEDULER_SIZE);
-    m2o->droneidSchedule[0] = ODID_MESSAGETYPE_BASIC_ID;
-    int index = 2;
-    for (int i = 0; i < ODID_AUTH_MAX_PAGES; i++, index += 2)
-        m2o->droneidSchedule[index] = ODID_MESSAGETYPE_AUTH;
-    m2o->droneidSchedule[index] = ODID_MESSAGETYPE_SELF_ID;
-    index += 2;
-    m2o->droneidSchedule[index] = ODID_MESSAGETYPE_SYSTEM;
-    index += 2;
-    m2o->droneidSchedule[index] = ODID_MESSAGETYPE_OPERATOR_ID;
+    // The first cycle starts with the first Basic ID and Authentication page
+    m2o->basicIDIndex = ODID_BASIC_ID_MAX_MESSAGES - 1;
+    m2o->authIndex = ODID_AUTH_MAX_PAGES - 1;
 
     union {
         ODID_BasicID_data basicId;
@@ -97,12 +79,187 @@ int m2o_init(mav2odid_t *m2o)
     if (encodeOperatorIDMessage(&m2o->operatorIdEnc, &data.operatorId))
         return ODID_FAIL;
 
+    const uint8_t rates[M2O_SCHEDULE_TYPES] = {
+        [ODID_MESSAGETYPE_BASIC_ID] = 1,
+        [ODID_MESSAGETYPE_LOCATION] = M2O_RATE_EVERY_OTHER,
+        [ODID_MESSAGETYPE_AUTH] = 1,
+        [ODID_MESSAGETYPE_SELF_ID] = 1,
+        [ODID_MESSAGETYPE_SYSTEM] = 1,
+        [ODID_MESSAGETYPE_OPERATOR_ID] = 1,
+    };
+    return m2o_setScheduleRates(m2o, rates);
+}
+
+// The number of slots per cycle for the given number of valid messages of each type
+static int m2o_scheduleWeights(const uint8_t *rates, const int *counts, int *weights)
+{
+    int others = 0;
+    for (int t = 0; t < M2O_SCHEDULE_TYPES; t++) {
+        weights[t] = t == ODID_MESSAGETYPE_LOCATION ? 0 : rates[t] * counts[t];
+        others += weights[t];
+    }
+    if (counts[ODID_MESSAGETYPE_LOCATION]) {
+        if (rates[ODID_MESSAGETYPE_LOCATION] == M2O_RATE_EVERY_OTHER)
+            weights[ODID_MESSAGETYPE_LOCATION] = others ? others : 1;
+        else
+            weights[ODID_MESSAGETYPE_LOCATION] = rates[ODID_MESSAGETYPE_LOCATION];
+    }
+    return others + weights[ODID_MESSAGETYPE_LOCATION];
+}
+
+/**
+* Set how often each message type is broadcast by m2o_cycleMessages()
+*
+* The rate of a type is the number of slots per schedule cycle for each valid
+* message of that type, i.e. for each stored Basic ID and Authentication page.
+* A rate of 0 leaves the type out. The Location message can instead use
+* M2O_RATE_EVERY_OTHER, to be broadcast in every second slot.
+*
+* The cycle only contains the messages that have been received, spread evenly
+* over the cycle, so no slot is left empty. It is rebuilt when another message
+* becomes valid. A cycle longer than DRONEID_SCHEDULER_SIZE is scaled down to
+* it, keeping at least one slot for each type as long as there are enough
+* slots. The Basic IDs and Authentication pages then take turns in the slots of
+* their type.
+*
+* @param m2o    Instance structure containing working buffers
+* @param rates  The rate of each message type, indexed by ODID_messagetype_t
+* @return       Success or fail
+*/
+int m2o_setScheduleRates(mav2odid_t *m2o, const uint8_t rates[M2O_SCHEDULE_TYPES])
+{
+    if (!m2o || !rates)
+        return ODID_FAIL;
+
+    memcpy(m2o->scheduleRates, rates, M2O_SCHEDULE_TYPES);
+    m2o->scheduleChanged = 1;
     return ODID_SUCCESS;
 }
 
+/**
+* Scale the weights down to at most count slots in total, in proportion to each
+* other. Each type keeps at least one slot, unless there are more types than
+* slots.
+*/
+static void m2o_fitWeights(int *weights, int count)
+{
+    int total = 0;
+    for (int t = 0; t < M2O_SCHEDULE_TYPES; t++)
+        total += weights[t];
+    if (total <= count)
+        return;
+
+    int scaled = 0;
+    for (int t = 0; t < M2O_SCHEDULE_TYPES; t++) {
+        if (!weights[t])
+            continue;
+        weights[t] = weights[t] * count / total;
+        if (!weights[t])
+            weights[t] = 1;
+        scaled += weights[t];
+    }
+
+    // The types raised to one slot are taken from the largest ones
+    while (scaled > count) {
+        int largest = 0;
+        for (int t = 1; t < M2O_SCHEDULE_TYPES; t++) {
+            if (weights[t] > weights[largest])
+                largest = t;
+        }
+        if (weights[largest] <= 1)
+            break;
+        weights[largest]--;
+        scaled--;
+    }
+}
+
+/**
+* Spread the slots of each type evenly over count slots, with a smooth weighted
+* round robin. Writes every stride'th slot.
+*/
+static void m2o_spreadSlots(const int *weights, int count, uint8_t *slots, int stride)
+{
+    int total = 0;
+    for (int t = 0; t < M2O_SCHEDULE_TYPES; t++)
+        total += weights[t];
+
+    int current[M2O_SCHEDULE_TYPES] = { 0 };
+    for (int slot = 0; slot < count; slot++) {
+        int best = -1;
+        for (int t = 0; t < M2O_SCHEDULE_TYPES; t++) {
+            if (!weights[t])
+                continue;
+            current[t] += weights[t];
+            if (best < 0 || current[t] > current[best])
+                best = t;
+        }
+        current[best] -= total;
+        slots[slot * stride] = (uint8_t) best;
+    }
+}
+
+/**
+* Build the cycle of droneidSchedule from the rates and the valid messages
+*/
+static void m2o_buildSchedule(mav2odid_t *m2o)
+{
+    int counts[M2O_SCHEDULE_TYPES] = { 0 };
+    for (int i = 0; i < ODID_BASIC_ID_MAX_MESSAGES; i++)
+        counts[ODID_MESSAGETYPE_BASIC_ID] += m2o->basicIDEncValid[i];
+    counts[ODID_MESSAGETYPE_LOCATION] = m2o->locationEncValid;
+    for (int i = 0; i < ODID_AUTH_MAX_PAGES; i++)
+        counts[ODID_MESSAGETYPE_AUTH] += m2o->authEncValid[i];
+    counts[ODID_MESSAGETYPE_SELF_ID] = m2o->selfIDEncValid;
+    counts[ODID_MESSAGETYPE_SYSTEM] = m2o->systemEncValid;
+    counts[ODID_MESSAGETYPE_OPERATOR_ID] = m2o->operatorIDEncValid;
+
+    int weights[M2O_SCHEDULE_TYPES];
+    int total = m2o_scheduleWeights(m2o->scheduleRates, counts, weights);
+    if (total > DRONEID_SCHEDULER_SIZE)
+        total = DRONEID_SCHEDULER_SIZE;
+
+    if (m2o->scheduleRates[ODID_MESSAGETYPE_LOCATION] == M2O_RATE_EVERY_OTHER &&
+        counts[ODID_MESSAGETYPE_LOCATION] && total > 1) {
+        // Location in the even slots, the other types spread over the odd ones
+        weights[ODID_MESSAGETYPE_LOCATION] = 0;
+        total &= ~1;
+        for (int slot = 0; slot < total; slot += 2)
+            m2o->droneidSchedule[slot] = ODID_MESSAGETYPE_LOCATION;
+        m2o_fitWeights(weights, total / 2);
+        m2o_spreadSlots(weights, total / 2, &m2o->droneidSchedule[1], 2);
+    } else {
+        m2o_fitWeights(weights, total);
+        m2o_spreadSlots(weights, total, m2o->droneidSchedule, 1);
+    }
+
+    m2o->scheduleLength = (uint8_t) total;
+    m2o->scheduleIdx = 0;
+    m2o->scheduleChanged = 0;
+}
+
+// Advance index to the next valid message of an array
+static void m2o_nextValid(const uint8_t *valid, int size, uint8_t *index)
+{
+    for (int i = 1; i <= size; i++) {
+        int next = (*index + i) % size;
+        if (valid[next]) {
+            *index = (uint8_t) next;
+            return;
+        }
+    }
+}
+
+// Mark a message as valid and rebuild the schedule, if it was not valid before
+static void m2o_setValid(mav2odid_t *m2o, uint8_t *valid)
+{
+    if (!*valid)
+        m2o->scheduleChanged = 1;
+    *valid = 1;
+}
+
 /**
 * Cycle through the various DroneID messages according to the schedule defined
-* in droneidSchedule.
+* in droneidSchedule, see m2o_setScheduleRates().
 *
 * This is useful e.g. when transmitting on Bluetooth Legacy broadcast where
 * only one message at a time can be transmitted.
@@ -116,53 +273,46 @@ int m2o_init(mav2odid_t *m2o)
 * @param m2o    Instance structure containing working buffers
 * @param data   Pointer to the buffer into which the current message data will
 *               be copied
-* @return       Success or fail
+* @return       Success or fail, if no message has been received yet
 */
 int m2o_cycleMessages(mav2odid_t *m2o, uint8_t *data)
 {
     if (!m2o || !data)
         return ODID_FAIL;
 
-    static uint8_t basicIDIndex = 0;
-    static uint8_t authIndex = 0;
+    if (m2o->scheduleChanged)
+        m2o_buildSchedule(m2o);
+    if (m2o->scheduleLength == 0)
+        return ODID_FAIL;
 
+    // Only valid messages are in the schedule
     switch (m2o->droneidSchedule[m2o->scheduleIdx])
     {
     case ODID_MESSAGETYPE_BASIC_ID:
-        for (int i = 0; i < ODID_BASIC_ID_MAX_MESSAGES; i++) {
-            basicIDIndex = (uint8_t) ((basicIDIndex + 1) % ODID_BASIC_ID_MAX_MESSAGES);
-            if (m2o->basicIDEncValid[basicIDIndex]) {
-                memcpy(data, &m2o->basicIdEnc, sizeof(ODID_BasicID_encoded));
-                break;
-            }
-        }
+        m2o_nextValid(m2o->basicIDEncValid, ODID_BASIC_ID_MAX_MESSAGES, &m2o->basicIDIndex);
+        memcpy(data, &m2o->basicIdEnc[m2o->basicIDIndex], sizeof(ODID_BasicID_encoded));
         break;
     case ODID_MESSAGETYPE_LOCATION:
-        if (m2o->locationEncValid)
-            memcpy(data, &m2o->locationEnc, sizeof(ODID_Location_encoded));
+        memcpy(data, &m2o->locationEnc, sizeof(ODID_Location_encoded));
         break;
     case ODID_MESSAGETYPE_AUTH:
-        if (m2o->authEncValid[authIndex])
-            memcpy(data, &m2o->authEnc[authIndex], sizeof(ODID_Auth_encoded));
-        authIndex = (uint8_t) ((authIndex + 1) % ODID_AUTH_MAX_PAGES);
+        m2o_nextValid(m2o->authEncValid, ODID_AUTH_MAX_PAGES, &m2o->authIndex);
+        memcpy(data, &m2o->authEnc[m2o->authIndex], sizeof(ODID_Auth_encoded));
         break;
     case ODID_MESSAGETYPE_SELF_ID:
-        if (m2o->selfIDEncValid)
-            memcpy(data, &m2o->selfIdEnc, sizeof(ODID_SelfID_encoded));
+        memcpy(data, &m2o->selfIdEnc, sizeof(ODID_SelfID_encoded));
         break;
     case ODID_MESSAGETYPE_SYSTEM:
-        if (m2o->systemEncValid)
-            memcpy(data, &m2o->systemEnc, sizeof(ODID_System_encoded));
+        memcpy(data, &m2o->systemEnc, sizeof(ODID_System_encoded));
         break;
     case ODID_MESSAGETYPE_OPERATOR_ID:
-        if (m2o->operatorIDEncValid)
-            memcpy(data, &m2o->operatorIdEnc, sizeof(ODID_OperatorID_encoded));
+        memcpy(data, &m2o->operatorIdEnc, sizeof(ODID_OperatorID_encoded));
         break;
     default:
         return ODID_FAIL;
     }
 
-    m2o->scheduleIdx = (uint8_t) ((m2o->scheduleIdx + 1) % DRONEID_SCHEDULER_SIZE);
+    m2o->scheduleIdx = (uint8_t) ((m2o->scheduleIdx + 1) % m2o->scheduleLength);
     return ODID_SUCCESS;
 }
 
@@ -252,7 +402,7 @@ static int m2o_basicId(mav2odid_t *m2o, mavlink_open_drone_id_basic_id_t *mavBas
         if (storedType == ODID_IDTYPE_NONE || storedType == basicId.IDType) {
             if (encodeBasicIDMessage(&m2o->basicIdEnc[i], &basicId) != ODID_SUCCESS)
                 return ODID_FAIL;
-            m2o->basicIDEncValid[i] = 1;
+            m2o_setValid(m2o, &m2o->basicIDEncValid[i]);
             return ODID_SUCCESS;
             }
         }
@@ -287,7 +437,7 @@ static int m2o_location(mav2odid_t *m2o, mavlink_open_drone_id_location_t *mavLo
 
     if (encodeLocationMessage(&m2o->locationEnc, &location) != ODID_SUCCESS)
         return ODID_FAIL;
-    m2o->locationEncValid = 1;
+    m2o_setValid(m2o, &m2o->locationEncValid);
     return ODID_SUCCESS;
 }
 
@@ -319,7 +469,7 @@ static int m2o_authentication(mav2odid_t *m2o, mavlink_open_drone_id_authenticat
     if (ret != ODID_SUCCESS)
         return ret;
 
-    m2o->authEncValid[mavAuthentication->data_page] = 1;
+    m2o_setValid(m2o, &m2o->authEncValid[mavAuthentication->data_page]);
     return ODID_SUCCESS;
 }
 
@@ -338,7 +488,7 @@ static int m2o_selfId(mav2odid_t *m2o, mavlink_open_drone_id_self_id_t *mavSelfI
 
     if (encodeSelfIDMessage(&m2o->selfIdEnc, &selfId) != ODID_SUCCESS)
         return ODID_FAIL;
-    m2o->selfIDEncValid = 1;
+    m2o_setValid(m2o, &m2o->selfIDEncValid);
     return ODID_SUCCESS;
 }
 
@@ -368,7 +518,7 @@ static int m2o_system(mav2odid_t *m2o, mavlink_open_drone_id_system_t *mavSystem
 
     if (encodeSystemMessage(&m2o->systemEnc, &system) != ODID_SUCCESS)
         return ODID_FAIL;
-    m2o->systemEncValid = 1;
+    m2o_setValid(m2o, &m2o->systemEncValid);
     return ODID_SUCCESS;
 }
 
@@ -387,7 +537,7 @@ static int m2o_operatorId(mav2odid_t *m2o, mavlink_open_drone_id_operator_id_t *
 
     if (encodeOperatorIDMessage(&m2o->operatorIdEnc, &operatorId) != ODID_SUCCESS)
         return ODID_FAIL;
-    m2o->operatorIDEncValid = 1;
+    m2o_setValid(m2o, &m2o->operatorIDEncValid);
     return ODID_SUCCESS;
 }
 
@@ -399,10 +549,15 @@ static int m2o_messagePack(mav2odid_t *m2o, mavlink_open_drone_id_message_pack_t
     if (!mavMessagePack)
         return ODID_FAIL;
 
+    // The messages field of the Mavlink message holds no more than this
+    uint8_t msgPackSize = mavMessagePack->msg_pack_size;
+    if (msgPackSize > ODID_PACK_MAX_MESSAGES)
+        msgPackSize = ODID_PACK_MAX_MESSAGES;
+
     ODID_MessagePack_data messagePack;
     messagePack.SingleMessageSize = mavMessagePack->single_message_size;
-    messagePack.MsgPackSize = mavMessagePack->msg_pack_size;
-    for (int i = 0; i < mavMessagePack->msg_pack_size; i++)
+    messagePack.MsgPackSize = msgPackSize;
+    for (int i = 0; i < msgPackSize; i++)
         for (int j = 0; j < ODID_MESSAGE_SIZE; j++)
             messagePack.Messages[i].rawData[j] = mavMessagePack->messages[i*ODID_MESSAGE_SIZE + j];
 
@@ -412,6 +567,72 @@ static int m2o_messagePack(mav2odid_t *m2o, mavlink_open_drone_id_message_pack_t
     return ODID_SUCCESS;
 }
 
+/**
+* Convert a complete Mavlink message to the corresponding encoded Open Drone ID
+* structure, if it is one of the Open Drone ID messages
+*/
+static ODID_messagetype_t m2o_dispatchMavlink(mav2odid_t *m2o, mavlink_message_t *message)
+{
+    union {
+        mavlink_open_drone_id_basic_id_t basicId;
+        mavlink_open_drone_id_location_t location;
+        mavlink_open_drone_id_authentication_t authentication;
+        mavlink_open_drone_id_self_id_t selfId;
+        mavlink_open_drone_id_system_t system;
+        mavlink_open_drone_id_operator_id_t operatorId;
+        mavlink_open_drone_id_message_pack_t messagePack;
+    } msg;
+
+    switch ((int) message->msgid)
+    {
+    case MAVLINK_MSG_ID_OPEN_DRONE_ID_BASIC_ID:
+        mavlink_msg_open_drone_id_basic_id_decode(message, &msg.basicId);
+        if (m2o_basicId(m2o, &msg.basicId) == ODID_SUCCESS)
+            return ODID_MESSAGETYPE_BASIC_ID;
+        break;
+
+    case MAVLINK_MSG_ID_OPEN_DRONE_ID_LOCATION:
+        mavlink_msg_open_drone_id_location_decode(message, &msg.location);
+        if (m2o_location(m2o, &msg.location) == ODID_SUCCESS)
+            return ODID_MESSAGETYPE_LOCATION;
+        break;
+
+    case MAVLINK_MSG_ID_OPEN_DRONE_ID_AUTHENTICATION:
+        mavlink_msg_open_drone_id_authentication_decode(message, &msg.authentication);
+        if (m2o_authentication(m2o, &msg.authentication) == ODID_SUCCESS)
+            return ODID_MESSAGETYPE_AUTH;
+        break;
+
+    case MAVLINK_MSG_ID_OPEN_DRONE_ID_SELF_ID:
+        mavlink_msg_open_drone_id_self_id_decode(message, &msg.selfId);
+        if (m2o_selfId(m2o, &msg.selfId) == ODID_SUCCESS)
+            return ODID_MESSAGETYPE_SELF_ID;
+        break;
+
+    case MAVLINK_MSG_ID_OPEN_DRONE_ID_SYSTEM:
+        mavlink_msg_open_drone_id_system_decode(message, &msg.system);
+        if (m2o_system(m2o, &msg.system) == ODID_SUCCESS)
+            return ODID_MESSAGETYPE_SYSTEM;
+        break;
+
+    case MAVLINK_MSG_ID_OPEN_DRONE_ID_OPERATOR_ID:
+        mavlink_msg_open_drone_id_operator_id_decode(message, &msg.operatorId);
+        if (m2o_operatorId(m2o, &msg.operatorId) == ODID_SUCCESS)
+            return ODID_MESSAGETYPE_OPERATOR_ID;
+        break;
+
+    case MAVLINK_MSG_ID_OPEN_DRONE_ID_MESSAGE_PACK:
+        mavlink_msg_open_drone_id_message_pack_decode(message, &msg.messagePack);
+        if (m2o_messagePack(m2o, &msg.messagePack) == ODID_SUCCESS)
+            return ODID_MESSAGETYPE_PACKED;
+        break;
+
+    default:
+        break;
+    }
+    return ODID_MESSAGETYPE_INVALID;
+}
+
 /**
 * Parse incoming data for detecting Mavlink messages
 *
@@ -421,24 +642,18 @@ static int m2o_messagePack(mav2odid_t *m2o, mavlink_open_drone_id_message_pack_t
 * the full message will be decoded and the data from the message stored in the
 * corresponding Open Drone ID structure.
 *
+* The parser state is kept by Mavlink per channel. Instances that parse
+* different links must set a different m2o->mavlinkChannel after m2o_init().
+*
 * @param  m2o   Instance structure containing working buffers
 * @param  data  One byte of data to be parsed
 * @return       The type of message decoded
 */
 ODID_messagetype_t m2o_parseMavlink(mav2odid_t *m2o, uint8_t data)
 {
-    if (!m2o)
+    if (!m2o || m2o->mavlinkChannel >= MAVLINK_COMM_NUM_BUFFERS)
         return ODID_MESSAGETYPE_INVALID;
 
-    union {
-        mavlink_open_drone_id_basic_id_t basicId;
-        mavlink_open_drone_id_location_t location;
-        mavlink_open_drone_id_authentication_t authentication;
-        mavlink_open_drone_id_self_id_t selfId;
-        mavlink_open_drone_id_system_t system;
-        mavlink_open_drone_id_operator_id_t operatorId;
-        mavlink_open_drone_id_message_pack_t messagePack;
-    } msg;
     mavlink_message_t message;
 
     // Note: this struct can in principle be set to null, to reduce stack usage.
@@ -446,58 +661,369 @@ ODID_messagetype_t m2o_parseMavlink(mav2odid_t *m2o, uint8_t data)
     // allocated and this parse function does not need the status information.
     mavlink_status_t status;
 
-    // Enhance this, if used in a system transmitting on other than channel 0
-    if (mavlink_parse_char(MAVLINK_COMM_0, data, &message, &status))
-    {
-        switch ((int) message.msgid)
-        {
-        case MAVLINK_MSG_ID_OPEN_DRONE_ID_BASIC_ID:
-            mavlink_msg_open_drone_id_basic_id_decode(&message, &msg.basicId);
-            if (m2o_basicId(m2o, &msg.basicId) == ODID_SUCCESS)
-                return ODID_MESSAGETYPE_BASIC_ID;
-            break;
+    if (mavlink_parse_char(m2o->mavlinkChannel, data, &message, &status))
+        return m2o_dispatchMavlink(m2o, &message);
+    return ODID_MESSAGETYPE_INVALID;
+}
 
-        case MAVLINK_MSG_ID_OPEN_DRONE_ID_LOCATION:
-            mavlink_msg_open_drone_id_location_decode(&message, &msg.location);
-            if (m2o_location(m2o, &msg.location) == ODID_SUCCESS)
-                return ODID_MESSAGETYPE_LOCATION;
-            break;
+// The Open Drone ID messages, which are the only ones m2o_parseMavlinkBuffer() checks and decodes
+static const struct {
+    uint32_t msgid;
+    uint8_t crcExtra;
+    uint8_t maxLen;
+} odidMessages[] = {
+    { MAVLINK_MSG_ID_OPEN_DRONE_ID_BASIC_ID, MAVLINK_MSG_ID_OPEN_DRONE_ID_BASIC_ID_CRC,
+      MAVLINK_MSG_ID_OPEN_DRONE_ID_BASIC_ID_LEN },
+    { MAVLINK_MSG_ID_OPEN_DRONE_ID_LOCATION, MAVLINK_MSG_ID_OPEN_DRONE_ID_LOCATION_CRC,
+      MAVLINK_MSG_ID_OPEN_DRONE_ID_LOCATION_LEN },
+    { MAVLINK_MSG_ID_OPEN_DRONE_ID_AUTHENTICATION, MAVLINK_MSG_ID_OPEN_DRONE_ID_AUTHENTICATION_CRC,
+      MAVLINK_MSG_ID_OPEN_DRONE_ID_AUTHENTICATION_LEN },
+    { MAVLINK_MSG_ID_OPEN_DRONE_ID_SELF_ID, MAVLINK_MSG_ID_OPEN_DRONE_ID_SELF_ID_CRC,
+      MAVLINK_MSG_ID_OPEN_DRONE_ID_SELF_ID_LEN },
+    { MAVLINK_MSG_ID_OPEN_DRONE_ID_SYSTEM, MAVLINK_MSG_ID_OPEN_DRONE_ID_SYSTEM_CRC,
+      MAVLINK_MSG_ID_OPEN_DRONE_ID_SYSTEM_LEN },
+    { MAVLINK_MSG_ID_OPEN_DRONE_ID_OPERATOR_ID, MAVLINK_MSG_ID_OPEN_DRONE_ID_OPERATOR_ID_CRC,
+      MAVLINK_MSG_ID_OPEN_DRONE_ID_OPERATOR_ID_LEN },
+    { MAVLINK_MSG_ID_OPEN_DRONE_ID_MESSAGE_PACK, MAVLINK_MSG_ID_OPEN_DRONE_ID_MESSAGE_PACK_CRC,
+      MAVLINK_MSG_ID_OPEN_DRONE_ID_MESSAGE_PACK_LEN },
+};
+
+#define M2O_FRAME_HEADER_LEN MAVLINK_NUM_HEADER_BYTES   // STX, len, flags, seq, sysid, compid, 3 byte msgid
 
-        case MAVLINK_MSG_ID_OPEN_DRONE_ID_AUTHENTICATION:
-            mavlink_msg_open_drone_id_authentication_decode(&message, &msg.authentication);
-            if (m2o_authentication(m2o, &msg.authentication) == ODID_SUCCESS)
-                return ODID_MESSAGETYPE_AUTH;
-            break;
+/**
+* Find the Mavlink v2 frames in data and dispatch the Open Drone ID messages
+* among them, to m2o or to the vehicle of the sender in fleet. Returns the
+* offset of a frame that is not complete at the end of data, or len if there is
+* none.
+*/
+static size_t m2o_scanMavlink(mav2odid_t *m2o, m2o_fleet_t *fleet,
+                              const uint8_t *data, size_t len,
+                              m2o_messageCallback callback, int *count)
+{
+    size_t pos = 0;
+    bool inSync = false;    // pos is the end of a frame with a valid CRC
+
+    while (pos < len) {
+        // Mavlink v1 frames are skipped, since their 8 bit message IDs can not
+        // carry the Open Drone ID messages
+        const uint8_t *stx = memchr(&data[pos], MAVLINK_STX, len - pos);
+        if (!stx)
+            return len;
+        size_t start = (size_t) (stx - data);
+        if (len - start < M2O_FRAME_HEADER_LEN)
+            return start;
+        inSync = inSync && start == pos;
+
+        uint8_t payloadLen = data[start + 1];
+        uint8_t incompatFlags = data[start + 2];
+        if (incompatFlags & ~MAVLINK_IFLAG_SIGNED) {
+            pos = start + 1;    // Not a frame, or from a future Mavlink version
+            inSync = false;
+            continue;
+        }
+        size_t frameLen = M2O_FRAME_HEADER_LEN + payloadLen + MAVLINK_NUM_CHECKSUM_BYTES +
+                          ((incompatFlags & MAVLINK_IFLAG_SIGNED) ? MAVLINK_SIGNATURE_BLOCK_LEN : 0);
+        uint32_t msgid = data[start + 7] | (uint32_t) data[start + 8] << 8 |
+                         (uint32_t) data[start + 9] << 16;
+
+        int entry = -1;
+        for (int i = 0; i < (int) (sizeof(odidMessages) / sizeof(odidMessages[0])); i++) {
+            if (odidMessages[i].msgid == msgid) {
+                entry = i;
+                break;
+            }
+        }
 
-        case MAVLINK_MSG_ID_OPEN_DRONE_ID_SELF_ID:
-            mavlink_msg_open_drone_id_self_id_decode(&message, &msg.selfId);
-            if (m2o_selfId(m2o, &msg.selfId) == ODID_SUCCESS)
-                return ODID_MESSAGETYPE_SELF_ID;
-            break;
+        if (len - start < frameLen)
+            return start;
+
+        uint16_t frameCrc = data[start + M2O_FRAME_HEADER_LEN + payloadLen] |
+                            (uint16_t) (data[start + M2O_FRAME_HEADER_LEN + payloadLen + 1] << 8);
+
+        if (entry < 0) {
+            // Other messages directly following a valid frame are skipped
+            // without checking their CRC. After data that was not a frame,
+            // the CRC must show that this is the start of the next frame.
+            if (!inSync) {
+                const mavlink_msg_entry_t *msgEntry = mavlink_get_msg_entry(msgid);
+                uint16_t crc = crc_calculate(&data[start + 1], (uint16_t) (M2O_FRAME_HEADER_LEN - 1 + payloadLen));
+                if (msgEntry)
+                    crc_accumulate(msgEntry->crc_extra, &crc);
+                if (!msgEntry || crc != frameCrc) {
+                    pos = start + 1;
+                    continue;
+                }
+            }
+            pos = start + frameLen;
+            inSync = true;
+            continue;
+        }
 
-        case MAVLINK_MSG_ID_OPEN_DRONE_ID_SYSTEM:
-            mavlink_msg_open_drone_id_system_decode(&message, &msg.system);
-            if (m2o_system(m2o, &msg.system) == ODID_SUCCESS)
-                return ODID_MESSAGETYPE_SYSTEM;
-            break;
+        uint16_t crc = crc_calculate(&data[start + 1], (uint16_t) (M2O_FRAME_HEADER_LEN - 1 + payloadLen));
+        crc_accumulate(odidMessages[entry].crcExtra, &crc);
+        if (crc != frameCrc || payloadLen > odidMessages[entry].maxLen) {
+            pos = start + 1;
+            inSync = false;
+            continue;
+        }
 
-        case MAVLINK_MSG_ID_OPEN_DRONE_ID_OPERATOR_ID:
-            mavlink_msg_open_drone_id_operator_id_decode(&message, &msg.operatorId);
-            if (m2o_operatorId(m2o, &msg.operatorId) == ODID_SUCCESS)
-                return ODID_MESSAGETYPE_OPERATOR_ID;
-            break;
+        // Mavlink v2 drops the trailing zeros of the payload, which the
+        // decode functions fill in again
+        mavlink_message_t message;
+        message.magic = MAVLINK_STX;
+        message.len = payloadLen;
+        message.incompat_flags = incompatFlags;
+        message.compat_flags = data[start + 3];
+        message.seq = data[start + 4];
+        message.sysid = data[start + 5];
+        message.compid = data[start + 6];
+        message.msgid = msgid;
+        message.checksum = frameCrc;
+        memset(_MAV_PAYLOAD_NON_CONST(&message), 0, odidMessages[entry].maxLen);
+        memcpy(_MAV_PAYLOAD_NON_CONST(&message), &data[start + M2O_FRAME_HEADER_LEN], payloadLen);
+
+        mav2odid_t *vehicle = fleet ? m2o_fleetGet(fleet, message.sysid, message.compid) : m2o;
+        if (vehicle) {
+            ODID_messagetype_t type = m2o_dispatchMavlink(vehicle, &message);
+            if (type != ODID_MESSAGETYPE_INVALID) {
+                (*count)++;
+                if (callback)
+                    callback(vehicle, type);
+            }
+        } else {
+            fleet->dropped++;
+        }
+        pos = start + frameLen;
+        inSync = true;
+    }
+    return len;
+}
 
-        case MAVLINK_MSG_ID_OPEN_DRONE_ID_MESSAGE_PACK:
-            mavlink_msg_open_drone_id_message_pack_decode(&message, &msg.messagePack);
-            if (m2o_messagePack(m2o, &msg.messagePack) == ODID_SUCCESS)
-                return ODID_MESSAGETYPE_PACKED;
-            break;
+/**
+* Scan buf after the frame kept in rxBuf from the previous buffer, and keep
+* the frame that continues in the next buffer
+*/
+static int m2o_parseBuffer(mav2odid_t *m2o, m2o_fleet_t *fleet,
+                           uint8_t *rxBuf, uint16_t *rxLen,
+                           const uint8_t *buf, size_t len,
+                           m2o_messageCallback callback)
+{
+    if (!buf && len)
+        return -1;
+
+    int count = 0;
+    size_t pos = 0;
+
+    if (*rxLen) {
+        // Continue the frame of the previous buffer with enough data to
+        // complete any frame that starts in it
+        uint8_t joined[2 * MAVLINK_MAX_PACKET_LEN];
+        size_t add = len < MAVLINK_MAX_PACKET_LEN ? len : MAVLINK_MAX_PACKET_LEN;
+        memcpy(joined, rxBuf, *rxLen);
+        memcpy(&joined[*rxLen], buf, add);
+
+        size_t used = m2o_scanMavlink(m2o, fleet, joined, *rxLen + add, callback, &count);
+        if (used < *rxLen) {
+            // Only possible when all of buf was added
+            *rxLen = (uint16_t) (*rxLen + add - used);
+            memmove(rxBuf, &joined[used], *rxLen);
+            return count;
+        }
+        pos = used - *rxLen;
+        *rxLen = 0;
+    }
 
-        default:
-            break;
+    size_t used = pos + m2o_scanMavlink(m2o, fleet, &buf[pos], len - pos, callback, &count);
+    *rxLen = (uint16_t) (len - used);
+    memcpy(rxBuf, &buf[used], *rxLen);
+    return count;
+}
+
+/**
+* Parse a buffer of incoming data for Mavlink messages
+*
+* This is an alternative to calling m2o_parseMavlink() for each byte, e.g. with
+* the data of each read from a serial port or UDP socket. The buffer is
+* searched for the start of Mavlink v2 frames with memchr. Only the Open Drone
+* ID messages are decoded. The CRC of other messages is only checked when they
+* do not directly follow a valid frame, while in sync they are skipped as a
+* whole. A frame that continues in the next buffer is kept in m2o
+* until then.
+*
+* The callback is called with the type of each decoded Open Drone ID message,
+* after its data has been stored in the corresponding Open Drone ID structure.
+*
+* Do not mix calls to this function and m2o_parseMavlink() on the same stream.
+*
+* @param  m2o       Instance structure containing working buffers
+* @param  buf       The received data
+* @param  len       The number of bytes in buf
+* @param  callback  Called for each decoded message, can be NULL
+* @return           The number of decoded Open Drone ID messages, or -1
+*/
+int m2o_parseMavlinkBuffer(mav2odid_t *m2o, const uint8_t *buf, size_t len,
+                           m2o_messageCallback callback)
+{
+    if (!m2o)
+        return -1;
+    return m2o_parseBuffer(m2o, NULL, m2o->rxBuf, &m2o->rxLen, buf, len, callback);
+}
+
+/**
+* Init a table of vehicles, for a link on which several vehicles send their
+* Open Drone ID data, e.g. at a ground station relaying a fleet
+*
+* Each vehicle, i.e. Mavlink system ID and component ID, gets its own mav2odid_t
+* with its own schedule, the first time an Open Drone ID message is received
+* from it. Fleets on different links must use different Mavlink channels.
+*
+* @param  fleet     The table to init
+* @param  vehicles  Array of capacity instances, provided by the caller
+* @param  capacity  The maximum number of vehicles
+* @param  channel   The Mavlink channel used for parsing the link
+* @return           Success or fail
+*/
+int m2o_fleetInit(m2o_fleet_t *fleet, mav2odid_t *vehicles, uint16_t capacity, uint8_t channel)
+{
+    if (!fleet || !vehicles || capacity == 0 || channel >= MAVLINK_COMM_NUM_BUFFERS)
+        return ODID_FAIL;
+
+    memset(fleet, 0, sizeof(m2o_fleet_t));
+    fleet->vehicles = vehicles;
+    fleet->capacity = capacity;
+    fleet->mavlinkChannel = channel;
+    return ODID_SUCCESS;
+}
+
+/**
+* Find the vehicle with the given Mavlink system ID and component ID
+*
+* @return  The instance of the vehicle, or NULL if nothing has been received
+*          from it
+*/
+mav2odid_t *m2o_fleetFind(m2o_fleet_t *fleet, uint8_t systemId, uint8_t componentId)
+{
+    if (!fleet)
+        return NULL;
+
+    // The messages of a vehicle usually arrive together
+    if (fleet->last < fleet->count &&
+        fleet->vehicles[fleet->last].systemId == systemId &&
+        fleet->vehicles[fleet->last].componentId == componentId)
+        return &fleet->vehicles[fleet->last];
+
+    for (uint16_t i = 0; i < fleet->count; i++) {
+        if (fleet->vehicles[i].systemId == systemId &&
+            fleet->vehicles[i].componentId == componentId) {
+            fleet->last = i;
+            return &fleet->vehicles[i];
         }
     }
-    return ODID_MESSAGETYPE_INVALID;
+    return NULL;
+}
+
+/**
+* Find the vehicle with the given Mavlink system ID and component ID, or add it
+* to the table
+*
+* @return  The instance of the vehicle, or NULL if the table is full
+*/
+mav2odid_t *m2o_fleetGet(m2o_fleet_t *fleet, uint8_t systemId, uint8_t componentId)
+{
+    mav2odid_t *m2o = m2o_fleetFind(fleet, systemId, componentId);
+    if (m2o || !fleet || fleet->count >= fleet->capacity)
+        return m2o;
+
+    m2o = &fleet->vehicles[fleet->count];
+    if (m2o_init(m2o) != ODID_SUCCESS)
+        return NULL;
+    m2o->systemId = systemId;
+    m2o->componentId = componentId;
+    m2o->mavlinkChannel = fleet->mavlinkChannel;
+    fleet->last = fleet->count++;
+    return m2o;
+}
+
+/**
+* Remove a vehicle from the table, e.g. when it has landed
+*
+* The last vehicle of the table is moved into its place, so pointers to that
+* vehicle are no longer valid afterwards.
+*
+* @return  Success or fail, if the vehicle is not in the table
+*/
+int m2o_fleetRemove(m2o_fleet_t *fleet, uint8_t systemId, uint8_t componentId)
+{
+    mav2odid_t *m2o = m2o_fleetFind(fleet, systemId, componentId);
+    if (!m2o)
+        return ODID_FAIL;
+
+    fleet->count--;
+    if (m2o != &fleet->vehicles[fleet->count])
+        memcpy(m2o, &fleet->vehicles[fleet->count], sizeof(mav2odid_t));
+    fleet->last = 0;
+    return ODID_SUCCESS;
+}
+
+/**
+* Parse incoming data of a fleet link one byte at a time, see m2o_parseMavlink()
+*
+* @param  fleet  The table of vehicles
+* @param  data   One byte of data to be parsed
+* @param  m2o    Set to the vehicle that sent the decoded message. Can be NULL
+* @return        The type of message decoded
+*/
+ODID_messagetype_t m2o_fleetParseMavlink(m2o_fleet_t *fleet, uint8_t data, mav2odid_t **m2o)
+{
+    if (!fleet)
+        return ODID_MESSAGETYPE_INVALID;
+
+    mavlink_message_t message;
+    mavlink_status_t status;
+
+    if (!mavlink_parse_char(fleet->mavlinkChannel, data, &message, &status))
+        return ODID_MESSAGETYPE_INVALID;
+
+    // Other messages must not create vehicles
+    switch ((int) message.msgid)
+    {
+    case MAVLINK_MSG_ID_OPEN_DRONE_ID_BASIC_ID:
+    case MAVLINK_MSG_ID_OPEN_DRONE_ID_LOCATION:
+    case MAVLINK_MSG_ID_OPEN_DRONE_ID_AUTHENTICATION:
+    case MAVLINK_MSG_ID_OPEN_DRONE_ID_SELF_ID:
+    case MAVLINK_MSG_ID_OPEN_DRONE_ID_SYSTEM:
+    case MAVLINK_MSG_ID_OPEN_DRONE_ID_OPERATOR_ID:
+    case MAVLINK_MSG_ID_OPEN_DRONE_ID_MESSAGE_PACK:
+        break;
+    default:
+        return ODID_MESSAGETYPE_INVALID;
+    }
+
+    mav2odid_t *vehicle = m2o_fleetGet(fleet, message.sysid, message.compid);
+    if (!vehicle) {
+        fleet->dropped++;
+        return ODID_MESSAGETYPE_INVALID;
+    }
+    if (m2o)
+        *m2o = vehicle;
+    return m2o_dispatchMavlink(vehicle, &message);
+}
+
+/**
+* Parse a buffer of incoming data of a fleet link, see m2o_parseMavlinkBuffer()
+*
+* The callback is called with the instance of the vehicle that sent the message.
+* Messages from vehicles that do not fit in the table are counted in
+* fleet->dropped.
+*
+* @return  The number of decoded Open Drone ID messages, or -1
+*/
+int m2o_fleetParseMavlinkBuffer(m2o_fleet_t *fleet, const uint8_t *buf, size_t len,
+                                m2o_messageCallback callback)
+{
+    if (!fleet)
+        return -1;
+    return m2o_parseBuffer(NULL, fleet, fleet->rxBuf, &fleet->rxLen, buf, len, callback);
 }
 
 /**
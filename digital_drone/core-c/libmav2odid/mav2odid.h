@@ -38,23 +38,32 @@ mavlink_status_t m_mavlink_status[MAVLINK_COMM_NUM_BUFFERS];
 
 /*
  * Different transmitter implementations will be defining different sets of
- * messages to transmit. Therefore, it is possible to override the size of the
- * schedule list here. Define DRONEID_SCHEDULER_SIZE to the desired value
+ * messages to transmit. Therefore, it is possible to override the maximum size
+ * of the schedule list here. Define DRONEID_SCHEDULER_SIZE to the desired value
  * before including mav2odid.h. E.g. "-DDRONEID_SCHEDULER_SIZE=12" when calling
- * cmake. NOTE: Do not call the m2o_init() in this case, but create your own
- * suitable version of that function.
+ * cmake. A schedule cycle that would be longer is scaled down to this size, see
+ * m2o_setScheduleRates().
  */
 #ifndef DRONEID_SCHEDULER_SIZE
-#define DRONEID_SCHEDULER_SIZE (2 * (4 + ODID_AUTH_MAX_PAGES))
+#define DRONEID_SCHEDULER_SIZE (2 * (ODID_BASIC_ID_MAX_MESSAGES + ODID_AUTH_MAX_PAGES + 3))
 #endif
 #if (DRONEID_SCHEDULER_SIZE < 1) || (DRONEID_SCHEDULER_SIZE > 255)
 #error "DRONEID_SCHEDULER_SIZE must be between 1 and 255."
 #endif
 
+// The message types cycled by m2o_cycleMessages(), Basic ID to Operator ID
+#define M2O_SCHEDULE_TYPES (ODID_MESSAGETYPE_OPERATOR_ID + 1)
+#define M2O_RATE_EVERY_OTHER 0xFF  // Location rate for every second slot
+
 
 typedef struct {
     uint8_t droneidSchedule[DRONEID_SCHEDULER_SIZE];
+    uint8_t scheduleLength;     // The slots of the current cycle
     uint8_t scheduleIdx;
+    uint8_t scheduleRates[M2O_SCHEDULE_TYPES];
+    uint8_t scheduleChanged;    // Rebuild the cycle before the next slot
+    uint8_t basicIDIndex;
+    uint8_t authIndex;
 
     ODID_BasicID_encoded basicIdEnc[ODID_BASIC_ID_MAX_MESSAGES];
     ODID_Location_encoded locationEnc;
@@ -71,13 +80,49 @@ typedef struct {
     uint8_t systemEncValid;
     uint8_t operatorIDEncValid;
     uint8_t messagePackEncValid;
+
+    // The start of a Mavlink frame, which continues in the next buffer given
+    // to m2o_parseMavlinkBuffer()
+    uint8_t rxBuf[MAVLINK_MAX_PACKET_LEN];
+    uint16_t rxLen;
+    uint8_t mavlinkChannel;     // Parser state of m2o_parseMavlink(), 0 after m2o_init()
+
+    // The sender of the messages, when the instance is part of a m2o_fleet_t
+    uint8_t systemId;
+    uint8_t componentId;
 } mav2odid_t;
 
+typedef void (*m2o_messageCallback)(mav2odid_t *m2o, ODID_messagetype_t type);
+
+// The vehicles of one Mavlink link, by system ID and component ID
+typedef struct {
+    mav2odid_t *vehicles;       // Provided by the caller
+    uint16_t capacity;
+    uint16_t count;             // vehicles[0] to vehicles[count - 1] are in use
+    uint16_t last;              // The most recently found vehicle
+    uint8_t mavlinkChannel;
+    uint32_t dropped;           // Messages from vehicles that did not fit in the table
+
+    uint8_t rxBuf[MAVLINK_MAX_PACKET_LEN];
+    uint16_t rxLen;
+} m2o_fleet_t;
+
 int m2o_init(mav2odid_t *m2o);
+int m2o_setScheduleRates(mav2odid_t *m2o, const uint8_t rates[M2O_SCHEDULE_TYPES]);
 int m2o_cycleMessages(mav2odid_t *m2o, uint8_t *data);
 int m2o_collectMessagePack(mav2odid_t *m2o);
 
 ODID_messagetype_t m2o_parseMavlink(mav2odid_t *m2o, uint8_t data);
+int m2o_parseMavlinkBuffer(mav2odid_t *m2o, const uint8_t *buf, size_t len,
+                           m2o_messageCallback callback);
+
+int m2o_fleetInit(m2o_fleet_t *fleet, mav2odid_t *vehicles, uint16_t capacity, uint8_t channel);
+mav2odid_t *m2o_fleetFind(m2o_fleet_t *fleet, uint8_t systemId, uint8_t componentId);
+mav2odid_t *m2o_fleetGet(m2o_fleet_t *fleet, uint8_t systemId, uint8_t componentId);
+int m2o_fleetRemove(m2o_fleet_t *fleet, uint8_t systemId, uint8_t componentId);
+ODID_messagetype_t m2o_fleetParseMavlink(m2o_fleet_t *fleet, uint8_t data, mav2odid_t **m2o);
+int m2o_fleetParseMavlinkBuffer(m2o_fleet_t *fleet, const uint8_t *buf, size_t len,
+                                m2o_messageCallback callback);
 
 void m2o_basicId2Mavlink(mavlink_open_drone_id_basic_id_t *mavBasicId,
                          ODID_BasicID_data *basicId);
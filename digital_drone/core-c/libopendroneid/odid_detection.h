@@ -0,0 +1,116 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID C Library
+*/
+
+#ifndef _ODID_DETECTION_H_
+#define _ODID_DETECTION_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "opendroneid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+* Binary detection record, for sending what a receiver saw over serial
+* and UDP links instead of JSON text.
+*
+* A record has a fixed size and layout, all fields are little endian:
+*
+*   Offset Size Field
+*    0     1    Version, ODID_DETECTION_VERSION
+*    1     1    Size of the record, ODID_DETECTION_SIZE
+*    2     2    Valid, ODID_DETECTION_VALID_* bitmap
+*    4     4    Timestamp, ms of the receiver clock
+*    8     6    MAC address of the transmitter
+*   14     1    RSSI, dBm, signed
+*   15     1    Channel
+*   16    20    UAS ID, padded with NULL
+*   36     4    Latitude, 1e-7 deg, signed
+*   40     4    Longitude, 1e-7 deg, signed
+*   44     4    Operator latitude, 1e-7 deg, signed
+*   48     4    Operator longitude, 1e-7 deg, signed
+*   52     2    Geodetic altitude, 0.5 m, offset -1000 m as in the Location message
+*   54     2    Height, 0.5 m, offset -1000 m
+*   56     2    Horizontal speed, cm/s
+*   58     2    Direction, 0.01 deg
+*   60     2    Reserved, 0
+*   62     2    CRC-16/CCITT-FALSE of bytes 0 to 61
+*
+* Readers skip records with an unknown version, using the size field. The
+* CRC allows finding the record boundaries in a serial byte stream.
+*/
+
+#define ODID_DETECTION_VERSION  1
+#define ODID_DETECTION_SIZE     64
+
+#define ODID_DETECTION_VALID_ID             0x0001
+#define ODID_DETECTION_VALID_POSITION       0x0002
+#define ODID_DETECTION_VALID_ALTITUDE       0x0004
+#define ODID_DETECTION_VALID_HEIGHT         0x0008
+#define ODID_DETECTION_VALID_SPEED          0x0010
+#define ODID_DETECTION_VALID_DIRECTION      0x0020
+#define ODID_DETECTION_VALID_RSSI           0x0040
+#define ODID_DETECTION_VALID_CHANNEL        0x0080
+#define ODID_DETECTION_VALID_OPERATOR_POS   0x0100
+
+typedef struct ODID_Detection {
+    uint16_t Valid;             // ODID_DETECTION_VALID_* bitmap
+    uint32_t Timestamp;         // ms
+    uint8_t MAC[6];
+    int8_t RSSI;                // dBm
+    uint8_t Channel;
+    char UASID[ODID_ID_SIZE+1];
+    double Latitude;            // deg
+    double Longitude;           // deg
+    double OperatorLatitude;    // deg
+    double OperatorLongitude;   // deg
+    float AltitudeGeo;          // m
+    float Height;               // m
+    float SpeedHorizontal;      // m/s
+    float Direction;            // deg
+} ODID_Detection;
+
+/**
+ * odid_detectionFromUasData - fills a detection with the received drone data
+ * and sets the Valid bits of the fields that were received. Timestamp, MAC,
+ * RSSI and Channel are set by the caller.
+ */
+void odid_detectionFromUasData(ODID_Detection *det, const ODID_UAS_Data *UAS_Data);
+
+/**
+ * encodeDetectionRecord - writes a detection as binary record
+ * @outRecord: ODID_DETECTION_SIZE bytes
+ *
+ * Returns ODID_SUCCESS or ODID_FAIL
+ */
+int encodeDetectionRecord(uint8_t *outRecord, const ODID_Detection *inDet);
+
+/**
+ * decodeDetectionRecord - reads a binary record
+ * @inRecord: the record
+ * @size: bytes available at @inRecord
+ *
+ * Returns ODID_SUCCESS or ODID_FAIL if the record is incomplete, has an
+ * unknown version or a wrong CRC
+ */
+int decodeDetectionRecord(ODID_Detection *outDet, const uint8_t *inRecord, size_t size);
+
+/**
+ * odid_detectionToJson - writes a detection as one line JSON object, with
+ * only the valid fields
+ *
+ * Returns the length of the text, as snprintf()
+ */
+int odid_detectionToJson(char *buf, size_t size, const ODID_Detection *det);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ODID_DETECTION_H_
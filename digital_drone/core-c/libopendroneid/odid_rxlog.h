@@ -0,0 +1,109 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID C Library
+*/
+
+#ifndef _ODID_RXLOG_H_
+#define _ODID_RXLOG_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "opendroneid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+* Deferred receive log.
+*
+* A receive callback that must return quickly (e.g. the ESP32 promiscuous
+* mode callback, which runs in the WiFi task) only copies each frame with
+* its metadata into the log. A low priority task takes the frames out,
+* decodes them and prints the results.
+*
+* The log is a byte ring with variable size records, for one producer and
+* one consumer, which may run on different cores. When the ring is full
+* the new frame is dropped and counted, the producer never waits.
+*/
+
+#define ODID_RXLOG_ALIGN 8
+
+// Header of each record in the ring, followed by Length bytes of the frame
+typedef struct ODID_RxFrame {
+    uint32_t Timestamp; // ms
+    uint16_t Length;
+    int8_t RSSI;
+    uint8_t Channel;
+} ODID_RxFrame;
+
+typedef struct ODID_RxLog {
+    uint8_t *Buf;
+    uint32_t Mask;      // Size of Buf - 1
+    uint32_t Head;      // Bytes written, only changed by the producer
+    uint32_t Tail;      // Bytes read, only changed by the consumer
+    // Statistics, only changed by the producer
+    uint32_t Frames;
+    uint32_t Dropped;
+    uint32_t HighWater; // Max. bytes in use
+} ODID_RxLog;
+
+/**
+ * odid_initRxLog - initializes an empty log
+ * @log: log to initialize
+ * @buf: ring memory, aligned to ODID_RXLOG_ALIGN
+ * @size: size of @buf, a power of two
+ *
+ * Returns ODID_SUCCESS or ODID_FAIL
+ */
+int odid_initRxLog(ODID_RxLog *log, void *buf, uint32_t size);
+
+/**
+ * odid_rxLogPush - copies a received frame into the log. Producer side
+ *
+ * Returns ODID_SUCCESS or ODID_FAIL if the log is full and the frame was dropped
+ */
+int odid_rxLogPush(ODID_RxLog *log, const uint8_t *frame, uint16_t length,
+                   int8_t rssi, uint8_t channel, uint32_t timestamp);
+
+/**
+ * odid_rxLogPeek - returns the oldest frame in the log or NULL if it is empty.
+ *                  The frame data follows the header and stays valid until
+ *                  odid_rxLogPop(). Consumer side
+ */
+ODID_RxFrame *odid_rxLogPeek(ODID_RxLog *log);
+void odid_rxLogPop(ODID_RxLog *log);
+
+// Returns the frame data of a record returned by odid_rxLogPeek()
+static inline uint8_t *odid_rxFrameData(ODID_RxFrame *frame)
+{
+    return (uint8_t *) (frame + 1);
+}
+
+/**
+ * odid_rxFrameDecode - decodes the ODID data of a Beacon (ASD-STAN or Parrot
+ *                      vendor specific IE) or NAN action frame
+ * @UAS_Data: decoded data
+ * @mac: source MAC address of the frame
+ * @frame: IEEE 802.11 frame
+ * @length: length of @frame
+ *
+ * Returns ODID_SUCCESS or ODID_FAIL if the frame contains no ODID data
+ */
+int odid_rxFrameDecode(ODID_UAS_Data *UAS_Data, uint8_t *mac, uint8_t *frame, uint16_t length);
+
+/**
+ * odid_rxFrameFormat - writes a compact one line JSON record of a decoded frame
+ *
+ * Returns the length of the record, as snprintf()
+ */
+int odid_rxFrameFormat(char *buf, size_t size, const ODID_RxFrame *frame,
+                       const uint8_t *mac, const ODID_UAS_Data *UAS_Data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ODID_RXLOG_H_
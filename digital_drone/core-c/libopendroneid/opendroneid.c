@@ -151,6 +151,22 @@ void odid_initUasData(ODID_UAS_Data *data)
     odid_initOperatorIDData(&data->OperatorID);
 }
 
+/**
+* Initialize a message pack cache. No messages are present in the pack until
+* they are set via odid_packCacheSet*() or odid_packCacheUpdate()
+*
+* @param cache Message pack cache
+*/
+void odid_initPackCache(ODID_PackCache *cache)
+{
+    if (!cache)
+        return;
+    memset(cache, 0, sizeof(ODID_PackCache));
+    odid_initUasData(&cache->Data);
+    for (int i = 0; i < ODID_PACK_CACHE_ENTRIES; i++)
+        cache->Slot[i] = -1;
+}
+
 /**
 * Encode direction as defined by Open Drone ID
 *
@@ -557,6 +573,220 @@ int encodeMessagePack(ODID_MessagePack_encoded *outEncoded, ODID_MessagePack_dat
     return ODID_SUCCESS;
 }
 
+/**
+* Store the data of one message in the pack cache. The message is only marked
+* for encoding if it was not present or if its data differs from the cached data
+*
+* @param cache Message pack cache
+* @param entry ODID_PACK_CACHE_* entry of the message
+* @param dst   Cached data of the message
+* @param src   New data of the message
+* @param size  Size of the data structure
+* @param valid Valid flag of the message in the cached data
+*/
+static void packCacheSet(ODID_PackCache *cache, int entry, void *dst,
+                         const void *src, size_t size, uint8_t *valid)
+{
+    if (*valid && memcmp(dst, src, size) == 0)
+        return;
+    memcpy(dst, src, size);
+    *valid = 1;
+    cache->Valid |= 1UL << entry;
+    cache->Dirty |= 1UL << entry;
+}
+
+/**
+* Remove one message from the pack cache
+*
+* @param cache Message pack cache
+* @param entry ODID_PACK_CACHE_* entry of the message
+* @param valid Valid flag of the message in the cached data
+*/
+static void packCacheClear(ODID_PackCache *cache, int entry, uint8_t *valid)
+{
+    if (!*valid)
+        return;
+    *valid = 0;
+    cache->Valid &= ~(1UL << entry);
+    cache->Dirty &= ~(1UL << entry);
+}
+
+int odid_packCacheSetBasicID(ODID_PackCache *cache, int index, const ODID_BasicID_data *data)
+{
+    if (!cache || !data || !intInRange(index, 0, ODID_BASIC_ID_MAX_MESSAGES - 1))
+        return ODID_FAIL;
+    packCacheSet(cache, ODID_PACK_CACHE_BASIC_ID + index, &cache->Data.BasicID[index],
+                 data, sizeof(*data), &cache->Data.BasicIDValid[index]);
+    return ODID_SUCCESS;
+}
+
+int odid_packCacheSetLocation(ODID_PackCache *cache, const ODID_Location_data *data)
+{
+    if (!cache || !data)
+        return ODID_FAIL;
+    packCacheSet(cache, ODID_PACK_CACHE_LOCATION, &cache->Data.Location,
+                 data, sizeof(*data), &cache->Data.LocationValid);
+    return ODID_SUCCESS;
+}
+
+int odid_packCacheSetAuth(ODID_PackCache *cache, int page, const ODID_Auth_data *data)
+{
+    if (!cache || !data || !intInRange(page, 0, ODID_AUTH_MAX_PAGES - 1))
+        return ODID_FAIL;
+    packCacheSet(cache, ODID_PACK_CACHE_AUTH + page, &cache->Data.Auth[page],
+                 data, sizeof(*data), &cache->Data.AuthValid[page]);
+    return ODID_SUCCESS;
+}
+
+int odid_packCacheSetSelfID(ODID_PackCache *cache, const ODID_SelfID_data *data)
+{
+    if (!cache || !data)
+        return ODID_FAIL;
+    packCacheSet(cache, ODID_PACK_CACHE_SELF_ID, &cache->Data.SelfID,
+                 data, sizeof(*data), &cache->Data.SelfIDValid);
+    return ODID_SUCCESS;
+}
+
+int odid_packCacheSetSystem(ODID_PackCache *cache, const ODID_System_data *data)
+{
+    if (!cache || !data)
+        return ODID_FAIL;
+    packCacheSet(cache, ODID_PACK_CACHE_SYSTEM, &cache->Data.System,
+                 data, sizeof(*data), &cache->Data.SystemValid);
+    return ODID_SUCCESS;
+}
+
+int odid_packCacheSetOperatorID(ODID_PackCache *cache, const ODID_OperatorID_data *data)
+{
+    if (!cache || !data)
+        return ODID_FAIL;
+    packCacheSet(cache, ODID_PACK_CACHE_OPERATOR_ID, &cache->Data.OperatorID,
+                 data, sizeof(*data), &cache->Data.OperatorIDValid);
+    return ODID_SUCCESS;
+}
+
+/**
+* Update the pack cache from UAS data. Messages with the Valid flag set are
+* stored via the odid_packCacheSet*() functions. Other messages are removed
+*
+* @param cache   Message pack cache
+* @param uasData Structure containing the data of all messages
+* @return        ODID_SUCCESS or ODID_FAIL;
+*/
+int odid_packCacheUpdate(ODID_PackCache *cache, const ODID_UAS_Data *uasData)
+{
+    if (!cache || !uasData)
+        return ODID_FAIL;
+
+    for (int i = 0; i < ODID_BASIC_ID_MAX_MESSAGES; i++) {
+        if (uasData->BasicIDValid[i])
+            odid_packCacheSetBasicID(cache, i, &uasData->BasicID[i]);
+        else
+            packCacheClear(cache, ODID_PACK_CACHE_BASIC_ID + i, &cache->Data.BasicIDValid[i]);
+    }
+    if (uasData->LocationValid)
+        odid_packCacheSetLocation(cache, &uasData->Location);
+    else
+        packCacheClear(cache, ODID_PACK_CACHE_LOCATION, &cache->Data.LocationValid);
+    for (int i = 0; i < ODID_AUTH_MAX_PAGES; i++) {
+        if (uasData->AuthValid[i])
+            odid_packCacheSetAuth(cache, i, &uasData->Auth[i]);
+        else
+            packCacheClear(cache, ODID_PACK_CACHE_AUTH + i, &cache->Data.AuthValid[i]);
+    }
+    if (uasData->SelfIDValid)
+        odid_packCacheSetSelfID(cache, &uasData->SelfID);
+    else
+        packCacheClear(cache, ODID_PACK_CACHE_SELF_ID, &cache->Data.SelfIDValid);
+    if (uasData->SystemValid)
+        odid_packCacheSetSystem(cache, &uasData->System);
+    else
+        packCacheClear(cache, ODID_PACK_CACHE_SYSTEM, &cache->Data.SystemValid);
+    if (uasData->OperatorIDValid)
+        odid_packCacheSetOperatorID(cache, &uasData->OperatorID);
+    else
+        packCacheClear(cache, ODID_PACK_CACHE_OPERATOR_ID, &cache->Data.OperatorIDValid);
+    return ODID_SUCCESS;
+}
+
+/**
+* Encode one pack cache entry into its slot in the message pack
+*
+* @param cache Message pack cache
+* @param entry ODID_PACK_CACHE_* entry of the message
+* @return      ODID_SUCCESS or ODID_FAIL;
+*/
+static int encodePackCacheEntry(ODID_PackCache *cache, int entry)
+{
+    ODID_Message_encoded *msg = &cache->Pack.Messages[cache->Slot[entry]];
+    ODID_UAS_Data *data = &cache->Data;
+
+    if (entry < ODID_PACK_CACHE_LOCATION)
+        return encodeBasicIDMessage(&msg->basicId, &data->BasicID[entry - ODID_PACK_CACHE_BASIC_ID]);
+    if (entry == ODID_PACK_CACHE_LOCATION)
+        return encodeLocationMessage(&msg->location, &data->Location);
+    if (entry < ODID_PACK_CACHE_SELF_ID)
+        return encodeAuthMessage(&msg->auth, &data->Auth[entry - ODID_PACK_CACHE_AUTH]);
+    if (entry == ODID_PACK_CACHE_SELF_ID)
+        return encodeSelfIDMessage(&msg->selfId, &data->SelfID);
+    if (entry == ODID_PACK_CACHE_SYSTEM)
+        return encodeSystemMessage(&msg->system, &data->System);
+    return encodeOperatorIDMessage(&msg->operatorId, &data->OperatorID);
+}
+
+/**
+* Encode the message pack from the pack cache. Only the messages that have
+* been changed since the last call are encoded. If messages have been added or
+* removed, the order of the messages in the pack is recalculated
+*
+* @param cache      Message pack cache
+* @param outEncoded Output (encoded/packed) structure. Can be NULL, in which
+*                   case the result is only available in cache->Pack
+* @return           ODID_SUCCESS or ODID_FAIL;
+*/
+int encodePackCache(ODID_PackCache *cache, ODID_MessagePack_encoded *outEncoded)
+{
+    if (!cache)
+        return ODID_FAIL;
+
+    uint32_t layout = cache->Valid;
+    if (layout != cache->Layout) {
+        int8_t slot[ODID_PACK_CACHE_ENTRIES];
+        int amount = 0;
+        for (int i = 0; i < ODID_PACK_CACHE_ENTRIES; i++) {
+            if (layout & (1UL << i))
+                slot[i] = (int8_t) amount++;
+            else
+                slot[i] = -1;
+        }
+        if (amount == 0 || amount > ODID_PACK_MAX_MESSAGES)
+            return ODID_FAIL;
+
+        memcpy(cache->Slot, slot, sizeof(cache->Slot));
+        cache->Layout = layout;
+        cache->Dirty = layout;
+        cache->Pack.MessageType = ODID_MESSAGETYPE_PACKED;
+        cache->Pack.ProtoVersion = ODID_PROTOCOL_VERSION;
+        cache->Pack.SingleMessageSize = ODID_MESSAGE_SIZE;
+        cache->Pack.MsgPackSize = (uint8_t) amount;
+    }
+
+    uint32_t dirty = cache->Dirty & layout;
+    for (int i = 0; dirty; i++) {
+        if (!(dirty & (1UL << i)))
+            continue;
+        if (encodePackCacheEntry(cache, i) != ODID_SUCCESS)
+            return ODID_FAIL;
+        dirty &= ~(1UL << i);
+        cache->Dirty &= ~(1UL << i);
+    }
+
+    if (outEncoded)
+        memcpy(outEncoded, &cache->Pack, sizeof(ODID_MessagePack_encoded) -
+               (size_t) (ODID_PACK_MAX_MESSAGES - cache->Pack.MsgPackSize) * ODID_MESSAGE_SIZE);
+    return ODID_SUCCESS;
+}
+
 /**
 * Dencode direction from Open Drone ID packed message
 *
@@ -878,6 +1108,288 @@ int decodeMessagePack(ODID_UAS_Data *uasData, ODID_MessagePack_encoded *pack)
     return ODID_SUCCESS;
 }
 
+/**
+* Prepare a UAS data structure for receiving the content of a message pack
+*
+* Instead of initializing the full structure, only the Valid flags are cleared
+* and only the data fields that would not be completely overwritten by the
+* decoders are initialized. I.e. all Basic ID slots (the slot search depends on
+* the stored ID types) and the Auth pages present in the pack (non-zero pages
+* do not carry LastPageIndex, Length and Timestamp).
+*
+* @param uasData Structure to prepare
+* @param pack    Pointer to an encoded packed message with validated content
+*/
+static void prepareUasDataForPack(ODID_UAS_Data *uasData, ODID_MessagePack_encoded *pack)
+{
+    int basicIdInitialized = 0;
+
+    memset(uasData->BasicIDValid, 0, sizeof(uasData->BasicIDValid));
+    uasData->LocationValid = 0;
+    memset(uasData->AuthValid, 0, sizeof(uasData->AuthValid));
+    uasData->SelfIDValid = 0;
+    uasData->SystemValid = 0;
+    uasData->OperatorIDValid = 0;
+
+    for (int i = 0; i < pack->MsgPackSize; i++) {
+        switch (decodeMessageType(pack->Messages[i].rawData[0]))
+        {
+        case ODID_MESSAGETYPE_BASIC_ID:
+            if (!basicIdInitialized) {
+                for (int j = 0; j < ODID_BASIC_ID_MAX_MESSAGES; j++)
+                    odid_initBasicIDData(&uasData->BasicID[j]);
+                basicIdInitialized = 1;
+            }
+            break;
+        case ODID_MESSAGETYPE_AUTH: {
+            int pageNum;
+            if (getAuthPageNum(&pack->Messages[i].auth, &pageNum) == ODID_SUCCESS)
+                odid_initAuthData(&uasData->Auth[pageNum]);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+/**
+* Decode a batch of message packs from raw receive buffers
+*
+* Each buffer is decoded into the UAS data structure with the same index. The
+* output structures do not need to be initialized by the caller. Only the data
+* structures of message types present in a pack are touched. Data belonging to
+* message types that are not present in the pack is left as-is and must be
+* ignored, as indicated by the Valid flags being cleared.
+*
+* @param uasData Output: Array of count structures for the decoded data
+* @param packs   Array of count pointers to encoded message packs
+* @param lengths Array of count buffer lengths, one for each pack
+* @param status  Output: Array of count status codes, ODID_SUCCESS or ODID_FAIL
+* @param count   Number of packs to decode
+* @return        The number of packs decoded successfully
+*/
+int decodeMessagePackBatch(ODID_UAS_Data *uasData, uint8_t *packs[],
+                           size_t lengths[], int status[], int count)
+{
+    const size_t headerSize = sizeof(ODID_MessagePack_encoded) -
+                              ODID_PACK_MAX_MESSAGES * ODID_MESSAGE_SIZE;
+    int decoded = 0;
+
+    if (!uasData || !packs || !lengths || !status)
+        return 0;
+
+    for (int i = 0; i < count; i++) {
+        ODID_MessagePack_encoded *pack = (ODID_MessagePack_encoded *) packs[i];
+        status[i] = ODID_FAIL;
+
+        if (!pack || lengths[i] < headerSize)
+            continue;
+
+        if (pack->MessageType != ODID_MESSAGETYPE_PACKED ||
+            pack->SingleMessageSize != ODID_MESSAGE_SIZE ||
+            pack->MsgPackSize > ODID_PACK_MAX_MESSAGES ||
+            headerSize + pack->MsgPackSize * ODID_MESSAGE_SIZE > lengths[i])
+            continue;
+
+        if (checkPackContent(pack->Messages, pack->MsgPackSize) != ODID_SUCCESS)
+            continue;
+
+        prepareUasDataForPack(&uasData[i], pack);
+        for (int j = 0; j < pack->MsgPackSize; j++)
+            decodeOpenDroneID(&uasData[i], pack->Messages[j].rawData);
+
+        status[i] = ODID_SUCCESS;
+        decoded++;
+    }
+    return decoded;
+}
+
+/**
+* Get the message type of an encoded message without decoding it
+*
+* @param msg  Input message (encoded/packed)
+* @return     The message type: ODID_messagetype_t
+*/
+ODID_messagetype_t odid_view_type(const ODID_Message_encoded *msg)
+{
+    if (!msg)
+        return ODID_MESSAGETYPE_INVALID;
+    return decodeMessageType(msg->rawData[0]);
+}
+
+/**
+* Get the UAS ID of an encoded Basic ID message without decoding the rest
+*
+* @param msg    Input message (encoded/packed)
+* @param uasId  Output: null terminated UAS ID. Must hold ODID_ID_SIZE + 1 bytes
+* @return       ODID_SUCCESS or ODID_FAIL;
+*/
+int odid_view_uasid(const ODID_Message_encoded *msg, char *uasId)
+{
+    if (!msg || !uasId || msg->basicId.MessageType != ODID_MESSAGETYPE_BASIC_ID)
+        return ODID_FAIL;
+
+    safe_dec_copyfill(uasId, msg->basicId.UASID, ODID_ID_SIZE + 1);
+    return ODID_SUCCESS;
+}
+
+/**
+* Get the latitude of an encoded Location message without decoding the rest
+*
+* @param msg  Input message (encoded/packed)
+* @param lat  Output: latitude in degrees
+* @return     ODID_SUCCESS or ODID_FAIL;
+*/
+int odid_view_lat(const ODID_Message_encoded *msg, double *lat)
+{
+    if (!msg || !lat || msg->location.MessageType != ODID_MESSAGETYPE_LOCATION)
+        return ODID_FAIL;
+
+    *lat = decodeLatLon(msg->location.Latitude);
+    return ODID_SUCCESS;
+}
+
+/**
+* Get the longitude of an encoded Location message without decoding the rest
+*
+* @param msg  Input message (encoded/packed)
+* @param lon  Output: longitude in degrees
+* @return     ODID_SUCCESS or ODID_FAIL;
+*/
+int odid_view_lon(const ODID_Message_encoded *msg, double *lon)
+{
+    if (!msg || !lon || msg->location.MessageType != ODID_MESSAGETYPE_LOCATION)
+        return ODID_FAIL;
+
+    *lon = decodeLatLon(msg->location.Longitude);
+    return ODID_SUCCESS;
+}
+
+/**
+* Get the geodetic altitude of an encoded Location message
+*
+* @param msg  Input message (encoded/packed)
+* @param alt  Output: altitude in meters (WGS84-HAE)
+* @return     ODID_SUCCESS or ODID_FAIL;
+*/
+int odid_view_altitude_geo(const ODID_Message_encoded *msg, float *alt)
+{
+    if (!msg || !alt || msg->location.MessageType != ODID_MESSAGETYPE_LOCATION)
+        return ODID_FAIL;
+
+    *alt = decodeAltitude(msg->location.AltitudeGeo);
+    return ODID_SUCCESS;
+}
+
+/**
+* Get the horizontal speed and direction of an encoded Location message
+*
+* @param msg        Input message (encoded/packed)
+* @param speed      Output: horizontal speed in m/s
+* @param direction  Output: direction in degrees
+* @return           ODID_SUCCESS or ODID_FAIL;
+*/
+int odid_view_velocity(const ODID_Message_encoded *msg, float *speed, float *direction)
+{
+    if (!msg || !speed || !direction ||
+        msg->location.MessageType != ODID_MESSAGETYPE_LOCATION)
+        return ODID_FAIL;
+
+    *speed = decodeSpeedHorizontal(msg->location.SpeedHorizontal, msg->location.SpeedMult);
+    *direction = decodeDirection(msg->location.Direction, msg->location.EWDirection);
+    return ODID_SUCCESS;
+}
+
+/**
+* Get the timestamp of an encoded Location message
+*
+* @param msg        Input message (encoded/packed)
+* @param timestamp  Output: seconds after the full hour
+* @return           ODID_SUCCESS or ODID_FAIL;
+*/
+int odid_view_timestamp(const ODID_Message_encoded *msg, float *timestamp)
+{
+    if (!msg || !timestamp || msg->location.MessageType != ODID_MESSAGETYPE_LOCATION)
+        return ODID_FAIL;
+
+    *timestamp = decodeTimeStamp(msg->location.TimeStamp);
+    return ODID_SUCCESS;
+}
+
+/**
+* Get the operator ID of an encoded Operator ID message
+*
+* @param msg         Input message (encoded/packed)
+* @param operatorId  Output: null terminated ID. Must hold ODID_ID_SIZE + 1 bytes
+* @return            ODID_SUCCESS or ODID_FAIL;
+*/
+int odid_view_operator_id(const ODID_Message_encoded *msg, char *operatorId)
+{
+    if (!msg || !operatorId || msg->operatorId.MessageType != ODID_MESSAGETYPE_OPERATOR_ID)
+        return ODID_FAIL;
+
+    safe_dec_copyfill(operatorId, msg->operatorId.OperatorId, ODID_ID_SIZE + 1);
+    return ODID_SUCCESS;
+}
+
+/**
+* Find a message of the given type in an encoded message pack
+*
+* The pack header is validated against the buffer length, but the messages
+* themselves are not decoded.
+*
+* @param pack    Pointer to an encoded packed message
+* @param buflen  Length of the buffer holding the pack
+* @param type    The message type to look for
+* @param start   Index of the first message to consider
+* @return        Pointer to the message inside the pack or NULL if not found
+*/
+const ODID_Message_encoded *odid_view_pack_find(const ODID_MessagePack_encoded *pack,
+                                                size_t buflen, ODID_messagetype_t type,
+                                                int start)
+{
+    const size_t headerSize = sizeof(ODID_MessagePack_encoded) -
+                              ODID_PACK_MAX_MESSAGES * ODID_MESSAGE_SIZE;
+
+    if (!pack || buflen < headerSize ||
+        pack->MessageType != ODID_MESSAGETYPE_PACKED ||
+        pack->SingleMessageSize != ODID_MESSAGE_SIZE ||
+        pack->MsgPackSize > ODID_PACK_MAX_MESSAGES ||
+        headerSize + pack->MsgPackSize * ODID_MESSAGE_SIZE > buflen)
+        return NULL;
+
+    for (int i = start < 0 ? 0 : start; i < pack->MsgPackSize; i++) {
+        if (decodeMessageType(pack->Messages[i].rawData[0]) == type)
+            return &pack->Messages[i];
+    }
+    return NULL;
+}
+
+/**
+* Calculate a fingerprint of encoded data, e.g. a message or message pack
+*
+* This is a 32-bit FNV-1a hash. It is meant for quickly detecting repeated
+* transmissions of identical content before spending time on decoding.
+*
+* @param data  The encoded data
+* @param len   Length of the data in bytes
+* @return      The fingerprint
+*/
+uint32_t odid_view_fingerprint(const uint8_t *data, size_t len)
+{
+    uint32_t hash = 2166136261u;
+
+    if (!data)
+        return 0;
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
 /**
 * Decodes the message type of a packed Open Drone ID message
 *
@@ -1058,6 +1570,70 @@ static int intInRange(int inValue, int startRange, int endRange)
     }
 }
 
+/*
+ * Lookup tables for the accuracy conversions. The limit tables hold the lower
+ * limit of each enum interval in ascending order, i.e. the enum value with the
+ * best accuracy comes first. The value tables are indexed by the enum values.
+ *
+ * The limits are also read as their IEEE 754 bit patterns. Positive floats
+ * sort like their bit patterns as unsigned integers, so a single integer
+ * comparison checks that a value is in the range of the limits, which also
+ * excludes zero, negative values and NaN.
+ */
+typedef union {
+    float f;
+    uint32_t u;
+} floatBits;
+
+static const floatBits horizAccLimits[] = {
+    { 1 }, { 3 }, { 10 }, { 30 }, { 92.6f }, { 185.2f }, { 555.6f }, { 926 }, { 1852 },
+    { 3704 }, { 7408 }, { 18520 }
+};
+static const float horizAccValues[] = {
+    18520, 18520, 7808, 3704, 1852, 926, 555.6f, 185.2f, 92.6f, 30, 10, 3, 1
+};
+
+static const floatBits vertAccLimits[] = { { 1 }, { 3 }, { 10 }, { 25 }, { 45 }, { 150 } };
+static const float vertAccValues[] = { 150, 150, 45, 25, 10, 3, 1 };
+
+static const floatBits speedAccLimits[] = { { 0.3f }, { 1 }, { 3 }, { 10 } };
+static const float speedAccValues[] = { 10, 10, 3, 1, 0.3f };
+
+static const float timeAccLimits[] = {
+    0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.6f, 0.7f, 0.8f, 0.9f, 1.0f,
+    1.1f, 1.2f, 1.3f, 1.4f, 1.5f
+};
+static const float timeAccValues[] = {
+    0.0f, 0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.6f, 0.7f, 0.8f, 0.9f, 1.0f,
+    1.1f, 1.2f, 1.3f, 1.4f, 1.5f
+};
+
+/*
+ * The exponent and the top two mantissa bits of a float split the range of
+ * the limits into buckets of a quarter of a power of two each, starting with
+ * the bucket of the first limit. An entry holds the number of limits at or
+ * below the start of its bucket. The limits are more than a factor 1.25
+ * apart, so a bucket holds at most one of them and a single comparison
+ * completes the count. This replaces a search through the limits, which is
+ * slower than the if/else chains it replaced, in particular without compiler
+ * optimization.
+ */
+#define ACC_BUCKET_SHIFT 21
+#define ACC_BUCKET(limit) ((limit).u >> ACC_BUCKET_SHIFT)
+
+static const uint8_t horizAccBuckets[] = {
+    1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 5, 5, 5,
+    5, 6, 6, 6, 6, 6, 6, 6, 7, 7, 7, 8, 8, 8, 8, 9, 9, 9, 9, 10, 10, 10, 10, 11, 11, 11, 11, 11
+};
+static const uint8_t vertAccBuckets[] = {
+    1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 5, 5, 5, 5, 5, 5, 5
+};
+static const uint8_t speedAccBuckets[] = {
+    0, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 4
+};
+
+#define ARRAY_SIZE(a) ((int) (sizeof(a) / sizeof((a)[0])))
+
 /**
 * This converts a horizontal accuracy float value to the corresponding enum
 *
@@ -1066,34 +1642,14 @@ static int intInRange(int inValue, int startRange, int endRange)
 */
 ODID_Horizontal_accuracy_t createEnumHorizontalAccuracy(float Accuracy)
 {
-    if (Accuracy >= 18520)
-        return ODID_HOR_ACC_UNKNOWN;
-    else if (Accuracy >= 7408)
-        return ODID_HOR_ACC_10NM;
-    else if (Accuracy >= 3704)
-        return ODID_HOR_ACC_4NM;
-    else if (Accuracy >= 1852)
-        return ODID_HOR_ACC_2NM;
-    else if (Accuracy >= 926)
-        return ODID_HOR_ACC_1NM;
-    else if (Accuracy >= 555.6f)
-        return ODID_HOR_ACC_0_5NM;
-    else if (Accuracy >= 185.2f)
-        return ODID_HOR_ACC_0_3NM;
-    else if (Accuracy >= 92.6f)
-        return ODID_HOR_ACC_0_1NM;
-    else if (Accuracy >= 30)
-        return ODID_HOR_ACC_0_05NM;
-    else if (Accuracy >= 10)
-        return ODID_HOR_ACC_30_METER;
-    else if (Accuracy >= 3)
-        return ODID_HOR_ACC_10_METER;
-    else if (Accuracy >= 1)
-        return ODID_HOR_ACC_3_METER;
-    else if (Accuracy > 0)
-        return ODID_HOR_ACC_1_METER;
-    else
-        return ODID_HOR_ACC_UNKNOWN;
+    floatBits bits = { .f = Accuracy };
+
+    if (bits.u - horizAccLimits[0].u >= horizAccLimits[ARRAY_SIZE(horizAccLimits) - 1].u - horizAccLimits[0].u)
+        return Accuracy > 0 && Accuracy < horizAccLimits[0].f ? ODID_HOR_ACC_1_METER : ODID_HOR_ACC_UNKNOWN;
+
+    int passed = horizAccBuckets[ACC_BUCKET(bits) - ACC_BUCKET(horizAccLimits[0])];
+    passed += (Accuracy >= horizAccLimits[passed].f);
+    return (ODID_Horizontal_accuracy_t) (ODID_HOR_ACC_1_METER - passed);
 }
 
 /**
@@ -1104,22 +1660,14 @@ ODID_Horizontal_accuracy_t createEnumHorizontalAccuracy(float Accuracy)
 */
 ODID_Vertical_accuracy_t createEnumVerticalAccuracy(float Accuracy)
 {
-    if (Accuracy >= 150)
-        return ODID_VER_ACC_UNKNOWN;
-    else if (Accuracy >= 45)
-        return ODID_VER_ACC_150_METER;
-    else if (Accuracy >= 25)
-        return ODID_VER_ACC_45_METER;
-    else if (Accuracy >= 10)
-        return ODID_VER_ACC_25_METER;
-    else if (Accuracy >= 3)
-        return ODID_VER_ACC_10_METER;
-    else if (Accuracy >= 1)
-        return ODID_VER_ACC_3_METER;
-    else if (Accuracy > 0)
-        return ODID_VER_ACC_1_METER;
-    else
-        return ODID_VER_ACC_UNKNOWN;
+    floatBits bits = { .f = Accuracy };
+
+    if (bits.u - vertAccLimits[0].u >= vertAccLimits[ARRAY_SIZE(vertAccLimits) - 1].u - vertAccLimits[0].u)
+        return Accuracy > 0 && Accuracy < vertAccLimits[0].f ? ODID_VER_ACC_1_METER : ODID_VER_ACC_UNKNOWN;
+
+    int passed = vertAccBuckets[ACC_BUCKET(bits) - ACC_BUCKET(vertAccLimits[0])];
+    passed += (Accuracy >= vertAccLimits[passed].f);
+    return (ODID_Vertical_accuracy_t) (ODID_VER_ACC_1_METER - passed);
 }
 
 /**
@@ -1130,18 +1678,15 @@ ODID_Vertical_accuracy_t createEnumVerticalAccuracy(float Accuracy)
 */
 ODID_Speed_accuracy_t createEnumSpeedAccuracy(float Accuracy)
 {
-    if (Accuracy >= 10)
-        return ODID_SPEED_ACC_UNKNOWN;
-    else if (Accuracy >= 3)
-        return ODID_SPEED_ACC_10_METERS_PER_SECOND;
-    else if (Accuracy >= 1)
-        return ODID_SPEED_ACC_3_METERS_PER_SECOND;
-    else if (Accuracy >= 0.3f)
-        return ODID_SPEED_ACC_1_METERS_PER_SECOND;
-    else if (Accuracy > 0)
-        return ODID_SPEED_ACC_0_3_METERS_PER_SECOND;
-    else
-        return ODID_SPEED_ACC_UNKNOWN;
+    floatBits bits = { .f = Accuracy };
+
+    if (bits.u - speedAccLimits[0].u >= speedAccLimits[ARRAY_SIZE(speedAccLimits) - 1].u - speedAccLimits[0].u)
+        return Accuracy > 0 && Accuracy < speedAccLimits[0].f ? ODID_SPEED_ACC_0_3_METERS_PER_SECOND :
+                                                                ODID_SPEED_ACC_UNKNOWN;
+
+    int passed = speedAccBuckets[ACC_BUCKET(bits) - ACC_BUCKET(speedAccLimits[0])];
+    passed += (Accuracy >= speedAccLimits[passed].f);
+    return (ODID_Speed_accuracy_t) (ODID_SPEED_ACC_0_3_METERS_PER_SECOND - passed);
 }
 
 /**
@@ -1152,40 +1697,17 @@ ODID_Speed_accuracy_t createEnumSpeedAccuracy(float Accuracy)
 */
 ODID_Timestamp_accuracy_t createEnumTimestampAccuracy(float Accuracy)
 {
-    if (Accuracy > 1.5f)
-        return ODID_TIME_ACC_UNKNOWN;
-    else if (Accuracy > 1.4f)
-        return ODID_TIME_ACC_1_5_SECOND;
-    else if (Accuracy > 1.3f)
-        return ODID_TIME_ACC_1_4_SECOND;
-    else if (Accuracy > 1.2f)
-        return ODID_TIME_ACC_1_3_SECOND;
-    else if (Accuracy > 1.1f)
-        return ODID_TIME_ACC_1_2_SECOND;
-    else if (Accuracy > 1.0f)
-        return ODID_TIME_ACC_1_1_SECOND;
-    else if (Accuracy > 0.9f)
-        return ODID_TIME_ACC_1_0_SECOND;
-    else if (Accuracy > 0.8f)
-        return ODID_TIME_ACC_0_9_SECOND;
-    else if (Accuracy > 0.7f)
-        return ODID_TIME_ACC_0_8_SECOND;
-    else if (Accuracy > 0.6f)
-        return ODID_TIME_ACC_0_7_SECOND;
-    else if (Accuracy > 0.5f)
-        return ODID_TIME_ACC_0_6_SECOND;
-    else if (Accuracy > 0.4f)
-        return ODID_TIME_ACC_0_5_SECOND;
-    else if (Accuracy > 0.3f)
-        return ODID_TIME_ACC_0_4_SECOND;
-    else if (Accuracy > 0.2f)
-        return ODID_TIME_ACC_0_3_SECOND;
-    else if (Accuracy > 0.1f)
-        return ODID_TIME_ACC_0_2_SECOND;
-    else if (Accuracy > 0.0f)
-        return ODID_TIME_ACC_0_1_SECOND;
-    else
+    if (!(Accuracy > 0) || Accuracy > timeAccLimits[ARRAY_SIZE(timeAccLimits) - 1])
         return ODID_TIME_ACC_UNKNOWN;
+
+    // The limits are spaced 0.1 s apart, so the interval can be calculated
+    // directly. Compare with the neighbouring limits to correct for rounding.
+    int passed = (int) (Accuracy * 10);
+    if (passed > 0 && !(Accuracy > timeAccLimits[passed - 1]))
+        passed--;
+    else if (passed < ARRAY_SIZE(timeAccLimits) && Accuracy > timeAccLimits[passed])
+        passed++;
+    return (ODID_Timestamp_accuracy_t) (ODID_TIME_ACC_0_1_SECOND + passed);
 }
 
 /**
@@ -1196,37 +1718,9 @@ ODID_Timestamp_accuracy_t createEnumTimestampAccuracy(float Accuracy)
 */
 float decodeHorizontalAccuracy(ODID_Horizontal_accuracy_t Accuracy)
 {
-    switch (Accuracy)
-    {
-    case ODID_HOR_ACC_UNKNOWN:
-        return 18520;
-    case ODID_HOR_ACC_10NM:
-        return 18520;
-    case ODID_HOR_ACC_4NM:
-        return 7808;
-    case ODID_HOR_ACC_2NM:
-        return 3704;
-    case ODID_HOR_ACC_1NM:
-        return 1852;
-    case ODID_HOR_ACC_0_5NM:
-        return 926;
-    case ODID_HOR_ACC_0_3NM:
-        return 555.6f;
-    case ODID_HOR_ACC_0_1NM:
-        return 185.2f;
-    case ODID_HOR_ACC_0_05NM:
-        return 92.6f;
-    case ODID_HOR_ACC_30_METER:
-        return 30;
-    case ODID_HOR_ACC_10_METER:
-        return 10;
-    case ODID_HOR_ACC_3_METER:
-        return 3;
-    case ODID_HOR_ACC_1_METER:
-        return 1;
-    default:
-        return 18520;
-    }
+    if ((unsigned int) Accuracy >= (unsigned int) ARRAY_SIZE(horizAccValues))
+        return horizAccValues[ODID_HOR_ACC_UNKNOWN];
+    return horizAccValues[Accuracy];
 }
 
 /**
@@ -1237,25 +1731,9 @@ float decodeHorizontalAccuracy(ODID_Horizontal_accuracy_t Accuracy)
 */
 float decodeVerticalAccuracy(ODID_Vertical_accuracy_t Accuracy)
 {
-    switch (Accuracy)
-    {
-    case ODID_VER_ACC_UNKNOWN:
-        return 150;
-    case ODID_VER_ACC_150_METER:
-        return 150;
-    case ODID_VER_ACC_45_METER:
-        return 45;
-    case ODID_VER_ACC_25_METER:
-        return 25;
-    case ODID_VER_ACC_10_METER:
-        return 10;
-    case ODID_VER_ACC_3_METER:
-        return 3;
-    case ODID_VER_ACC_1_METER:
-        return 1;
-    default:
-        return 150;
-    }
+    if ((unsigned int) Accuracy >= (unsigned int) ARRAY_SIZE(vertAccValues))
+        return vertAccValues[ODID_VER_ACC_UNKNOWN];
+    return vertAccValues[Accuracy];
 }
 
 /**
@@ -1266,21 +1744,9 @@ float decodeVerticalAccuracy(ODID_Vertical_accuracy_t Accuracy)
 */
 float decodeSpeedAccuracy(ODID_Speed_accuracy_t Accuracy)
 {
-    switch (Accuracy)
-    {
-    case ODID_SPEED_ACC_UNKNOWN:
-        return 10;
-    case ODID_SPEED_ACC_10_METERS_PER_SECOND:
-        return 10;
-    case ODID_SPEED_ACC_3_METERS_PER_SECOND:
-        return 3;
-    case ODID_SPEED_ACC_1_METERS_PER_SECOND:
-        return 1;
-    case ODID_SPEED_ACC_0_3_METERS_PER_SECOND:
-        return 0.3f;
-    default:
-        return 10;
-    }
+    if ((unsigned int) Accuracy >= (unsigned int) ARRAY_SIZE(speedAccValues))
+        return speedAccValues[ODID_SPEED_ACC_UNKNOWN];
+    return speedAccValues[Accuracy];
 }
 
 /**
@@ -1291,43 +1757,9 @@ float decodeSpeedAccuracy(ODID_Speed_accuracy_t Accuracy)
 */
 float decodeTimestampAccuracy(ODID_Timestamp_accuracy_t Accuracy)
 {
-    switch (Accuracy)
-    {
-    case ODID_TIME_ACC_UNKNOWN:
-        return 0.0f;
-    case ODID_TIME_ACC_0_1_SECOND:
-        return 0.1f;
-    case ODID_TIME_ACC_0_2_SECOND:
-        return 0.2f;
-    case ODID_TIME_ACC_0_3_SECOND:
-        return 0.3f;
-    case ODID_TIME_ACC_0_4_SECOND:
-        return 0.4f;
-    case ODID_TIME_ACC_0_5_SECOND:
-        return 0.5f;
-    case ODID_TIME_ACC_0_6_SECOND:
-        return 0.6f;
-    case ODID_TIME_ACC_0_7_SECOND:
-        return 0.7f;
-    case ODID_TIME_ACC_0_8_SECOND:
-        return 0.8f;
-    case ODID_TIME_ACC_0_9_SECOND:
-        return 0.9f;
-    case ODID_TIME_ACC_1_0_SECOND:
-        return 1.0f;
-    case ODID_TIME_ACC_1_1_SECOND:
-        return 1.1f;
-    case ODID_TIME_ACC_1_2_SECOND:
-        return 1.2f;
-    case ODID_TIME_ACC_1_3_SECOND:
-        return 1.3f;
-    case ODID_TIME_ACC_1_4_SECOND:
-        return 1.4f;
-    case ODID_TIME_ACC_1_5_SECOND:
-        return 1.5f;
-    default:
-        return 0.0f;
-    }
+    if ((unsigned int) Accuracy >= (unsigned int) ARRAY_SIZE(timeAccValues))
+        return timeAccValues[ODID_TIME_ACC_UNKNOWN];
+    return timeAccValues[Accuracy];
 }
 
 #ifndef ODID_DISABLE_PRINTF
@@ -0,0 +1,136 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID C Library
+*/
+
+#include <string.h>
+
+#include "odid_json.h"
+#include "odid_rxlog.h"
+
+// Length of the record that fills the rest of the ring before it wraps around
+#define RXLOG_WRAP 0xFFFF
+
+#define IEEE80211_HDR_LEN       24
+
+static uint32_t recordSize(uint32_t length)
+{
+    return (uint32_t) (sizeof(ODID_RxFrame) + length + ODID_RXLOG_ALIGN - 1) &
+           ~(uint32_t) (ODID_RXLOG_ALIGN - 1);
+}
+
+int odid_initRxLog(ODID_RxLog *log, void *buf, uint32_t size)
+{
+    if (!log || !buf || size < 2 * ODID_RXLOG_ALIGN || (size & (size - 1)) ||
+        ((uintptr_t) buf & (ODID_RXLOG_ALIGN - 1)))
+        return ODID_FAIL;
+
+    memset(log, 0, sizeof(*log));
+    log->Buf = (uint8_t *) buf;
+    log->Mask = size - 1;
+    return ODID_SUCCESS;
+}
+
+int odid_rxLogPush(ODID_RxLog *log, const uint8_t *frame, uint16_t length,
+                   int8_t rssi, uint8_t channel, uint32_t timestamp)
+{
+    uint32_t size = log->Mask + 1;
+    uint32_t head = log->Head;
+    uint32_t used = head - __atomic_load_n(&log->Tail, __ATOMIC_ACQUIRE);
+    uint32_t contig = size - (head & log->Mask);
+    uint32_t need = recordSize(length);
+    ODID_RxFrame *record;
+
+    __atomic_store_n(&log->Frames, log->Frames + 1, __ATOMIC_RELAXED);
+
+    // A record never wraps around, the end of the ring is skipped instead
+    if (length == RXLOG_WRAP || need + (contig < need ? contig : 0) > size - used) {
+        __atomic_store_n(&log->Dropped, log->Dropped + 1, __ATOMIC_RELAXED);
+        return ODID_FAIL;
+    }
+    if (contig < need) {
+        record = (ODID_RxFrame *) (log->Buf + (head & log->Mask));
+        record->Length = RXLOG_WRAP;
+        head += contig;
+        used += contig;
+    }
+
+    record = (ODID_RxFrame *) (log->Buf + (head & log->Mask));
+    record->Timestamp = timestamp;
+    record->Length = length;
+    record->RSSI = rssi;
+    record->Channel = channel;
+    memcpy(record + 1, frame, length);
+
+    __atomic_store_n(&log->Head, head + need, __ATOMIC_RELEASE);
+    if (used + need > log->HighWater)
+        __atomic_store_n(&log->HighWater, used + need, __ATOMIC_RELAXED);
+    return ODID_SUCCESS;
+}
+
+ODID_RxFrame *odid_rxLogPeek(ODID_RxLog *log)
+{
+    uint32_t tail = log->Tail;
+    ODID_RxFrame *record;
+
+    if (tail == __atomic_load_n(&log->Head, __ATOMIC_ACQUIRE))
+        return NULL;
+
+    record = (ODID_RxFrame *) (log->Buf + (tail & log->Mask));
+    if (record->Length == RXLOG_WRAP) {
+        // The producer wrote the wrap marker and the next record together
+        tail += log->Mask + 1 - (tail & log->Mask);
+        __atomic_store_n(&log->Tail, tail, __ATOMIC_RELEASE);
+        record = (ODID_RxFrame *) log->Buf;
+    }
+    return record;
+}
+
+void odid_rxLogPop(ODID_RxLog *log)
+{
+    ODID_RxFrame *record = (ODID_RxFrame *) (log->Buf + (log->Tail & log->Mask));
+
+    __atomic_store_n(&log->Tail, log->Tail + recordSize(record->Length), __ATOMIC_RELEASE);
+}
+
+int odid_rxFrameDecode(ODID_UAS_Data *UAS_Data, uint8_t *mac, uint8_t *frame, uint16_t length)
+{
+    static const uint8_t nanDest[6] = { 0x51, 0x6f, 0x9a, 0x01, 0x00, 0x00 };
+
+    if (length < IEEE80211_HDR_LEN)
+        return ODID_FAIL;
+    memcpy(mac, &frame[10], 6);
+
+    char frameMac[6];
+    if (frame[0] == 0x80 && odid_wifi_receive_beacon_frame(UAS_Data, frameMac, frame, length) == 0)
+        return ODID_SUCCESS;
+    if (frame[0] == 0xD0 && memcmp(&frame[4], nanDest, 6) == 0 &&
+        odid_wifi_receive_message_pack_nan_action_frame(UAS_Data, frameMac, frame, length) == 0)
+        return ODID_SUCCESS;
+    return ODID_FAIL;
+}
+
+int odid_rxFrameFormat(char *buf, size_t size, const ODID_RxFrame *frame,
+                       const uint8_t *mac, const ODID_UAS_Data *UAS_Data)
+{
+    int len;
+
+    len = odid_jsonAppend(buf, size, 0, "{\"t\":%lu,\"mac\":\"%02x:%02x:%02x:%02x:%02x:%02x\",\"rssi\":%d,\"ch\":%u",
+                          (unsigned long) frame->Timestamp, mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
+                          frame->RSSI, frame->Channel);
+    if (UAS_Data->BasicIDValid[0]) {
+        len = odid_jsonAppend(buf, size, len, ",\"id\":");
+        len = odid_jsonAppendString(buf, size, len, UAS_Data->BasicID[0].UASID, ODID_ID_SIZE);
+    }
+    if (UAS_Data->LocationValid)
+        len = odid_jsonAppend(buf, size, len, ",\"lat\":%.7f,\"lon\":%.7f,\"alt\":%.1f",
+                              UAS_Data->Location.Latitude, UAS_Data->Location.Longitude,
+                              (double) UAS_Data->Location.AltitudeGeo);
+    if (UAS_Data->OperatorIDValid) {
+        len = odid_jsonAppend(buf, size, len, ",\"op\":");
+        len = odid_jsonAppendString(buf, size, len, UAS_Data->OperatorID.OperatorId, ODID_ID_SIZE);
+    }
+    return odid_jsonAppend(buf, size, len, "}");
+}
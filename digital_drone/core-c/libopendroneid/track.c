@@ -0,0 +1,345 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID C Library
+*/
+
+#include <string.h>
+#include <stddef.h>
+
+#include "odid_track.h"
+
+#define WHEEL_MASK (ODID_TRACK_WHEEL_SLOTS - 1)
+
+// Compares times that may have wrapped around
+#define TIME_AFTER_EQ(a, b) ((int32_t) ((a) - (b)) >= 0)
+// Same for wheel ticks, which wrap around at 2^(32 - TickShift)
+#define TICK_AFTER_EQ(table, a, b) ((int32_t) (((a) - (b)) << (table)->TickShift) >= 0)
+
+static uint32_t hashMAC(const uint8_t *mac)
+{
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < 6; i++)
+        hash = (hash ^ mac[i]) * 16777619u;
+    return hash;
+}
+
+static uint32_t hashID(const char *uasId)
+{
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < ODID_ID_SIZE && uasId[i]; i++)
+        hash = (hash ^ (uint8_t) uasId[i]) * 16777619u;
+    return hash;
+}
+
+/**
+* Open addressing with linear probing. The entries are track indexes,
+* ODID_TRACK_NONE marks an empty bucket. Removal shifts the following
+* entries back instead of leaving tombstones, so lookups never get slower
+* as drones come and go.
+*/
+static uint32_t indexFindSlot(const ODID_TrackTable *table, const uint16_t *index,
+                              uint32_t hash, uint16_t track)
+{
+    uint32_t pos = hash & table->IndexMask;
+    while (index[pos] != track)
+        pos = (pos + 1) & table->IndexMask;
+    return pos;
+}
+
+static void indexInsert(ODID_TrackTable *table, uint16_t *index, uint32_t hash, uint16_t track)
+{
+    index[indexFindSlot(table, index, hash, ODID_TRACK_NONE)] = track;
+}
+
+static void indexRemove(ODID_TrackTable *table, uint16_t *index, int isID, uint16_t track)
+{
+    const ODID_Track *t = &table->Tracks[track];
+    uint32_t mask = table->IndexMask;
+    uint32_t hole = indexFindSlot(table, index, isID ? t->IDHash : t->MACHash, track);
+    uint32_t pos = hole;
+
+    for (;;) {
+        pos = (pos + 1) & mask;
+        if (index[pos] == ODID_TRACK_NONE)
+            break;
+
+        const ODID_Track *moved = &table->Tracks[index[pos]];
+        uint32_t home = (isID ? moved->IDHash : moved->MACHash) & mask;
+        // The entry can fill the hole unless its home bucket is cyclically in (hole, pos]
+        if (((pos - home) & mask) >= ((pos - hole) & mask)) {
+            index[hole] = index[pos];
+            hole = pos;
+        }
+    }
+    index[hole] = ODID_TRACK_NONE;
+}
+
+static void lruUnlink(ODID_TrackTable *table, uint16_t track)
+{
+    ODID_Track *t = &table->Tracks[track];
+
+    if (t->LruPrev != ODID_TRACK_NONE)
+        table->Tracks[t->LruPrev].LruNext = t->LruNext;
+    else
+        table->LruHead = t->LruNext;
+    if (t->LruNext != ODID_TRACK_NONE)
+        table->Tracks[t->LruNext].LruPrev = t->LruPrev;
+    else
+        table->LruTail = t->LruPrev;
+}
+
+static void lruPushHead(ODID_TrackTable *table, uint16_t track)
+{
+    ODID_Track *t = &table->Tracks[track];
+
+    t->LruPrev = ODID_TRACK_NONE;
+    t->LruNext = table->LruHead;
+    if (table->LruHead != ODID_TRACK_NONE)
+        table->Tracks[table->LruHead].LruPrev = track;
+    else
+        table->LruTail = track;
+    table->LruHead = track;
+}
+
+static void wheelUnlink(ODID_TrackTable *table, uint16_t track)
+{
+    ODID_Track *t = &table->Tracks[track];
+
+    if (t->WheelPrev != ODID_TRACK_NONE)
+        table->Tracks[t->WheelPrev].WheelNext = t->WheelNext;
+    else
+        table->Wheel[t->WheelSlot] = t->WheelNext;
+    if (t->WheelNext != ODID_TRACK_NONE)
+        table->Tracks[t->WheelNext].WheelPrev = t->WheelPrev;
+}
+
+static void wheelInsert(ODID_TrackTable *table, uint16_t track, uint8_t slot)
+{
+    ODID_Track *t = &table->Tracks[track];
+
+    t->WheelSlot = slot;
+    t->WheelPrev = ODID_TRACK_NONE;
+    t->WheelNext = table->Wheel[slot];
+    if (t->WheelNext != ODID_TRACK_NONE)
+        table->Tracks[t->WheelNext].WheelPrev = track;
+    table->Wheel[slot] = track;
+}
+
+// The slot of the first tick at or after the expiry time, so that no track
+// is expired early
+static uint8_t wheelSlot(const ODID_TrackTable *table, uint32_t expires)
+{
+    uint32_t roundUp = ((uint32_t) 1 << table->TickShift) - 1;
+    return (uint8_t) (((expires + roundUp) >> table->TickShift) & WHEEL_MASK);
+}
+
+int odid_initTrackTable(ODID_TrackTable *table, ODID_Track *tracks, uint16_t capacity,
+                        uint16_t *index, uint32_t buckets, uint32_t timeout,
+                        ODID_TrackEvictFn evict, void *ctx)
+{
+    if (!table || !tracks || !index || capacity == 0 || capacity > ODID_TRACK_MAX_CAPACITY)
+        return ODID_FAIL;
+    // An empty bucket must remain, otherwise probing would never end
+    if (buckets <= capacity || (buckets & (buckets - 1)))
+        return ODID_FAIL;
+
+    memset(table, 0, sizeof(*table));
+    table->Tracks = tracks;
+    table->MACIndex = index;
+    table->IDIndex = index + buckets;
+    table->IndexMask = buckets - 1;
+    table->Capacity = capacity;
+    table->Timeout = timeout;
+    table->Evict = evict;
+    table->EvictCtx = ctx;
+    table->LruHead = table->LruTail = ODID_TRACK_NONE;
+
+    // Keep the expiry horizon within one turn of the wheel, with a slot for rounding
+    while (((timeout >> table->TickShift) + 2) >= ODID_TRACK_WHEEL_SLOTS)
+        table->TickShift++;
+
+    for (uint32_t i = 0; i < 2 * buckets; i++)
+        index[i] = ODID_TRACK_NONE;
+    for (int i = 0; i < ODID_TRACK_WHEEL_SLOTS; i++)
+        table->Wheel[i] = ODID_TRACK_NONE;
+
+    memset(tracks, 0, capacity * sizeof(ODID_Track));
+    for (uint16_t i = 0; i < capacity; i++)
+        tracks[i].LruNext = (uint16_t) (i + 1 < capacity ? i + 1 : ODID_TRACK_NONE);
+    table->FreeList = 0;
+    return ODID_SUCCESS;
+}
+
+int odid_trackFind(const ODID_TrackTable *table, const uint8_t *mac)
+{
+    uint32_t pos = hashMAC(mac) & table->IndexMask;
+    uint16_t track;
+
+    while ((track = table->MACIndex[pos]) != ODID_TRACK_NONE) {
+        if (memcmp(table->Tracks[track].MAC, mac, 6) == 0)
+            return track;
+        pos = (pos + 1) & table->IndexMask;
+    }
+    return -1;
+}
+
+int odid_trackFindID(const ODID_TrackTable *table, const char *uasId)
+{
+    uint32_t pos = hashID(uasId) & table->IndexMask;
+    uint16_t track;
+
+    while ((track = table->IDIndex[pos]) != ODID_TRACK_NONE) {
+        if (strncmp(table->Tracks[track].UASID, uasId, ODID_ID_SIZE) == 0)
+            return track;
+        pos = (pos + 1) & table->IndexMask;
+    }
+    return -1;
+}
+
+static void trackRelease(ODID_TrackTable *table, uint16_t track, int notify)
+{
+    ODID_Track *t = &table->Tracks[track];
+
+    if (notify && table->Evict)
+        table->Evict(table->EvictCtx, track, t);
+
+    indexRemove(table, table->MACIndex, 0, track);
+    if (t->IDIndexed)
+        indexRemove(table, table->IDIndex, 1, track);
+    lruUnlink(table, track);
+    wheelUnlink(table, track);
+    table->Count--;
+
+    t->InUse = 0;
+    t->IDIndexed = 0;
+    t->LruNext = table->FreeList;
+    table->FreeList = track;
+}
+
+void odid_trackRemove(ODID_TrackTable *table, int index)
+{
+    if (index < 0 || index >= table->Capacity || !table->Tracks[index].InUse)
+        return;
+    trackRelease(table, (uint16_t) index, 0);
+}
+
+// The clock may start anywhere, e.g. at epoch ms truncated to 32 bits. Ticks more
+// than half the tick range after NextTick would otherwise compare as before it.
+// After that, the time of the table only moves forward: a frame handed over late,
+// e.g. by another decoding thread, must not move a track back to an earlier expiry
+static uint32_t tableTime(ODID_TrackTable *table, uint32_t now)
+{
+    if (!table->WheelStarted) {
+        table->NextTick = now >> table->TickShift;
+        table->WheelStarted = 1;
+        table->Now = now;
+    } else if (TIME_AFTER_EQ(now, table->Now)) {
+        table->Now = now;
+    }
+    return table->Now;
+}
+
+int odid_trackUpdate(ODID_TrackTable *table, const uint8_t *mac, uint32_t now)
+{
+    int found = odid_trackFind(table, mac);
+    uint16_t track;
+    ODID_Track *t;
+    uint8_t slot;
+
+    now = tableTime(table, now);
+
+    if (found >= 0) {
+        track = (uint16_t) found;
+        t = &table->Tracks[track];
+        if (table->LruHead != track) {
+            lruUnlink(table, track);
+            lruPushHead(table, track);
+        }
+    } else {
+        if (table->FreeList == ODID_TRACK_NONE)
+            trackRelease(table, table->LruTail, 1);
+        track = table->FreeList;
+        t = &table->Tracks[track];
+        table->FreeList = t->LruNext;
+
+        memset(t, 0, sizeof(*t));
+        memcpy(t->MAC, mac, 6);
+        t->InUse = 1;
+        t->MACHash = hashMAC(mac);
+        t->FirstSeen = now;
+        indexInsert(table, table->MACIndex, t->MACHash, track);
+        lruPushHead(table, track);
+        table->Count++;
+    }
+
+    t->LastSeen = now;
+    t->Expires = now + table->Timeout;
+    slot = wheelSlot(table, t->Expires);
+    if (found < 0) {
+        wheelInsert(table, track, slot);
+    } else if (slot != t->WheelSlot) {
+        // Frames arrive much more often than the wheel ticks, mostly the slot stays the same
+        wheelUnlink(table, track);
+        wheelInsert(table, track, slot);
+    }
+    return track;
+}
+
+int odid_trackSetID(ODID_TrackTable *table, int index, const char *uasId)
+{
+    ODID_Track *t;
+    int owner;
+
+    if (index < 0 || index >= table->Capacity || !table->Tracks[index].InUse || !uasId)
+        return ODID_FAIL;
+    t = &table->Tracks[index];
+    if (t->IDIndexed && strncmp(t->UASID, uasId, ODID_ID_SIZE) == 0)
+        return ODID_SUCCESS;
+
+    if (t->IDIndexed) {
+        indexRemove(table, table->IDIndex, 1, (uint16_t) index);
+        t->IDIndexed = 0;
+    }
+    owner = odid_trackFindID(table, uasId);
+    if (owner >= 0) {
+        indexRemove(table, table->IDIndex, 1, (uint16_t) owner);
+        table->Tracks[owner].IDIndexed = 0;
+    }
+
+    strncpy(t->UASID, uasId, ODID_ID_SIZE);
+    t->UASID[ODID_ID_SIZE] = 0;
+    t->IDHash = hashID(t->UASID);
+    indexInsert(table, table->IDIndex, t->IDHash, (uint16_t) index);
+    t->IDIndexed = 1;
+    return ODID_SUCCESS;
+}
+
+int odid_trackExpire(ODID_TrackTable *table, uint32_t now)
+{
+    uint32_t tickMask = UINT32_MAX >> table->TickShift;
+    uint32_t nowTick;
+    int removed = 0;
+
+    now = tableTime(table, now);
+    nowTick = now >> table->TickShift;
+
+    for (int steps = 0; TICK_AFTER_EQ(table, nowTick, table->NextTick) && steps < ODID_TRACK_WHEEL_SLOTS; steps++) {
+        uint16_t track = table->Wheel[table->NextTick & WHEEL_MASK];
+
+        while (track != ODID_TRACK_NONE) {
+            uint16_t next = table->Tracks[track].WheelNext;
+            if (TIME_AFTER_EQ(now, table->Tracks[track].Expires)) {
+                trackRelease(table, track, 1);
+                removed++;
+            }
+            track = next;
+        }
+        table->NextTick = (table->NextTick + 1) & tickMask;
+    }
+    // After a long pause every slot has been visited once
+    if (TICK_AFTER_EQ(table, nowTick, table->NextTick))
+        table->NextTick = (nowTick + 1) & tickMask;
+    return removed;
+}
@@ -275,6 +275,33 @@ int odid_message_build_pack(ODID_UAS_Data *UAS_Data, void *pack, size_t buflen)
     return (int) len;
 }
 
+int odid_message_build_pack_cached(ODID_PackCache *cache, ODID_UAS_Data *UAS_Data,
+                                   void *pack, size_t buflen)
+{
+    size_t len;
+
+    if (!cache)
+        return -EINVAL;
+
+    /* mark the messages that have changed since the previous pack */
+    if (UAS_Data)
+        odid_packCacheUpdate(cache, UAS_Data);
+
+    /* encode the changed messages. Fails if there are no messages to send */
+    if (encodePackCache(cache, NULL) != ODID_SUCCESS)
+        return -EINVAL;
+
+    /* calculate the exact encoded message pack size. */
+    len = sizeof(cache->Pack) - (ODID_PACK_MAX_MESSAGES - cache->Pack.MsgPackSize) * ODID_MESSAGE_SIZE;
+
+    /* check if there is enough space for the message pack. */
+    if (len > buflen)
+        return -ENOMEM;
+
+    memcpy(pack, &cache->Pack, len);
+    return (int) len;
+}
+
 int odid_wifi_build_nan_sync_beacon_frame(char *mac, uint8_t *buf, size_t buf_size)
 {
     /* Broadcast address */
@@ -358,9 +385,30 @@ int odid_wifi_build_nan_sync_beacon_frame(char *mac, uint8_t *buf, size_t buf_si
     return (int) len;
 }
 
+/* The length of an encoded message pack, or < 0 if it holds no messages or too many */
+static int encoded_pack_len(const ODID_MessagePack_encoded *pack)
+{
+    if (pack->MsgPackSize == 0 || pack->MsgPackSize > ODID_PACK_MAX_MESSAGES)
+        return -EINVAL;
+    return (int) (sizeof(*pack) - (ODID_PACK_MAX_MESSAGES - pack->MsgPackSize) * ODID_MESSAGE_SIZE);
+}
+
 int odid_wifi_build_message_pack_nan_action_frame(ODID_UAS_Data *UAS_Data, char *mac,
                                                   uint8_t send_counter,
                                                   uint8_t *buf, size_t buf_size)
+{
+    ODID_MessagePack_encoded pack;
+    int ret;
+
+    ret = odid_message_build_pack(UAS_Data, &pack, sizeof(pack));
+    if (ret < 0)
+        return ret;
+    return odid_wifi_build_nan_action_frame_from_pack(&pack, mac, send_counter, buf, buf_size);
+}
+
+int odid_wifi_build_nan_action_frame_from_pack(const ODID_MessagePack_encoded *pack, char *mac,
+                                               uint8_t send_counter,
+                                               uint8_t *buf, size_t buf_size)
 {
     /* Neighbor Awareness Networking Specification v3.0 in section 2.8.1
      * NAN Network ID calls for the destination mac to be 51-6F-9A-01-00-00 */
@@ -415,9 +463,12 @@ int odid_wifi_build_message_pack_nan_action_frame(ODID_UAS_Data *UAS_Data, char
     si->message_counter = send_counter;
     len += sizeof(*si);
 
-    ret = odid_message_build_pack(UAS_Data, buf + len, buf_size - len);
+    ret = encoded_pack_len(pack);
     if (ret < 0)
         return ret;
+    if (len + (size_t) ret > buf_size)
+        return -ENOMEM;
+    memcpy(buf + len, pack, (size_t) ret);
     len += ret;
 
     /* set the lengths according to the message pack lengths */
@@ -443,6 +494,21 @@ int odid_wifi_build_message_pack_beacon_frame(ODID_UAS_Data *UAS_Data, char *mac
                                               const char *SSID, size_t SSID_len,
                                               uint16_t interval_tu, uint8_t send_counter,
                                               uint8_t *buf, size_t buf_size)
+{
+    ODID_MessagePack_encoded pack;
+    int ret;
+
+    ret = odid_message_build_pack(UAS_Data, &pack, sizeof(pack));
+    if (ret < 0)
+        return ret;
+    return odid_wifi_build_beacon_frame_from_pack(&pack, mac, SSID, SSID_len, interval_tu,
+                                                  send_counter, buf, buf_size);
+}
+
+int odid_wifi_build_beacon_frame_from_pack(const ODID_MessagePack_encoded *pack, char *mac,
+                                           const char *SSID, size_t SSID_len,
+                                           uint16_t interval_tu, uint8_t send_counter,
+                                           uint8_t *buf, size_t buf_size)
 {
     /* Broadcast address */
     uint8_t target_addr[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
@@ -510,9 +576,12 @@ int odid_wifi_build_message_pack_beacon_frame(ODID_UAS_Data *UAS_Data, char *mac
     si->message_counter = send_counter;
     len += sizeof(*si);
 
-    ret = odid_message_build_pack(UAS_Data, buf + len, buf_size - len);
+    ret = encoded_pack_len(pack);
     if (ret < 0)
         return ret;
+    if (len + (size_t) ret > buf_size)
+        return -ENOMEM;
+    memcpy(buf + len, pack, (size_t) ret);
     len += ret;
 
     /* set the lengths according to the message pack lengths */
@@ -616,3 +685,79 @@ int odid_wifi_receive_message_pack_nan_action_frame(ODID_UAS_Data *UAS_Data,
 
     return 0;
 }
+
+int odid_wifi_receive_beacon_frame(ODID_UAS_Data *UAS_Data,
+                                   char *mac, uint8_t *buf, size_t buf_size)
+{
+    struct ieee80211_mgmt *mgmt;
+    struct ieee80211_vendor_specific *vendor;
+    uint8_t asd_stan_oui[3] = { 0xFA, 0x0B, 0xBC };
+    uint8_t parrot_oui[3] = { 0x90, 0x3A, 0xE6 };
+    size_t len = 0;
+    size_t ie_len;
+    int ret;
+
+    /* IEEE 802.11 Management Header */
+    if (len + sizeof(*mgmt) > buf_size)
+        return -EINVAL;
+    mgmt = (struct ieee80211_mgmt *)(buf + len);
+    if ((mgmt->frame_control & cpu_to_le16(IEEE80211_FCTL_FTYPE | IEEE80211_FCTL_STYPE)) !=
+        cpu_to_le16(IEEE80211_FTYPE_MGMT | IEEE80211_STYPE_BEACON))
+        return -EINVAL;
+    len += sizeof(*mgmt);
+
+    /* Mandatory Beacon fields */
+    if (len + sizeof(struct ieee80211_beacon) > buf_size)
+        return -EINVAL;
+    len += sizeof(struct ieee80211_beacon);
+
+    /* Walk the Information Elements until the ASD-STAN vendor specific IE,
+     * or the one of Parrot drones, which carries the same message pack */
+    while (len + 2 <= buf_size) {
+        ie_len = buf[len + 1];
+        if (len + 2 + ie_len > buf_size)
+            return -EINVAL;
+
+        vendor = (struct ieee80211_vendor_specific *)(buf + len);
+        if (vendor->element_id == IEEE80211_ELEMID_VENDOR &&
+            ie_len >= sizeof(*vendor) - 2 + sizeof(struct ODID_service_info) &&
+            ((memcmp(vendor->oui, asd_stan_oui, sizeof(asd_stan_oui)) == 0 && vendor->oui_type == 0x0D) ||
+             memcmp(vendor->oui, parrot_oui, sizeof(parrot_oui)) == 0))
+            break;
+
+        len += 2 + ie_len;
+    }
+    if (len + 2 > buf_size)
+        return -EINVAL;
+
+    /* The message pack follows the ODID Service Info Attribute header and
+     * must fit within the vendor specific IE */
+    len += sizeof(*vendor) + sizeof(struct ODID_service_info);
+    ie_len -= sizeof(*vendor) - 2 + sizeof(struct ODID_service_info);
+    if (ie_len < offsetof(ODID_MessagePack_encoded, Messages))
+        return -EINVAL;
+
+    ret = odid_message_process_pack(UAS_Data, buf + len, ie_len);
+    if (ret < 0)
+        return -EINVAL;
+
+    memcpy(mac, mgmt->sa, sizeof(mgmt->sa));
+    return 0;
+}
+
+int odid_wifi_receive_frame(ODID_UAS_Data *UAS_Data, char *mac, uint8_t *buf, size_t buf_size)
+{
+    struct ieee80211_mgmt *mgmt;
+
+    if (sizeof(*mgmt) > buf_size)
+        return -EINVAL;
+    mgmt = (struct ieee80211_mgmt *) buf;
+
+    uint16_t type = mgmt->frame_control & cpu_to_le16(IEEE80211_FCTL_FTYPE | IEEE80211_FCTL_STYPE);
+    if (type == cpu_to_le16(IEEE80211_FTYPE_MGMT | IEEE80211_STYPE_BEACON))
+        return odid_wifi_receive_beacon_frame(UAS_Data, mac, buf, buf_size);
+    if (type == cpu_to_le16(IEEE80211_FTYPE_MGMT | IEEE80211_STYPE_ACTION))
+        return odid_wifi_receive_message_pack_nan_action_frame(UAS_Data, mac, buf, buf_size);
+
+    return -EINVAL;
+}
@@ -0,0 +1,380 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID C Library
+*/
+
+#include <stdio.h>
+#include <time.h>
+#include <opendroneid.h>
+
+#define BENCH_VALUES 4096
+#define BENCH_ROUNDS 500
+
+static float values[BENCH_VALUES];
+static volatile int sink;
+static volatile float fsink;
+
+/*
+ * The if/else based conversions that were used before the table driven
+ * versions in opendroneid.c. Kept here as a reference for the benchmark and
+ * for verifying that both produce identical results.
+ */
+
+/**
+* This converts a horizontal accuracy float value to the corresponding enum
+*
+* @param Accuracy The horizontal accuracy in meters
+* @return Enum value representing the accuracy
+*/
+static __attribute__((noinline)) ODID_Horizontal_accuracy_t legacy_createEnumHorizontalAccuracy(float Accuracy)
+{
+    if (Accuracy >= 18520)
+        return ODID_HOR_ACC_UNKNOWN;
+    else if (Accuracy >= 7408)
+        return ODID_HOR_ACC_10NM;
+    else if (Accuracy >= 3704)
+        return ODID_HOR_ACC_4NM;
+    else if (Accuracy >= 1852)
+        return ODID_HOR_ACC_2NM;
+    else if (Accuracy >= 926)
+        return ODID_HOR_ACC_1NM;
+    else if (Accuracy >= 555.6f)
+        return ODID_HOR_ACC_0_5NM;
+    else if (Accuracy >= 185.2f)
+        return ODID_HOR_ACC_0_3NM;
+    else if (Accuracy >= 92.6f)
+        return ODID_HOR_ACC_0_1NM;
+    else if (Accuracy >= 30)
+        return ODID_HOR_ACC_0_05NM;
+    else if (Accuracy >= 10)
+        return ODID_HOR_ACC_30_METER;
+    else if (Accuracy >= 3)
+        return ODID_HOR_ACC_10_METER;
+    else if (Accuracy >= 1)
+        return ODID_HOR_ACC_3_METER;
+    else if (Accuracy > 0)
+        return ODID_HOR_ACC_1_METER;
+    else
+        return ODID_HOR_ACC_UNKNOWN;
+}
+
+/**
+* This converts a vertical accuracy float value to the corresponding enum
+*
+* @param Accuracy The vertical accuracy in meters
+* @return Enum value representing the accuracy
+*/
+static __attribute__((noinline)) ODID_Vertical_accuracy_t legacy_createEnumVerticalAccuracy(float Accuracy)
+{
+    if (Accuracy >= 150)
+        return ODID_VER_ACC_UNKNOWN;
+    else if (Accuracy >= 45)
+        return ODID_VER_ACC_150_METER;
+    else if (Accuracy >= 25)
+        return ODID_VER_ACC_45_METER;
+    else if (Accuracy >= 10)
+        return ODID_VER_ACC_25_METER;
+    else if (Accuracy >= 3)
+        return ODID_VER_ACC_10_METER;
+    else if (Accuracy >= 1)
+        return ODID_VER_ACC_3_METER;
+    else if (Accuracy > 0)
+        return ODID_VER_ACC_1_METER;
+    else
+        return ODID_VER_ACC_UNKNOWN;
+}
+
+/**
+* This converts a speed accuracy float value to the corresponding enum
+*
+* @param Accuracy The speed accuracy in m/s
+* @return Enum value representing the accuracy
+*/
+static __attribute__((noinline)) ODID_Speed_accuracy_t legacy_createEnumSpeedAccuracy(float Accuracy)
+{
+    if (Accuracy >= 10)
+        return ODID_SPEED_ACC_UNKNOWN;
+    else if (Accuracy >= 3)
+        return ODID_SPEED_ACC_10_METERS_PER_SECOND;
+    else if (Accuracy >= 1)
+        return ODID_SPEED_ACC_3_METERS_PER_SECOND;
+    else if (Accuracy >= 0.3f)
+        return ODID_SPEED_ACC_1_METERS_PER_SECOND;
+    else if (Accuracy > 0)
+        return ODID_SPEED_ACC_0_3_METERS_PER_SECOND;
+    else
+        return ODID_SPEED_ACC_UNKNOWN;
+}
+
+/**
+* This converts a timestamp accuracy float value to the corresponding enum
+*
+* @param Accuracy The timestamp accuracy in seconds
+* @return Enum value representing the accuracy
+*/
+static __attribute__((noinline)) ODID_Timestamp_accuracy_t legacy_createEnumTimestampAccuracy(float Accuracy)
+{
+    if (Accuracy > 1.5f)
+        return ODID_TIME_ACC_UNKNOWN;
+    else if (Accuracy > 1.4f)
+        return ODID_TIME_ACC_1_5_SECOND;
+    else if (Accuracy > 1.3f)
+        return ODID_TIME_ACC_1_4_SECOND;
+    else if (Accuracy > 1.2f)
+        return ODID_TIME_ACC_1_3_SECOND;
+    else if (Accuracy > 1.1f)
+        return ODID_TIME_ACC_1_2_SECOND;
+    else if (Accuracy > 1.0f)
+        return ODID_TIME_ACC_1_1_SECOND;
+    else if (Accuracy > 0.9f)
+        return ODID_TIME_ACC_1_0_SECOND;
+    else if (Accuracy > 0.8f)
+        return ODID_TIME_ACC_0_9_SECOND;
+    else if (Accuracy > 0.7f)
+        return ODID_TIME_ACC_0_8_SECOND;
+    else if (Accuracy > 0.6f)
+        return ODID_TIME_ACC_0_7_SECOND;
+    else if (Accuracy > 0.5f)
+        return ODID_TIME_ACC_0_6_SECOND;
+    else if (Accuracy > 0.4f)
+        return ODID_TIME_ACC_0_5_SECOND;
+    else if (Accuracy > 0.3f)
+        return ODID_TIME_ACC_0_4_SECOND;
+    else if (Accuracy > 0.2f)
+        return ODID_TIME_ACC_0_3_SECOND;
+    else if (Accuracy > 0.1f)
+        return ODID_TIME_ACC_0_2_SECOND;
+    else if (Accuracy > 0.0f)
+        return ODID_TIME_ACC_0_1_SECOND;
+    else
+        return ODID_TIME_ACC_UNKNOWN;
+}
+
+/**
+* This decodes a horizontal accuracy enum to the corresponding float value
+*
+* @param Accuracy Enum value representing the accuracy
+* @return The maximum horizontal accuracy in meters
+*/
+static __attribute__((noinline)) float legacy_decodeHorizontalAccuracy(ODID_Horizontal_accuracy_t Accuracy)
+{
+    switch (Accuracy)
+    {
+    case ODID_HOR_ACC_UNKNOWN:
+        return 18520;
+    case ODID_HOR_ACC_10NM:
+        return 18520;
+    case ODID_HOR_ACC_4NM:
+        return 7808;
+    case ODID_HOR_ACC_2NM:
+        return 3704;
+    case ODID_HOR_ACC_1NM:
+        return 1852;
+    case ODID_HOR_ACC_0_5NM:
+        return 926;
+    case ODID_HOR_ACC_0_3NM:
+        return 555.6f;
+    case ODID_HOR_ACC_0_1NM:
+        return 185.2f;
+    case ODID_HOR_ACC_0_05NM:
+        return 92.6f;
+    case ODID_HOR_ACC_30_METER:
+        return 30;
+    case ODID_HOR_ACC_10_METER:
+        return 10;
+    case ODID_HOR_ACC_3_METER:
+        return 3;
+    case ODID_HOR_ACC_1_METER:
+        return 1;
+    default:
+        return 18520;
+    }
+}
+
+/**
+* This decodes a vertical accuracy enum to the corresponding float value
+*
+* @param Accuracy Enum value representing the accuracy
+* @return The maximum vertical accuracy in meters
+*/
+static __attribute__((noinline)) float legacy_decodeVerticalAccuracy(ODID_Vertical_accuracy_t Accuracy)
+{
+    switch (Accuracy)
+    {
+    case ODID_VER_ACC_UNKNOWN:
+        return 150;
+    case ODID_VER_ACC_150_METER:
+        return 150;
+    case ODID_VER_ACC_45_METER:
+        return 45;
+    case ODID_VER_ACC_25_METER:
+        return 25;
+    case ODID_VER_ACC_10_METER:
+        return 10;
+    case ODID_VER_ACC_3_METER:
+        return 3;
+    case ODID_VER_ACC_1_METER:
+        return 1;
+    default:
+        return 150;
+    }
+}
+
+/**
+* This decodes a speed accuracy enum to the corresponding float value
+*
+* @param Accuracy Enum value representing the accuracy
+* @return The maximum speed accuracy in m/s
+*/
+static __attribute__((noinline)) float legacy_decodeSpeedAccuracy(ODID_Speed_accuracy_t Accuracy)
+{
+    switch (Accuracy)
+    {
+    case ODID_SPEED_ACC_UNKNOWN:
+        return 10;
+    case ODID_SPEED_ACC_10_METERS_PER_SECOND:
+        return 10;
+    case ODID_SPEED_ACC_3_METERS_PER_SECOND:
+        return 3;
+    case ODID_SPEED_ACC_1_METERS_PER_SECOND:
+        return 1;
+    case ODID_SPEED_ACC_0_3_METERS_PER_SECOND:
+        return 0.3f;
+    default:
+        return 10;
+    }
+}
+
+/**
+* This decodes a timestamp accuracy enum to the corresponding float value
+*
+* @param Accuracy Enum value representing the accuracy
+* @return The maximum timestamp accuracy in seconds
+*/
+static __attribute__((noinline)) float legacy_decodeTimestampAccuracy(ODID_Timestamp_accuracy_t Accuracy)
+{
+    switch (Accuracy)
+    {
+    case ODID_TIME_ACC_UNKNOWN:
+        return 0.0f;
+    case ODID_TIME_ACC_0_1_SECOND:
+        return 0.1f;
+    case ODID_TIME_ACC_0_2_SECOND:
+        return 0.2f;
+    case ODID_TIME_ACC_0_3_SECOND:
+        return 0.3f;
+    case ODID_TIME_ACC_0_4_SECOND:
+        return 0.4f;
+    case ODID_TIME_ACC_0_5_SECOND:
+        return 0.5f;
+    case ODID_TIME_ACC_0_6_SECOND:
+        return 0.6f;
+    case ODID_TIME_ACC_0_7_SECOND:
+        return 0.7f;
+    case ODID_TIME_ACC_0_8_SECOND:
+        return 0.8f;
+    case ODID_TIME_ACC_0_9_SECOND:
+        return 0.9f;
+    case ODID_TIME_ACC_1_0_SECOND:
+        return 1.0f;
+    case ODID_TIME_ACC_1_1_SECOND:
+        return 1.1f;
+    case ODID_TIME_ACC_1_2_SECOND:
+        return 1.2f;
+    case ODID_TIME_ACC_1_3_SECOND:
+        return 1.3f;
+    case ODID_TIME_ACC_1_4_SECOND:
+        return 1.4f;
+    case ODID_TIME_ACC_1_5_SECOND:
+        return 1.5f;
+    default:
+        return 0.0f;
+    }
+}
+
+static double elapsed_ns(struct timespec *start, struct timespec *end)
+{
+    return (double) (end->tv_sec - start->tv_sec) * 1e9 +
+           (double) (end->tv_nsec - start->tv_nsec);
+}
+
+#define BENCH_CREATE(label, legacy, table, range)                           \
+    do {                                                                    \
+        struct timespec start, end;                                         \
+        double legacyNs, tableNs;                                           \
+        for (int i = 0; i < BENCH_VALUES; i++)                              \
+            values[i] = (range) * (float) ((i * 7919) % BENCH_VALUES) /     \
+                        (BENCH_VALUES / 2) - (range) / 4;                   \
+        for (int i = 0; i < BENCH_VALUES; i++) {                            \
+            if (legacy(values[i]) != table(values[i]))                      \
+                mismatches++;                                               \
+        }                                                                   \
+        clock_gettime(CLOCK_MONOTONIC, &start);                             \
+        for (int r = 0; r < BENCH_ROUNDS; r++)                              \
+            for (int i = 0; i < BENCH_VALUES; i++)                          \
+                sink = legacy(values[i]);                                   \
+        clock_gettime(CLOCK_MONOTONIC, &end);                               \
+        legacyNs = elapsed_ns(&start, &end) / (BENCH_VALUES * BENCH_ROUNDS);\
+        clock_gettime(CLOCK_MONOTONIC, &start);                             \
+        for (int r = 0; r < BENCH_ROUNDS; r++)                              \
+            for (int i = 0; i < BENCH_VALUES; i++)                          \
+                sink = table(values[i]);                                    \
+        clock_gettime(CLOCK_MONOTONIC, &end);                               \
+        tableNs = elapsed_ns(&start, &end) / (BENCH_VALUES * BENCH_ROUNDS); \
+        printf("  %-28s %6.2f ns/call  %6.2f ns/call\n",                   \
+               label, legacyNs, tableNs);                                   \
+    } while (0)
+
+#define BENCH_DECODE(label, legacy, table, type, amount)                    \
+    do {                                                                    \
+        struct timespec start, end;                                         \
+        double legacyNs, tableNs;                                           \
+        for (int i = 0; i < 16; i++) {                                      \
+            if (legacy((type) i) != table((type) i))                        \
+                mismatches++;                                               \
+        }                                                                   \
+        clock_gettime(CLOCK_MONOTONIC, &start);                             \
+        for (int r = 0; r < BENCH_ROUNDS; r++)                              \
+            for (int i = 0; i < BENCH_VALUES; i++)                          \
+                fsink = legacy((type) (i % (amount)));                      \
+        clock_gettime(CLOCK_MONOTONIC, &end);                               \
+        legacyNs = elapsed_ns(&start, &end) / (BENCH_VALUES * BENCH_ROUNDS);\
+        clock_gettime(CLOCK_MONOTONIC, &start);                             \
+        for (int r = 0; r < BENCH_ROUNDS; r++)                              \
+            for (int i = 0; i < BENCH_VALUES; i++)                          \
+                fsink = table((type) (i % (amount)));                       \
+        clock_gettime(CLOCK_MONOTONIC, &end);                               \
+        tableNs = elapsed_ns(&start, &end) / (BENCH_VALUES * BENCH_ROUNDS); \
+        printf("  %-28s %6.2f ns/call  %6.2f ns/call\n",                   \
+               label, legacyNs, tableNs);                                   \
+    } while (0)
+
+void bench_accuracy(void)
+{
+    int mismatches = 0;
+
+    // The input values are spread from slightly below zero to twice the given
+    // range, i.e. mostly values typical for a GPS fix plus some out of range
+    printf("\nAccuracy conversion         if/else chain    lookup table\n");
+    BENCH_CREATE("createEnumHorizontalAccuracy", legacy_createEnumHorizontalAccuracy,
+                 createEnumHorizontalAccuracy, 50.0f);
+    BENCH_CREATE("createEnumVerticalAccuracy", legacy_createEnumVerticalAccuracy,
+                 createEnumVerticalAccuracy, 50.0f);
+    BENCH_CREATE("createEnumSpeedAccuracy", legacy_createEnumSpeedAccuracy,
+                 createEnumSpeedAccuracy, 5.0f);
+    BENCH_CREATE("createEnumTimestampAccuracy", legacy_createEnumTimestampAccuracy,
+                 createEnumTimestampAccuracy, 1.0f);
+    BENCH_DECODE("decodeHorizontalAccuracy", legacy_decodeHorizontalAccuracy,
+                 decodeHorizontalAccuracy, ODID_Horizontal_accuracy_t, 13);
+    BENCH_DECODE("decodeVerticalAccuracy", legacy_decodeVerticalAccuracy,
+                 decodeVerticalAccuracy, ODID_Vertical_accuracy_t, 7);
+    BENCH_DECODE("decodeSpeedAccuracy", legacy_decodeSpeedAccuracy,
+                 decodeSpeedAccuracy, ODID_Speed_accuracy_t, 5);
+    BENCH_DECODE("decodeTimestampAccuracy", legacy_decodeTimestampAccuracy,
+                 decodeTimestampAccuracy, ODID_Timestamp_accuracy_t, 16);
+
+    if (mismatches)
+        printf("  %d results differ between the two implementations\n", mismatches);
+}
@@ -0,0 +1,168 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID C Library
+*/
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <opendroneid.h>
+
+#define BENCH_PACKS 1024
+#define BENCH_ROUNDS 200
+#define PACK_BUF_SIZE (sizeof(ODID_MessagePack_encoded))
+#define FRAME_BUF_SIZE 512
+
+static uint8_t packBufs[BENCH_PACKS][PACK_BUF_SIZE];
+static uint8_t *packs[BENCH_PACKS];
+static size_t lengths[BENCH_PACKS];
+static int status[BENCH_PACKS];
+static uint8_t frameBufs[BENCH_PACKS][FRAME_BUF_SIZE];
+static size_t frameLengths[BENCH_PACKS];
+static ODID_UAS_Data single;
+static ODID_UAS_Data batch[BENCH_PACKS];
+
+static double elapsed_seconds(struct timespec *start, struct timespec *end)
+{
+    return (double) (end->tv_sec - start->tv_sec) +
+           (double) (end->tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+void fill_bench_data(ODID_UAS_Data *uasData, int index)
+{
+    odid_initUasData(uasData);
+
+    uasData->BasicID[0].UAType = ODID_UATYPE_HELICOPTER_OR_MULTIROTOR;
+    uasData->BasicID[0].IDType = ODID_IDTYPE_SERIAL_NUMBER;
+    snprintf(uasData->BasicID[0].UASID, sizeof(uasData->BasicID[0].UASID),
+             "BENCH%015d", index);
+    uasData->BasicIDValid[0] = 1;
+
+    uasData->Location.Status = ODID_STATUS_AIRBORNE;
+    uasData->Location.Direction = (float) (index % 360);
+    uasData->Location.SpeedHorizontal = 5.4f;
+    uasData->Location.SpeedVertical = 1.5f;
+    uasData->Location.Latitude = 45.539309 + index * 0.00001;
+    uasData->Location.Longitude = -122.966389 - index * 0.00001;
+    uasData->Location.AltitudeBaro = 100;
+    uasData->Location.AltitudeGeo = 110;
+    uasData->Location.HeightType = ODID_HEIGHT_REF_OVER_GROUND;
+    uasData->Location.Height = 80;
+    uasData->Location.TimeStamp = 360.5f;
+    uasData->LocationValid = 1;
+
+    uasData->Auth[0].AuthType = ODID_AUTH_UAS_ID_SIGNATURE;
+    uasData->Auth[0].LastPageIndex = 0;
+    uasData->Auth[0].Length = 17;
+    uasData->Auth[0].Timestamp = 28000000;
+    uasData->AuthValid[0] = 1;
+
+    uasData->SelfID.DescType = ODID_DESC_TYPE_TEXT;
+    strncpy(uasData->SelfID.Desc, "Benchmark flight", sizeof(uasData->SelfID.Desc));
+    uasData->SelfIDValid = 1;
+
+    uasData->System.OperatorLatitude = uasData->Location.Latitude;
+    uasData->System.OperatorLongitude = uasData->Location.Longitude;
+    uasData->System.Timestamp = 28000000;
+    uasData->SystemValid = 1;
+
+    uasData->OperatorID.OperatorIdType = ODID_OPERATOR_ID;
+    strncpy(uasData->OperatorID.OperatorId, "FIN87astrdge12k8",
+            sizeof(uasData->OperatorID.OperatorId));
+    uasData->OperatorIDValid = 1;
+}
+
+void bench_decode(void)
+{
+    struct timespec start, end;
+    ODID_UAS_Data source;
+    double singleTime, batchTime, viewTime, beaconTime;
+    char mac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+    char rcvdMac[6] = { 0 };
+    char uasId[ODID_ID_SIZE + 1];
+    double lat = 0, lon = 0;
+    int failures = 0;
+
+    for (int i = 0; i < BENCH_PACKS; i++) {
+        fill_bench_data(&source, i);
+        int len = odid_message_build_pack(&source, packBufs[i], PACK_BUF_SIZE);
+        if (len < 0) {
+            fprintf(stderr, "Failed to build message pack %d\n", i);
+            return;
+        }
+        packs[i] = packBufs[i];
+        lengths[i] = (size_t) len;
+
+        len = odid_wifi_build_message_pack_beacon_frame(&source, mac, "UAS_ID_OPEN", 11,
+                                                        100, 0, frameBufs[i], FRAME_BUF_SIZE);
+        if (len < 0) {
+            fprintf(stderr, "Failed to build beacon frame %d\n", i);
+            return;
+        }
+        frameLengths[i] = (size_t) len;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int i = 0; i < BENCH_PACKS; i++) {
+            if (odid_message_process_pack(&single, packs[i], lengths[i]) < 0)
+                failures++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    singleTime = elapsed_seconds(&start, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        if (decodeMessagePackBatch(batch, packs, lengths, status, BENCH_PACKS) != BENCH_PACKS)
+            failures++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    batchTime = elapsed_seconds(&start, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int i = 0; i < BENCH_PACKS; i++) {
+            const ODID_MessagePack_encoded *pack = (ODID_MessagePack_encoded *) packs[i];
+            const ODID_Message_encoded *msg;
+            msg = odid_view_pack_find(pack, lengths[i], ODID_MESSAGETYPE_BASIC_ID, 0);
+            if (odid_view_uasid(msg, uasId) != ODID_SUCCESS)
+                failures++;
+            msg = odid_view_pack_find(pack, lengths[i], ODID_MESSAGETYPE_LOCATION, 0);
+            if (odid_view_lat(msg, &lat) != ODID_SUCCESS ||
+                odid_view_lon(msg, &lon) != ODID_SUCCESS)
+                failures++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    viewTime = elapsed_seconds(&start, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int i = 0; i < BENCH_PACKS; i++) {
+            if (odid_wifi_receive_frame(&single, rcvdMac, frameBufs[i], frameLengths[i]) != 0)
+                failures++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    beaconTime = elapsed_seconds(&start, &end);
+
+    // Sanity check that both paths produce the same result for the last pack
+    if (!batch[BENCH_PACKS - 1].LocationValid ||
+        batch[BENCH_PACKS - 1].Location.Latitude != single.Location.Latitude ||
+        strcmp(batch[BENCH_PACKS - 1].BasicID[0].UASID, single.BasicID[0].UASID) != 0 ||
+        lat != single.Location.Latitude || lon != single.Location.Longitude ||
+        strcmp(uasId, single.BasicID[0].UASID) != 0 ||
+        memcmp(mac, rcvdMac, sizeof(mac)) != 0)
+        failures++;
+
+    printf("Message pack decoding, %d packs x %d rounds\n", BENCH_PACKS, BENCH_ROUNDS);
+    printf("  single: %12.0f packs/s\n", (BENCH_PACKS * BENCH_ROUNDS) / singleTime);
+    printf("  batch:  %12.0f packs/s\n", (BENCH_PACKS * BENCH_ROUNDS) / batchTime);
+    printf("  view (UAS ID + lat/lon only): %12.0f packs/s\n", (BENCH_PACKS * BENCH_ROUNDS) / viewTime);
+    printf("  beacon frame: %12.0f frames/s\n", (BENCH_PACKS * BENCH_ROUNDS) / beaconTime);
+    if (failures)
+        printf("  %d decoding failures\n", failures);
+}
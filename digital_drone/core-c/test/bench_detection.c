@@ -0,0 +1,86 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID C Library
+*/
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <opendroneid.h>
+#include <odid_detection.h>
+
+#define BENCH_DETECTIONS 200000
+
+static char text[4096];
+static volatile size_t sink;
+
+static double elapsed_seconds(struct timespec *start, struct timespec *end)
+{
+    return (double) (end->tv_sec - start->tv_sec) +
+           (double) (end->tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+void bench_detection(void)
+{
+    ODID_UAS_Data uasData;
+    ODID_Detection det;
+    uint8_t record[ODID_DETECTION_SIZE];
+    struct timespec start, end;
+    double exportTime, jsonTime, recordTime;
+    size_t exportLen = 0, jsonLen = 0;
+
+    odid_initUasData(&uasData);
+    strcpy(uasData.BasicID[0].UASID, "12345678901234567890");
+    uasData.BasicIDValid[0] = 1;
+    uasData.Location.Latitude = 45.539309;
+    uasData.Location.Longitude = -122.966389;
+    uasData.Location.AltitudeGeo = 110;
+    uasData.Location.Height = 80;
+    uasData.Location.SpeedHorizontal = 5.25f;
+    uasData.Location.Direction = 90;
+    uasData.LocationValid = 1;
+    memset(&det, 0, sizeof(det));
+    det.RSSI = -70;
+    det.Channel = 6;
+    det.Valid = ODID_DETECTION_VALID_RSSI | ODID_DETECTION_VALID_CHANNEL;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < BENCH_DETECTIONS; i++) {
+        uasData.Location.Latitude += 1e-7;
+        drone_export_gps_data(&uasData, text, sizeof(text));
+        exportLen += strlen(text);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    exportTime = elapsed_seconds(&start, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < BENCH_DETECTIONS; i++) {
+        uasData.Location.Latitude += 1e-7;
+        det.Timestamp = i;
+        odid_detectionFromUasData(&det, &uasData);
+        jsonLen += (size_t) odid_detectionToJson(text, sizeof(text), &det);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    jsonTime = elapsed_seconds(&start, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < BENCH_DETECTIONS; i++) {
+        uasData.Location.Latitude += 1e-7;
+        det.Timestamp = i;
+        odid_detectionFromUasData(&det, &uasData);
+        encodeDetectionRecord(record, &det);
+        sink += record[36];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    recordTime = elapsed_seconds(&start, &end);
+
+    printf("\nDetection output, %d detections\n", BENCH_DETECTIONS);
+    printf("drone_export_gps_data: %7.1f ns, %4zu bytes per detection\n",
+           exportTime * 1e9 / BENCH_DETECTIONS, exportLen / BENCH_DETECTIONS);
+    printf("compact JSON:          %7.1f ns, %4zu bytes per detection\n",
+           jsonTime * 1e9 / BENCH_DETECTIONS, jsonLen / BENCH_DETECTIONS);
+    printf("binary record:         %7.1f ns, %4d bytes per detection (%.1fx faster than JSON)\n",
+           recordTime * 1e9 / BENCH_DETECTIONS, ODID_DETECTION_SIZE, jsonTime / recordTime);
+}
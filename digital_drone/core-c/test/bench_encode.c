@@ -0,0 +1,117 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID C Library
+*/
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <opendroneid.h>
+
+#define BENCH_DRONES 256
+#define BENCH_ROUNDS 200
+#define PACK_BUF_SIZE (sizeof(ODID_MessagePack_encoded))
+
+void fill_bench_data(ODID_UAS_Data *uasData, int index);
+
+static ODID_UAS_Data drones[BENCH_DRONES];
+static ODID_PackCache caches[BENCH_DRONES];
+static uint8_t fullBufs[BENCH_DRONES][PACK_BUF_SIZE];
+static uint8_t cachedBufs[BENCH_DRONES][PACK_BUF_SIZE];
+
+static double elapsed_seconds(struct timespec *start, struct timespec *end)
+{
+    return (double) (end->tv_sec - start->tv_sec) +
+           (double) (end->tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+// Moves the drone a little, as a new GPS fix would
+static void move_drone(ODID_UAS_Data *uasData, int round)
+{
+    uasData->Location.Latitude += 0.000001;
+    uasData->Location.TimeStamp = (float) (round % 3600);
+}
+
+void bench_encode(void)
+{
+    struct timespec start, end;
+    double fullTime, cachedTime, setterTime;
+    int fullLen = 0, cachedLen = 0;
+    int failures = 0;
+
+    for (int i = 0; i < BENCH_DRONES; i++) {
+        fill_bench_data(&drones[i], i);
+        odid_initPackCache(&caches[i]);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int i = 0; i < BENCH_DRONES; i++) {
+            move_drone(&drones[i], r);
+            fullLen = odid_message_build_pack(&drones[i], fullBufs[i], PACK_BUF_SIZE);
+            if (fullLen < 0)
+                failures++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fullTime = elapsed_seconds(&start, &end);
+
+    for (int i = 0; i < BENCH_DRONES; i++)
+        fill_bench_data(&drones[i], i);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int i = 0; i < BENCH_DRONES; i++) {
+            move_drone(&drones[i], r);
+            cachedLen = odid_message_build_pack_cached(&caches[i], &drones[i], cachedBufs[i], PACK_BUF_SIZE);
+            if (cachedLen < 0)
+                failures++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    cachedTime = elapsed_seconds(&start, &end);
+
+    // As above, but the caller knows that only the Location message changes
+    for (int i = 0; i < BENCH_DRONES; i++)
+        fill_bench_data(&drones[i], i);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int i = 0; i < BENCH_DRONES; i++) {
+            move_drone(&drones[i], r);
+            odid_packCacheSetLocation(&caches[i], &drones[i].Location);
+            if (encodePackCache(&caches[i], (ODID_MessagePack_encoded *) cachedBufs[i]) != ODID_SUCCESS)
+                failures++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    setterTime = elapsed_seconds(&start, &end);
+
+    // Sanity check that both paths produce packs with the same content.
+    // Compare the decoded data, since reserved bytes may differ in the encoded data
+    for (int i = 0; i < BENCH_DRONES; i++) {
+        ODID_UAS_Data full, cached;
+        odid_initUasData(&full);
+        odid_initUasData(&cached);
+        if (fullLen != cachedLen ||
+            decodeMessagePack(&full, (ODID_MessagePack_encoded *) fullBufs[i]) != ODID_SUCCESS ||
+            decodeMessagePack(&cached, (ODID_MessagePack_encoded *) cachedBufs[i]) != ODID_SUCCESS ||
+            full.Location.Latitude != cached.Location.Latitude ||
+            full.Location.TimeStamp != cached.Location.TimeStamp ||
+            strcmp(full.BasicID[0].UASID, cached.BasicID[0].UASID) != 0 ||
+            strcmp(full.SelfID.Desc, cached.SelfID.Desc) != 0 ||
+            strcmp(full.OperatorID.OperatorId, cached.OperatorID.OperatorId) != 0 ||
+            full.System.OperatorLatitude != cached.System.OperatorLatitude ||
+            full.AuthValid[0] != cached.AuthValid[0])
+            failures++;
+    }
+
+    printf("\nMessage pack encoding, %d drones x %d rounds, Location changing\n", BENCH_DRONES, BENCH_ROUNDS);
+    printf("  full:   %12.0f packs/s\n", (BENCH_DRONES * BENCH_ROUNDS) / fullTime);
+    printf("  cached, update from UAS data: %12.0f packs/s\n", (BENCH_DRONES * BENCH_ROUNDS) / cachedTime);
+    printf("  cached, set Location only:    %12.0f packs/s\n", (BENCH_DRONES * BENCH_ROUNDS) / setterTime);
+    if (failures)
+        printf("  %d encoding failures\n", failures);
+}
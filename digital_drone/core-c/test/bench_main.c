@@ -0,0 +1,33 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID C Library
+*/
+
+#include <stdio.h>
+#include <opendroneid.h>
+
+void bench_decode(void);
+void bench_accuracy(void);
+void bench_encode(void);
+void bench_track(void);
+void bench_detection(void);
+
+int main(int argc __attribute__((unused)), char const *argv[] __attribute__((unused))) {
+    // Compares decoding message packs one at a time with batch decoding and
+    // with reading single fields from the encoded data
+    bench_decode();
+
+    // Compares the table driven accuracy conversions with if/else chains
+    bench_accuracy();
+
+    // Compares encoding all messages of a pack with only encoding the changed ones
+    bench_encode();
+
+    // Compares the hashed track table with a linear scan over all drones
+    bench_track();
+
+    // Compares the binary detection record with JSON text output
+    bench_detection();
+}
@@ -0,0 +1,155 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Mavlink to Open Drone ID C Library
+*/
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <mav2odid.h>
+
+#define MAVLINK_SYSTEM_ID       1
+#define MAVLINK_COMPONENT_ID    1
+
+#define BENCH_STREAM_SIZE (256 * 1024)
+#define BENCH_ROUNDS 20
+#define BENCH_READ_SIZE 64      // Bytes per read from e.g. a serial port
+
+static uint8_t stream[BENCH_STREAM_SIZE];
+static int odidMessages;
+
+static double elapsed_seconds(struct timespec *start, struct timespec *end)
+{
+    return (double) (end->tv_sec - start->tv_sec) +
+           (double) (end->tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+static size_t append_message(size_t pos, mavlink_message_t *msg)
+{
+    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+    uint16_t len = mavlink_msg_to_send_buffer(buf, msg);
+
+    if (pos + len > BENCH_STREAM_SIZE)
+        return 0;
+    memcpy(&stream[pos], buf, len);
+    return len;
+}
+
+/**
+* Fill the stream with the traffic of a flight controller, where the Open Drone
+* ID messages are a small part of the telemetry
+*/
+static size_t fill_stream(void)
+{
+    mavlink_heartbeat_t heartbeat = { .type = MAV_TYPE_QUADROTOR,
+                                      .autopilot = MAV_AUTOPILOT_GENERIC,
+                                      .system_status = MAV_STATE_ACTIVE };
+    mavlink_attitude_t attitude = { .roll = 0.1f, .pitch = -0.05f, .yaw = 1.2f };
+    mavlink_global_position_int_t position = { .lat = 514770000, .lon = 5000,
+                                               .alt = 36500, .relative_alt = 25500 };
+    mavlink_open_drone_id_basic_id_t basicId = {
+        .id_type = MAV_ODID_ID_TYPE_SERIAL_NUMBER,
+        .ua_type = MAV_ODID_UA_TYPE_HELICOPTER_OR_MULTIROTOR,
+        .uas_id = "112624150A90E3AE1EC0" };
+    mavlink_open_drone_id_location_t location = {
+        .status = MAV_ODID_STATUS_AIRBORNE,
+        .latitude = 514770000,
+        .longitude = 5000,
+        .altitude_geodetic = 36.5f,
+        .height_reference = MAV_ODID_HEIGHT_REF_OVER_GROUND,
+        .height = 25.5f,
+        .horizontal_accuracy = MAV_ODID_HOR_ACC_3_METER,
+        .vertical_accuracy = MAV_ODID_VER_ACC_1_METER };
+    mavlink_message_t msg;
+    size_t pos = 0, len;
+
+    for (int i = 0; ; i++) {
+        attitude.time_boot_ms = (uint32_t) i * 20;
+        mavlink_msg_attitude_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &attitude);
+        if (!(len = append_message(pos, &msg)))
+            break;
+        pos += len;
+
+        position.time_boot_ms = (uint32_t) i * 20;
+        mavlink_msg_global_position_int_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &position);
+        if (!(len = append_message(pos, &msg)))
+            break;
+        pos += len;
+
+        if (i % 10 == 0) {
+            location.timestamp = (float) i / 10;
+            mavlink_msg_open_drone_id_location_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID,
+                                                      &msg, &location);
+            if (!(len = append_message(pos, &msg)))
+                break;
+            pos += len;
+            odidMessages++;
+        }
+
+        if (i % 50 == 0) {
+            mavlink_msg_heartbeat_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &heartbeat);
+            if (!(len = append_message(pos, &msg)))
+                break;
+            pos += len;
+
+            mavlink_msg_open_drone_id_basic_id_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID,
+                                                      &msg, &basicId);
+            if (!(len = append_message(pos, &msg)))
+                break;
+            pos += len;
+            odidMessages++;
+        }
+    }
+    return pos;
+}
+
+static int bufferMessages;
+
+static void count_message(mav2odid_t *m2o __attribute__((unused)),
+                          ODID_messagetype_t type __attribute__((unused)))
+{
+    bufferMessages++;
+}
+
+int main(int argc __attribute__((unused)), char const *argv[] __attribute__((unused)))
+{
+    static mav2odid_t perByte, perBuffer;
+    struct timespec start, end;
+    int byteMessages = 0;
+    size_t size = fill_stream();
+
+    m2o_init(&perByte);
+    m2o_init(&perBuffer);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (size_t i = 0; i < size; i++) {
+            if (m2o_parseMavlink(&perByte, stream[i]) != ODID_MESSAGETYPE_INVALID)
+                byteMessages++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double byteTime = elapsed_seconds(&start, &end);
+
+    // The reads end in the middle of frames, which are continued with the next read
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (size_t i = 0; i < size; i += BENCH_READ_SIZE) {
+            size_t len = size - i < BENCH_READ_SIZE ? size - i : BENCH_READ_SIZE;
+            m2o_parseMavlinkBuffer(&perBuffer, &stream[i], len, count_message);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double bufferTime = elapsed_seconds(&start, &end);
+
+    // The messages found are checked by test_mav2odid.c
+    printf("Parsing a %zu byte Mavlink stream with %d Open Drone ID messages, %d rounds\n",
+           size, odidMessages, BENCH_ROUNDS);
+    printf("  m2o_parseMavlink per byte:   %8.1f MB/s\n", (double) size * BENCH_ROUNDS / byteTime / 1e6);
+    printf("  m2o_parseMavlinkBuffer (%d): %8.1f MB/s\n", BENCH_READ_SIZE,
+           (double) size * BENCH_ROUNDS / bufferTime / 1e6);
+    printf("  messages found: %d per byte, %d per buffer\n", byteMessages, bufferMessages);
+    return 0;
+}
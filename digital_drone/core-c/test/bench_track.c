@@ -0,0 +1,131 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID C Library
+*/
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <opendroneid.h>
+#include <odid_track.h>
+
+#define BENCH_MAX_DRONES 4096
+#define BENCH_FRAMES 2000000
+#define BENCH_TIMEOUT 300000
+
+// The per drone state of a linear table as used by the ESP32 scanner
+struct linear_track {
+    uint8_t mac[6];
+    uint32_t last_seen;
+};
+
+static struct linear_track linear[BENCH_MAX_DRONES];
+static ODID_TrackTable table;
+static ODID_Track tracks[BENCH_MAX_DRONES];
+static uint16_t indexes[4 * BENCH_MAX_DRONES];
+static uint8_t macs[BENCH_MAX_DRONES][6];
+static uint16_t order[BENCH_FRAMES];
+static volatile uintptr_t sink;
+
+static double elapsed_seconds(struct timespec *start, struct timespec *end)
+{
+    return (double) (end->tv_sec - start->tv_sec) +
+           (double) (end->tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+static struct linear_track *linear_update(int drones, const uint8_t *mac, uint32_t now)
+{
+    struct linear_track *track = NULL;
+
+    for (int i = 0; i < drones; i++) {
+        if (memcmp(linear[i].mac, mac, 6) == 0) {
+            track = &linear[i];
+            break;
+        }
+    }
+    if (!track) {
+        for (int i = 0; i < drones; i++) {
+            if (!linear[i].mac[0]) {
+                track = &linear[i];
+                break;
+            }
+        }
+    }
+    if (!track)
+        track = &linear[drones - 1];
+    memcpy(track->mac, mac, 6);
+    track->last_seen = now;
+    return track;
+}
+
+static void linear_expire(int drones, uint32_t now)
+{
+    for (int i = 0; i < drones; i++) {
+        if (linear[i].last_seen && (now - linear[i].last_seen) > BENCH_TIMEOUT) {
+            linear[i].last_seen = 0;
+            linear[i].mac[0] = 0;
+        }
+    }
+}
+
+// Frames from all drones in random order, with an expiry sweep every 64 frames
+static void bench_track_drones(int drones)
+{
+    struct timespec start, end;
+    double linearTime, hashTime;
+    uint32_t buckets = 1;
+    uintptr_t check = 0;
+
+    while (buckets < 2 * (uint32_t) drones)
+        buckets <<= 1;
+    for (int i = 0; i < BENCH_FRAMES; i++)
+        order[i] = (uint16_t) (rand() % drones);
+
+    memset(linear, 0, sizeof(linear));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < BENCH_FRAMES; i++) {
+        check += (uintptr_t) linear_update(drones, macs[order[i]], i);
+        if ((i & 63) == 0)
+            linear_expire(drones, i);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    linearTime = elapsed_seconds(&start, &end);
+
+    odid_initTrackTable(&table, tracks, (uint16_t) drones, indexes, buckets,
+                        BENCH_TIMEOUT, NULL, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < BENCH_FRAMES; i++) {
+        check += (uintptr_t) odid_trackUpdate(&table, macs[order[i]], i);
+        if ((i & 63) == 0)
+            odid_trackExpire(&table, i);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    hashTime = elapsed_seconds(&start, &end);
+
+    sink = check;
+    printf("%5d drones: linear scan %7.1f ns/frame, hash table %5.1f ns/frame (%.1fx)\n",
+           drones, linearTime * 1e9 / BENCH_FRAMES, hashTime * 1e9 / BENCH_FRAMES,
+           linearTime / hashTime);
+}
+
+void bench_track(void)
+{
+    printf("\nTrack table, %d frames\n", BENCH_FRAMES);
+
+    for (int i = 0; i < BENCH_MAX_DRONES; i++) {
+        macs[i][0] = 0x60;
+        macs[i][1] = 0x60;
+        macs[i][2] = (uint8_t) (rand() & 0xFF);
+        macs[i][3] = (uint8_t) (rand() & 0xFF);
+        macs[i][4] = (uint8_t) (i >> 8);
+        macs[i][5] = (uint8_t) i;
+    }
+
+    bench_track_drones(8);
+    bench_track_drones(64);
+    bench_track_drones(512);
+    bench_track_drones(BENCH_MAX_DRONES);
+}
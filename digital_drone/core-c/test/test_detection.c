@@ -0,0 +1,170 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID C Library
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <opendroneid.h>
+#include <odid_detection.h>
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static void fill_uas_data(ODID_UAS_Data *uasData)
+{
+    odid_initUasData(uasData);
+    uasData->BasicID[0].UAType = ODID_UATYPE_HELICOPTER_OR_MULTIROTOR;
+    uasData->BasicID[0].IDType = ODID_IDTYPE_SERIAL_NUMBER;
+    strcpy(uasData->BasicID[0].UASID, "DETECT0000000000001");
+    uasData->BasicIDValid[0] = 1;
+    uasData->Location.Status = ODID_STATUS_AIRBORNE;
+    uasData->Location.Latitude = 45.5393091;
+    uasData->Location.Longitude = -122.9663889;
+    uasData->Location.AltitudeGeo = 110.5f;
+    uasData->Location.Height = 80;
+    uasData->Location.SpeedHorizontal = 12.34f;
+    uasData->Location.Direction = 215.5f;
+    uasData->LocationValid = 1;
+    uasData->System.OperatorLatitude = -45.5;
+    uasData->System.OperatorLongitude = 170.25;
+    uasData->SystemValid = 1;
+}
+
+static void test_round_trip(void)
+{
+    static const uint8_t mac[6] = { 0x60, 0x60, 0x01, 0x02, 0x03, 0x04 };
+    ODID_UAS_Data uasData;
+    ODID_Detection det, out;
+    uint8_t record[ODID_DETECTION_SIZE + 1];
+    char text[512];
+
+    fill_uas_data(&uasData);
+    memset(&det, 0, sizeof(det));
+    odid_detectionFromUasData(&det, &uasData);
+    memcpy(det.MAC, mac, 6);
+    det.Timestamp = 0xFEDCBA98;
+    det.RSSI = -87;
+    det.Channel = 6;
+    det.Valid |= ODID_DETECTION_VALID_RSSI | ODID_DETECTION_VALID_CHANNEL;
+    CHECK(det.Valid == 0x1FF);
+
+    CHECK(encodeDetectionRecord(record, &det) == ODID_SUCCESS);
+    // Fixed little endian layout
+    CHECK(record[0] == ODID_DETECTION_VERSION && record[1] == ODID_DETECTION_SIZE);
+    CHECK(record[2] == 0xFF && record[3] == 0x01);
+    CHECK(record[4] == 0x98 && record[7] == 0xFE);
+    CHECK(memcmp(&record[8], mac, 6) == 0);
+    CHECK(record[14] == (uint8_t) -87 && record[15] == 6);
+    CHECK(memcmp(&record[16], "DETECT0000000000001\0", 20) == 0);
+    CHECK(record[36] == (455393091 & 0xFF) && record[39] == (455393091 >> 24));
+
+    CHECK(decodeDetectionRecord(&out, record, ODID_DETECTION_SIZE) == ODID_SUCCESS);
+    CHECK(out.Valid == det.Valid && out.Timestamp == det.Timestamp);
+    CHECK(memcmp(out.MAC, mac, 6) == 0 && out.RSSI == -87 && out.Channel == 6);
+    CHECK(strcmp(out.UASID, "DETECT0000000000001") == 0);
+    CHECK(fabs(out.Latitude - 45.5393091) < 1e-9 && fabs(out.Longitude + 122.9663889) < 1e-9);
+    CHECK(fabs(out.OperatorLatitude + 45.5) < 1e-9 && fabs(out.OperatorLongitude - 170.25) < 1e-9);
+    CHECK(out.AltitudeGeo == 110.5f && out.Height == 80);
+    CHECK(fabsf(out.SpeedHorizontal - 12.34f) < 0.006f && out.Direction == 215.5f);
+
+    CHECK(odid_detectionToJson(text, sizeof(text), &out) == (int) strlen(text));
+    CHECK(strcmp(text, "{\"t\":4275878552,\"mac\":\"60:60:01:02:03:04\",\"rssi\":-87,\"ch\":6,"
+                       "\"id\":\"DETECT0000000000001\",\"lat\":45.5393091,\"lon\":-122.9663889,"
+                       "\"alt\":110.5,\"height\":80.0,\"speed\":12.34,\"dir\":215.50,"
+                       "\"op_lat\":-45.5000000,\"op_lon\":170.2500000}") == 0);
+
+    // Incomplete, corrupted and unknown records
+    CHECK(decodeDetectionRecord(&out, record, ODID_DETECTION_SIZE - 1) == ODID_FAIL);
+    for (int i = 0; i < ODID_DETECTION_SIZE; i++) {
+        record[i] ^= 0x10;
+        CHECK(decodeDetectionRecord(&out, record, ODID_DETECTION_SIZE) == ODID_FAIL);
+        record[i] ^= 0x10;
+    }
+    CHECK(decodeDetectionRecord(&out, record, ODID_DETECTION_SIZE) == ODID_SUCCESS);
+}
+
+static void test_invalid_fields(void)
+{
+    ODID_UAS_Data uasData;
+    ODID_Detection det, out;
+    uint8_t record[ODID_DETECTION_SIZE];
+    char text[512];
+
+    // Only what was received is marked valid
+    odid_initUasData(&uasData);
+    uasData.Location.Latitude = 0;
+    uasData.Location.Longitude = 0;
+    uasData.Location.AltitudeGeo = INV_ALT;
+    uasData.Location.Height = INV_ALT;
+    uasData.Location.SpeedHorizontal = INV_SPEED_H;
+    uasData.Location.Direction = INV_DIR;
+    uasData.Location.Height = 20;
+    uasData.LocationValid = 1;
+    memset(&det, 0, sizeof(det));
+    odid_detectionFromUasData(&det, &uasData);
+    CHECK(det.Valid == ODID_DETECTION_VALID_HEIGHT);
+
+    CHECK(encodeDetectionRecord(record, &det) == ODID_SUCCESS);
+    CHECK(record[52] == 0 && record[53] == 0);
+    CHECK(decodeDetectionRecord(&out, record, sizeof(record)) == ODID_SUCCESS);
+    odid_detectionToJson(text, sizeof(text), &out);
+    CHECK(strcmp(text, "{\"t\":0,\"mac\":\"00:00:00:00:00:00\",\"height\":20.0}") == 0);
+
+    // Out of range values are clamped
+    det.AltitudeGeo = 40000;
+    det.SpeedHorizontal = 1000;
+    det.Latitude = 200;
+    encodeDetectionRecord(record, &det);
+    decodeDetectionRecord(&out, record, sizeof(record));
+    CHECK(out.AltitudeGeo == MAX_ALT && out.SpeedHorizontal == 655.35f && out.Latitude == 0);
+}
+
+// A received ID can contain any byte, the JSON line must stay valid
+static void test_json_escape(void)
+{
+    ODID_Detection det;
+    char text[512];
+    int len;
+
+    memset(&det, 0, sizeof(det));
+    memcpy(det.UASID, "a\"b\\c\nd\xC3\xA9", 9);
+    det.Valid = ODID_DETECTION_VALID_ID;
+    len = odid_detectionToJson(text, sizeof(text), &det);
+    CHECK(len == (int) strlen(text));
+    CHECK(strcmp(text, "{\"t\":0,\"mac\":\"00:00:00:00:00:00\","
+                       "\"id\":\"a\\\"b\\\\c\\u000ad\\u00c3\\u00a9\"}") == 0);
+
+    // At most ODID_ID_SIZE characters, also without a NULL
+    memset(det.UASID, 'X', sizeof(det.UASID));
+    len = odid_detectionToJson(text, sizeof(text), &det);
+    CHECK(len == (int) strlen("{\"t\":0,\"mac\":\"00:00:00:00:00:00\",\"id\":\"\"}") + ODID_ID_SIZE);
+
+    // Truncated output, also in the middle of an escaped string, reports the full length
+    memcpy(det.UASID, "\"\"\"\"\"\"\"\"\"\"\"\"\"\"\"\"\"\"\"\"", ODID_ID_SIZE);
+    len = odid_detectionToJson(text, sizeof(text), &det);
+    for (size_t size = 1; size < (size_t) len + 1; size++) {
+        char small[512];
+        memset(small, 'Z', sizeof(small));
+        CHECK(odid_detectionToJson(small, size, &det) == len);
+        CHECK(strlen(small) == size - 1 && strncmp(small, text, size - 1) == 0);
+    }
+}
+
+int main(int argc __attribute__((unused)), char const *argv[] __attribute__((unused))) {
+    test_round_trip();
+    test_invalid_fields();
+    test_json_escape();
+
+    printf("detection record test: %s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -354,6 +354,313 @@ static void test_operatorID(mav2odid_t *m2o, ODID_UAS_Data *uas_data)
     print_mavlink_operatorID(&operatorID2);
 }
 
+static int fleetMessages;
+
+static void count_fleet_message(mav2odid_t *m2o __attribute__((unused)),
+                                ODID_messagetype_t type __attribute__((unused)))
+{
+    fleetMessages++;
+}
+
+/**
+* Three vehicles send their Basic ID on one link, with a table for two of them.
+* Each vehicle must get its own data and schedule.
+*/
+static void test_fleet(void)
+{
+    mav2odid_t vehicles[2];
+    m2o_fleet_t fleet;
+    if (m2o_fleetInit(&fleet, vehicles, 2, MAVLINK_COMM_0))
+        printf("ERROR: Initialising the fleet failed\n");
+
+    printf("\n\n-------------------------Fleet--------------------------\n\n");
+
+    uint8_t stream[3 * MAVLINK_MAX_PACKET_LEN];
+    size_t len = 0;
+    for (uint8_t systemId = 1; systemId <= 3; systemId++) {
+        mavlink_message_t msg = { 0 };
+        mavlink_open_drone_id_basic_id_t basicId = {
+            .id_type = MAV_ODID_ID_TYPE_SERIAL_NUMBER,
+            .ua_type = MAV_ODID_UA_TYPE_HELICOPTER_OR_MULTIROTOR };
+        snprintf((char *) basicId.uas_id, sizeof(basicId.uas_id), "FLEET%d", systemId);
+        mavlink_msg_open_drone_id_basic_id_encode(systemId, MAVLINK_COMPONENT_ID, &msg, &basicId);
+        len += mavlink_msg_to_send_buffer(&stream[len], &msg);
+    }
+
+    // Split in the middle of the second frame
+    int count = m2o_fleetParseMavlinkBuffer(&fleet, stream, len / 2, count_fleet_message);
+    count += m2o_fleetParseMavlinkBuffer(&fleet, &stream[len / 2], len - len / 2, count_fleet_message);
+    if (count != 2 || fleetMessages != 2 || fleet.count != 2 || fleet.dropped != 1)
+        printf("ERROR: Fleet decoded %d messages for %d vehicles, dropped %u\n",
+               count, fleet.count, fleet.dropped);
+
+    for (uint8_t systemId = 1; systemId <= 2; systemId++) {
+        mav2odid_t *m2o = m2o_fleetFind(&fleet, systemId, MAVLINK_COMPONENT_ID);
+        ODID_BasicID_data basicId;
+        char expected[ODID_ID_SIZE + 1];
+        snprintf(expected, sizeof(expected), "FLEET%d", systemId);
+
+        uint8_t data[ODID_MESSAGE_SIZE];
+        if (!m2o || m2o_cycleMessages(m2o, data) ||
+            decodeBasicIDMessage(&basicId, (ODID_BasicID_encoded *) data) ||
+            strncmp(basicId.UASID, expected, ODID_ID_SIZE) != 0)
+            printf("ERROR: Vehicle %d did not send its own Basic ID\n", systemId);
+        else
+            printf("Vehicle %d: %s\n", systemId, basicId.UASID);
+    }
+
+    if (m2o_fleetRemove(&fleet, 1, MAVLINK_COMPONENT_ID) || fleet.count != 1 ||
+        m2o_fleetFind(&fleet, 2, MAVLINK_COMPONENT_ID) != &vehicles[0])
+        printf("ERROR: Removing a vehicle from the fleet failed\n");
+}
+
+static void parse_message(mav2odid_t *m2o, mavlink_message_t *msg)
+{
+    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+    uint16_t len = mavlink_msg_to_send_buffer(buf, msg);
+    if (m2o_parseMavlinkBuffer(m2o, buf, len, NULL) != 1)
+        printf("ERROR: Parsing Mavlink message failed\n");
+}
+
+/**
+* The schedule must only contain the received messages, with every second slot
+* a Location message by default
+*/
+static void test_schedule(void)
+{
+    mav2odid_t m2o;
+    uint8_t data[ODID_MESSAGE_SIZE];
+    mavlink_message_t msg = { 0 };
+
+    printf("\n\n-----------------------Schedule-------------------------\n\n");
+
+    if (m2o_init(&m2o))
+        printf("ERROR: Initialising mav2odid data failed\n");
+    if (m2o_cycleMessages(&m2o, data) == ODID_SUCCESS)
+        printf("ERROR: Empty schedule returned a message\n");
+
+    mavlink_open_drone_id_location_t location = { .status = MAV_ODID_STATUS_AIRBORNE };
+    mavlink_msg_open_drone_id_location_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &location);
+    parse_message(&m2o, &msg);
+    mavlink_open_drone_id_basic_id_t basicId = { .id_type = MAV_ODID_ID_TYPE_SERIAL_NUMBER,
+                                                 .uas_id = "112624150A90E3AE1EC0" };
+    mavlink_msg_open_drone_id_basic_id_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &basicId);
+    parse_message(&m2o, &msg);
+    mavlink_open_drone_id_authentication_t auth = { .authentication_type = MAV_ODID_AUTH_TYPE_UAS_ID_SIGNATURE,
+                                                    .last_page_index = 1, .length = 40 };
+    for (uint8_t page = 0; page < 2; page++) {
+        auth.data_page = page;
+        mavlink_msg_open_drone_id_authentication_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &auth);
+        parse_message(&m2o, &msg);
+    }
+
+    // Location, Basic ID, Location, Auth page 0, Location, Auth page 1
+    int counts[M2O_SCHEDULE_TYPES] = { 0 }, authPages = 0;
+    uint8_t previous = ODID_MESSAGETYPE_INVALID;
+    for (int slot = 0; slot < 12; slot++) {
+        if (m2o_cycleMessages(&m2o, data) != ODID_SUCCESS) {
+            printf("ERROR: Schedule slot %d was empty\n", slot);
+            break;
+        }
+        uint8_t type = ((ODID_BasicID_encoded *) data)->MessageType;
+        if (type >= M2O_SCHEDULE_TYPES || (type == ODID_MESSAGETYPE_LOCATION) == (previous == ODID_MESSAGETYPE_LOCATION)) {
+            printf("ERROR: Schedule slot %d had message type %d\n", slot, type);
+            break;
+        }
+        if (type == ODID_MESSAGETYPE_AUTH)
+            authPages |= 1 << ((ODID_Auth_encoded *) data)->page_zero.DataPage;
+        counts[type]++;
+        previous = type;
+    }
+    if (counts[ODID_MESSAGETYPE_LOCATION] != 6 || counts[ODID_MESSAGETYPE_BASIC_ID] != 2 ||
+        counts[ODID_MESSAGETYPE_AUTH] != 4 || authPages != 3)
+        printf("ERROR: Schedule sent %d Location, %d Basic ID and %d Auth messages\n",
+               counts[ODID_MESSAGETYPE_LOCATION], counts[ODID_MESSAGETYPE_BASIC_ID],
+               counts[ODID_MESSAGETYPE_AUTH]);
+    else
+        printf("Schedule of %d slots\n", m2o.scheduleLength);
+
+    // Only Location and Basic ID, with Location twice as often
+    const uint8_t rates[M2O_SCHEDULE_TYPES] = { [ODID_MESSAGETYPE_BASIC_ID] = 1,
+                                                [ODID_MESSAGETYPE_LOCATION] = 2 };
+    if (m2o_setScheduleRates(&m2o, rates) || m2o_cycleMessages(&m2o, data) || m2o.scheduleLength != 3)
+        printf("ERROR: Setting the schedule rates failed\n");
+}
+
+static int streamMessages;
+
+static void count_stream_message(mav2odid_t *m2o __attribute__((unused)),
+                                 ODID_messagetype_t type __attribute__((unused)))
+{
+    streamMessages++;
+}
+
+static size_t append_frame(uint8_t *stream, size_t pos, mavlink_message_t *msg)
+{
+    return pos + mavlink_msg_to_send_buffer(&stream[pos], msg);
+}
+
+/**
+* Telemetry of a flight controller with the Open Drone ID messages in between.
+* Returns the length and the number of Open Drone ID messages in count.
+*/
+static size_t fill_stream(uint8_t *stream, int *count)
+{
+    mavlink_message_t msg = { 0 };
+    mavlink_heartbeat_t heartbeat = { .type = MAV_TYPE_QUADROTOR, .autopilot = MAV_AUTOPILOT_GENERIC,
+                                      .system_status = MAV_STATE_ACTIVE };
+    mavlink_attitude_t attitude = { .roll = 0.1f, .pitch = -0.05f, .yaw = 1.2f };
+    mavlink_open_drone_id_basic_id_t basicId = { .id_type = MAV_ODID_ID_TYPE_SERIAL_NUMBER,
+                                                 .ua_type = MAV_ODID_UA_TYPE_HELICOPTER_OR_MULTIROTOR,
+                                                 .uas_id = "112624150A90E3AE1EC0" };
+    mavlink_open_drone_id_location_t location = { .status = MAV_ODID_STATUS_AIRBORNE,
+                                                  .latitude = 514770000, .longitude = 5000,
+                                                  .altitude_geodetic = 36.5f, .height = 25.5f };
+    mavlink_open_drone_id_self_id_t selfId = { .description = "Stream" };
+    size_t pos = 0;
+
+    *count = 0;
+    for (int i = 0; i < 10; i++) {
+        attitude.time_boot_ms = (uint32_t) i * 20;
+        mavlink_msg_attitude_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &attitude);
+        pos = append_frame(stream, pos, &msg);
+        location.timestamp = (float) i / 10;
+        mavlink_msg_open_drone_id_location_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &location);
+        pos = append_frame(stream, pos, &msg);
+        (*count)++;
+        if (i % 5 == 0) {
+            mavlink_msg_heartbeat_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &heartbeat);
+            pos = append_frame(stream, pos, &msg);
+            mavlink_msg_open_drone_id_basic_id_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &basicId);
+            pos = append_frame(stream, pos, &msg);
+            mavlink_msg_open_drone_id_self_id_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &selfId);
+            pos = append_frame(stream, pos, &msg);
+            *count += 2;
+        }
+    }
+    return pos;
+}
+
+static int same_messages(mav2odid_t *a, mav2odid_t *b)
+{
+    return memcmp(&a->locationEnc, &b->locationEnc, sizeof(a->locationEnc)) == 0 &&
+           memcmp(&a->basicIdEnc[0], &b->basicIdEnc[0], sizeof(a->basicIdEnc[0])) == 0 &&
+           memcmp(&a->selfIdEnc, &b->selfIdEnc, sizeof(a->selfIdEnc)) == 0 &&
+           a->locationEncValid && a->basicIDEncValid[0] && a->selfIDEncValid;
+}
+
+/**
+* m2o_parseMavlinkBuffer() must find the same messages as m2o_parseMavlink(),
+* however the stream is split into reads, and find the next frame after a
+* corrupted frame or garbage
+*/
+static void test_stream(void)
+{
+    static uint8_t stream[4096];
+    mav2odid_t perByte, perBuffer;
+    int count, byteMessages = 0;
+    size_t size = fill_stream(stream, &count);
+
+    printf("\n\n-----------------------Stream---------------------------\n\n");
+
+    m2o_init(&perByte);
+    for (size_t i = 0; i < size; i++) {
+        if (m2o_parseMavlink(&perByte, stream[i]) != ODID_MESSAGETYPE_INVALID)
+            byteMessages++;
+    }
+    if (byteMessages != count)
+        printf("ERROR: Parsing per byte found %d of %d messages\n", byteMessages, count);
+
+    // Reads of every size end in the middle of frames, which continue in the next read
+    for (size_t readSize = 1; readSize <= MAVLINK_MAX_PACKET_LEN + 1; readSize++) {
+        m2o_init(&perBuffer);
+        streamMessages = 0;
+        int messages = 0;
+        for (size_t i = 0; i < size; i += readSize) {
+            size_t len = size - i < readSize ? size - i : readSize;
+            messages += m2o_parseMavlinkBuffer(&perBuffer, &stream[i], len, count_stream_message);
+        }
+        if (messages != count || streamMessages != count || !same_messages(&perByte, &perBuffer)) {
+            printf("ERROR: Parsing reads of %zu bytes found %d of %d messages\n", readSize, messages, count);
+            break;
+        }
+    }
+
+    // A frame split at every position
+    uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+    mavlink_message_t msg = { 0 };
+    mavlink_open_drone_id_self_id_t selfId = { .description = "Split" };
+    mavlink_msg_open_drone_id_self_id_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &selfId);
+    uint16_t frameLen = mavlink_msg_to_send_buffer(frame, &msg);
+    for (uint16_t split = 1; split < frameLen; split++) {
+        m2o_init(&perBuffer);
+        int messages = m2o_parseMavlinkBuffer(&perBuffer, frame, split, NULL);
+        messages += m2o_parseMavlinkBuffer(&perBuffer, &frame[split], frameLen - split, NULL);
+        if (messages != 1 || !perBuffer.selfIDEncValid) {
+            printf("ERROR: Frame split after %u bytes was not found\n", split);
+            break;
+        }
+    }
+
+    // A corrupted Open Drone ID frame must fail the CRC check and not hide the next frame
+    uint8_t frames[2 * MAVLINK_MAX_PACKET_LEN];
+    memcpy(frames, frame, frameLen);
+    memcpy(&frames[frameLen], frame, frameLen);
+    frames[MAVLINK_NUM_HEADER_BYTES + 1] ^= 0xFF;
+    m2o_init(&perBuffer);
+    if (m2o_parseMavlinkBuffer(&perBuffer, frames, 2 * (size_t) frameLen, NULL) != 1)
+        printf("ERROR: The frame after a corrupted frame was not found\n");
+
+    // Garbage before a frame, with headers of frames that would cover the start of
+    // the frame. Telemetry follows, so that those frames end and fail their CRC
+    uint8_t garbage[600 + 3 * MAVLINK_MAX_PACKET_LEN];
+    size_t garbageLen = 600;
+    uint32_t seed = 1;
+    for (size_t i = 0; i < garbageLen; i++) {
+        seed = seed * 1103515245 + 12345;
+        garbage[i] = (uint8_t) (seed >> 16);
+    }
+    for (size_t i = 0; i + 3 < garbageLen; i += 37) {
+        garbage[i] = MAVLINK_STX;
+        garbage[i + 1] = garbage[i + 1] & 0x3F;   // Payload length
+        garbage[i + 2] = 0;                       // Incompatibility flags
+    }
+    garbage[garbageLen - 4] = MAVLINK_STX;
+    garbage[garbageLen - 3] = 40;
+    garbage[garbageLen - 2] = 0;
+    memcpy(&garbage[garbageLen], frame, frameLen);
+    garbageLen += frameLen;
+    mavlink_attitude_t attitude = { .roll = 0.1f };
+    for (int i = 0; i < 2; i++) {
+        mavlink_msg_attitude_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &attitude);
+        garbageLen = append_frame(garbage, garbageLen, &msg);
+    }
+    for (size_t readSize = 1; readSize <= garbageLen; readSize *= 2) {
+        m2o_init(&perBuffer);
+        int messages = 0;
+        for (size_t i = 0; i < garbageLen; i += readSize) {
+            size_t len = garbageLen - i < readSize ? garbageLen - i : readSize;
+            messages += m2o_parseMavlinkBuffer(&perBuffer, &garbage[i], len, NULL);
+        }
+        if (messages != 1 || !perBuffer.selfIDEncValid) {
+            printf("ERROR: The frame after garbage was not found with reads of %zu bytes\n", readSize);
+            break;
+        }
+    }
+
+    // A message pack can't hold more messages than its Mavlink message carries
+    mavlink_open_drone_id_message_pack_t pack = { .single_message_size = ODID_MESSAGE_SIZE,
+                                                  .msg_pack_size = 200 };
+    mavlink_msg_open_drone_id_message_pack_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &pack);
+    frameLen = mavlink_msg_to_send_buffer(frame, &msg);
+    m2o_init(&perBuffer);
+    m2o_parseMavlinkBuffer(&perBuffer, frame, frameLen, NULL);
+    if (perBuffer.messagePackEncValid && perBuffer.messagePackEnc.MsgPackSize > ODID_PACK_MAX_MESSAGES)
+        printf("ERROR: Message pack of %d messages\n", perBuffer.messagePackEnc.MsgPackSize);
+
+    printf("Parsed %d messages in a stream of %zu bytes\n", count, size);
+}
+
 void test_mav2odid()
 {
     mav2odid_t m2o;
@@ -369,6 +676,9 @@ void test_mav2odid()
     test_selfID(&m2o, &uas_data);
     test_system(&m2o, &uas_data);
     test_operatorID(&m2o, &uas_data);
+    test_fleet();
+    test_schedule();
+    test_stream();
 
     printf("\n-------------------------------------------------------------------------------\n");
     printf("-------------------------------------  End  -----------------------------------\n");
@@ -0,0 +1,132 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Mavlink to Open Drone ID schedule test
+
+Built with a DRONEID_SCHEDULER_SIZE that is too small for a cycle with all
+messages at the default rates, see test/CMakeLists.txt.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <mav2odid.h>
+
+#define MAVLINK_SYSTEM_ID       1
+#define MAVLINK_COMPONENT_ID    1
+#define CYCLES                  ODID_AUTH_MAX_PAGES
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static void parse_message(mav2odid_t *m2o, mavlink_message_t *msg)
+{
+    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+    uint16_t len = mavlink_msg_to_send_buffer(buf, msg);
+    CHECK(m2o_parseMavlinkBuffer(m2o, buf, len, NULL) == 1);
+}
+
+// Every message a transmitter can receive, incl. both Basic IDs and all Authentication pages
+static void receive_all(mav2odid_t *m2o)
+{
+    mavlink_message_t msg = { 0 };
+
+    mavlink_open_drone_id_location_t location = { .status = MAV_ODID_STATUS_AIRBORNE };
+    mavlink_msg_open_drone_id_location_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &location);
+    parse_message(m2o, &msg);
+
+    mavlink_open_drone_id_basic_id_t basicId = { .id_type = MAV_ODID_ID_TYPE_SERIAL_NUMBER,
+                                                 .uas_id = "112624150A90E3AE1EC0" };
+    mavlink_msg_open_drone_id_basic_id_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &basicId);
+    parse_message(m2o, &msg);
+    basicId.id_type = MAV_ODID_ID_TYPE_CAA_REGISTRATION_ID;
+    mavlink_msg_open_drone_id_basic_id_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &basicId);
+    parse_message(m2o, &msg);
+
+    mavlink_open_drone_id_authentication_t auth = { .authentication_type = MAV_ODID_AUTH_TYPE_UAS_ID_SIGNATURE,
+                                                    .last_page_index = ODID_AUTH_MAX_PAGES - 1, .length = 40 };
+    for (uint8_t page = 0; page < ODID_AUTH_MAX_PAGES; page++) {
+        auth.data_page = page;
+        mavlink_msg_open_drone_id_authentication_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &auth);
+        parse_message(m2o, &msg);
+    }
+
+    mavlink_open_drone_id_self_id_t selfId = { .description_type = MAV_ODID_DESC_TYPE_TEXT };
+    mavlink_msg_open_drone_id_self_id_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &selfId);
+    parse_message(m2o, &msg);
+    mavlink_open_drone_id_system_t system = { .operator_location_type = MAV_ODID_OPERATOR_LOCATION_TYPE_TAKEOFF };
+    mavlink_msg_open_drone_id_system_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &system);
+    parse_message(m2o, &msg);
+    mavlink_open_drone_id_operator_id_t operatorId = { .operator_id_type = MAV_ODID_OPERATOR_ID_TYPE_CAA };
+    mavlink_msg_open_drone_id_operator_id_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &operatorId);
+    parse_message(m2o, &msg);
+}
+
+// The default rates do not fit, but the cycle is scaled down instead of failing
+static void test_default_rates(void)
+{
+    mav2odid_t m2o;
+    uint8_t data[ODID_MESSAGE_SIZE];
+
+    CHECK(m2o_init(&m2o) == ODID_SUCCESS);
+    receive_all(&m2o);
+
+    // Each cycle has every type and Location in every second slot. The Basic IDs and
+    // Authentication pages take turns over the cycles
+    int counts[M2O_SCHEDULE_TYPES] = { 0 }, basicIds = 0, authPages = 0;
+    for (int cycle = 0; cycle < CYCLES; cycle++) {
+        int types = 0;
+        for (int slot = 0; slot < DRONEID_SCHEDULER_SIZE; slot++) {
+            CHECK(m2o_cycleMessages(&m2o, data) == ODID_SUCCESS);
+            uint8_t type = ((ODID_BasicID_encoded *) data)->MessageType;
+            CHECK(type < M2O_SCHEDULE_TYPES);
+            if (type >= M2O_SCHEDULE_TYPES)
+                return;
+            CHECK((type == ODID_MESSAGETYPE_LOCATION) == ((slot & 1) == 0));
+            if (type == ODID_MESSAGETYPE_BASIC_ID)
+                basicIds |= 1 << (((ODID_BasicID_encoded *) data)->IDType - 1);
+            if (type == ODID_MESSAGETYPE_AUTH)
+                authPages |= 1 << ((ODID_Auth_encoded *) data)->page_zero.DataPage;
+            types |= 1 << type;
+            counts[type]++;
+        }
+        CHECK(types == (1 << M2O_SCHEDULE_TYPES) - 1);
+    }
+    CHECK(m2o.scheduleLength == DRONEID_SCHEDULER_SIZE);
+    CHECK(counts[ODID_MESSAGETYPE_LOCATION] == CYCLES * DRONEID_SCHEDULER_SIZE / 2);
+    CHECK(counts[ODID_MESSAGETYPE_AUTH] > counts[ODID_MESSAGETYPE_SELF_ID]);
+    CHECK(basicIds == 3);
+    CHECK(authPages == (1 << ODID_AUTH_MAX_PAGES) - 1);
+}
+
+// Creating a vehicle initialises it with the default rates, which must not fail either
+static void test_fleet(void)
+{
+    mav2odid_t vehicles[2];
+    m2o_fleet_t fleet;
+    mavlink_message_t msg = { 0 };
+    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+
+    CHECK(m2o_fleetInit(&fleet, vehicles, 2, 1) == ODID_SUCCESS);
+    mavlink_open_drone_id_location_t location = { .status = MAV_ODID_STATUS_AIRBORNE };
+    mavlink_msg_open_drone_id_location_encode(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &msg, &location);
+    uint16_t len = mavlink_msg_to_send_buffer(buf, &msg);
+    CHECK(m2o_fleetParseMavlinkBuffer(&fleet, buf, len, NULL) == 1);
+    CHECK(fleet.count == 1 && fleet.dropped == 0);
+    CHECK(m2o_fleetFind(&fleet, MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID) == &vehicles[0]);
+}
+
+int main(int argc __attribute__((unused)), char const *argv[] __attribute__((unused))) {
+    test_default_rates();
+    test_fleet();
+
+    printf("mav2odid schedule test (DRONEID_SCHEDULER_SIZE %d): %s\n", DRONEID_SCHEDULER_SIZE,
+           failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,253 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID C Library
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <opendroneid.h>
+#include <odid_rxlog.h>
+
+#define MAX_RING_SIZE 65536
+#define FRAME_BUF_SIZE 1024
+#define BURST_GAP_US 20000
+#define BURSTS 20
+#define CONSUMER_SLEEP_US 1000  // One FreeRTOS tick at the default 1 kHz
+
+static uint8_t ring[MAX_RING_SIZE] __attribute__((aligned(ODID_RXLOG_ALIGN)));
+static uint8_t beacon[FRAME_BUF_SIZE];
+static uint8_t nan[FRAME_BUF_SIZE];
+static int beaconLen, nanLen;
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static void build_frames(void)
+{
+    ODID_UAS_Data uasData;
+    char mac[6] = { 0x60, 0x60, 0x01, 0x02, 0x03, 0x04 };
+
+    odid_initUasData(&uasData);
+    uasData.BasicID[0].UAType = ODID_UATYPE_HELICOPTER_OR_MULTIROTOR;
+    uasData.BasicID[0].IDType = ODID_IDTYPE_SERIAL_NUMBER;
+    strcpy(uasData.BasicID[0].UASID, "RXLOG00000000000001");
+    uasData.BasicIDValid[0] = 1;
+    uasData.Location.Status = ODID_STATUS_AIRBORNE;
+    uasData.Location.Latitude = 45.539309;
+    uasData.Location.Longitude = -122.966389;
+    uasData.Location.AltitudeGeo = 110;
+    uasData.LocationValid = 1;
+    strcpy(uasData.OperatorID.OperatorId, "FIN87astrdge12k8");
+    uasData.OperatorIDValid = 1;
+
+    beaconLen = odid_wifi_build_message_pack_beacon_frame(&uasData, mac, "RID", 3, 100, 1,
+                                                         beacon, sizeof(beacon));
+    nanLen = odid_wifi_build_message_pack_nan_action_frame(&uasData, mac, 1, nan, sizeof(nan));
+    CHECK(beaconLen > 0 && nanLen > 0);
+}
+
+static void test_init(void)
+{
+    ODID_RxLog log;
+
+    CHECK(odid_initRxLog(&log, ring, 1000) == ODID_FAIL);
+    CHECK(odid_initRxLog(&log, ring + 1, 1024) == ODID_FAIL);
+    CHECK(odid_initRxLog(&log, ring, 1024) == ODID_SUCCESS);
+    CHECK(odid_rxLogPeek(&log) == NULL);
+}
+
+// Records of varying size wrap around the end of the ring many times
+static void test_wrap(void)
+{
+    ODID_RxLog log;
+    uint8_t frame[300];
+    int pushed = 0, popped = 0;
+
+    odid_initRxLog(&log, ring, 1024);
+    for (int round = 0; round < 10000; round++) {
+        uint16_t len = (uint16_t) (round * 37 % sizeof(frame));
+
+        memset(frame, (uint8_t) pushed, len);
+        if (odid_rxLogPush(&log, frame, len, -50, 6, (uint32_t) pushed) == ODID_SUCCESS)
+            pushed++;
+
+        // Drain in batches, so the ring is full now and then
+        if ((round % 5) == 4) {
+            ODID_RxFrame *rec;
+            while ((rec = odid_rxLogPeek(&log))) {
+                uint8_t *data = odid_rxFrameData(rec);
+                CHECK(rec->Timestamp == (uint32_t) popped);
+                CHECK(rec->RSSI == -50 && rec->Channel == 6);
+                for (int i = 0; i < rec->Length; i++) {
+                    if (data[i] != (uint8_t) popped) {
+                        CHECK(data[i] == (uint8_t) popped);
+                        break;
+                    }
+                }
+                odid_rxLogPop(&log);
+                popped++;
+            }
+        }
+    }
+    CHECK(pushed == popped);
+    CHECK(log.Frames == 10000 && log.Dropped == (uint32_t) (10000 - pushed));
+    CHECK(log.Dropped > 0);
+    CHECK(log.HighWater <= 1024);
+}
+
+static void test_decode(void)
+{
+    ODID_UAS_Data uasData;
+    ODID_RxFrame header = { 1234, 0, -61, 6 };
+    uint8_t mac[6];
+    uint8_t junk[64];
+    char text[256];
+    int len;
+
+    CHECK(odid_rxFrameDecode(&uasData, mac, beacon, (uint16_t) beaconLen) == ODID_SUCCESS);
+    CHECK(mac[0] == 0x60 && mac[5] == 0x04);
+    CHECK(uasData.BasicIDValid[0] && strcmp(uasData.BasicID[0].UASID, "RXLOG00000000000001") == 0);
+
+    len = odid_rxFrameFormat(text, sizeof(text), &header, mac, &uasData);
+    CHECK(len == (int) strlen(text));
+    CHECK(strcmp(text, "{\"t\":1234,\"mac\":\"60:60:01:02:03:04\",\"rssi\":-61,\"ch\":6,"
+                       "\"id\":\"RXLOG00000000000001\",\"lat\":45.5393090,\"lon\":-122.9663890,"
+                       "\"alt\":110.0,\"op\":\"FIN87astrdge12k8\"}") == 0);
+    // Truncated output still reports the full length
+    CHECK(odid_rxFrameFormat(text, 10, &header, mac, &uasData) == len);
+    CHECK(strlen(text) == 9);
+
+    CHECK(odid_rxFrameDecode(&uasData, mac, nan, (uint16_t) nanLen) == ODID_SUCCESS);
+    CHECK(uasData.OperatorIDValid);
+
+    // The same message pack in the vendor specific IE of Parrot drones
+    uint8_t parrot[FRAME_BUF_SIZE];
+    uint8_t *oui = NULL;
+    memcpy(parrot, beacon, (size_t) beaconLen);
+    for (int i = 0; i + 3 <= beaconLen && !oui; i++) {
+        if (parrot[i] == 0xFA && parrot[i + 1] == 0x0B && parrot[i + 2] == 0xBC)
+            oui = &parrot[i];
+    }
+    CHECK(oui != NULL);
+    if (oui) {
+        oui[0] = 0x90; oui[1] = 0x3A; oui[2] = 0xE6;
+        memset(&uasData, 0, sizeof(uasData));
+        CHECK(odid_rxFrameDecode(&uasData, mac, parrot, (uint16_t) beaconLen) == ODID_SUCCESS);
+        CHECK(uasData.BasicIDValid[0] && strcmp(uasData.BasicID[0].UASID, "RXLOG00000000000001") == 0);
+    }
+
+    // Truncated beacons and other frames
+    for (int l = 0; l < beaconLen; l++)
+        CHECK(odid_rxFrameDecode(&uasData, mac, beacon, (uint16_t) l) == ODID_FAIL);
+    memset(junk, 0, sizeof(junk));
+    junk[0] = 0x80;
+    CHECK(odid_rxFrameDecode(&uasData, mac, junk, sizeof(junk)) == ODID_FAIL);
+}
+
+struct burst_test {
+    ODID_RxLog log;
+    int burst;
+    volatile int done;
+    uint32_t decoded;
+    uint32_t outOfOrder;
+};
+
+// Simulates the WiFi callback: bursts of frames as fast as possible, then a pause
+static void *producer(void *arg)
+{
+    struct burst_test *test = arg;
+    uint32_t seq = 0;
+
+    for (int b = 0; b < BURSTS; b++) {
+        for (int i = 0; i < test->burst; i++) {
+            const uint8_t *frame = (seq & 1) ? nan : beacon;
+            uint16_t len = (uint16_t) ((seq & 1) ? nanLen : beaconLen);
+            odid_rxLogPush(&test->log, frame, len, -60, 6, seq++);
+        }
+        usleep(BURST_GAP_US);
+    }
+    __atomic_store_n(&test->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Simulates the low priority task: decodes and formats, sleeps a tick when idle
+static void *consumer(void *arg)
+{
+    struct burst_test *test = arg;
+    ODID_UAS_Data uasData;
+    uint32_t last = 0;
+    uint8_t mac[6];
+    char text[256];
+
+    for (;;) {
+        ODID_RxFrame *rec = odid_rxLogPeek(&test->log);
+
+        if (!rec) {
+            if (__atomic_load_n(&test->done, __ATOMIC_ACQUIRE) && !odid_rxLogPeek(&test->log))
+                break;
+            usleep(CONSUMER_SLEEP_US);
+            continue;
+        }
+        if (test->decoded && rec->Timestamp <= last)
+            test->outOfOrder++;
+        last = rec->Timestamp;
+        if (odid_rxFrameDecode(&uasData, mac, odid_rxFrameData(rec), rec->Length) == ODID_SUCCESS &&
+            odid_rxFrameFormat(text, sizeof(text), rec, mac, &uasData) > 0)
+            test->decoded++;
+        odid_rxLogPop(&test->log);
+    }
+    return NULL;
+}
+
+static void test_bursts(uint32_t size, int burst)
+{
+    struct burst_test test;
+    pthread_t threads[2];
+    double rate;
+
+    memset(&test, 0, sizeof(test));
+    odid_initRxLog(&test.log, ring, size);
+    test.burst = burst;
+    pthread_create(&threads[0], NULL, consumer, &test);
+    pthread_create(&threads[1], NULL, producer, &test);
+    pthread_join(threads[1], NULL);
+    pthread_join(threads[0], NULL);
+
+    rate = 100.0 * test.log.Dropped / test.log.Frames;
+    printf("ring %5u bytes, bursts of %4d frames: dropped %5.1f%%, high water %5u bytes\n",
+           size, burst, rate, test.log.HighWater);
+    CHECK(test.decoded + test.log.Dropped == test.log.Frames);
+    CHECK(test.outOfOrder == 0);
+    CHECK(test.log.HighWater <= size);
+    // Without back to back frames the consumer always keeps up
+    if (burst == 1)
+        CHECK(test.log.Dropped == 0);
+}
+
+int main(int argc __attribute__((unused)), char const *argv[] __attribute__((unused))) {
+    build_frames();
+    test_init();
+    test_wrap();
+    test_decode();
+
+    printf("beacon %d bytes, NAN %d bytes, %d bursts %d ms apart\n",
+           beaconLen, nanLen, BURSTS, BURST_GAP_US / 1000);
+    for (uint32_t size = 4096; size <= MAX_RING_SIZE; size *= 4) {
+        test_bursts(size, 1);
+        test_bursts(size, 32);
+        test_bursts(size, 256);
+    }
+
+    printf("receive log test: %s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,290 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID C Library
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <opendroneid.h>
+#include <odid_track.h>
+
+#define CAPACITY 64
+#define BUCKETS 128
+#define TIMEOUT 300000
+
+static ODID_TrackTable table;
+static ODID_Track tracks[CAPACITY];
+static uint16_t indexes[2 * BUCKETS];
+static int evicted[CAPACITY];
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static void on_evict(void *ctx, int index, const ODID_Track *track)
+{
+    (void) ctx;
+    (void) track;
+    evicted[index]++;
+}
+
+static void make_mac(uint8_t *mac, int n)
+{
+    mac[0] = 0x60;
+    mac[1] = 0x60;
+    mac[2] = (uint8_t) (n >> 24);
+    mac[3] = (uint8_t) (n >> 16);
+    mac[4] = (uint8_t) (n >> 8);
+    mac[5] = (uint8_t) n;
+}
+
+static void reset(uint32_t timeout)
+{
+    memset(evicted, 0, sizeof(evicted));
+    CHECK(odid_initTrackTable(&table, tracks, CAPACITY, indexes, BUCKETS, timeout,
+                              on_evict, NULL) == ODID_SUCCESS);
+}
+
+static int total_evicted(void)
+{
+    int n = 0;
+    for (int i = 0; i < CAPACITY; i++)
+        n += evicted[i];
+    return n;
+}
+
+static void test_init(void)
+{
+    CHECK(odid_initTrackTable(&table, tracks, CAPACITY, indexes, CAPACITY, TIMEOUT,
+                              NULL, NULL) == ODID_FAIL);
+    CHECK(odid_initTrackTable(&table, tracks, CAPACITY, indexes, 100, TIMEOUT,
+                              NULL, NULL) == ODID_FAIL);
+    CHECK(odid_initTrackTable(&table, tracks, 0, indexes, BUCKETS, TIMEOUT,
+                              NULL, NULL) == ODID_FAIL);
+}
+
+static void test_find(void)
+{
+    uint8_t mac[6];
+    int idx[CAPACITY];
+
+    reset(TIMEOUT);
+    for (int i = 0; i < CAPACITY; i++) {
+        make_mac(mac, i);
+        CHECK(odid_trackFind(&table, mac) < 0);
+        idx[i] = odid_trackUpdate(&table, mac, 1000);
+        CHECK(idx[i] >= 0 && idx[i] < CAPACITY);
+    }
+    CHECK(table.Count == CAPACITY);
+    for (int i = 0; i < CAPACITY; i++) {
+        make_mac(mac, i);
+        CHECK(odid_trackFind(&table, mac) == idx[i]);
+        CHECK(odid_trackUpdate(&table, mac, 2000) == idx[i]);
+        CHECK(memcmp(tracks[idx[i]].MAC, mac, 6) == 0);
+        CHECK(tracks[idx[i]].FirstSeen == 1000 && tracks[idx[i]].LastSeen == 2000);
+    }
+    CHECK(table.Count == CAPACITY);
+    CHECK(total_evicted() == 0);
+
+    // Removing every other track must not break the probe chains of the others
+    for (int i = 0; i < CAPACITY; i += 2)
+        odid_trackRemove(&table, idx[i]);
+    CHECK(table.Count == CAPACITY / 2);
+    for (int i = 0; i < CAPACITY; i++) {
+        make_mac(mac, i);
+        CHECK(odid_trackFind(&table, mac) == ((i & 1) ? idx[i] : -1));
+    }
+    CHECK(total_evicted() == 0);
+}
+
+static void test_lru(void)
+{
+    uint8_t mac[6];
+    int first, idx;
+
+    reset(TIMEOUT);
+    for (int i = 0; i < CAPACITY; i++) {
+        make_mac(mac, i);
+        odid_trackUpdate(&table, mac, (uint32_t) i);
+    }
+    // Seeing drone 0 again makes drone 1 the least recently seen
+    make_mac(mac, 0);
+    first = odid_trackUpdate(&table, mac, 100);
+
+    make_mac(mac, CAPACITY);
+    idx = odid_trackUpdate(&table, mac, 101);
+    CHECK(table.Count == CAPACITY);
+    CHECK(total_evicted() == 1);
+    CHECK(evicted[idx] == 1);
+    make_mac(mac, 1);
+    CHECK(odid_trackFind(&table, mac) < 0);
+    make_mac(mac, 0);
+    CHECK(odid_trackFind(&table, mac) == first);
+    make_mac(mac, CAPACITY);
+    CHECK(odid_trackFind(&table, mac) == idx);
+}
+
+static void test_id(void)
+{
+    uint8_t mac[6];
+    int a, b;
+
+    reset(TIMEOUT);
+    make_mac(mac, 1);
+    a = odid_trackUpdate(&table, mac, 0);
+    make_mac(mac, 2);
+    b = odid_trackUpdate(&table, mac, 0);
+
+    CHECK(odid_trackFindID(&table, "12345678901234567890") < 0);
+    CHECK(odid_trackSetID(&table, a, "12345678901234567890") == ODID_SUCCESS);
+    CHECK(odid_trackFindID(&table, "12345678901234567890") == a);
+    CHECK(odid_trackSetID(&table, a, "SN-A") == ODID_SUCCESS);
+    CHECK(odid_trackFindID(&table, "12345678901234567890") < 0);
+    CHECK(odid_trackFindID(&table, "SN-A") == a);
+
+    // The same drone seen with a new MAC address
+    CHECK(odid_trackSetID(&table, b, "SN-A") == ODID_SUCCESS);
+    CHECK(odid_trackFindID(&table, "SN-A") == b);
+    CHECK(!tracks[a].IDIndexed);
+
+    odid_trackRemove(&table, b);
+    CHECK(odid_trackFindID(&table, "SN-A") < 0);
+    CHECK(odid_trackSetID(&table, b, "SN-B") == ODID_FAIL);
+}
+
+// Returns the time at which the next track expired, stepping through time like a main loop
+static uint32_t expire_until(uint32_t from, uint32_t to)
+{
+    for (uint32_t t = from; t != to; t += 7) {
+        if (odid_trackExpire(&table, t) > 0)
+            return t;
+    }
+    return to;
+}
+
+static void test_expire(uint32_t start)
+{
+    uint32_t tick, t;
+    uint8_t mac[6];
+    int idx[3];
+
+    reset(10000);
+    tick = (uint32_t) 1 << table.TickShift;
+    CHECK(odid_trackExpire(&table, start) == 0);
+    for (int i = 0; i < 3; i++) {
+        make_mac(mac, i);
+        idx[i] = odid_trackUpdate(&table, mac, start + (uint32_t) i * 4000);
+    }
+    // Drone 0 is kept alive until start + 19000
+    make_mac(mac, 0);
+    odid_trackUpdate(&table, mac, start + 9000);
+
+    // Tracks never expire early and at most one wheel slot late
+    t = expire_until(start, start + 30000);
+    CHECK(t - start >= 14000 && t - start <= 14000 + tick);
+    CHECK(evicted[idx[1]] == 1 && table.Count == 2);
+    t = expire_until(t, start + 30000);
+    CHECK(t - start >= 18000 && t - start <= 18000 + tick);
+    CHECK(evicted[idx[2]] == 1 && table.Count == 1);
+    t = expire_until(t, start + 30000);
+    CHECK(t - start >= 19000 && t - start <= 19000 + tick);
+    CHECK(evicted[idx[0]] == 1 && table.Count == 0);
+
+    // After a long pause
+    make_mac(mac, 3);
+    idx[0] = odid_trackUpdate(&table, mac, start + 30000);
+    CHECK(odid_trackExpire(&table, start + 1000000) == 1);
+    CHECK(evicted[idx[0]] == 2 && table.Count == 0);
+}
+
+// Decoding threads hand over frames out of order. A late frame must not make
+// the drone expire early and then be counted as a new one
+static void test_out_of_order(void)
+{
+    uint32_t tick, t;
+    uint8_t mac[6];
+    int a;
+
+    reset(10000);
+    tick = (uint32_t) 1 << table.TickShift;
+    make_mac(mac, 1);
+    a = odid_trackUpdate(&table, mac, 9000);
+    CHECK(odid_trackExpire(&table, 9000) == 0);
+    CHECK(odid_trackUpdate(&table, mac, 1000) == a);
+    CHECK(tracks[a].LastSeen == 9000);
+    CHECK(odid_trackExpire(&table, 500) == 0);
+
+    make_mac(mac, 2);
+    CHECK(odid_trackExpire(&table, 11500) == 0);
+    odid_trackUpdate(&table, mac, 11500);
+    CHECK(evicted[a] == 0 && table.Count == 2);
+    make_mac(mac, 1);
+    CHECK(odid_trackFind(&table, mac) == a);
+
+    // Drone 1 expires after the timeout from the frame at 9000
+    t = expire_until(11500, 30000);
+    CHECK(t >= 19000 && t <= 19000 + tick);
+    CHECK(evicted[a] == 1 && table.Count == 1);
+}
+
+static void test_random(void)
+{
+    uint8_t mac[6];
+    uint32_t now = 0;
+
+    reset(5000);
+    srand(1);
+    for (int round = 0; round < 200000; round++) {
+        int n = rand() % (4 * CAPACITY);
+        make_mac(mac, n);
+        now += (uint32_t) (rand() % 10);
+
+        switch (rand() % 4) {
+        case 0:
+            odid_trackRemove(&table, odid_trackFind(&table, mac));
+            break;
+        case 1:
+            odid_trackExpire(&table, now);
+            break;
+        default:
+            odid_trackUpdate(&table, mac, now);
+            break;
+        }
+
+        // Every track in use must be found by its own MAC address
+        if ((round % 1000) == 0) {
+            int count = 0;
+            for (int i = 0; i < CAPACITY; i++) {
+                if (!tracks[i].InUse)
+                    continue;
+                count++;
+                CHECK(odid_trackFind(&table, tracks[i].MAC) == i);
+            }
+            CHECK(count == table.Count);
+        }
+    }
+}
+
+int main(int argc __attribute__((unused)), char const *argv[] __attribute__((unused))) {
+    test_init();
+    test_find();
+    test_lru();
+    test_id();
+    test_expire(0);
+    // millis() wraps around after 49.7 days
+    test_expire(UINT32_MAX - 6000);
+    // Epoch ms truncated to 32 bits, more than half the range after 0
+    test_expire(0x90000000);
+    test_out_of_order();
+    test_random();
+
+    printf("track table test: %s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
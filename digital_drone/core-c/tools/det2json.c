@@ -0,0 +1,174 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID detection record converter
+
+Reads binary detection records (see odid_detection.h) from files, stdin
+(e.g. a serial port) or UDP datagrams and prints one JSON object per line.
+Bytes that are not part of a valid record, like log text between the
+records of a serial stream, are skipped.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <opendroneid.h>
+#include <odid_detection.h>
+
+#define READ_BUF_SIZE 65536
+
+struct converter {
+    uint8_t buf[READ_BUF_SIZE];
+    size_t len;
+    unsigned long records;
+    unsigned long skipped;  // bytes
+};
+
+void usage(char *name)
+{
+    fprintf(stderr,"%s [file...]\n", name);
+    fprintf(stderr,"\t-u\treceive records in UDP datagrams on this port\n");
+    fprintf(stderr,"\tReads stdin without files or port\n");
+}
+
+static void print_record(struct converter *conv, const ODID_Detection *det)
+{
+    char text[512];
+
+    odid_detectionToJson(text, sizeof(text), det);
+    puts(text);
+    conv->records++;
+}
+
+/**
+ * convert_buffer - print all complete records in the buffer and keep the rest
+ */
+static void convert_buffer(struct converter *conv)
+{
+    ODID_Detection det;
+    size_t pos = 0;
+
+    while (conv->len - pos >= ODID_DETECTION_SIZE) {
+        if (decodeDetectionRecord(&det, &conv->buf[pos], conv->len - pos) == ODID_SUCCESS) {
+            print_record(conv, &det);
+            pos += ODID_DETECTION_SIZE;
+        } else {
+            pos++;
+            conv->skipped++;
+        }
+    }
+    memmove(conv->buf, &conv->buf[pos], conv->len - pos);
+    conv->len -= pos;
+}
+
+static int convert_fd(struct converter *conv, int fd)
+{
+    ssize_t n;
+
+    conv->len = 0;
+    for (;;) {
+        n = read(fd, &conv->buf[conv->len], sizeof(conv->buf) - conv->len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return -errno;
+        if (n == 0)
+            break;
+        conv->len += (size_t) n;
+        convert_buffer(conv);
+        fflush(stdout);
+    }
+    conv->skipped += conv->len;
+    return 0;
+}
+
+static int convert_udp(struct converter *conv, int port)
+{
+    struct sockaddr_in addr;
+    ssize_t n;
+    int fd;
+
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+        return -errno;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t) port);
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        int ret = -errno;
+        close(fd);
+        return ret;
+    }
+
+    // Each datagram holds whole records, nothing is carried over
+    for (;;) {
+        n = recv(fd, conv->buf, sizeof(conv->buf), 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            break;
+        conv->len = (size_t) n;
+        convert_buffer(conv);
+        conv->skipped += conv->len;
+        fflush(stdout);
+    }
+    n = -errno;
+    close(fd);
+    return (int) n;
+}
+
+int main(int argc, char *argv[])
+{
+    static struct converter conv;
+    int port = 0, opt, ret = 0;
+
+    while((opt = getopt(argc, argv, "hu:")) != -1) {
+        switch (opt) {
+            case 'u':
+                port = atoi(optarg);
+                break;
+            case 'h':
+                usage(argv[0]);
+                return 0;
+            default:
+                usage(argv[0]);
+                return -1;
+        }
+    }
+
+    if (port) {
+        ret = convert_udp(&conv, port);
+        if (ret < 0)
+            fprintf(stderr, "%s: UDP port %d: %s\n", argv[0], port, strerror(-ret));
+    } else if (optind == argc) {
+        ret = convert_fd(&conv, STDIN_FILENO);
+        if (ret < 0)
+            fprintf(stderr, "%s: stdin: %s\n", argv[0], strerror(-ret));
+    }
+    for (int i = optind; i < argc && !port; i++) {
+        FILE *file = fopen(argv[i], "rb");
+        int err;
+
+        if (!file) {
+            fprintf(stderr, "%s: %s: %s\n", argv[0], argv[i], strerror(errno));
+            ret = -1;
+            continue;
+        }
+        err = convert_fd(&conv, fileno(file));
+        if (err < 0) {
+            fprintf(stderr, "%s: %s: %s\n", argv[0], argv[i], strerror(-err));
+            ret = err;
+        }
+        fclose(file);
+    }
+
+    fprintf(stderr, "%lu records, %lu bytes skipped\n", conv.records, conv.skipped);
+    return ret < 0 ? -1 : 0;
+}
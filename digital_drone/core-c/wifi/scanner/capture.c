@@ -0,0 +1,383 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID WiFi scanner
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <byteswap.h>
+
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+
+#include "capture.h"
+#include "radiotap.h"
+
+/* 64 blocks of 256 KiB. A block is handed to user space when it is full or
+ * when RING_BLOCK_TIMEOUT_MS has passed since the first frame was written */
+#define RING_BLOCK_SIZE         (1 << 18)
+#define RING_BLOCK_NR           64
+#define RING_FRAME_SIZE         2048
+#define RING_BLOCK_TIMEOUT_MS   50
+
+#define POLL_TIMEOUT_MS         100
+
+/* Number of information elements the filter looks at in a beacon frame
+ * before it gives up finding the ODID vendor specific IE */
+#define FILTER_IE_HOPS          16
+
+#define IEEE80211_HDR_LEN       24
+#define IEEE80211_BEACON_LEN    12
+
+#define PCAP_MAGIC              0xa1b2c3d4
+#define PCAP_MAGIC_NSEC         0xa1b23c4d
+#define LINKTYPE_IEEE802_11     105
+#define LINKTYPE_RADIOTAP       127
+
+struct pcap_file_hdr {
+    uint32_t magic;
+    uint16_t version_major;
+    uint16_t version_minor;
+    int32_t thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t linktype;
+};
+
+struct pcap_record_hdr {
+    uint32_t ts_sec;
+    uint32_t ts_frac;
+    uint32_t incl_len;
+    uint32_t orig_len;
+};
+
+/* Filter layout. All loads after the header are relative to the end of the
+ * radiotap header, which is kept in X (and advanced per IE for beacons) */
+#define FILTER_HEADER           9
+#define FILTER_ACTION           FILTER_HEADER
+#define FILTER_BEACON           (FILTER_ACTION + 8)
+#define FILTER_HOP_LEN          8
+#define FILTER_REJECT           (FILTER_BEACON + 3 + FILTER_IE_HOPS * FILTER_HOP_LEN)
+#define FILTER_ACCEPT           (FILTER_REJECT + 1)
+#define FILTER_LEN              (FILTER_ACCEPT + 1)
+
+#define JUMP_TO(target, pc)     ((uint8_t) ((target) - (pc) - 1))
+
+static int build_filter(struct sock_filter *prog)
+{
+    int pc = 0;
+
+    /* X = radiotap header length (little endian) */
+    prog[pc++] = (struct sock_filter) BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 3);
+    prog[pc++] = (struct sock_filter) BPF_STMT(BPF_ALU | BPF_LSH | BPF_K, 8);
+    prog[pc++] = (struct sock_filter) BPF_STMT(BPF_MISC | BPF_TAX, 0);
+    prog[pc++] = (struct sock_filter) BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 2);
+    prog[pc++] = (struct sock_filter) BPF_STMT(BPF_ALU | BPF_OR | BPF_X, 0);
+    prog[pc++] = (struct sock_filter) BPF_STMT(BPF_MISC | BPF_TAX, 0);
+
+    /* first frame control byte: beacon or action frame */
+    prog[pc++] = (struct sock_filter) BPF_STMT(BPF_LD | BPF_B | BPF_IND, 0);
+    prog[pc] = (struct sock_filter) BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0x80,
+                                             JUMP_TO(FILTER_BEACON, pc), 0);
+    pc++;
+    prog[pc] = (struct sock_filter) BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0xD0,
+                                             0, JUMP_TO(FILTER_REJECT, pc));
+    pc++;
+
+    /* NAN action frame: public action, NAN service discovery with the
+     * ODID service ID (see odid_wifi_build_message_pack_nan_action_frame) */
+    prog[pc++] = (struct sock_filter) BPF_STMT(BPF_LD | BPF_H | BPF_IND, IEEE80211_HDR_LEN);
+    prog[pc] = (struct sock_filter) BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0x0409,
+                                             0, JUMP_TO(FILTER_REJECT, pc));
+    pc++;
+    prog[pc++] = (struct sock_filter) BPF_STMT(BPF_LD | BPF_W | BPF_IND, IEEE80211_HDR_LEN + 2);
+    prog[pc] = (struct sock_filter) BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0x506F9A13,
+                                             0, JUMP_TO(FILTER_REJECT, pc));
+    pc++;
+    prog[pc++] = (struct sock_filter) BPF_STMT(BPF_LD | BPF_W | BPF_IND, IEEE80211_HDR_LEN + 9);
+    prog[pc] = (struct sock_filter) BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0x8869199D,
+                                             0, JUMP_TO(FILTER_REJECT, pc));
+    pc++;
+    prog[pc++] = (struct sock_filter) BPF_STMT(BPF_LD | BPF_H | BPF_IND, IEEE80211_HDR_LEN + 13);
+    prog[pc] = (struct sock_filter) BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0x9209,
+                                             JUMP_TO(FILTER_ACCEPT, pc), JUMP_TO(FILTER_REJECT, pc));
+    pc++;
+
+    /* Beacon frame: X = first information element */
+    prog[pc++] = (struct sock_filter) BPF_STMT(BPF_MISC | BPF_TXA, 0);
+    prog[pc++] = (struct sock_filter) BPF_STMT(BPF_ALU | BPF_ADD | BPF_K,
+                                               IEEE80211_HDR_LEN + IEEE80211_BEACON_LEN);
+    prog[pc++] = (struct sock_filter) BPF_STMT(BPF_MISC | BPF_TAX, 0);
+
+    /* Classic BPF has no loops, so the IE walk is unrolled. A load past the
+     * end of the frame rejects it */
+    for (int hop = 0; hop < FILTER_IE_HOPS; hop++) {
+        prog[pc++] = (struct sock_filter) BPF_STMT(BPF_LD | BPF_B | BPF_IND, 0);
+        prog[pc++] = (struct sock_filter) BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0xDD, 0, 2);
+        prog[pc++] = (struct sock_filter) BPF_STMT(BPF_LD | BPF_W | BPF_IND, 2);
+        prog[pc] = (struct sock_filter) BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0xFA0BBC0D,
+                                                 JUMP_TO(FILTER_ACCEPT, pc), 0);
+        pc++;
+        prog[pc++] = (struct sock_filter) BPF_STMT(BPF_LD | BPF_B | BPF_IND, 1);
+        prog[pc++] = (struct sock_filter) BPF_STMT(BPF_ALU | BPF_ADD | BPF_X, 0);
+        prog[pc++] = (struct sock_filter) BPF_STMT(BPF_ALU | BPF_ADD | BPF_K, 2);
+        prog[pc++] = (struct sock_filter) BPF_STMT(BPF_MISC | BPF_TAX, 0);
+    }
+
+    prog[pc++] = (struct sock_filter) BPF_STMT(BPF_RET | BPF_K, 0);
+    prog[pc++] = (struct sock_filter) BPF_STMT(BPF_RET | BPF_K, 0x40000);
+
+    return pc;
+}
+
+static void deliver_radiotap(uint8_t *buf, size_t len, uint64_t timestamp_ns,
+                             rx_frame_cb cb, void *ctx, struct capture_stats *stats)
+{
+    struct radiotap_info rt;
+    struct rx_frame_info info;
+
+    stats->packets++;
+    if (radiotap_parse(buf, len, &rt) < 0) {
+        stats->invalid++;
+        return;
+    }
+    len -= rt.header_len;
+    if (rt.has_fcs) {
+        if (len < 4) {
+            stats->invalid++;
+            return;
+        }
+        len -= 4;
+    }
+
+    info.timestamp_ns = timestamp_ns;
+    info.has_rssi = rt.has_rssi;
+    info.rssi = rt.rssi;
+    info.freq = rt.freq;
+    cb(ctx, buf + rt.header_len, len, &info);
+}
+
+int capture_ring_open(struct capture_ring *ring, const char *iface)
+{
+    struct sock_filter filter[FILTER_LEN];
+    struct sock_fprog fprog;
+    struct tpacket_req3 req;
+    struct sockaddr_ll ll;
+    struct ifreq ifr;
+    int version = TPACKET_V3;
+    int ret;
+
+    memset(ring, 0, sizeof(*ring));
+
+    ring->fd = socket(AF_PACKET, SOCK_RAW, 0);
+    if (ring->fd < 0)
+        return -errno;
+
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, iface, sizeof(ifr.ifr_name) - 1);
+    if (ioctl(ring->fd, SIOCGIFHWADDR, &ifr) < 0)
+        goto err;
+    if (ifr.ifr_hwaddr.sa_family != ARPHRD_IEEE80211_RADIOTAP) {
+        fprintf(stderr, "%s is not in monitor mode\n", iface);
+        errno = EINVAL;
+        goto err;
+    }
+
+    fprog.len = (unsigned short) build_filter(filter);
+    fprog.filter = filter;
+    if (setsockopt(ring->fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) < 0)
+        goto err;
+
+    if (setsockopt(ring->fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0)
+        goto err;
+
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = RING_BLOCK_SIZE;
+    req.tp_block_nr = RING_BLOCK_NR;
+    req.tp_frame_size = RING_FRAME_SIZE;
+    req.tp_frame_nr = (RING_BLOCK_SIZE / RING_FRAME_SIZE) * RING_BLOCK_NR;
+    req.tp_retire_blk_tov = RING_BLOCK_TIMEOUT_MS;
+    if (setsockopt(ring->fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0)
+        goto err;
+
+    ring->map_size = (size_t) req.tp_block_size * req.tp_block_nr;
+    ring->map = mmap(NULL, ring->map_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED, ring->fd, 0);
+    if (ring->map == MAP_FAILED) {
+        ring->map = NULL;
+        goto err;
+    }
+
+    ring->block_nr = req.tp_block_nr;
+    ring->blocks = calloc(ring->block_nr, sizeof(*ring->blocks));
+    if (!ring->blocks)
+        goto err;
+    for (unsigned int i = 0; i < ring->block_nr; i++) {
+        ring->blocks[i].iov_base = ring->map + (size_t) i * req.tp_block_size;
+        ring->blocks[i].iov_len = req.tp_block_size;
+    }
+
+    /* bind last, so that no unfiltered frames end up in the ring */
+    memset(&ll, 0, sizeof(ll));
+    ll.sll_family = AF_PACKET;
+    ll.sll_protocol = htons(ETH_P_ALL);
+    ll.sll_ifindex = (int) if_nametoindex(iface);
+    if (ll.sll_ifindex == 0 || bind(ring->fd, (struct sockaddr *) &ll, sizeof(ll)) < 0)
+        goto err;
+
+    return 0;
+
+err:
+    ret = -errno;
+    capture_ring_close(ring);
+    return ret;
+}
+
+int capture_ring_run(struct capture_ring *ring, rx_frame_cb cb, void *ctx,
+                     volatile sig_atomic_t *stop)
+{
+    struct pollfd pfd = { .fd = ring->fd, .events = POLLIN | POLLERR };
+
+    while (!*stop) {
+        struct tpacket_block_desc *block = ring->blocks[ring->block].iov_base;
+
+        if (!(__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER)) {
+            if (poll(&pfd, 1, POLL_TIMEOUT_MS) < 0 && errno != EINTR)
+                return -errno;
+            continue;
+        }
+
+        struct tpacket3_hdr *hdr = (struct tpacket3_hdr *)
+            ((uint8_t *) block + block->hdr.bh1.offset_to_first_pkt);
+        for (uint32_t i = 0; i < block->hdr.bh1.num_pkts; i++) {
+            deliver_radiotap((uint8_t *) hdr + hdr->tp_mac, hdr->tp_snaplen,
+                             (uint64_t) hdr->tp_sec * 1000000000ULL + hdr->tp_nsec,
+                             cb, ctx, &ring->stats);
+            hdr = (struct tpacket3_hdr *) ((uint8_t *) hdr + hdr->tp_next_offset);
+        }
+
+        /* hand the block back to the kernel */
+        __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        ring->block = (ring->block + 1) % ring->block_nr;
+    }
+
+    return 0;
+}
+
+void capture_ring_update_stats(struct capture_ring *ring)
+{
+    struct tpacket_stats_v3 kstats;
+    socklen_t len = sizeof(kstats);
+
+    /* the kernel resets its counters on every read */
+    if (getsockopt(ring->fd, SOL_PACKET, PACKET_STATISTICS, &kstats, &len) == 0) {
+        ring->stats.kernel_packets += kstats.tp_packets;
+        ring->stats.kernel_drops += kstats.tp_drops;
+    }
+}
+
+void capture_ring_close(struct capture_ring *ring)
+{
+    free(ring->blocks);
+    ring->blocks = NULL;
+    if (ring->map)
+        munmap(ring->map, ring->map_size);
+    ring->map = NULL;
+    if (ring->fd >= 0)
+        close(ring->fd);
+    ring->fd = -1;
+}
+
+int capture_replay_pcap(const char *path, rx_frame_cb cb, void *ctx,
+                        struct capture_stats *stats)
+{
+    struct pcap_file_hdr fhdr;
+    struct pcap_record_hdr rhdr;
+    struct stat st;
+    uint8_t *map;
+    size_t offset;
+    int swapped, nsec;
+    uint32_t linktype;
+    int fd, ret = 0;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -errno;
+    if (fstat(fd, &st) < 0) {
+        ret = -errno;
+        close(fd);
+        return ret;
+    }
+    if ((size_t) st.st_size < sizeof(fhdr)) {
+        close(fd);
+        return -EINVAL;
+    }
+
+    /* a private writable mapping: frames are handed out without copying */
+    map = mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -errno;
+
+    memcpy(&fhdr, map, sizeof(fhdr));
+    swapped = fhdr.magic == bswap_32(PCAP_MAGIC) || fhdr.magic == bswap_32(PCAP_MAGIC_NSEC);
+    if (swapped)
+        fhdr.magic = bswap_32(fhdr.magic);
+    if (fhdr.magic != PCAP_MAGIC && fhdr.magic != PCAP_MAGIC_NSEC) {
+        ret = -EINVAL;
+        goto out;
+    }
+    nsec = fhdr.magic == PCAP_MAGIC_NSEC;
+    linktype = swapped ? bswap_32(fhdr.linktype) : fhdr.linktype;
+    if (linktype != LINKTYPE_RADIOTAP && linktype != LINKTYPE_IEEE802_11) {
+        fprintf(stderr, "%s: unsupported link type %u\n", path, linktype);
+        ret = -EINVAL;
+        goto out;
+    }
+
+    offset = sizeof(fhdr);
+    while (offset + sizeof(rhdr) <= (size_t) st.st_size) {
+        memcpy(&rhdr, map + offset, sizeof(rhdr));
+        if (swapped) {
+            rhdr.ts_sec = bswap_32(rhdr.ts_sec);
+            rhdr.ts_frac = bswap_32(rhdr.ts_frac);
+            rhdr.incl_len = bswap_32(rhdr.incl_len);
+        }
+        offset += sizeof(rhdr);
+        if (rhdr.incl_len > (size_t) st.st_size - offset) {
+            ret = -EINVAL;
+            break;
+        }
+
+        uint8_t *pkt = map + offset;
+        uint64_t ts = (uint64_t) rhdr.ts_sec * 1000000000ULL +
+                      (uint64_t) rhdr.ts_frac * (nsec ? 1 : 1000);
+        if (linktype == LINKTYPE_RADIOTAP) {
+            deliver_radiotap(pkt, rhdr.incl_len, ts, cb, ctx, stats);
+        } else {
+            struct rx_frame_info info = { .timestamp_ns = ts };
+            stats->packets++;
+            cb(ctx, pkt, rhdr.incl_len, &info);
+        }
+        offset += rhdr.incl_len;
+    }
+
+out:
+    munmap(map, (size_t) st.st_size);
+    return ret;
+}
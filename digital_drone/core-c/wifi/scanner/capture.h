@@ -0,0 +1,80 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID WiFi scanner
+*/
+
+#ifndef _CAPTURE_H_
+#define _CAPTURE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <signal.h>
+#include <sys/uio.h>
+
+struct rx_frame_info {
+    uint64_t timestamp_ns;  /* capture time, from the kernel or the pcap file */
+    int has_rssi;
+    int8_t rssi;            /* dBm */
+    uint16_t freq;          /* MHz, 0 if unknown */
+};
+
+/* Called for each received IEEE 802.11 frame. @frame points directly into the
+ * capture ring or the mapped pcap file, without radiotap header and FCS, and
+ * is only valid until the callback returns */
+typedef void (*rx_frame_cb)(void *ctx, uint8_t *frame, size_t len,
+                            const struct rx_frame_info *info);
+
+struct capture_stats {
+    uint64_t packets;       /* packets passed by the filter */
+    uint64_t invalid;       /* packets with a malformed radiotap header */
+    uint64_t kernel_packets;
+    uint64_t kernel_drops;  /* packets dropped because the ring was full */
+};
+
+struct capture_ring {
+    int fd;
+    uint8_t *map;
+    size_t map_size;
+    struct iovec *blocks;
+    unsigned int block_nr;
+    unsigned int block;     /* next block to read */
+    struct capture_stats stats;
+};
+
+/* capture_ring_open - opens a TPACKET_V3 PACKET_RX_RING on a monitor interface
+ * and attaches a classic BPF filter that only passes beacon frames and NAN
+ * action frames carrying ODID data
+ * @ring: ring state, filled on success
+ * @iface: name of the monitor mode interface
+ *
+ * Returns 0 on success, < 0 on error
+ */
+int capture_ring_open(struct capture_ring *ring, const char *iface);
+
+/* capture_ring_run - hands all received frames to @cb until @stop is set
+ *
+ * Returns 0 when stopped, < 0 on error
+ */
+int capture_ring_run(struct capture_ring *ring, rx_frame_cb cb, void *ctx,
+                     volatile sig_atomic_t *stop);
+
+/* capture_ring_update_stats - adds the kernel packet and drop counters
+ * since the previous call to @ring->stats
+ */
+void capture_ring_update_stats(struct capture_ring *ring);
+
+void capture_ring_close(struct capture_ring *ring);
+
+/* capture_replay_pcap - hands all frames of a pcap file with radiotap
+ * (LINKTYPE_IEEE802_11_RADIOTAP) or plain 802.11 (LINKTYPE_IEEE802_11)
+ * link type to @cb, the same way as capture_ring_run does for live frames
+ * @stats: packet counters, updated while replaying
+ *
+ * Returns 0 on success, < 0 on error
+ */
+int capture_replay_pcap(const char *path, rx_frame_cb cb, void *ctx,
+                        struct capture_stats *stats);
+
+#endif // _CAPTURE_H_
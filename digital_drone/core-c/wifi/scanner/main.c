@@ -0,0 +1,308 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID WiFi scanner
+
+Receives ODID Wi-Fi Beacon and NAN frames on a monitor mode interface,
+or replays them from a pcap file, and prints the decoded drone data.
+By default the frames are decoded on worker threads, see pipeline.h.
+With -b the detections are written as binary records, see odid_detection.h,
+which tools/det2json converts back to JSON.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <errno.h>
+
+#include <opendroneid.h>
+#include <odid_track.h>
+#include <odid_detection.h>
+
+#include "capture.h"
+#include "pipeline.h"
+
+#define DEFAULT_WORKERS         2
+#define WORKER_QUEUE_SIZE       1024
+#define TRACKER_QUEUE_SIZE      4096
+#define MAX_DRONES              4096
+#define DRONE_TIMEOUT_MS        300000
+
+struct global {
+    char wlan_iface[16];
+    const char *pcap_file;
+    int quiet;
+    int binary;
+    int workers;
+    int stats_interval;
+    uint64_t decoded;
+    uint64_t drones;            // tracks created
+    ODID_TrackTable track_table;
+    ODID_Track tracks[MAX_DRONES];
+    uint16_t track_index[4 * MAX_DRONES];
+};
+
+static volatile sig_atomic_t stop;
+
+void usage(char *name)
+{
+    fprintf(stderr,"%s\n", name);
+    fprintf(stderr,"\t-w\tmonitor mode wlan interface (default: mon0)\n");
+    fprintf(stderr,"\t-r\treplay a pcap file instead of capturing\n");
+    fprintf(stderr,"\t-q\tonly print statistics\n");
+    fprintf(stderr,"\t-b\twrite binary detection records to stdout instead of text\n");
+    fprintf(stderr,"\t-j\tnumber of decode worker threads, 0 decodes on the capture thread (default: %d)\n",
+            DEFAULT_WORKERS);
+    fprintf(stderr,"\t-s\tprint pipeline statistics every N seconds\n");
+}
+
+int read_arguments(int argc, char *argv[], struct global *global)
+{
+    int opt;
+
+    strncpy(global->wlan_iface, "mon0", sizeof(global->wlan_iface) - 1);
+    global->workers = DEFAULT_WORKERS;
+
+    while((opt = getopt(argc, argv, "hw:r:qbj:s:")) != -1) {
+        switch (opt) {
+            case 'h':
+                usage(argv[0]);
+                exit(0);
+            case 'w':
+                strncpy(global->wlan_iface, optarg, sizeof(global->wlan_iface) - 1);
+                break;
+            case 'r':
+                global->pcap_file = optarg;
+                break;
+            case 'q':
+                global->quiet = 1;
+                break;
+            case 'b':
+                global->binary = 1;
+                break;
+            case 'j':
+                global->workers = atoi(optarg);
+                if (global->workers < 0)
+                    return -1;
+                break;
+            case 's':
+                global->stats_interval = atoi(optarg);
+                break;
+            default:
+                return -1;
+        }
+    }
+    return 0;
+}
+
+static void sig_handler(int signo)
+{
+    (void) signo;
+    stop = 1;
+}
+
+static uint8_t freq_to_channel(uint16_t freq)
+{
+    if (freq == 2484)
+        return 14;
+    if (freq >= 2412 && freq < 2484)
+        return (uint8_t) ((freq - 2407) / 5);
+    if (freq >= 5000 && freq < 5900)
+        return (uint8_t) ((freq - 5000) / 5);
+    return 0;
+}
+
+/**
+ * write_record - write a detection as binary record to stdout
+ */
+static void write_record(const struct detection *det)
+{
+    ODID_Detection rec;
+    uint8_t buf[ODID_DETECTION_SIZE];
+
+    memset(&rec, 0, sizeof(rec));
+    rec.Timestamp = (uint32_t) (det->timestamp_ns / 1000000ULL);
+    memcpy(rec.MAC, det->mac, sizeof(rec.MAC));
+    rec.AltitudeGeo = rec.Height = INV_ALT;
+    if (det->has_rssi) {
+        rec.RSSI = det->rssi;
+        rec.Valid |= ODID_DETECTION_VALID_RSSI;
+    }
+    rec.Channel = freq_to_channel(det->freq);
+    if (rec.Channel)
+        rec.Valid |= ODID_DETECTION_VALID_CHANNEL;
+    if (det->valid & DETECTION_BASIC_ID) {
+        memcpy(rec.UASID, det->uas_id, sizeof(rec.UASID));
+        rec.Valid |= ODID_DETECTION_VALID_ID;
+    }
+    if (det->valid & DETECTION_LOCATION) {
+        if (det->latitude != 0 || det->longitude != 0) {
+            rec.Latitude = det->latitude;
+            rec.Longitude = det->longitude;
+            rec.Valid |= ODID_DETECTION_VALID_POSITION;
+        }
+        if (det->altitude_geo > INV_ALT) {
+            rec.AltitudeGeo = det->altitude_geo;
+            rec.Valid |= ODID_DETECTION_VALID_ALTITUDE;
+        }
+        if (det->speed_horizontal < INV_SPEED_H) {
+            rec.SpeedHorizontal = det->speed_horizontal;
+            rec.Valid |= ODID_DETECTION_VALID_SPEED;
+        }
+        if (det->direction < INV_DIR) {
+            rec.Direction = det->direction;
+            rec.Valid |= ODID_DETECTION_VALID_DIRECTION;
+        }
+    }
+
+    if (encodeDetectionRecord(buf, &rec) == ODID_SUCCESS)
+        fwrite(buf, sizeof(buf), 1, stdout);
+}
+
+/**
+ * print_detection - print the drone data of a decoded frame
+ * @ctx: struct global
+ * @det: decoded frame
+ */
+static void print_detection(void *ctx, const struct detection *det)
+{
+    struct global *global = ctx;
+    uint32_t now = (uint32_t) (det->timestamp_ns / 1000000ULL);
+    int track;
+
+    global->decoded++;
+    // The decode workers hand over detections out of timestamp order. The time
+    // of the track table does not go back, so an earlier frame that arrives late
+    // can't make a drone expire early and then be counted again
+    odid_trackExpire(&global->track_table, now);
+    if (odid_trackFind(&global->track_table, det->mac) < 0)
+        global->drones++;
+    track = odid_trackUpdate(&global->track_table, det->mac, now);
+    if (det->valid & DETECTION_BASIC_ID)
+        odid_trackSetID(&global->track_table, track, det->uas_id);
+    if (global->quiet)
+        return;
+    if (global->binary) {
+        write_record(det);
+        return;
+    }
+
+    printf("%llu.%06llu %02x:%02x:%02x:%02x:%02x:%02x",
+           (unsigned long long) (det->timestamp_ns / 1000000000ULL),
+           (unsigned long long) (det->timestamp_ns % 1000000000ULL / 1000),
+           det->mac[0], det->mac[1], det->mac[2], det->mac[3], det->mac[4], det->mac[5]);
+    if (det->has_rssi)
+        printf(" rssi %d", det->rssi);
+    if (det->valid & DETECTION_BASIC_ID)
+        printf(" id %s", det->uas_id);
+    if (det->valid & DETECTION_LOCATION)
+        printf(" lat %.7f lon %.7f alt %.1f", det->latitude,
+               det->longitude, (double) det->altitude_geo);
+    if (det->valid & DETECTION_OPERATOR_ID)
+        printf(" operator %s", det->operator_id);
+    printf("\n");
+}
+
+/**
+ * scanner_handle_frame - decode a received frame on the capture thread
+ * @ctx: struct global
+ * @frame: IEEE 802.11 frame, in the capture ring or the mapped pcap file
+ * @len: length of @frame
+ * @info: capture time and radio information
+ */
+static void scanner_handle_frame(void *ctx, uint8_t *frame, size_t len,
+                                 const struct rx_frame_info *info)
+{
+    struct detection det;
+
+    if (detection_from_frame(&det, frame, len, info) == 0)
+        print_detection(ctx, &det);
+}
+
+static void print_stats(struct global *global, struct capture_stats *stats)
+{
+    fprintf(stderr, "packets %llu, invalid %llu, decoded %llu, drones %llu (%u active)",
+            (unsigned long long) stats->packets, (unsigned long long) stats->invalid,
+            (unsigned long long) global->decoded, (unsigned long long) global->drones,
+            global->track_table.Count);
+    if (!global->pcap_file)
+        fprintf(stderr, ", kernel packets %llu, kernel drops %llu",
+                (unsigned long long) stats->kernel_packets,
+                (unsigned long long) stats->kernel_drops);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char *argv[])
+{
+    static struct global global;
+    struct capture_ring ring;
+    struct capture_stats stats;
+    struct pipeline_config config;
+    struct pipeline *pipeline = NULL;
+    rx_frame_cb cb = scanner_handle_frame;
+    void *cb_ctx = &global;
+    int ret;
+
+    memset(&global, 0, sizeof(global));
+    memset(&stats, 0, sizeof(stats));
+
+    if (read_arguments(argc, argv, &global) < 0) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    odid_initTrackTable(&global.track_table, global.tracks, MAX_DRONES, global.track_index,
+                        2 * MAX_DRONES, DRONE_TIMEOUT_MS, NULL, NULL);
+
+    signal(SIGINT, sig_handler);
+    signal(SIGTERM, sig_handler);
+
+    if (global.workers > 0) {
+        memset(&config, 0, sizeof(config));
+        config.workers = global.workers;
+        config.worker_queue = WORKER_QUEUE_SIZE;
+        config.tracker_queue = TRACKER_QUEUE_SIZE;
+        /* a file can be read as fast as it is decoded, nothing to drop */
+        config.block_when_full = global.pcap_file != NULL;
+        config.stats_interval = global.stats_interval;
+        pipeline = pipeline_start(&config, print_detection, &global);
+        if (!pipeline) {
+            fprintf(stderr, "%s: Couldn't start the receive pipeline\n", argv[0]);
+            return -1;
+        }
+        cb = pipeline_frame_cb;
+        cb_ctx = pipeline;
+    }
+
+    if (global.pcap_file) {
+        ret = capture_replay_pcap(global.pcap_file, cb, cb_ctx, &stats);
+        if (ret < 0)
+            fprintf(stderr, "%s: Couldn't replay %s: %s\n", argv[0],
+                    global.pcap_file, strerror(-ret));
+    } else {
+        ret = capture_ring_open(&ring, global.wlan_iface);
+        if (ret < 0) {
+            fprintf(stderr, "%s: Couldn't open capture ring on %s: %s\n", argv[0],
+                    global.wlan_iface, strerror(-ret));
+            if (pipeline)
+                pipeline_stop(pipeline);
+            return -1;
+        }
+
+        ret = capture_ring_run(&ring, cb, cb_ctx, &stop);
+        if (ret < 0)
+            fprintf(stderr, "%s: Capture failed: %s\n", argv[0], strerror(-ret));
+        capture_ring_update_stats(&ring);
+        stats = ring.stats;
+        capture_ring_close(&ring);
+    }
+
+    if (pipeline)
+        pipeline_stop(pipeline);
+    print_stats(&global, &stats);
+
+    return ret < 0 ? -1 : 0;
+}
@@ -0,0 +1,328 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID WiFi scanner
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "pipeline.h"
+#include "ring.h"
+
+/* Frames are copied out of the capture ring into fixed size queue slots.
+ * ODID beacon and NAN frames are a few hundred bytes */
+#define PIPELINE_FRAME_MAX      2000
+
+/* Source address in the IEEE 802.11 management header */
+#define IEEE80211_SA_OFFSET     10
+#define IEEE80211_HDR_LEN       24
+
+#define IDLE_SPINS              64
+#define IDLE_SLEEP_US           100
+
+struct pipeline_frame {
+    struct rx_frame_info info;
+    uint16_t len;
+    uint8_t data[PIPELINE_FRAME_MAX];
+};
+
+struct worker {
+    struct spsc_ring queue;
+    struct pipeline *pipeline;
+    pthread_t thread;
+    int index;
+    uint64_t frames;
+    uint64_t decoded;
+} __attribute__((aligned(RING_CACHE_LINE)));
+
+struct pipeline {
+    struct pipeline_config config;
+    detection_cb cb;
+    void *ctx;
+    struct worker *workers;
+    struct mpsc_ring tracker_queue;
+    pthread_t tracker;
+    int threads_started;
+    int capture_done;
+    int workers_done;
+    uint64_t captured;
+    uint64_t invalid;
+    uint64_t detections;
+};
+
+static void idle(unsigned int *spins)
+{
+    if (*spins < IDLE_SPINS) {
+        (*spins)++;
+        sched_yield();
+    } else {
+        usleep(IDLE_SLEEP_US);
+    }
+}
+
+/* counters have a single writer and are only read for statistics */
+static void counter_inc(uint64_t *counter)
+{
+    __atomic_store_n(counter, *counter + 1, __ATOMIC_RELAXED);
+}
+
+static uint64_t counter_get(uint64_t *counter)
+{
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+int detection_from_frame(struct detection *det, uint8_t *frame, size_t len,
+                         const struct rx_frame_info *info)
+{
+    ODID_UAS_Data uas;
+
+    if (odid_wifi_receive_frame(&uas, (char *) det->mac, frame, len) < 0)
+        return -EINVAL;
+
+    det->timestamp_ns = info->timestamp_ns;
+    det->valid = 0;
+    det->rssi = info->rssi;
+    det->has_rssi = (uint8_t) info->has_rssi;
+    det->freq = info->freq;
+    if (uas.BasicIDValid[0]) {
+        det->valid |= DETECTION_BASIC_ID;
+        memcpy(det->uas_id, uas.BasicID[0].UASID, sizeof(det->uas_id));
+    }
+    if (uas.LocationValid) {
+        det->valid |= DETECTION_LOCATION;
+        det->latitude = uas.Location.Latitude;
+        det->longitude = uas.Location.Longitude;
+        det->altitude_geo = uas.Location.AltitudeGeo;
+        det->speed_horizontal = uas.Location.SpeedHorizontal;
+        det->direction = uas.Location.Direction;
+    }
+    if (uas.OperatorIDValid) {
+        det->valid |= DETECTION_OPERATOR_ID;
+        memcpy(det->operator_id, uas.OperatorID.OperatorId, sizeof(det->operator_id));
+    }
+    return 0;
+}
+
+static void worker_push(struct worker *worker, const struct detection *det)
+{
+    struct pipeline *pipeline = worker->pipeline;
+    struct mpsc_ring *queue = &pipeline->tracker_queue;
+    struct mpsc_slot *slot;
+    unsigned int spins = 0;
+
+    while (!(slot = mpsc_ring_reserve(queue)) && pipeline->config.block_when_full)
+        idle(&spins);
+    if (!slot) {
+        __atomic_fetch_add(&queue->drops, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    memcpy(slot->data, det, sizeof(*det));
+    mpsc_ring_commit(queue, slot);
+}
+
+static void *worker_loop(void *arg)
+{
+    struct worker *worker = arg;
+    struct pipeline *pipeline = worker->pipeline;
+    struct detection det;
+    unsigned int spins = 0;
+
+    for (;;) {
+        struct pipeline_frame *frame = spsc_ring_peek(&worker->queue);
+
+        if (!frame) {
+            if (__atomic_load_n(&pipeline->capture_done, __ATOMIC_ACQUIRE) &&
+                !spsc_ring_peek(&worker->queue))
+                break;
+            idle(&spins);
+            continue;
+        }
+        spins = 0;
+
+        counter_inc(&worker->frames);
+        if (detection_from_frame(&det, frame->data, frame->len, &frame->info) == 0) {
+            counter_inc(&worker->decoded);
+            worker_push(worker, &det);
+        }
+        spsc_ring_release(&worker->queue);
+    }
+
+    __atomic_fetch_add(&pipeline->workers_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static uint64_t monotonic_seconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec;
+}
+
+static void *tracker_loop(void *arg)
+{
+    struct pipeline *pipeline = arg;
+    struct mpsc_ring *queue = &pipeline->tracker_queue;
+    uint64_t next_stats = monotonic_seconds() + (uint64_t) pipeline->config.stats_interval;
+    unsigned int spins = 0;
+
+    for (;;) {
+        struct mpsc_slot *slot = mpsc_ring_peek(queue);
+
+        if (pipeline->config.stats_interval && monotonic_seconds() >= next_stats) {
+            pipeline_print_stats(pipeline, stderr);
+            next_stats += (uint64_t) pipeline->config.stats_interval;
+        }
+
+        if (!slot) {
+            if (__atomic_load_n(&pipeline->workers_done, __ATOMIC_ACQUIRE) == pipeline->config.workers &&
+                !mpsc_ring_peek(queue))
+                break;
+            idle(&spins);
+            continue;
+        }
+        spins = 0;
+
+        pipeline->cb(pipeline->ctx, (const struct detection *) slot->data);
+        counter_inc(&pipeline->detections);
+        mpsc_ring_release(queue, slot);
+    }
+
+    if (pipeline->config.stats_interval)
+        pipeline_print_stats(pipeline, stderr);
+    return NULL;
+}
+
+static void pipeline_free(struct pipeline *pipeline)
+{
+    if (pipeline->workers) {
+        for (int i = 0; i < pipeline->config.workers; i++)
+            spsc_ring_free(&pipeline->workers[i].queue);
+        free(pipeline->workers);
+    }
+    mpsc_ring_free(&pipeline->tracker_queue);
+    free(pipeline);
+}
+
+struct pipeline *pipeline_start(const struct pipeline_config *config,
+                                detection_cb cb, void *ctx)
+{
+    struct pipeline *pipeline;
+
+    if (config->workers < 1)
+        return NULL;
+
+    pipeline = calloc(1, sizeof(*pipeline));
+    if (!pipeline)
+        return NULL;
+    pipeline->config = *config;
+    pipeline->cb = cb;
+    pipeline->ctx = ctx;
+
+    if (posix_memalign((void **) &pipeline->workers, RING_CACHE_LINE,
+                       sizeof(struct worker) * (size_t) config->workers) != 0) {
+        pipeline->workers = NULL;
+        goto err;
+    }
+    memset(pipeline->workers, 0, sizeof(struct worker) * (size_t) config->workers);
+    for (int i = 0; i < config->workers; i++) {
+        pipeline->workers[i].pipeline = pipeline;
+        pipeline->workers[i].index = i;
+        if (spsc_ring_init(&pipeline->workers[i].queue, config->worker_queue,
+                           sizeof(struct pipeline_frame)) < 0)
+            goto err;
+    }
+    if (mpsc_ring_init(&pipeline->tracker_queue, config->tracker_queue,
+                       sizeof(struct detection)) < 0)
+        goto err;
+
+    for (; pipeline->threads_started < config->workers; pipeline->threads_started++) {
+        struct worker *worker = &pipeline->workers[pipeline->threads_started];
+        if (pthread_create(&worker->thread, NULL, worker_loop, worker) != 0)
+            goto err_threads;
+    }
+    if (pthread_create(&pipeline->tracker, NULL, tracker_loop, pipeline) != 0)
+        goto err_threads;
+
+    return pipeline;
+
+err_threads:
+    /* the queues are still empty, the started workers exit right away */
+    __atomic_store_n(&pipeline->capture_done, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < pipeline->threads_started; i++)
+        pthread_join(pipeline->workers[i].thread, NULL);
+err:
+    pipeline_free(pipeline);
+    return NULL;
+}
+
+void pipeline_frame_cb(void *ctx, uint8_t *frame, size_t len,
+                       const struct rx_frame_info *info)
+{
+    struct pipeline *pipeline = ctx;
+    struct pipeline_frame *slot;
+    struct worker *worker;
+    uint32_t hash = 2166136261u;
+    unsigned int spins = 0;
+
+    counter_inc(&pipeline->captured);
+    if (len < IEEE80211_HDR_LEN || len > PIPELINE_FRAME_MAX) {
+        counter_inc(&pipeline->invalid);
+        return;
+    }
+
+    /* shard by source address, so that the frames of a drone stay in order */
+    for (int i = 0; i < 6; i++)
+        hash = (hash ^ frame[IEEE80211_SA_OFFSET + i]) * 16777619u;
+    worker = &pipeline->workers[hash % (uint32_t) pipeline->config.workers];
+
+    while (!(slot = spsc_ring_reserve(&worker->queue)) && pipeline->config.block_when_full)
+        idle(&spins);
+    if (!slot) {
+        counter_inc(&worker->queue.drops);
+        return;
+    }
+    slot->info = *info;
+    slot->len = (uint16_t) len;
+    memcpy(slot->data, frame, len);
+    spsc_ring_commit(&worker->queue);
+}
+
+void pipeline_stop(struct pipeline *pipeline)
+{
+    __atomic_store_n(&pipeline->capture_done, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < pipeline->config.workers; i++)
+        pthread_join(pipeline->workers[i].thread, NULL);
+    pthread_join(pipeline->tracker, NULL);
+    pipeline_free(pipeline);
+}
+
+void pipeline_print_stats(struct pipeline *pipeline, FILE *fp)
+{
+    struct mpsc_ring *queue = &pipeline->tracker_queue;
+
+    fprintf(fp, "capture: frames %llu, invalid %llu\n",
+            (unsigned long long) counter_get(&pipeline->captured),
+            (unsigned long long) counter_get(&pipeline->invalid));
+    for (int i = 0; i < pipeline->config.workers; i++) {
+        struct worker *worker = &pipeline->workers[i];
+        fprintf(fp, "worker %d: queue %zu (max %zu), drops %llu, frames %llu, decoded %llu\n",
+                i, spsc_ring_depth(&worker->queue),
+                __atomic_load_n(&worker->queue.high_water, __ATOMIC_RELAXED),
+                (unsigned long long) counter_get(&worker->queue.drops),
+                (unsigned long long) counter_get(&worker->frames),
+                (unsigned long long) counter_get(&worker->decoded));
+    }
+    fprintf(fp, "tracker: queue %zu (max %zu), drops %llu, detections %llu\n",
+            mpsc_ring_depth(queue),
+            __atomic_load_n(&queue->high_water, __ATOMIC_RELAXED),
+            (unsigned long long) __atomic_load_n(&queue->drops, __ATOMIC_RELAXED),
+            (unsigned long long) counter_get(&pipeline->detections));
+}
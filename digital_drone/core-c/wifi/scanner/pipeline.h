@@ -0,0 +1,83 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID WiFi scanner
+
+Receive pipeline: the capture thread shards frames by source MAC address
+over N decode workers through SPSC rings. The workers hand the decoded
+detections to a single tracker thread through an MPSC ring. Sharding by
+MAC address keeps the frames of one drone in order.
+*/
+
+#ifndef _PIPELINE_H_
+#define _PIPELINE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <opendroneid.h>
+
+#include "capture.h"
+
+#define DETECTION_BASIC_ID      0x01
+#define DETECTION_LOCATION      0x02
+#define DETECTION_OPERATOR_ID   0x04
+
+/* The data of one decoded frame that is passed on to the tracker */
+struct detection {
+    uint64_t timestamp_ns;
+    uint8_t mac[6];
+    uint8_t valid;          /* DETECTION_* flags */
+    int8_t rssi;
+    uint8_t has_rssi;
+    uint16_t freq;
+    char uas_id[ODID_ID_SIZE + 1];
+    char operator_id[ODID_ID_SIZE + 1];
+    double latitude;
+    double longitude;
+    float altitude_geo;
+    float speed_horizontal;
+    float direction;
+};
+
+/* Called from the tracker thread for every detection, in order per drone */
+typedef void (*detection_cb)(void *ctx, const struct detection *det);
+
+struct pipeline_config {
+    int workers;
+    size_t worker_queue;    /* frames per worker queue, power of two */
+    size_t tracker_queue;   /* detections in the tracker queue, power of two */
+    int block_when_full;    /* wait instead of dropping, e.g. for pcap replay */
+    int stats_interval;     /* seconds between statistics reports to stderr, 0 for none.
+                             * A last report is printed when the pipeline stops */
+};
+
+struct pipeline;
+
+/* detection_from_frame - decodes an ODID frame into a detection
+ *
+ * Returns 0 on success, < 0 if the frame does not contain ODID data
+ */
+int detection_from_frame(struct detection *det, uint8_t *frame, size_t len,
+                         const struct rx_frame_info *info);
+
+/* pipeline_start - allocates the queues and starts the worker and tracker threads
+ *
+ * Returns NULL on error
+ */
+struct pipeline *pipeline_start(const struct pipeline_config *config,
+                                detection_cb cb, void *ctx);
+
+/* pipeline_frame_cb - rx_frame_cb that passes a frame to the pipeline.
+ * Must always be called from the same (capture) thread */
+void pipeline_frame_cb(void *ctx, uint8_t *frame, size_t len,
+                       const struct rx_frame_info *info);
+
+/* pipeline_stop - processes all queued frames, then stops and frees the pipeline */
+void pipeline_stop(struct pipeline *pipeline);
+
+/* pipeline_print_stats - prints the per stage counters, queue depths and drops */
+void pipeline_print_stats(struct pipeline *pipeline, FILE *fp);
+
+#endif // _PIPELINE_H_
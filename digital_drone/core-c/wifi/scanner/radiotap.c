@@ -0,0 +1,98 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID WiFi scanner
+*/
+
+#include <errno.h>
+#include <string.h>
+
+#include "radiotap.h"
+
+/* Radiotap fields, see https://www.radiotap.org/fields/defined */
+#define RADIOTAP_TSFT               0
+#define RADIOTAP_FLAGS              1
+#define RADIOTAP_RATE               2
+#define RADIOTAP_CHANNEL            3
+#define RADIOTAP_FHSS               4
+#define RADIOTAP_DBM_ANTSIGNAL      5
+#define RADIOTAP_EXT                31
+
+#define RADIOTAP_F_FCS              0x10
+
+/* alignment and size of the fields up to and including RADIOTAP_DBM_ANTSIGNAL */
+static const struct {
+    uint8_t align;
+    uint8_t size;
+} radiotap_fields[] = {
+    [RADIOTAP_TSFT]             = { 8, 8 },
+    [RADIOTAP_FLAGS]            = { 1, 1 },
+    [RADIOTAP_RATE]             = { 1, 1 },
+    [RADIOTAP_CHANNEL]          = { 2, 4 },
+    [RADIOTAP_FHSS]             = { 1, 2 },
+    [RADIOTAP_DBM_ANTSIGNAL]    = { 1, 1 },
+};
+
+static uint16_t get_le16(const uint8_t *p)
+{
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) |
+           ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+int radiotap_parse(const uint8_t *buf, size_t len, struct radiotap_info *info)
+{
+    uint32_t present;
+    size_t offset;
+
+    memset(info, 0, sizeof(*info));
+
+    /* it_version, it_pad, it_len, it_present */
+    if (len < 8 || buf[0] != 0)
+        return -EINVAL;
+    info->header_len = get_le16(buf + 2);
+    if (info->header_len < 8 || info->header_len > len)
+        return -EINVAL;
+
+    /* only the first presence word is used. Skip the extended ones */
+    present = get_le32(buf + 4);
+    offset = 8;
+    for (uint32_t word = present; word & (1u << RADIOTAP_EXT); offset += 4) {
+        if (offset + 4 > info->header_len)
+            return -EINVAL;
+        word = get_le32(buf + offset);
+    }
+
+    for (int field = 0; field <= RADIOTAP_DBM_ANTSIGNAL; field++) {
+        if (!(present & (1u << field)))
+            continue;
+
+        size_t align = radiotap_fields[field].align;
+        offset = (offset + align - 1) & ~(align - 1);
+        if (offset + radiotap_fields[field].size > info->header_len)
+            return -EINVAL;
+
+        switch (field) {
+        case RADIOTAP_FLAGS:
+            info->has_fcs = (buf[offset] & RADIOTAP_F_FCS) != 0;
+            break;
+        case RADIOTAP_CHANNEL:
+            info->freq = get_le16(buf + offset);
+            break;
+        case RADIOTAP_DBM_ANTSIGNAL:
+            info->rssi = (int8_t) buf[offset];
+            info->has_rssi = 1;
+            break;
+        default:
+            break;
+        }
+        offset += radiotap_fields[field].size;
+    }
+
+    return 0;
+}
@@ -0,0 +1,32 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID WiFi scanner
+*/
+
+#ifndef _RADIOTAP_H_
+#define _RADIOTAP_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct radiotap_info {
+    size_t header_len;      /* length of the radiotap header incl. all fields */
+    int has_fcs;            /* the 802.11 frame is followed by a 4 byte FCS */
+    int has_rssi;
+    int8_t rssi;            /* antenna signal in dBm */
+    uint16_t freq;          /* channel frequency in MHz, 0 if not present */
+};
+
+/* radiotap_parse - parses the fields of a radiotap header that are needed
+ * for receiving ODID frames
+ * @buf: pointer to the start of the radiotap header
+ * @len: number of bytes available at @buf
+ * @info: filled with the parsed fields
+ *
+ * Returns 0 on success, -EINVAL if the header is malformed or truncated
+ */
+int radiotap_parse(const uint8_t *buf, size_t len, struct radiotap_info *info);
+
+#endif // _RADIOTAP_H_
@@ -0,0 +1,202 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID WiFi scanner
+
+Bounded lock-free rings with fixed size elements, used to connect the
+stages of the receive pipeline. Elements are written and read in place:
+reserve a slot, fill it and commit it on the producer side, peek at the
+oldest slot and release it on the consumer side.
+*/
+
+#ifndef _RING_H_
+#define _RING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#define RING_CACHE_LINE 64
+
+/* Single producer, single consumer */
+struct spsc_ring {
+    size_t head __attribute__((aligned(RING_CACHE_LINE)));  /* written by the producer */
+    size_t tail __attribute__((aligned(RING_CACHE_LINE)));  /* written by the consumer */
+    size_t mask __attribute__((aligned(RING_CACHE_LINE)));
+    size_t elem_size;
+    uint8_t *buf;
+    /* statistics, written by the producer only */
+    uint64_t drops;
+    size_t high_water;
+};
+
+/* Multiple producers, single consumer. Each slot carries a sequence number
+ * telling whether it is free for the producer of a given position or
+ * committed for the consumer (D. Vyukov's bounded queue) */
+struct mpsc_ring {
+    size_t head __attribute__((aligned(RING_CACHE_LINE)));  /* next position to reserve */
+    size_t tail __attribute__((aligned(RING_CACHE_LINE)));  /* next position to consume */
+    size_t mask __attribute__((aligned(RING_CACHE_LINE)));
+    size_t elem_size;
+    size_t slot_size;
+    uint8_t *buf;
+    /* statistics, updated by all producers */
+    uint64_t drops;
+    size_t high_water;
+};
+
+struct mpsc_slot {
+    size_t seq;
+    uint8_t data[] __attribute__((aligned(8)));
+};
+
+/* capacity must be a power of two */
+static inline int spsc_ring_init(struct spsc_ring *ring, size_t capacity, size_t elem_size)
+{
+    if (capacity == 0 || (capacity & (capacity - 1)))
+        return -EINVAL;
+    ring->head = ring->tail = 0;
+    ring->mask = capacity - 1;
+    ring->elem_size = elem_size;
+    ring->drops = 0;
+    ring->high_water = 0;
+    ring->buf = calloc(capacity, elem_size);
+    return ring->buf ? 0 : -ENOMEM;
+}
+
+static inline void spsc_ring_free(struct spsc_ring *ring)
+{
+    free(ring->buf);
+    ring->buf = NULL;
+}
+
+static inline size_t spsc_ring_depth(struct spsc_ring *ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_RELAXED) -
+           __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+}
+
+/* Returns the next free slot, or NULL if the ring is full */
+static inline void *spsc_ring_reserve(struct spsc_ring *ring)
+{
+    size_t head = ring->head;
+
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) > ring->mask)
+        return NULL;
+    return ring->buf + (head & ring->mask) * ring->elem_size;
+}
+
+static inline void spsc_ring_commit(struct spsc_ring *ring)
+{
+    size_t head = ring->head + 1;
+    size_t depth = head - __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+    /* read by the statistics of other threads */
+    if (depth > ring->high_water)
+        __atomic_store_n(&ring->high_water, depth, __ATOMIC_RELAXED);
+}
+
+/* Returns the oldest committed slot, or NULL if the ring is empty */
+static inline void *spsc_ring_peek(struct spsc_ring *ring)
+{
+    size_t tail = ring->tail;
+
+    if (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE))
+        return NULL;
+    return ring->buf + (tail & ring->mask) * ring->elem_size;
+}
+
+static inline void spsc_ring_release(struct spsc_ring *ring)
+{
+    __atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_RELEASE);
+}
+
+static inline int mpsc_ring_init(struct mpsc_ring *ring, size_t capacity, size_t elem_size)
+{
+    if (capacity == 0 || (capacity & (capacity - 1)))
+        return -EINVAL;
+    ring->head = ring->tail = 0;
+    ring->mask = capacity - 1;
+    ring->elem_size = elem_size;
+    ring->slot_size = (sizeof(struct mpsc_slot) + elem_size + 7) & ~(size_t) 7;
+    ring->drops = 0;
+    ring->high_water = 0;
+    ring->buf = calloc(capacity, ring->slot_size);
+    if (!ring->buf)
+        return -ENOMEM;
+    for (size_t i = 0; i < capacity; i++)
+        ((struct mpsc_slot *) (ring->buf + i * ring->slot_size))->seq = i;
+    return 0;
+}
+
+static inline void mpsc_ring_free(struct mpsc_ring *ring)
+{
+    free(ring->buf);
+    ring->buf = NULL;
+}
+
+static inline size_t mpsc_ring_depth(struct mpsc_ring *ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_RELAXED) -
+           __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+}
+
+static inline struct mpsc_slot *mpsc_ring_slot(struct mpsc_ring *ring, size_t pos)
+{
+    return (struct mpsc_slot *) (ring->buf + (pos & ring->mask) * ring->slot_size);
+}
+
+/* Returns a free slot, or NULL if the ring is full. The slot must be
+ * committed with mpsc_ring_commit */
+static inline struct mpsc_slot *mpsc_ring_reserve(struct mpsc_ring *ring)
+{
+    size_t pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+
+    for (;;) {
+        struct mpsc_slot *slot = mpsc_ring_slot(ring, pos);
+        size_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+
+        if (seq == pos) {
+            if (__atomic_compare_exchange_n(&ring->head, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                return slot;
+        } else if ((ptrdiff_t) (seq - pos) < 0) {
+            return NULL;
+        } else {
+            pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static inline void mpsc_ring_commit(struct mpsc_ring *ring, struct mpsc_slot *slot)
+{
+    size_t pos = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+    size_t depth = pos + 1 - __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    if (depth > __atomic_load_n(&ring->high_water, __ATOMIC_RELAXED))
+        __atomic_store_n(&ring->high_water, depth, __ATOMIC_RELAXED);
+}
+
+/* Returns the oldest committed slot, or NULL if there is none */
+static inline struct mpsc_slot *mpsc_ring_peek(struct mpsc_ring *ring)
+{
+    struct mpsc_slot *slot = mpsc_ring_slot(ring, ring->tail);
+
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != ring->tail + 1)
+        return NULL;
+    return slot;
+}
+
+static inline void mpsc_ring_release(struct mpsc_ring *ring, struct mpsc_slot *slot)
+{
+    size_t tail = ring->tail;
+
+    __atomic_store_n(&slot->seq, tail + ring->mask + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELAXED);
+}
+
+#endif // _RING_H_
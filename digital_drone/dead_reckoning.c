@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#include <math.h>
+#include <string.h>
+#include "dead_reckoning.h"
+
+#define METERS_PER_DEG_LAT 111132.954
+#define NSEC_PER_SEC 1000000000ULL
+
+void dead_reckoning_init(struct dead_reckoning *dr) {
+    memset(dr, 0, sizeof(*dr));
+    odid_initLocationData(&dr->fix);
+}
+
+void dead_reckoning_update(struct dead_reckoning *dr, const ODID_Location_data *fix, uint64_t fix_ns) {
+    dr->fix = *fix;
+    dr->fix_ns = fix_ns;
+}
+
+bool dead_reckoning_predict(const struct dead_reckoning *dr, uint64_t now_ns, ODID_Location_data *location) {
+    if (dr->fix_ns == 0)
+        return false;
+
+    // A fix read after the running call started is not moved back
+    double secs = now_ns > dr->fix_ns ? (double) (now_ns - dr->fix_ns) / NSEC_PER_SEC : 0;
+    dead_reckoning_extrapolate(&dr->fix, secs, location);
+    return true;
+}
+
+// Meters per degree of longitude at the latitude
+static double meters_per_deg_lon(double latitude) {
+    return METERS_PER_DEG_LAT * cos(latitude * M_PI / 180);
+}
+
+static bool valid_altitude(float altitude) {
+    return altitude > INV_ALT;
+}
+
+void dead_reckoning_extrapolate(const ODID_Location_data *fix, double secs, ODID_Location_data *location) {
+    *location = *fix;
+    if (!(secs > 0))
+        return;
+
+    double move_secs = secs < DEAD_RECKONING_MAX_SECS ? secs : DEAD_RECKONING_MAX_SECS;
+    if (fix->SpeedHorizontal >= 0 && fix->SpeedHorizontal <= MAX_SPEED_H &&
+        fix->Direction >= MIN_DIR && fix->Direction <= MAX_DIR) {
+        double distance = fix->SpeedHorizontal * move_secs;
+        double direction = fix->Direction * M_PI / 180;
+        double m_per_deg_lon = meters_per_deg_lon(fix->Latitude);
+
+        location->Latitude = fix->Latitude + distance * cos(direction) / METERS_PER_DEG_LAT;
+        if (location->Latitude > 90)
+            location->Latitude = 90;
+        else if (location->Latitude < -90)
+            location->Latitude = -90;
+        if (m_per_deg_lon > 1) {
+            location->Longitude = fix->Longitude + distance * sin(direction) / m_per_deg_lon;
+            if (location->Longitude > 180)
+                location->Longitude -= 360;
+            else if (location->Longitude < -180)
+                location->Longitude += 360;
+        }
+    }
+
+    if (fabsf(fix->SpeedVertical) <= MAX_SPEED_V) {
+        float climb = (float) (fix->SpeedVertical * move_secs);
+        if (valid_altitude(fix->AltitudeGeo))
+            location->AltitudeGeo = fix->AltitudeGeo + climb;
+        if (valid_altitude(fix->AltitudeBaro))
+            location->AltitudeBaro = fix->AltitudeBaro + climb;
+        if (valid_altitude(fix->Height))
+            location->Height = fix->Height + climb;
+    }
+
+    // Seconds since the full hour, like the time stamp of the fix. Once the position is held, so is the
+    // time stamp, so that receivers can tell that the Location is not current
+    if (fix->TimeStamp >= 0 && fix->TimeStamp < MAX_TIMESTAMP)
+        location->TimeStamp = (float) fmod(fix->TimeStamp + move_secs, MAX_TIMESTAMP);
+
+    // The position is off by up to the error of the speeds times the time it moved. Unknown accuracies stay unknown
+    float speed_error = decodeSpeedAccuracy(fix->SpeedAccuracy) * (float) move_secs;
+    if (fix->HorizAccuracy != ODID_HOR_ACC_UNKNOWN)
+        location->HorizAccuracy = createEnumHorizontalAccuracy(decodeHorizontalAccuracy(fix->HorizAccuracy) + speed_error);
+    if (fix->VertAccuracy != ODID_VER_ACC_UNKNOWN)
+        location->VertAccuracy = createEnumVerticalAccuracy(decodeVerticalAccuracy(fix->VertAccuracy) + speed_error);
+    if (fix->BaroAccuracy != ODID_VER_ACC_UNKNOWN)
+        location->BaroAccuracy = createEnumVerticalAccuracy(decodeVerticalAccuracy(fix->BaroAccuracy) + speed_error);
+}
+
+double dead_reckoning_distance(const ODID_Location_data *a, const ODID_Location_data *b) {
+    double north = (b->Latitude - a->Latitude) * METERS_PER_DEG_LAT;
+    double east = (b->Longitude - a->Longitude) * meters_per_deg_lon((a->Latitude + b->Latitude) / 2);
+    return sqrt(north * north + east * east);
+}
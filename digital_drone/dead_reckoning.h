@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#ifndef _DEAD_RECKONING_H_
+#define _DEAD_RECKONING_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <opendroneid.h>
+
+#define DEAD_RECKONING_MAX_SECS 2.0 // Without a newer fix, the Location stays where it was after this time
+
+/*
+ * Moves the Location of the last GPS fix on to the time a Location message is sent, so that the
+ * messages between the fixes of a GPS, which typically has one fix per second, carry the current
+ * position instead of the one of the last fix.
+ */
+struct dead_reckoning {
+    ODID_Location_data fix;
+    uint64_t fix_ns;    // CLOCK_MONOTONIC time at which the fix was read, 0 before the first fix
+};
+
+void dead_reckoning_init(struct dead_reckoning *dr);
+
+void dead_reckoning_update(struct dead_reckoning *dr, const ODID_Location_data *fix, uint64_t fix_ns);
+
+/*
+ * Writes the Location at now_ns to location, extrapolated from the last fix. Returns false
+ * and leaves location unchanged before the first fix.
+ */
+bool dead_reckoning_predict(const struct dead_reckoning *dr, uint64_t now_ns, ODID_Location_data *location);
+
+/*
+ * Writes the Location secs after fix to location. The position and the altitudes move with the
+ * speeds and the direction of the fix, for at most DEAD_RECKONING_MAX_SECS. The TimeStamp moves
+ * on by the same time, so it is always the time for which the position is valid, and the
+ * accuracies of the position and the altitudes widen by the speed accuracy times that time.
+ * Invalid speeds, altitudes and time stamps stay as they are.
+ */
+void dead_reckoning_extrapolate(const ODID_Location_data *fix, double secs, ODID_Location_data *location);
+
+// Horizontal distance in meters between two positions that are close to each other
+double dead_reckoning_distance(const ODID_Location_data *a, const ODID_Location_data *b);
+
+#endif //_DEAD_RECKONING_H_
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <endian.h>
+#include <sys/time.h>
+
+#include <src/shared/btsnoop.h>
+
+#include "file_transport.h"
+
+#define PCAP_MAGIC 0xA1B2C3D4
+#define PCAP_LINKTYPE_IEEE802_11_RADIOTAP 127
+#define PCAP_SNAPLEN 65535
+
+#define RADIOTAP_PRESENT (1 << 1 | 1 << 2 | 1 << 3 | 1 << 5) // Flags, Rate, Channel, dBm Antenna Signal
+#define RADIOTAP_RATE_1MBPS 2                                 // 500 kbps units
+#define RADIOTAP_CHANNEL_CCK_2GHZ (0x0020 | 0x0080)
+
+#define BT_INDEX 0
+#define HCI_EV_LE_META 0x3E
+#define HCI_EV_LE_ADVERTISING_REPORT 0x02
+#define HCI_EV_LE_EXT_ADVERTISING_REPORT 0x0D
+#define ADV_NONCONN_IND 0x03
+#define ADDRESS_TYPE_RANDOM 0x01
+#define PHY_LE_CODED 0x03
+#define EXT_DATA_INCOMPLETE 0x0020    // Event_Type: More data to come in the next report
+#define EXT_REPORT_DATA_MAX 229       // 255 octets of event parameters minus the report fields
+
+struct pcap_file_header {
+    uint32_t magic;
+    uint16_t version_major;
+    uint16_t version_minor;
+    int32_t thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t linktype;
+};
+
+struct pcap_record_header {
+    uint32_t ts_sec;
+    uint32_t ts_usec;
+    uint32_t caplen;
+    uint32_t len;
+};
+
+struct radiotap_header {
+    uint8_t version;
+    uint8_t pad;
+    uint16_t len;
+    uint32_t present;
+    uint8_t flags;
+    uint8_t rate;
+    uint16_t channel_freq;
+    uint16_t channel_flags;
+    int8_t antenna_signal;
+} __attribute__((packed));
+
+static FILE *pcap;
+static struct btsnoop *btsnoop;
+
+int file_open_pcap(const char *file) {
+    struct pcap_file_header header = {
+        .magic = PCAP_MAGIC,
+        .version_major = 2,
+        .version_minor = 4,
+        .snaplen = PCAP_SNAPLEN,
+        .linktype = PCAP_LINKTYPE_IEEE802_11_RADIOTAP,
+    };
+
+    pcap = fopen(file, "wb");
+    if (!pcap) {
+        perror(file);
+        return -1;
+    }
+    if (fwrite(&header, sizeof(header), 1, pcap) != 1) {
+        perror(file);
+        fclose(pcap);
+        pcap = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+int file_open_btsnoop(const char *file) {
+    struct btsnoop_opcode_new_index index = {
+        .type = BTSNOOP_TYPE_PRIMARY,
+        .bus = BTSNOOP_BUS_VIRTUAL,
+        .name = "odid",
+    };
+    struct timeval tv;
+
+    btsnoop = btsnoop_create(file, 0, 0, BTSNOOP_FORMAT_MONITOR);
+    if (!btsnoop) {
+        perror(file);
+        return -1;
+    }
+
+    // The monitor format needs the controller index before its packets
+    gettimeofday(&tv, NULL);
+    if (!btsnoop_write_hci(btsnoop, &tv, BT_INDEX, BTSNOOP_OPCODE_NEW_INDEX, 0, &index, sizeof(index))) {
+        perror(file);
+        file_close();
+        return -1;
+    }
+    return 0;
+}
+
+void file_close(void) {
+    if (pcap)
+        fclose(pcap);
+    pcap = NULL;
+    btsnoop_unref(btsnoop);
+    btsnoop = NULL;
+}
+
+int file_write_wifi_frame(const struct timespec *ts, const uint8_t *frame, size_t len) {
+    struct radiotap_header radiotap = {
+        .len = htole16(sizeof(radiotap)),
+        .present = htole32(RADIOTAP_PRESENT),
+        .rate = RADIOTAP_RATE_1MBPS,
+        .channel_freq = htole16(FILE_WIFI_FREQ_MHZ),
+        .channel_flags = htole16(RADIOTAP_CHANNEL_CCK_2GHZ),
+        .antenna_signal = FILE_RSSI_DBM,
+    };
+    struct pcap_record_header header = {
+        .ts_sec = (uint32_t) ts->tv_sec,
+        .ts_usec = (uint32_t) (ts->tv_nsec / 1000),
+        .caplen = (uint32_t) (sizeof(radiotap) + len),
+        .len = (uint32_t) (sizeof(radiotap) + len),
+    };
+
+    if (!pcap)
+        return -1;
+    if (fwrite(&header, sizeof(header), 1, pcap) != 1 || fwrite(&radiotap, sizeof(radiotap), 1, pcap) != 1 ||
+        fwrite(frame, len, 1, pcap) != 1)
+        return -1;
+    return 0;
+}
+
+static int write_event(struct timeval *tv, const uint8_t *event, int len) {
+    if (!btsnoop_write_hci(btsnoop, tv, BT_INDEX, BTSNOOP_OPCODE_EVENT_PKT, 0, event, (uint16_t) len))
+        return -1;
+    return 0;
+}
+
+// Bluetooth Core Specification 5.1, Vol 2, Part E, 7.7.65.2 LE Advertising Report event
+static int write_advertising_report(struct timeval *tv, const uint8_t *address,
+                                    const uint8_t *ad, int ad_len) {
+    uint8_t event[2 + 12 + 31] = {
+        HCI_EV_LE_META,
+        0x00,             // Parameter_Total_Length
+        HCI_EV_LE_ADVERTISING_REPORT,
+        0x01,             // Num_Reports
+        ADV_NONCONN_IND,  // Event_Type
+        ADDRESS_TYPE_RANDOM,
+    };
+
+    if (ad_len > 31)
+        return -1;
+    memcpy(&event[6], address, 6);
+    event[12] = ad_len;
+    memcpy(&event[13], ad, ad_len);
+    event[13 + ad_len] = (uint8_t) FILE_RSSI_DBM;
+    event[1] = 12 + ad_len;
+    return write_event(tv, event, 2 + event[1]);
+}
+
+// Bluetooth Core Specification 5.1, Vol 2, Part E, 7.7.65.13 LE Extended Advertising Report event
+static int write_extended_advertising_reports(struct timeval *tv, const uint8_t *address,
+                                              const uint8_t *ad, int ad_len) {
+    uint8_t event[2 + 2 + 24 + EXT_REPORT_DATA_MAX] = {
+        HCI_EV_LE_META,
+        0x00,             // Parameter_Total_Length
+        HCI_EV_LE_EXT_ADVERTISING_REPORT,
+        0x01,             // Num_Reports
+        0x00, 0x00,       // Event_Type: Non-connectable and non-scannable undirected, data status
+        ADDRESS_TYPE_RANDOM,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // Address
+        PHY_LE_CODED,     // Primary_PHY
+        PHY_LE_CODED,     // Secondary_PHY
+        0x00,             // Advertising_SID, as in hci_le_set_extended_advertising_parameters()
+        0x7F,             // TX_Power: 0x7F = Not available
+        (uint8_t) FILE_RSSI_DBM,
+        0x00, 0x00,       // Periodic_Advertising_Interval: 0 = No periodic advertising
+        0x00,             // Direct_Address_Type
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // Direct_Address
+        0x00,             // Data_Length
+    };
+    int offset = 0;
+
+    memcpy(&event[7], address, 6);
+    do {
+        int len = ad_len - offset;
+        uint16_t event_type = 0;
+
+        if (len > EXT_REPORT_DATA_MAX) {
+            len = EXT_REPORT_DATA_MAX;
+            event_type = EXT_DATA_INCOMPLETE;
+        }
+        event[4] = event_type & 0xFF;
+        event[5] = event_type >> 8;
+        event[27] = len;
+        memcpy(&event[28], ad + offset, len);
+        event[1] = 2 + 24 + len;
+        if (write_event(tv, event, 2 + event[1]) < 0)
+            return -1;
+        offset += len;
+    } while (offset < ad_len);
+    return 0;
+}
+
+int file_write_bt_advertising(const struct timespec *ts, const uint8_t *address, bool long_range,
+                              const uint8_t *ad, int ad_len) {
+    struct timeval tv = { .tv_sec = ts->tv_sec, .tv_usec = ts->tv_nsec / 1000 };
+
+    if (!btsnoop)
+        return -1;
+    if (long_range)
+        return write_extended_advertising_reports(&tv, address, ad, ad_len);
+    return write_advertising_report(&tv, address, ad, ad_len);
+}
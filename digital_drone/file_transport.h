@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#ifndef _FILE_TRANSPORT_H_
+#define _FILE_TRANSPORT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#define FILE_WIFI_FREQ_MHZ 2437 // Channel 6, as in beacon.conf
+#define FILE_RSSI_DBM (-50)     // Signal strength of all frames and advertisements
+
+/*
+ * Instead of sending with hostapd and the HCI device, the transmitter can write what would
+ * go on air to files, e.g. to benchmark receivers without radios:
+ *  - IEEE 802.11 frames with a radiotap header to a pcap file.
+ *  - Bluetooth advertisements to a btsnoop file, as the LE Advertising Report events a
+ *    receiver gets from its controller. These can be read with "btmon -r" or Wireshark.
+ * The functions return 0 or -1.
+ */
+int file_open_pcap(const char *file);
+int file_open_btsnoop(const char *file);
+void file_close(void);
+
+int file_write_wifi_frame(const struct timespec *ts, const uint8_t *frame, size_t len);
+
+/*
+ * Writes the advertising data ad sent from address. Legacy advertising PDUs give an LE
+ * Advertising Report, long range advertising one or more LE Extended Advertising Reports
+ * on the LE Coded PHY, as the controller of the receiver splits longer data.
+ */
+int file_write_bt_advertising(const struct timespec *ts, const uint8_t *address, bool long_range,
+                              const uint8_t *ad, int ad_len);
+
+#endif //_FILE_TRANSPORT_H_
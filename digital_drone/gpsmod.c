@@ -1,12 +1,14 @@
 
 #include "gpsmod.h"
 #include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
 
-int init_gps(struct fixsource_t* source, struct gps_data_t* gpsdata) {
+static int open_gps_socket(struct fixsource_t* source, struct gps_data_t* gpsdata) {
     unsigned int flags = WATCH_ENABLE;
 
-    gpsd_source_spec(NULL, source);
-
     if (0 != gps_open(source->server, source->port, gpsdata)) {
         return 1;
     }
@@ -20,16 +22,111 @@ int init_gps(struct fixsource_t* source, struct gps_data_t* gpsdata) {
     return 0;
 }
 
-void process_gps_data(struct gps_data_t* gpsdata, struct ODID_UAS_Data *uasData) {
-    if(gpsdata->fix.mode >= MODE_2D) {
-        uasData->Location.Latitude = gpsdata->fix.latitude;
-        uasData->Location.Longitude = gpsdata->fix.longitude;
+int init_gps(struct fixsource_t* source, struct gps_data_t* gpsdata, bool try_shm) {
+    gpsd_source_spec(NULL, source);
+
+    // The shared memory export has no device selection and gpsd only updates it while it reads the GPS,
+    // i.e. when started with -n or while other clients are watching
+    if(try_shm && NULL == source->device) {
+        if(0 == gps_open(GPSD_SHARED_MEMORY, NULL, gpsdata)) {
+            // A segment that is not updated is left over from a gpsd that is no longer reading the GPS
+            if(wait_gps_data(gpsdata, NULL, GPS_SHM_PROBE_MICROSECS)) {
+                printf("Reading GPS fixes from the gpsd shared memory export\n");
+                return 0;
+            }
+            gps_close(gpsdata);
+            printf("No updates in the gpsd shared memory export, is gpsd running with -n? Using the socket\n");
+        }
+    }
+
+    return open_gps_socket(source, gpsdata);
+}
+
+bool gps_uses_shm(const struct gps_data_t* gpsdata) {
+    return SHM_PSEUDO_FD == (intptr_t) gpsdata->gps_fd;
+}
+
+static long elapsed_us(const timespec_t* from, const timespec_t* to) {
+    return (long) (to->tv_sec - from->tv_sec) * 1000000 + (to->tv_nsec - from->tv_nsec) / 1000;
+}
+
+bool wait_gps_data(const struct gps_data_t* gpsdata, const struct gps_last_fix* last, int timeout_us) {
+    if(!gps_uses_shm(gpsdata))
+        return gps_waiting(gpsdata, timeout_us);
 
-        if(isfinite(gpsdata->fix.track)) {
-            uasData->Location.Direction = gpsdata->fix.track;
+    // Sleep until shortly before the next fix is due. The updates of the other reports in between are skipped
+    int waited = 0;
+    if(last && last->interval_us > 0 && (last->online.tv_sec || last->online.tv_nsec)) {
+        timespec_t now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        long sleep_us = last->interval_us - GPS_SHM_EARLY_MICROSECS - elapsed_us(&last->online, &now);
+        if(sleep_us > timeout_us)
+            sleep_us = timeout_us;
+        if(sleep_us > 0) {
+            usleep((useconds_t) sleep_us);
+            waited = (int) sleep_us;
         }
     }
 
+    // gps_waiting() would busy wait on the shared memory for the whole timeout
+    for(; ; waited += GPS_SHM_POLL_MICROSECS) {
+        if(gps_waiting(gpsdata, 0))
+            return true;
+        if(waited >= timeout_us)
+            return false;
+        usleep(GPS_SHM_POLL_MICROSECS);
+    }
+}
+
+bool is_new_gps_fix(const struct gps_data_t* gpsdata, struct gps_last_fix* last) {
+    if(gpsdata->fix.time.tv_sec == last->time.tv_sec && gpsdata->fix.time.tv_nsec == last->time.tv_nsec)
+        return false;
+
+    // gpsd's time of reading the fixes, as the fix times of a replayed log do not follow the clock.
+    // Follows a faster GPS at once and a slower one gradually, so that the wait never sleeps past a fix
+    if((last->online.tv_sec || last->online.tv_nsec) && (gpsdata->online.tv_sec || gpsdata->online.tv_nsec)) {
+        long interval_us = elapsed_us(&last->online, &gpsdata->online);
+        if(interval_us <= 0 || interval_us > GPS_SHM_MAX_INTERVAL_MICROSECS)
+            last->interval_us = 0;
+        else if(last->interval_us == 0 || interval_us < last->interval_us)
+            last->interval_us = interval_us;
+        else
+            last->interval_us += (interval_us - last->interval_us) / 4;
+    }
+    last->time = gpsdata->fix.time;
+    last->online = gpsdata->online;
+    return true;
+}
+
+int process_gps_data(struct gps_data_t* gpsdata, struct ODID_UAS_Data *uasData) {
+    if(gpsdata->fix.mode < MODE_2D)
+        return 0;
+
+    uasData->Location.Latitude = gpsdata->fix.latitude;
+    uasData->Location.Longitude = gpsdata->fix.longitude;
+
+    // Seconds since the full hour of the time of the fix, which the transmitter moves on with the position
+    if(gpsdata->fix.time.tv_sec || gpsdata->fix.time.tv_nsec) {
+        uasData->Location.TimeStamp = (float) (gpsdata->fix.time.tv_sec % MAX_TIMESTAMP) +
+                                      (float) gpsdata->fix.time.tv_nsec * 1e-9f;
+        if(isfinite(gpsdata->fix.ept)) {
+            uasData->Location.TSAccuracy = createEnumTimestampAccuracy(gpsdata->fix.ept);
+        }
+    }
+
+    // The transmitter extrapolates the position with the speeds, so speeds of an older fix must not stay
+    uasData->Location.Direction = isfinite(gpsdata->fix.track) ? gpsdata->fix.track : INV_DIR;
+    uasData->Location.SpeedHorizontal = isfinite(gpsdata->fix.speed) ? gpsdata->fix.speed : INV_SPEED_H;
+    uasData->Location.SpeedVertical = INV_SPEED_V;
+
+    if(isfinite(gpsdata->fix.eph)) {
+        uasData->Location.HorizAccuracy = createEnumHorizontalAccuracy(gpsdata->fix.eph);
+    }
+
+    if(isfinite(gpsdata->fix.eps)) {
+        uasData->Location.SpeedAccuracy = createEnumSpeedAccuracy(gpsdata->fix.eps);
+    }
+
     if(gpsdata->fix.mode >= MODE_3D) {
         if(isfinite(gpsdata->fix.altMSL)) {
             uasData->Location.AltitudeGeo = gpsdata->fix.altMSL;
@@ -43,25 +140,14 @@ void process_gps_data(struct gps_data_t* gpsdata, struct ODID_UAS_Data *uasData)
                 gpsdata->fix.altitude - uasData->System.OperatorAltitudeGeo;
         }
 
-        if(isfinite(gpsdata->fix.speed)) {
-            uasData->Location.SpeedHorizontal = gpsdata->fix.speed;
-        }
-
         if(isfinite(gpsdata->fix.climb)) {
             uasData->Location.SpeedVertical = gpsdata->fix.climb;
         }
 
-        if(isfinite(gpsdata->fix.eph)) {
-            uasData->Location.HorizAccuracy = createEnumHorizontalAccuracy(gpsdata->fix.eph);
-        }
-
         if(isfinite(gpsdata->fix.epy)) {
             uasData->Location.VertAccuracy = createEnumVerticalAccuracy(gpsdata->fix.epy);
         }
-
-        if(isfinite(gpsdata->fix.eps)) {
-            uasData->Location.SpeedAccuracy = createEnumSpeedAccuracy(gpsdata->fix.eps);
-        }
-
     }
-}
\ No newline at end of file
+
+    return 1;
+}
@@ -2,6 +2,7 @@
 #ifndef _GPSMOD_H_
 #define _GPSMOD_H_
 
+#include <stdbool.h>
 #include <stdlib.h>
 
 #include "gpsd/gpsd-dev/include/libgps.h"
@@ -10,8 +11,27 @@
 #define MAX_GPS_WAIT_RETRIES 60 // 60 tries at 0.5 seconds a try is a 30 second timeout
 #define MAX_GPS_READ_RETRIES 5
 #define GPS_WAIT_TIME_MICROSECS 500000 // 1/2 second
+#define GPS_SHM_POLL_MICROSECS 1000 // gpsd does not signal updates of the shared memory export
+#define GPS_SHM_EARLY_MICROSECS 5000 // Polling starts this long before the next fix is due
+#define GPS_SHM_MAX_INTERVAL_MICROSECS 2000000 // Longer fix intervals are polled all the time
+#define GPS_SHM_PROBE_MICROSECS 2000000
 
-int init_gps(struct fixsource_t* source, struct gps_data_t* gpsdata);
-void process_gps_data(struct gps_data_t* gpsdata, struct ODID_UAS_Data *uasData);
+// The last new fix and the estimated interval of the fixes, which paces the polling of the shared memory
+struct gps_last_fix {
+    timespec_t time; // Of the fix
+    timespec_t online; // When gpsd read the fix from the GPS
+    long interval_us; // 0 until known
+};
+
+// Uses the gpsd shared memory export if try_shm and gpsd updates it, otherwise the JSON socket
+int init_gps(struct fixsource_t* source, struct gps_data_t* gpsdata, bool try_shm);
+bool gps_uses_shm(const struct gps_data_t* gpsdata);
+// Like gps_waiting(), but sleeps between the checks of the shared memory instead of busy waiting.
+// last may be NULL, otherwise the shared memory is not checked until the next fix is almost due
+bool wait_gps_data(const struct gps_data_t* gpsdata, const struct gps_last_fix* last, int timeout_us);
+// Returns true if the fix has another time than last, and updates last
+bool is_new_gps_fix(const struct gps_data_t* gpsdata, struct gps_last_fix* last);
+// Updates the Location of uasData with a 2D or 3D fix. Returns 1 if it did, 0 without a fix
+int process_gps_data(struct gps_data_t* gpsdata, struct ODID_UAS_Data *uasData);
 
 #endif
\ No newline at end of file
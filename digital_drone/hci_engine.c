@@ -0,0 +1,457 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+
+#include <lib/bluetooth.h>
+#include <lib/hci.h>
+
+#include "hci_engine.h"
+#include "scheduler.h"
+
+#define EVENT_BUF_SIZE (1 + HCI_EVENT_HDR_SIZE + 255)
+
+struct request_result {
+    struct hci_engine *engine;
+    bool done;
+    uint8_t status;
+    uint8_t *rparams;
+    int rsize;
+};
+
+static void deadline_after(struct timespec *deadline, int timeout_ms) {
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += timeout_ms / 1000;
+    deadline->tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+static void wake_thread(struct hci_engine *engine) {
+    uint64_t one = 1;
+    if (write(engine->wake_fd, &one, sizeof(one)) < 0)
+        perror("HCI engine wake up");
+}
+
+static int write_command(struct hci_engine *engine, const struct hci_command *command) {
+    uint8_t type = HCI_COMMAND_PKT;
+    hci_command_hdr hdr = { .opcode = htobs(command->opcode), .plen = command->plen };
+    struct iovec iov[3] = {
+        { &type, 1 },
+        { &hdr, HCI_COMMAND_HDR_SIZE },
+        { (void *) command->params, command->plen },
+    };
+
+    while (writev(engine->fd, iov, command->plen ? 3 : 2) < 0) {
+        if (errno == EINTR)
+            continue;
+        return -1;
+    }
+    return 0;
+}
+
+// Waits for the socket to become writable again only while a write failed with EAGAIN,
+// EPOLLOUT would otherwise wake the thread all the time
+static void set_write_wait(struct hci_engine *engine, bool wait) {
+    struct epoll_event event = { .events = EPOLLIN | (wait ? EPOLLOUT : 0), .data.fd = engine->fd };
+
+    if (engine->write_wait == wait)
+        return;
+    if (epoll_ctl(engine->epoll_fd, EPOLL_CTL_MOD, engine->fd, &event) < 0) {
+        perror("HCI engine epoll");
+        return;
+    }
+    engine->write_wait = wait;
+}
+
+// Sends the queued commands the controller has credits for. Called with the lock held
+static void send_queued(struct hci_engine *engine) {
+    set_write_wait(engine, false);
+    while (engine->credits > 0 && engine->queued > 0 && engine->sent < HCI_ENGINE_MAX_IN_FLIGHT) {
+        struct hci_command *command = &engine->queue[engine->first];
+
+        if (write_command(engine, command) < 0) {
+            if (errno == EAGAIN) {
+                set_write_wait(engine, true);
+                return;
+            }
+            fprintf(stderr, "Failed to send HCI command 0x%04X: %s\n", command->opcode, strerror(errno));
+            engine->dropped[engine->ndropped++] = *command;
+            engine->stats.failed++;
+        } else {
+            engine->in_flight[engine->sent++] = *command;
+            engine->credits--;
+        }
+        engine->first = (engine->first + 1) % HCI_ENGINE_MAX_QUEUED;
+        engine->queued--;
+    }
+    if (engine->sent > engine->stats.max_in_flight)
+        engine->stats.max_in_flight = engine->sent;
+}
+
+// Completes the commands that could not be sent, so that nothing waits for them
+static void complete_dropped(struct hci_engine *engine) {
+    struct hci_command dropped[HCI_ENGINE_MAX_QUEUED];
+    int n;
+
+    pthread_mutex_lock(&engine->lock);
+    n = engine->ndropped;
+    memcpy(dropped, engine->dropped, n * sizeof(dropped[0]));
+    engine->ndropped = 0;
+    pthread_mutex_unlock(&engine->lock);
+    if (!n)
+        return;
+
+    // The callbacks run without the lock, like those of the completed commands
+    for (int i = 0; i < n; i++) {
+        if (dropped[i].cb)
+            dropped[i].cb(dropped[i].arg, dropped[i].opcode, HCI_ENGINE_SEND_FAILED, NULL, 0);
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    pthread_cond_broadcast(&engine->changed);
+    pthread_mutex_unlock(&engine->lock);
+}
+
+// Handles a Command Complete or Command Status event of the controller
+static void complete_command(struct hci_engine *engine, uint8_t ncmd, uint16_t opcode, uint8_t status,
+                             const uint8_t *rparams, int len) {
+    struct hci_command command;
+    int i;
+
+    pthread_mutex_lock(&engine->lock);
+    engine->credits = ncmd;
+
+    // Events of commands of other processes on the same controller, and the NOP opcode 0
+    // that only hands out credits, match no command in flight
+    for (i = 0; i < engine->sent; i++) {
+        if (engine->in_flight[i].opcode == opcode)
+            break;
+    }
+    if (i == engine->sent) {
+        send_queued(engine);
+        pthread_mutex_unlock(&engine->lock);
+        complete_dropped(engine);
+        return;
+    }
+
+    command = engine->in_flight[i];
+    memmove(&engine->in_flight[i], &engine->in_flight[i + 1], (engine->sent - i - 1) * sizeof(command));
+    engine->sent--;
+
+    uint64_t ns = now_ns() - command.queued_ns;
+    engine->stats.completed++;
+    engine->stats.sum_ns += ns;
+    if (ns > engine->stats.max_ns)
+        engine->stats.max_ns = ns;
+    if (status)
+        engine->stats.failed++;
+    send_queued(engine);
+    pthread_mutex_unlock(&engine->lock);
+
+    // The callback may queue further commands, so it runs without the lock
+    if (command.cb)
+        command.cb(command.arg, opcode, status, rparams, len);
+
+    pthread_mutex_lock(&engine->lock);
+    pthread_cond_broadcast(&engine->changed);
+    pthread_mutex_unlock(&engine->lock);
+    complete_dropped(engine);
+}
+
+static void handle_event(struct hci_engine *engine, const uint8_t *buf, int len) {
+    const hci_event_hdr *hdr = (const void *) &buf[1];
+    const uint8_t *ptr = &buf[1 + HCI_EVENT_HDR_SIZE];
+
+    if (len < 1 + HCI_EVENT_HDR_SIZE || buf[0] != HCI_EVENT_PKT || hdr->plen > len - 1 - HCI_EVENT_HDR_SIZE)
+        return;
+
+    switch (hdr->evt) {
+        case EVT_CMD_COMPLETE:
+            if (hdr->plen < EVT_CMD_COMPLETE_SIZE)
+                return;
+            // Num_HCI_Command_Packets, Command_Opcode, Return_Parameters starting with the status
+            complete_command(engine, ptr[0], (uint16_t) (ptr[1] | ptr[2] << 8),
+                             hdr->plen > EVT_CMD_COMPLETE_SIZE ? ptr[3] : 0,
+                             &ptr[EVT_CMD_COMPLETE_SIZE], hdr->plen - EVT_CMD_COMPLETE_SIZE);
+            return;
+
+        case EVT_CMD_STATUS:
+            if (hdr->plen < EVT_CMD_STATUS_SIZE)
+                return;
+            // Status, Num_HCI_Command_Packets, Command_Opcode
+            complete_command(engine, ptr[1], (uint16_t) (ptr[2] | ptr[3] << 8), ptr[0], ptr, 1);
+            return;
+
+        default:
+            // E.g. the LE Meta events of advertising sets that end. Nothing waits for them
+            return;
+    }
+}
+
+static void *event_thread(void *arg) {
+    struct hci_engine *engine = arg;
+    uint8_t buf[EVENT_BUF_SIZE];
+
+    for (;;) {
+        struct epoll_event events[2];
+        int n = epoll_wait(engine->epoll_fd, events, 2, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("HCI engine epoll");
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.fd == engine->wake_fd) {
+                uint64_t count;
+                if (read(engine->wake_fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+                    perror("HCI engine wake up");
+                continue;
+            }
+
+            ssize_t len;
+            while ((len = read(engine->fd, buf, sizeof(buf))) > 0)
+                handle_event(engine, buf, (int) len);
+            if (len == 0 || (errno != EAGAIN && errno != EINTR)) {
+                perror("HCI engine read");
+                pthread_mutex_lock(&engine->lock);
+                engine->stop = true;
+                pthread_cond_broadcast(&engine->changed);
+                pthread_mutex_unlock(&engine->lock);
+                return NULL;
+            }
+        }
+
+        pthread_mutex_lock(&engine->lock);
+        if (engine->stop) {
+            pthread_mutex_unlock(&engine->lock);
+            break;
+        }
+        send_queued(engine);
+        pthread_mutex_unlock(&engine->lock);
+        complete_dropped(engine);
+    }
+    return NULL;
+}
+
+int hci_engine_start(struct hci_engine *engine, int fd) {
+    struct epoll_event hci_event = { .events = EPOLLIN, .data.fd = fd };
+    struct epoll_event wake_event = { .events = EPOLLIN };
+
+    memset(engine, 0, sizeof(*engine));
+    engine->fd = fd;
+    engine->credits = 1; // Until the controller tells otherwise
+    engine->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    engine->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    wake_event.data.fd = engine->wake_fd;
+
+    if (engine->epoll_fd < 0 || engine->wake_fd < 0 ||
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0 ||
+        epoll_ctl(engine->epoll_fd, EPOLL_CTL_ADD, fd, &hci_event) < 0 ||
+        epoll_ctl(engine->epoll_fd, EPOLL_CTL_ADD, engine->wake_fd, &wake_event) < 0) {
+        perror("HCI engine setup failed");
+        goto failed;
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&engine->changed, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&engine->lock, NULL);
+
+    if (pthread_create(&engine->thread, NULL, event_thread, engine) != 0) {
+        perror("HCI engine thread");
+        pthread_cond_destroy(&engine->changed);
+        pthread_mutex_destroy(&engine->lock);
+        goto failed;
+    }
+    return 0;
+
+failed:
+    if (engine->epoll_fd >= 0)
+        close(engine->epoll_fd);
+    if (engine->wake_fd >= 0)
+        close(engine->wake_fd);
+    engine->epoll_fd = engine->wake_fd = -1;
+    return -1;
+}
+
+void hci_engine_stop(struct hci_engine *engine) {
+    if (engine->epoll_fd < 0)
+        return;
+
+    hci_engine_flush(engine);
+    pthread_mutex_lock(&engine->lock);
+    engine->stop = true;
+    pthread_mutex_unlock(&engine->lock);
+    wake_thread(engine);
+    pthread_join(engine->thread, NULL);
+
+    pthread_cond_destroy(&engine->changed);
+    pthread_mutex_destroy(&engine->lock);
+    close(engine->epoll_fd);
+    close(engine->wake_fd);
+    engine->epoll_fd = engine->wake_fd = -1;
+}
+
+static int queue_command(struct hci_engine *engine, uint16_t opcode, const void *params, int plen,
+                         hci_engine_cb cb, void *arg, bool wait) {
+    struct timespec deadline;
+    struct hci_command *command;
+
+    if (plen < 0 || plen > HCI_ENGINE_MAX_PARAMS)
+        return -1;
+
+    deadline_after(&deadline, HCI_ENGINE_TIMEOUT_MS);
+    pthread_mutex_lock(&engine->lock);
+    while (wait && engine->queued == HCI_ENGINE_MAX_QUEUED && !engine->stop) {
+        if (pthread_cond_timedwait(&engine->changed, &engine->lock, &deadline) == ETIMEDOUT)
+            break;
+    }
+    if (engine->queued == HCI_ENGINE_MAX_QUEUED || engine->stop) {
+        pthread_mutex_unlock(&engine->lock);
+        if (wait)
+            fprintf(stderr, "HCI command 0x%04X dropped: The controller does not respond\n", opcode);
+        return -1;
+    }
+
+    command = &engine->queue[(engine->first + engine->queued) % HCI_ENGINE_MAX_QUEUED];
+    command->opcode = opcode;
+    command->plen = (uint8_t) plen;
+    if (plen)
+        memcpy(command->params, params, plen);
+    command->cb = cb;
+    command->arg = arg;
+    command->queued_ns = now_ns();
+    engine->queued++;
+    if (engine->queued > engine->stats.max_queued)
+        engine->stats.max_queued = engine->queued;
+    pthread_mutex_unlock(&engine->lock);
+
+    wake_thread(engine);
+    return 0;
+}
+
+int hci_engine_send(struct hci_engine *engine, uint16_t opcode, const void *params, int plen,
+                    hci_engine_cb cb, void *arg) {
+    return queue_command(engine, opcode, params, plen, cb, arg, true);
+}
+
+int hci_engine_try_send(struct hci_engine *engine, uint16_t opcode, const void *params, int plen,
+                        hci_engine_cb cb, void *arg) {
+    return queue_command(engine, opcode, params, plen, cb, arg, false);
+}
+
+static void request_done(void *arg, uint16_t opcode __attribute__((unused)), uint8_t status,
+                         const uint8_t *rparams, int len) {
+    struct request_result *result = arg;
+
+    pthread_mutex_lock(&result->engine->lock);
+    result->status = status;
+    if (result->rparams && len > 0)
+        memcpy(result->rparams, rparams, len < result->rsize ? len : result->rsize);
+    result->done = true;
+    pthread_cond_broadcast(&result->engine->changed);
+    pthread_mutex_unlock(&result->engine->lock);
+}
+
+int hci_engine_request(struct hci_engine *engine, uint16_t opcode, const void *params, int plen,
+                       uint8_t *rparams, int rsize) {
+    struct request_result result = { .engine = engine, .rparams = rparams, .rsize = rsize };
+    struct timespec deadline;
+    int ret = 0;
+
+    if (rparams)
+        memset(rparams, 0, rsize);
+    if (hci_engine_send(engine, opcode, params, plen, request_done, &result) < 0)
+        return -1;
+
+    deadline_after(&deadline, HCI_ENGINE_TIMEOUT_MS);
+    pthread_mutex_lock(&engine->lock);
+    while (!result.done && !engine->stop && ret != ETIMEDOUT)
+        ret = pthread_cond_timedwait(&engine->changed, &engine->lock, &deadline);
+
+    if (!result.done) {
+        // The result is on this stack, make sure a late completion does not write to it
+        bool pending = false;
+        for (int i = 0; i < engine->sent; i++) {
+            if (engine->in_flight[i].arg == &result) {
+                engine->in_flight[i].cb = NULL;
+                pending = true;
+            }
+        }
+        for (int i = 0; i < engine->queued; i++) {
+            struct hci_command *command = &engine->queue[(engine->first + i) % HCI_ENGINE_MAX_QUEUED];
+            if (command->arg == &result) {
+                command->cb = NULL;
+                pending = true;
+            }
+        }
+        for (int i = 0; i < engine->ndropped; i++) {
+            if (engine->dropped[i].arg == &result) {
+                engine->dropped[i].cb = NULL;
+                pending = true;
+            }
+        }
+        // Otherwise the event thread is running the callback right now, which only takes the lock
+        deadline_after(&deadline, HCI_ENGINE_TIMEOUT_MS);
+        ret = 0;
+        while (!pending && !result.done && ret != ETIMEDOUT)
+            ret = pthread_cond_timedwait(&engine->changed, &engine->lock, &deadline);
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    if (!result.done) {
+        fprintf(stderr, "HCI command 0x%04X timed out\n", opcode);
+        return -1;
+    }
+    return result.status;
+}
+
+int hci_engine_flush(struct hci_engine *engine) {
+    struct timespec deadline;
+    int ret = 0;
+
+    deadline_after(&deadline, HCI_ENGINE_TIMEOUT_MS);
+    pthread_mutex_lock(&engine->lock);
+    while ((engine->queued || engine->sent) && !engine->stop && ret != ETIMEDOUT)
+        ret = pthread_cond_timedwait(&engine->changed, &engine->lock, &deadline);
+    ret = engine->queued || engine->sent ? -1 : 0;
+    pthread_mutex_unlock(&engine->lock);
+    return ret;
+}
+
+void hci_engine_print_stats(struct hci_engine *engine) {
+    pthread_mutex_lock(&engine->lock);
+    struct hci_engine_stats stats = engine->stats;
+    pthread_mutex_unlock(&engine->lock);
+
+    if (!stats.completed)
+        return;
+    printf("%-16s %8s %8s %10s %10s %10s %10s\n", "HCI commands", "Count", "Failed", "Avg ms", "Max ms",
+           "Max queued", "Max sent");
+    printf("%-16s %8llu %8llu %10.3f %10.3f %10d %10d\n", "", (unsigned long long) stats.completed,
+           (unsigned long long) stats.failed, stats.sum_ns / 1e6 / (double) stats.completed,
+           stats.max_ns / 1e6, stats.max_queued, stats.max_in_flight);
+}
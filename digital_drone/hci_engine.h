@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#ifndef _HCI_ENGINE_H_
+#define _HCI_ENGINE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#define HCI_ENGINE_MAX_QUEUED 64     // Commands waiting for a Num_HCI_Command_Packets credit
+#define HCI_ENGINE_MAX_IN_FLIGHT 8   // Commands sent to the controller without their completion yet
+#define HCI_ENGINE_MAX_PARAMS 255
+#define HCI_ENGINE_TIMEOUT_MS 2000   // For hci_engine_request() and hci_engine_flush()
+#define HCI_ENGINE_SEND_FAILED 0x1F  // Unspecified Error
+
+/*
+ * Called from the event thread with the Command Complete or Command Status event of a command.
+ * rparams are the return parameters of Command Complete, starting with the status. A command
+ * that could not be sent completes with HCI_ENGINE_SEND_FAILED and no return parameters.
+ */
+typedef void (*hci_engine_cb)(void *arg, uint16_t opcode, uint8_t status, const uint8_t *rparams, int len);
+
+struct hci_command {
+    uint16_t opcode;
+    uint8_t plen;
+    uint8_t params[HCI_ENGINE_MAX_PARAMS];
+    hci_engine_cb cb;
+    void *arg;
+    uint64_t queued_ns;
+};
+
+struct hci_engine_stats {
+    uint64_t completed;
+    uint64_t failed;
+    uint64_t sum_ns;        // From queueing a command to its completion
+    uint64_t max_ns;
+    int max_queued;
+    int max_in_flight;
+};
+
+/*
+ * Sends HCI commands without waiting for their completion. A thread waits with epoll for the
+ * events of the controller. Commands are queued and sent as far as the controller has credits
+ * for them, as told by Num_HCI_Command_Packets in its Command Complete and Command Status
+ * events. The events are matched to the commands in flight by opcode, other events are ignored.
+ * Works on any HCI socket, incl. the virtual controllers of the BlueZ emulator through vhci.
+ */
+struct hci_engine {
+    int fd;
+    int epoll_fd;
+    int wake_fd;            // eventfd that wakes the thread for new commands or to stop
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t changed; // Signalled when a command completes
+    bool stop;
+    int credits;
+    struct hci_command queue[HCI_ENGINE_MAX_QUEUED];
+    int first;
+    int queued;
+    struct hci_command in_flight[HCI_ENGINE_MAX_IN_FLIGHT]; // In the order they were sent
+    int sent;
+    struct hci_command dropped[HCI_ENGINE_MAX_QUEUED]; // Failed to send, their callbacks are pending
+    int ndropped;
+    bool write_wait;        // The socket was full, EPOLLOUT is armed
+    struct hci_engine_stats stats;
+};
+
+// Starts the event thread on an open HCI socket. Returns 0 or -1
+int hci_engine_start(struct hci_engine *engine, int fd);
+
+// Waits for the commands in flight and stops the thread. Does not close the socket
+void hci_engine_stop(struct hci_engine *engine);
+
+/*
+ * Queues a command and returns without waiting for the controller. Only blocks while
+ * HCI_ENGINE_MAX_QUEUED commands are queued. Returns 0 or -1.
+ */
+int hci_engine_send(struct hci_engine *engine, uint16_t opcode, const void *params, int plen,
+                    hci_engine_cb cb, void *arg);
+
+/*
+ * Like hci_engine_send() but returns -1 at once when the queue is full. For the callbacks, which
+ * run on the event thread that empties the queue.
+ */
+int hci_engine_try_send(struct hci_engine *engine, uint16_t opcode, const void *params, int plen,
+                        hci_engine_cb cb, void *arg);
+
+/*
+ * Sends a command and waits for its completion. Copies up to rsize return parameters to
+ * rparams, if not NULL. Returns the status of the command or -1 on timeouts.
+ */
+int hci_engine_request(struct hci_engine *engine, uint16_t opcode, const void *params, int plen,
+                       uint8_t *rparams, int rsize);
+
+// Waits until all queued commands completed. Returns 0 or -1 on timeouts
+int hci_engine_flush(struct hci_engine *engine);
+
+void hci_engine_print_stats(struct hci_engine *engine);
+
+#endif //_HCI_ENGINE_H_
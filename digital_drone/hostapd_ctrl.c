@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <dirent.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "common/wpa_ctrl.h"
+#include "hostapd_ctrl.h"
+
+#define CLOSE_TIMEOUT_MS 1000
+
+static uint64_t timespec_ns(const struct timespec *ts) {
+    return (uint64_t) ts->tv_sec * 1000000000ULL + (uint64_t) ts->tv_nsec;
+}
+
+// SO_TIMESTAMPNS stamps the replies with CLOCK_REALTIME, so the commands are too
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return timespec_ns(&ts);
+}
+
+/*
+ * The replies may be handled long after they arrived, e.g. with the next beacon update.
+ * Their latency is measured up to the receive timestamp of the kernel instead.
+ */
+static ssize_t receive_reply(struct hostapd_ctrl *ctrl, uint64_t *received_ns) {
+    char control[CMSG_SPACE(sizeof(struct timespec))];
+    struct iovec iov = { ctrl->reply, sizeof(ctrl->reply) - 1 };
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control,
+        .msg_controllen = sizeof(control),
+    };
+    ssize_t len = recvmsg(ctrl->fd, &msg, 0);
+
+    *received_ns = 0;
+    if (len < 0)
+        return len;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            struct timespec ts;
+            memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            *received_ns = timespec_ns(&ts);
+        }
+    }
+    if (!*received_ns)
+        *received_ns = now_ns();
+    ctrl->reply[len] = '\0';
+    return len;
+}
+
+static struct wpa_ctrl *open_first_interface(void) {
+    struct wpa_ctrl *conn = NULL;
+    struct dirent *dent;
+    DIR *dir = opendir(HOSTAPD_CTRL_DIR);
+
+    if (!dir)
+        return NULL;
+    while (!conn && (dent = readdir(dir))) {
+        char path[sizeof(HOSTAPD_CTRL_DIR) + sizeof(dent->d_name) + 1];
+
+        if (strcmp(dent->d_name, ".") == 0 || strcmp(dent->d_name, "..") == 0)
+            continue;
+        snprintf(path, sizeof(path), "%s/%s", HOSTAPD_CTRL_DIR, dent->d_name);
+        conn = wpa_ctrl_open(path);
+        if (conn)
+            printf("Connected to hostapd interface %s\n", dent->d_name);
+    }
+    closedir(dir);
+    return conn;
+}
+
+int hostapd_ctrl_open(struct hostapd_ctrl *ctrl, const volatile bool *stop) {
+    memset(ctrl, 0, sizeof(*ctrl));
+    ctrl->fd = -1;
+
+    while (!(ctrl->conn = open_first_interface())) {
+        if (*stop)
+            return -1;
+        printf("Could not connect to hostapd - re-trying\n");
+        sleep(1);
+    }
+    ctrl->fd = wpa_ctrl_get_fd(ctrl->conn);
+    if (setsockopt(ctrl->fd, SOL_SOCKET, SO_TIMESTAMPNS, &(int) { 1 }, sizeof(int)) < 0)
+        perror("SO_TIMESTAMPNS");
+    return 0;
+}
+
+void hostapd_ctrl_close(struct hostapd_ctrl *ctrl) {
+    uint64_t deadline = now_ns() + CLOSE_TIMEOUT_MS * 1000000ULL;
+
+    if (!ctrl->conn)
+        return;
+    while (ctrl->count && now_ns() < deadline) {
+        if (hostapd_ctrl_poll(ctrl, (int) ((deadline - now_ns()) / 1000000) + 1) < 0)
+            break;
+    }
+    wpa_ctrl_close(ctrl->conn);
+    ctrl->conn = NULL;
+    ctrl->fd = -1;
+}
+
+// The histogram of a command is selected by its first word, e.g. SET or UPDATE_BEACON
+static int find_latency(struct hostapd_ctrl *ctrl, const char *cmd) {
+    size_t len = strcspn(cmd, " ");
+    int i;
+
+    if (len >= sizeof(ctrl->latencies[0].name))
+        len = sizeof(ctrl->latencies[0].name) - 1;
+    for (i = 0; i < ctrl->latency_count; i++) {
+        if (strncmp(ctrl->latencies[i].name, cmd, len) == 0 && ctrl->latencies[i].name[len] == '\0')
+            return i;
+    }
+    if (ctrl->latency_count == HOSTAPD_CTRL_MAX_COMMANDS)
+        return -1;
+    memcpy(ctrl->latencies[i].name, cmd, len);
+    ctrl->latencies[i].name[len] = '\0';
+    return ctrl->latency_count++;
+}
+
+static void record_latency(struct hostapd_ctrl_latency *latency, uint64_t ns, bool failed) {
+    uint64_t us = ns / 1000;
+    int bucket = us ? 64 - __builtin_clzll(us) : 0;
+
+    if (bucket >= HOSTAPD_CTRL_BUCKETS)
+        bucket = HOSTAPD_CTRL_BUCKETS - 1;
+    latency->buckets[bucket]++;
+    latency->count++;
+    latency->sum_ns += ns;
+    if (ns > latency->max_ns)
+        latency->max_ns = ns;
+    if (failed)
+        latency->failed++;
+}
+
+int hostapd_ctrl_send(struct hostapd_ctrl *ctrl, const char *cmd, hostapd_ctrl_cb cb, void *arg) {
+    struct hostapd_ctrl_cmd *pending;
+    uint64_t sent_ns;
+
+    if (!ctrl->conn)
+        return -1;
+    while (ctrl->count == HOSTAPD_CTRL_MAX_PENDING) {
+        if (hostapd_ctrl_poll(ctrl, CLOSE_TIMEOUT_MS) <= 0) {
+            fprintf(stderr, "hostapd: No reply to %d commands\n", ctrl->count);
+            return -1;
+        }
+    }
+
+    // wpa_ctrl opens the socket non-blocking, wait until hostapd has room for the command
+    sent_ns = now_ns();
+    while (send(ctrl->fd, cmd, strlen(cmd), 0) < 0) {
+        struct pollfd pfd = { .fd = ctrl->fd, .events = POLLOUT };
+
+        if (errno == EINTR)
+            continue;
+        if (errno != EAGAIN || poll(&pfd, 1, CLOSE_TIMEOUT_MS) <= 0) {
+            fprintf(stderr, "hostapd: '%s' command failed: %s\n", cmd, strerror(errno));
+            return -1;
+        }
+        sent_ns = now_ns();
+    }
+
+    pending = &ctrl->pending[(ctrl->first + ctrl->count) % HOSTAPD_CTRL_MAX_PENDING];
+    pending->cb = cb;
+    pending->arg = arg;
+    pending->latency = find_latency(ctrl, cmd);
+    pending->sent_ns = sent_ns;
+    ctrl->count++;
+    return 0;
+}
+
+int hostapd_ctrl_poll(struct hostapd_ctrl *ctrl, int timeout_ms) {
+    struct pollfd pfd = { .fd = ctrl->fd, .events = POLLIN };
+    int replies = 0;
+
+    if (!ctrl->conn)
+        return -1;
+    while (ctrl->count) {
+        int ret = poll(&pfd, 1, replies ? 0 : timeout_ms);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (ret == 0)
+            break;
+
+        uint64_t received_ns;
+        ssize_t len = receive_reply(ctrl, &received_ns);
+        if (len < 0) {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+            return -1;
+        }
+
+        // Unsolicited event messages start with the priority, e.g. "<3>"
+        if (ctrl->reply[0] == '<')
+            continue;
+
+        struct hostapd_ctrl_cmd *pending = &ctrl->pending[ctrl->first];
+        bool failed = strncmp(ctrl->reply, "FAIL", 4) == 0 || strncmp(ctrl->reply, "UNKNOWN", 7) == 0;
+        if (pending->latency >= 0)
+            record_latency(&ctrl->latencies[pending->latency], received_ns - pending->sent_ns, failed);
+        ctrl->first = (ctrl->first + 1) % HOSTAPD_CTRL_MAX_PENDING;
+        ctrl->count--;
+        if (pending->cb)
+            pending->cb(pending->arg, ctrl->reply, (size_t) len);
+        replies++;
+    }
+    return replies;
+}
+
+void hostapd_ctrl_print_stats(const struct hostapd_ctrl *ctrl) {
+    if (!ctrl->latency_count)
+        return;
+
+    printf("%-16s %8s %8s %10s %10s\n", "hostapd command", "Count", "Failed", "Avg ms", "Max ms");
+    for (int i = 0; i < ctrl->latency_count; i++) {
+        const struct hostapd_ctrl_latency *latency = &ctrl->latencies[i];
+        printf("%-16s %8llu %8llu %10.3f %10.3f\n", latency->name,
+               (unsigned long long) latency->count, (unsigned long long) latency->failed,
+               latency->count ? latency->sum_ns / 1e6 / (double) latency->count : 0.0,
+               latency->max_ns / 1e6);
+    }
+
+    for (int i = 0; i < ctrl->latency_count; i++) {
+        const struct hostapd_ctrl_latency *latency = &ctrl->latencies[i];
+        printf("%s latency histogram:\n", latency->name);
+        for (int b = 0; b < HOSTAPD_CTRL_BUCKETS; b++) {
+            if (!latency->buckets[b])
+                continue;
+            if (b == HOSTAPD_CTRL_BUCKETS - 1)
+                printf("  >= %8lu us: %llu\n", 1UL << (b - 1), (unsigned long long) latency->buckets[b]);
+            else
+                printf("  <  %8lu us: %llu\n", 1UL << b, (unsigned long long) latency->buckets[b]);
+        }
+    }
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#ifndef _HOSTAPD_CTRL_H_
+#define _HOSTAPD_CTRL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define HOSTAPD_CTRL_DIR "/var/run/hostapd" // ctrl_interface of beacon.conf
+// Commands sent without a reply yet. Below the default net.unix.max_dgram_qlen of 10, so
+// neither the commands nor their replies overflow the queues of the datagram sockets
+#define HOSTAPD_CTRL_MAX_PENDING 8
+#define HOSTAPD_CTRL_MAX_COMMANDS 4         // Command names with their own latency histogram
+#define HOSTAPD_CTRL_BUCKETS 24             // Bucket i counts latencies below 2^i us
+#define HOSTAPD_CTRL_REPLY_SIZE 4096
+
+// Called with the reply of a command, e.g. "OK\n" or "FAIL\n"
+typedef void (*hostapd_ctrl_cb)(void *arg, const char *reply, size_t len);
+
+struct hostapd_ctrl_cmd {
+    hostapd_ctrl_cb cb;
+    void *arg;
+    int latency;            // Index into latencies
+    uint64_t sent_ns;       // CLOCK_REALTIME, as the receive timestamps
+};
+
+struct hostapd_ctrl_latency {
+    char name[32];          // First word of the command
+    uint64_t count;
+    uint64_t failed;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+    uint64_t buckets[HOSTAPD_CTRL_BUCKETS];
+};
+
+/*
+ * A minimal client for the hostapd control interface. The socket stays open and commands
+ * are pipelined: hostapd handles them in order and replies in the same order, so a command
+ * is sent without waiting for the reply of the previous one.
+ */
+struct hostapd_ctrl {
+    struct wpa_ctrl *conn;
+    int fd;
+    struct hostapd_ctrl_cmd pending[HOSTAPD_CTRL_MAX_PENDING]; // Ring of commands waiting for a reply
+    int first;
+    int count;
+    struct hostapd_ctrl_latency latencies[HOSTAPD_CTRL_MAX_COMMANDS];
+    int latency_count;
+    char reply[HOSTAPD_CTRL_REPLY_SIZE];
+};
+
+/*
+ * Connects to the first interface of hostapd in HOSTAPD_CTRL_DIR, retrying every second
+ * until hostapd runs or *stop is set. Returns 0 or -1.
+ */
+int hostapd_ctrl_open(struct hostapd_ctrl *ctrl, const volatile bool *stop);
+
+// Waits up to a second for the replies of the pending commands and closes the socket
+void hostapd_ctrl_close(struct hostapd_ctrl *ctrl);
+
+/*
+ * Sends a command without waiting for the reply. cb is called from hostapd_ctrl_poll()
+ * when the reply arrives, if not NULL. When HOSTAPD_CTRL_MAX_PENDING commands are
+ * pending, waits for the reply of the oldest first. Returns 0 or -1.
+ */
+int hostapd_ctrl_send(struct hostapd_ctrl *ctrl, const char *cmd, hostapd_ctrl_cb cb, void *arg);
+
+/*
+ * Handles the replies that arrive within timeout_ms, 0 to only handle those that
+ * already arrived. Returns the number of replies or -1 on errors.
+ */
+int hostapd_ctrl_poll(struct hostapd_ctrl *ctrl, int timeout_ms);
+
+// Prints the number, failures and latency histogram of each command
+void hostapd_ctrl_print_stats(const struct hostapd_ctrl *ctrl);
+
+#endif //_HOSTAPD_CTRL_H_
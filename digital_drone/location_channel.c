@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#include <string.h>
+#include "location_channel.h"
+
+void location_channel_init(struct location_channel *channel) {
+    memset(channel, 0, sizeof(*channel));
+}
+
+void location_channel_publish(struct location_channel *channel, const struct location_fix *fix) {
+    uint32_t words[LOCATION_CHANNEL_WORDS] = { 0 };
+    uint32_t sequence = __atomic_load_n(&channel->sequence, __ATOMIC_RELAXED);
+
+    memcpy(words, fix, sizeof(*fix));
+
+    // The odd sequence must be visible before any of the new words
+    __atomic_store_n(&channel->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (size_t i = 0; i < LOCATION_CHANNEL_WORDS; i++)
+        __atomic_store_n(&channel->words[i], words[i], __ATOMIC_RELAXED);
+    __atomic_store_n(&channel->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+bool location_channel_read(struct location_channel *channel, struct location_fix *fix, uint32_t *seen) {
+    uint32_t words[LOCATION_CHANNEL_WORDS];
+    uint32_t before, after;
+
+    do {
+        before = __atomic_load_n(&channel->sequence, __ATOMIC_ACQUIRE);
+        if (before == *seen)
+            return false;
+        if (before & 1)
+            continue;   // The gps thread is in the middle of a publish, which takes a few stores
+
+        for (size_t i = 0; i < LOCATION_CHANNEL_WORDS; i++)
+            words[i] = __atomic_load_n(&channel->words[i], __ATOMIC_RELAXED);
+
+        // The words must be read before the sequence is checked again
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&channel->sequence, __ATOMIC_RELAXED);
+    } while ((before & 1) || before != after);
+
+    memcpy(fix, words, sizeof(*fix));
+    *seen = after;
+    return true;
+}
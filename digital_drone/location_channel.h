@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#ifndef _LOCATION_CHANNEL_H_
+#define _LOCATION_CHANNEL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <opendroneid.h>
+
+// A Location and the CLOCK_MONOTONIC time at which the gps thread read its fix from gpsd
+struct location_fix {
+    ODID_Location_data location;
+    uint64_t read_ns;
+};
+
+#define LOCATION_CHANNEL_WORDS ((sizeof(struct location_fix) + sizeof(uint32_t) - 1) / sizeof(uint32_t))
+
+/*
+ * Hands the latest Location of the gps thread to the transmitter with a seqlock. The gps thread
+ * publishes without waiting for the transmitter, and the transmitter reads without blocking the
+ * gps thread. A read that overlaps a publish is retried, so the transmitter never gets a mix of
+ * two fixes, e.g. the latitude of one and the longitude of the other. Only one thread may publish.
+ */
+struct location_channel {
+    uint32_t sequence;                      // Odd while a Location is published, 0 before the first
+    uint32_t words[LOCATION_CHANNEL_WORDS]; // The fix, copied with atomic loads and stores
+};
+
+void location_channel_init(struct location_channel *channel);
+
+void location_channel_publish(struct location_channel *channel, const struct location_fix *fix);
+
+/*
+ * Copies the latest fix to fix if it was published after the one that *seen refers to,
+ * which starts at 0, and updates *seen. Returns true if fix was updated.
+ */
+bool location_channel_read(struct location_channel *channel, struct location_fix *fix, uint32_t *seen);
+
+#endif //_LOCATION_CHANNEL_H_
@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include "drivers/nl80211_copy.h"
+#include "nl80211_inject.h"
+
+#define NL_ATTRS_SIZE 64
+#define NL_RX_BUF_SIZE 8192
+
+/*
+ * The netlink messages are built by hand instead of with libnl, so sending a frame needs
+ * no allocation: the request header is on the stack and the frame is appended with an iovec.
+ */
+struct nl_request {
+    struct nlmsghdr nlh;
+    struct genlmsghdr genl;
+    uint8_t attrs[NL_ATTRS_SIZE];
+};
+
+struct interface_info {
+    uint32_t type;
+    uint8_t *mac;
+};
+
+typedef void (*reply_fn)(const struct nlmsghdr *nlh, void *arg);
+
+static int nl_fd = -1;
+static int packet_fd = -1;
+static uint16_t nl80211_family;
+static uint32_t nl_seq;
+static int if_index;
+static uint32_t if_type;
+static uint8_t rx_buf[NL_RX_BUF_SIZE] __attribute__((aligned(NLMSG_ALIGNTO)));
+
+// A radiotap header without fields, the driver picks the rate
+static const uint8_t radiotap_header[] = { 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00 };
+static const uint8_t padding[NLA_ALIGNTO] = { 0 };
+
+static void request_init(struct nl_request *req, uint16_t family, uint8_t cmd) {
+    memset(req, 0, sizeof(*req));
+    req->nlh.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+    req->nlh.nlmsg_type = family;
+    req->nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+    req->nlh.nlmsg_seq = ++nl_seq;
+    req->genl.cmd = cmd;
+    req->genl.version = 1;
+}
+
+static struct nlattr *request_next_attr(struct nl_request *req) {
+    return (struct nlattr *) ((uint8_t *) req + NLMSG_ALIGN(req->nlh.nlmsg_len));
+}
+
+static void request_put(struct nl_request *req, uint16_t type, const void *data, uint16_t len) {
+    struct nlattr *attr = request_next_attr(req);
+
+    attr->nla_type = type;
+    attr->nla_len = NLA_HDRLEN + len;
+    if (len)
+        memcpy((uint8_t *) attr + NLA_HDRLEN, data, len);
+    req->nlh.nlmsg_len = NLMSG_ALIGN(req->nlh.nlmsg_len) + NLA_ALIGN(attr->nla_len);
+}
+
+static const struct nlattr *find_attr(const struct nlmsghdr *nlh, uint16_t type) {
+    const struct nlattr *attr = (const struct nlattr *) ((const uint8_t *) NLMSG_DATA(nlh) + GENL_HDRLEN);
+    int len = (int) nlh->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+
+    while (len >= NLA_HDRLEN && attr->nla_len >= NLA_HDRLEN && attr->nla_len <= len) {
+        if ((attr->nla_type & NLA_TYPE_MASK) == type)
+            return attr;
+        len -= NLA_ALIGN(attr->nla_len);
+        attr = (const struct nlattr *) ((const uint8_t *) attr + NLA_ALIGN(attr->nla_len));
+    }
+    return NULL;
+}
+
+static const void *attr_data(const struct nlattr *attr) {
+    return (const uint8_t *) attr + NLA_HDRLEN;
+}
+
+// Reads the replies to the last request until its ack. Returns 0 or a negative errno
+static int request_wait(uint32_t seq, reply_fn fn, void *arg) {
+    for (;;) {
+        int len = (int) recv(nl_fd, rx_buf, sizeof(rx_buf), 0);
+        if (len < 0) {
+            if (errno == EINTR)
+                continue;
+            return -errno;
+        }
+
+        for (struct nlmsghdr *nlh = (struct nlmsghdr *) rx_buf; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_seq != seq)
+                continue;
+            if (nlh->nlmsg_type == NLMSG_ERROR)
+                return ((const struct nlmsgerr *) NLMSG_DATA(nlh))->error;
+            if (nlh->nlmsg_type == NLMSG_DONE)
+                return 0;
+            if (fn)
+                fn(nlh, arg);
+        }
+    }
+}
+
+// Sends the request, followed by payload as the data of its last attribute if not NULL
+static int request_send(struct nl_request *req, uint16_t type, const uint8_t *payload, size_t len,
+                        reply_fn fn, void *arg) {
+    struct iovec iov[3] = { { req, req->nlh.nlmsg_len } };
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 1 };
+
+    if (payload) {
+        struct nlattr *attr = request_next_attr(req);
+        attr->nla_type = type;
+        attr->nla_len = (uint16_t) (NLA_HDRLEN + len);
+        iov[0].iov_len = NLMSG_ALIGN(req->nlh.nlmsg_len) + NLA_HDRLEN;
+        iov[1].iov_base = (void *) payload;
+        iov[1].iov_len = len;
+        iov[2].iov_base = (void *) padding;
+        iov[2].iov_len = NLA_ALIGN(len) - len;
+        msg.msg_iovlen = 3;
+        req->nlh.nlmsg_len = (uint32_t) (iov[0].iov_len + NLA_ALIGN(len));
+    }
+
+    if (sendmsg(nl_fd, &msg, 0) < 0)
+        return -errno;
+    return request_wait(req->nlh.nlmsg_seq, fn, arg);
+}
+
+static void family_reply(const struct nlmsghdr *nlh, void *arg) {
+    const struct nlattr *attr = find_attr(nlh, CTRL_ATTR_FAMILY_ID);
+    if (attr)
+        *(uint16_t *) arg = *(const uint16_t *) attr_data(attr);
+}
+
+static void interface_reply(const struct nlmsghdr *nlh, void *arg) {
+    struct interface_info *info = arg;
+    const struct nlattr *attr;
+
+    if ((attr = find_attr(nlh, NL80211_ATTR_IFTYPE)))
+        info->type = *(const uint32_t *) attr_data(attr);
+    if ((attr = find_attr(nlh, NL80211_ATTR_MAC)))
+        memcpy(info->mac, attr_data(attr), 6);
+}
+
+static int open_packet_socket(void) {
+    struct sockaddr_ll addr = {
+        .sll_family = AF_PACKET,
+        .sll_protocol = htons(ETH_P_ALL),
+        .sll_ifindex = if_index,
+    };
+
+    packet_fd = socket(AF_PACKET, SOCK_RAW | SOCK_CLOEXEC, htons(ETH_P_ALL));
+    if (packet_fd < 0)
+        return -errno;
+    if (bind(packet_fd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+        return -errno;
+    return 0;
+}
+
+int inject_open(const char *iface, uint8_t *mac) {
+    struct sockaddr_nl addr = { .nl_family = AF_NETLINK };
+    struct interface_info info = { .type = NL80211_IFTYPE_UNSPECIFIED, .mac = mac };
+    struct nl_request req;
+    uint32_t index;
+    int ret;
+
+    if_index = (int) if_nametoindex(iface);
+    if (if_index == 0) {
+        fprintf(stderr, "Error: No Wi-Fi interface %s\n", iface);
+        return -1;
+    }
+
+    nl_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+    if (nl_fd < 0 || bind(nl_fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        perror("netlink");
+        inject_close();
+        return -1;
+    }
+
+    request_init(&req, GENL_ID_CTRL, CTRL_CMD_GETFAMILY);
+    request_put(&req, CTRL_ATTR_FAMILY_NAME, NL80211_GENL_NAME, sizeof(NL80211_GENL_NAME));
+    ret = request_send(&req, 0, NULL, 0, family_reply, &nl80211_family);
+    if (ret < 0 || nl80211_family == 0) {
+        fprintf(stderr, "Error: nl80211 not found: %s\n", strerror(ret < 0 ? -ret : ENOENT));
+        inject_close();
+        return -1;
+    }
+
+    index = (uint32_t) if_index;
+    request_init(&req, nl80211_family, NL80211_CMD_GET_INTERFACE);
+    request_put(&req, NL80211_ATTR_IFINDEX, &index, sizeof(index));
+    ret = request_send(&req, 0, NULL, 0, interface_reply, &info);
+    if (ret < 0) {
+        fprintf(stderr, "Error: %s is not a Wi-Fi interface: %s\n", iface, strerror(-ret));
+        inject_close();
+        return -1;
+    }
+    if_type = info.type;
+
+    if (if_type == NL80211_IFTYPE_MONITOR && (ret = open_packet_socket()) < 0) {
+        fprintf(stderr, "Error: Failed to open a packet socket on %s: %s\n", iface, strerror(-ret));
+        inject_close();
+        return -1;
+    }
+    return 0;
+}
+
+void inject_close(void) {
+    if (packet_fd >= 0)
+        close(packet_fd);
+    if (nl_fd >= 0)
+        close(nl_fd);
+    packet_fd = nl_fd = -1;
+}
+
+bool inject_is_monitor(void) {
+    return if_type == NL80211_IFTYPE_MONITOR;
+}
+
+int inject_frame(const uint8_t *frame, size_t len) {
+    if (inject_is_monitor()) {
+        struct iovec iov[2] = { { (void *) radiotap_header, sizeof(radiotap_header) },
+                                { (void *) frame, len } };
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+
+        if (sendmsg(packet_fd, &msg, 0) < 0)
+            return -errno;
+        return 0;
+    }
+
+    // Without waiting for the ack of the receiver, the kernel only replies with the netlink ack
+    struct nl_request req;
+    uint32_t index = (uint32_t) if_index;
+    request_init(&req, nl80211_family, NL80211_CMD_FRAME);
+    request_put(&req, NL80211_ATTR_IFINDEX, &index, sizeof(index));
+    request_put(&req, NL80211_ATTR_DONT_WAIT_FOR_ACK, NULL, 0);
+    return request_send(&req, NL80211_ATTR_FRAME, frame, len, NULL, NULL);
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#ifndef _NL80211_INJECT_H_
+#define _NL80211_INJECT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Sends prebuilt IEEE 802.11 frames directly on a Wi-Fi interface, without hostapd.
+ * On a monitor interface, any frame incl. Beacons is injected through a packet socket.
+ * On other interfaces, e.g. a station interface, NAN action frames are sent with the
+ * nl80211 FRAME command, like core-c/wifi/sender does.
+ * The sockets are opened once and no memory is allocated per frame.
+ */
+
+// Returns 0 and the MAC address of the interface, or -1
+int inject_open(const char *iface, uint8_t *mac);
+void inject_close(void);
+
+// Beacons can only be injected on a monitor interface
+bool inject_is_monitor(void);
+
+// Returns 0 or a negative errno
+int inject_frame(const uint8_t *frame, size_t len);
+
+#endif //_NL80211_INJECT_H_
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "scheduler.h"
+
+#define NSEC_PER_SEC 1000000000ULL
+
+uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * NSEC_PER_SEC + (uint64_t) ts.tv_nsec;
+}
+
+void sched_init(struct scheduler *sched) {
+    memset(sched, 0, sizeof(*sched));
+}
+
+int sched_add(struct scheduler *sched, const char *name, double rate_hz, uint64_t offset_ns,
+              sched_fn fn, void *arg) {
+    if (sched->count >= SCHED_MAX_SLOTS || rate_hz <= 0 || !fn)
+        return -1;
+
+    struct sched_slot *slot = &sched->slots[sched->count];
+    memset(slot, 0, sizeof(*slot));
+    snprintf(slot->name, sizeof(slot->name), "%s", name);
+    slot->fn = fn;
+    slot->arg = arg;
+    slot->period_ns = (uint64_t) (NSEC_PER_SEC / rate_hz + 0.5);
+    if (slot->period_ns == 0)
+        slot->period_ns = 1;
+    slot->deadline_ns = offset_ns; // Made absolute by sched_run()
+    return sched->count++;
+}
+
+static struct sched_slot *next_slot(struct scheduler *sched) {
+    struct sched_slot *next = &sched->slots[0];
+    for (int i = 1; i < sched->count; i++) {
+        if (sched->slots[i].deadline_ns < next->deadline_ns)
+            next = &sched->slots[i];
+    }
+    return next;
+}
+
+static void call_slot(struct sched_slot *slot) {
+    uint64_t start = now_ns();
+    slot->fn(slot->arg);
+    uint64_t busy = now_ns() - start;
+
+    slot->busy_sum_ns += busy;
+    if (busy > slot->busy_max_ns)
+        slot->busy_max_ns = busy;
+}
+
+static void update_stats(struct sched_slot *slot, uint64_t start) {
+    uint64_t late = start > slot->deadline_ns ? start - slot->deadline_ns : 0;
+    slot->late_sum_ns += late;
+    if (late > slot->late_max_ns)
+        slot->late_max_ns = late;
+
+    if (slot->count) {
+        uint64_t interval = start - slot->last_ns;
+        uint64_t jitter = interval > slot->period_ns ? interval - slot->period_ns :
+                                                       slot->period_ns - interval;
+        slot->jitter_sum_ns += jitter;
+        if (jitter > slot->jitter_max_ns)
+            slot->jitter_max_ns = jitter;
+    } else {
+        slot->first_ns = start;
+    }
+    slot->last_ns = start;
+    slot->count++;
+}
+
+void sched_run(struct scheduler *sched, const volatile bool *stop, double duration_s) {
+    if (sched->count == 0)
+        return;
+
+    struct timespec realtime;
+    clock_gettime(CLOCK_REALTIME, &realtime);
+    uint64_t start = now_ns();
+    sched->realtime_ns = (int64_t) ((uint64_t) realtime.tv_sec * NSEC_PER_SEC + (uint64_t) realtime.tv_nsec) -
+                         (int64_t) start;
+
+    uint64_t end = duration_s > 0 ? start + (uint64_t) (duration_s * NSEC_PER_SEC) : UINT64_MAX;
+    for (int i = 0; i < sched->count; i++)
+        sched->slots[i].deadline_ns += start;
+
+    while (!*stop) {
+        struct sched_slot *slot = next_slot(sched);
+        if (slot->deadline_ns >= end)
+            break;
+
+        if (sched->simulated) {
+            sched->now_ns = slot->deadline_ns;
+            update_stats(slot, sched->now_ns);
+            call_slot(slot);
+            slot->deadline_ns += slot->period_ns;
+            continue;
+        }
+
+        struct timespec ts = { .tv_sec = (time_t) (slot->deadline_ns / NSEC_PER_SEC),
+                               .tv_nsec = (long) (slot->deadline_ns % NSEC_PER_SEC) };
+        int ret = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        if (ret == EINTR)
+            continue; // Check *stop, then sleep again for the same deadline
+        if (ret != 0) {
+            fprintf(stderr, "clock_nanosleep failed: %s\n", strerror(ret));
+            return;
+        }
+
+        uint64_t now = now_ns();
+        sched->now_ns = now;
+        update_stats(slot, now);
+        call_slot(slot);
+
+        // Catch up after a short delay, but don't send a burst after a long one
+        slot->deadline_ns += slot->period_ns;
+        now = now_ns();
+        if (now >= slot->deadline_ns + slot->period_ns) {
+            uint64_t missed = (now - slot->deadline_ns) / slot->period_ns;
+            slot->deadline_ns += missed * slot->period_ns;
+            slot->skipped += missed;
+        }
+    }
+}
+
+void sched_realtime(const struct scheduler *sched, struct timespec *ts) {
+    uint64_t realtime = (uint64_t) ((int64_t) sched->now_ns + sched->realtime_ns);
+    ts->tv_sec = (time_t) (realtime / NSEC_PER_SEC);
+    ts->tv_nsec = (long) (realtime % NSEC_PER_SEC);
+}
+
+void sched_print_stats(const struct scheduler *sched) {
+    printf("%-24s %10s %11s %8s %17s %19s %8s %17s\n", "Slot", "Target Hz", "Achieved Hz", "Sent",
+           "Late avg/max ms", "Jitter avg/max ms", "Skipped", "Busy avg/max ms");
+    for (int i = 0; i < sched->count; i++) {
+        const struct sched_slot *slot = &sched->slots[i];
+        double target = (double) NSEC_PER_SEC / (double) slot->period_ns;
+        double achieved = 0, late_avg = 0, jitter_avg = 0, busy_avg = 0;
+
+        if (slot->count > 1) {
+            achieved = (double) (slot->count - 1) * NSEC_PER_SEC / (double) (slot->last_ns - slot->first_ns);
+            jitter_avg = (double) slot->jitter_sum_ns / (double) (slot->count - 1) / 1e6;
+        }
+        if (slot->count) {
+            late_avg = (double) slot->late_sum_ns / (double) slot->count / 1e6;
+            busy_avg = (double) slot->busy_sum_ns / (double) slot->count / 1e6;
+        }
+
+        printf("%-24s %10.3f %11.3f %8llu %8.3f/%8.3f %9.3f/%9.3f %8llu %8.3f/%8.3f\n", slot->name, target,
+               achieved, (unsigned long long) slot->count, late_avg, (double) slot->late_max_ns / 1e6,
+               jitter_avg, (double) slot->jitter_max_ns / 1e6, (unsigned long long) slot->skipped,
+               busy_avg, (double) slot->busy_max_ns / 1e6);
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#ifndef _SCHEDULER_H_
+#define _SCHEDULER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#define SCHED_MAX_SLOTS 32
+#define SCHED_NAME_SIZE 32
+
+typedef void (*sched_fn)(void *arg);
+
+// A function that is called periodically, e.g. sending one message type on one transport
+struct sched_slot {
+    char name[SCHED_NAME_SIZE];
+    sched_fn fn;
+    void *arg;
+    uint64_t period_ns;
+    uint64_t deadline_ns;   // CLOCK_MONOTONIC time of the next call
+
+    // Statistics
+    uint64_t count;
+    uint64_t first_ns;      // Start of the first call
+    uint64_t last_ns;       // Start of the last call
+    uint64_t late_sum_ns;   // Start of a call after its deadline
+    uint64_t late_max_ns;
+    uint64_t jitter_sum_ns; // Difference between the time from the last call and the period
+    uint64_t jitter_max_ns;
+    uint64_t skipped;       // Deadlines dropped because the slot fell more than a period behind
+    uint64_t busy_sum_ns;   // Time spent in the calls, e.g. to compare transports
+    uint64_t busy_max_ns;
+};
+
+struct scheduler {
+    struct sched_slot slots[SCHED_MAX_SLOTS];
+    int count;
+
+    bool simulated;         // Run in virtual time without sleeping, e.g. when only writing files
+    uint64_t now_ns;        // CLOCK_MONOTONIC or virtual time of the running call
+    int64_t realtime_ns;    // CLOCK_REALTIME minus CLOCK_MONOTONIC when sched_run() started
+};
+
+// CLOCK_MONOTONIC time in ns
+uint64_t now_ns(void);
+
+void sched_init(struct scheduler *sched);
+
+/*
+ * Adds a slot that calls fn(arg) rate_hz times per second. The first call is
+ * offset_ns after sched_run() starts, which allows spreading slots with the
+ * same rate over the period. Returns the slot number or -1.
+ */
+int sched_add(struct scheduler *sched, const char *name, double rate_hz, uint64_t offset_ns,
+              sched_fn fn, void *arg);
+
+/*
+ * Calls the slot functions at their deadlines until *stop is set or for
+ * duration_s seconds, if > 0. Deadlines advance by exactly one period, so
+ * the time a call takes does not make the rate drift. A simulated scheduler
+ * calls the slots right away, as if each call started at its deadline.
+ */
+void sched_run(struct scheduler *sched, const volatile bool *stop, double duration_s);
+
+// Wall clock time of the running call, also in virtual time
+void sched_realtime(const struct scheduler *sched, struct timespec *ts);
+
+// Prints the target and achieved rate, lateness, jitter and busy time of each slot
+void sched_print_stats(const struct scheduler *sched);
+
+#endif //_SCHEDULER_H_
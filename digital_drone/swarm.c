@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "swarm.h"
+
+#define METERS_PER_DEG_LAT 111132.954
+#define SWARM_AREA_M 2000.0       // Side of the square the generated drones fly in
+#define SWARM_SEED 12345
+
+static double random_range(unsigned int *seed, double min, double max) {
+    return min + (max - min) * rand_r(seed) / (double) RAND_MAX;
+}
+
+static int swarm_alloc(struct swarm *swarm, int count) {
+    memset(swarm, 0, sizeof(*swarm));
+    if (count <= 0 || count > SWARM_MAX_DRONES) {
+        fprintf(stderr, "Error: A swarm has 1 to %d drones\n", SWARM_MAX_DRONES);
+        return -1;
+    }
+    swarm->drones = calloc((size_t) count, sizeof(*swarm->drones));
+    if (!swarm->drones)
+        return -1;
+    return 0;
+}
+
+// Sets the ID, MAC address and operator location of a drone and encodes its static messages
+static void init_drone(struct swarm *swarm, int index, const struct ODID_UAS_Data *template,
+                       const char *uas_id) {
+    struct swarm_drone *drone = &swarm->drones[index];
+
+    // The template has the data of all messages, but not necessarily their Valid flags
+    drone->uasData = *template;
+    for (int i = 0; i < ODID_BASIC_ID_MAX_MESSAGES; i++)
+        drone->uasData.BasicIDValid[i] = drone->uasData.BasicID[i].UASID[0] != 0;
+    for (int i = 0; i < ODID_AUTH_MAX_PAGES; i++)
+        drone->uasData.AuthValid[i] = i <= template->Auth[0].LastPageIndex;
+    drone->uasData.LocationValid = 1;
+    drone->uasData.SelfIDValid = 1;
+    drone->uasData.SystemValid = 1;
+    drone->uasData.OperatorIDValid = 1;
+    memset(drone->uasData.BasicID[0].UASID, 0, sizeof(drone->uasData.BasicID[0].UASID));
+    strncpy(drone->uasData.BasicID[0].UASID, uas_id, ODID_ID_SIZE);
+    drone->uasData.System.OperatorLatitude = drone->center_lat;
+    drone->uasData.System.OperatorLongitude = drone->center_lon;
+
+    // Locally administered unicast address. The BT5 random static address is derived from it
+    drone->mac[0] = 0x02;
+    drone->mac[1] = 0x5D;
+    drone->mac[2] = 0x00;
+    drone->mac[3] = (uint8_t) (index >> 16);
+    drone->mac[4] = (uint8_t) (index >> 8);
+    drone->mac[5] = (uint8_t) index;
+
+    odid_initPackCache(&drone->pack_cache);
+    odid_packCacheUpdate(&drone->pack_cache, &drone->uasData);
+    swarm->count = index + 1;
+}
+
+int swarm_generate(struct swarm *swarm, int count, const struct ODID_UAS_Data *uasData) {
+    unsigned int seed = SWARM_SEED;
+    double m_per_deg_lon = METERS_PER_DEG_LAT * cos(uasData->Location.Latitude * M_PI / 180);
+
+    if (swarm_alloc(swarm, count) < 0)
+        return -1;
+
+    for (int i = 0; i < count; i++) {
+        struct swarm_drone *drone = &swarm->drones[i];
+        char uas_id[ODID_ID_SIZE + 1];
+
+        drone->center_lat = uasData->Location.Latitude +
+                            random_range(&seed, -SWARM_AREA_M / 2, SWARM_AREA_M / 2) / METERS_PER_DEG_LAT;
+        drone->center_lon = uasData->Location.Longitude +
+                            random_range(&seed, -SWARM_AREA_M / 2, SWARM_AREA_M / 2) / m_per_deg_lon;
+        drone->radius_m = random_range(&seed, 20, 200);
+        drone->speed_mps = random_range(&seed, 2, 15);
+        drone->phase_rad = random_range(&seed, 0, 2 * M_PI);
+
+        snprintf(uas_id, sizeof(uas_id), "SWARM%015d", i);
+        init_drone(swarm, i, uasData, uas_id);
+        swarm->drones[i].uasData.Location.AltitudeGeo = (float) random_range(&seed, 50, 150);
+        swarm->drones[i].uasData.Location.Height = swarm->drones[i].uasData.Location.AltitudeGeo -
+                                                   (uasData->Location.AltitudeGeo - uasData->Location.Height);
+    }
+    return 0;
+}
+
+int swarm_load(struct swarm *swarm, const char *file, const struct ODID_UAS_Data *uasData) {
+    FILE *fp = fopen(file, "r");
+    char line[256];
+    int count = 0, n = 0;
+
+    if (!fp) {
+        perror(file);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        char *p = line + strspn(line, " \t");
+        if (*p && *p != '#' && *p != '\n')
+            count++;
+    }
+    if (swarm_alloc(swarm, count) < 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    rewind(fp);
+    for (int line_nr = 1; fgets(line, sizeof(line), fp); line_nr++) {
+        char uas_id[ODID_ID_SIZE + 1];
+        double lat, lon, alt, radius = 50, speed = 5;
+        char *p = line + strspn(line, " \t");
+
+        if (!*p || *p == '#' || *p == '\n')
+            continue;
+        if (sscanf(p, "%20s %lf %lf %lf %lf %lf", uas_id, &lat, &lon, &alt, &radius, &speed) < 4 ||
+            radius <= 0 || speed < 0) {
+            fprintf(stderr, "Error: %s:%d: Expected <UAS ID> <lat> <lon> <alt> [<radius> [<speed>]]\n",
+                    file, line_nr);
+            fclose(fp);
+            swarm_free(swarm);
+            return -1;
+        }
+
+        struct swarm_drone *drone = &swarm->drones[n];
+        drone->center_lat = lat;
+        drone->center_lon = lon;
+        drone->radius_m = radius;
+        drone->speed_mps = speed;
+        drone->phase_rad = 2 * M_PI * n / count;
+        init_drone(swarm, n, uasData, uas_id);
+        drone->uasData.Location.AltitudeGeo = (float) alt;
+        drone->uasData.Location.Height = (float) alt - (uasData->Location.AltitudeGeo - uasData->Location.Height);
+        n++;
+    }
+    fclose(fp);
+    return 0;
+}
+
+void swarm_free(struct swarm *swarm) {
+    free(swarm->drones);
+    memset(swarm, 0, sizeof(*swarm));
+}
+
+// Moves the drone counterclockwise on its circle
+static void update_location(struct swarm_drone *drone, double secs, const struct timespec *now) {
+    struct ODID_Location_data *location = &drone->uasData.Location;
+    double angle = drone->phase_rad + drone->speed_mps / drone->radius_m * secs;
+    double m_per_deg_lon = METERS_PER_DEG_LAT * cos(drone->center_lat * M_PI / 180);
+
+    location->Latitude = drone->center_lat + drone->radius_m * sin(angle) / METERS_PER_DEG_LAT;
+    location->Longitude = drone->center_lon + drone->radius_m * cos(angle) / m_per_deg_lon;
+    location->SpeedHorizontal = (float) drone->speed_mps;
+    location->Direction = (float) fmod(360.0 - fmod(angle * 180 / M_PI, 360.0), 360.0);
+
+    // Tenths of seconds since the full hour
+    location->TimeStamp = (float) (now->tv_sec % 3600) + (float) (now->tv_nsec / 100000000) / 10;
+
+    odid_packCacheSetLocation(&drone->pack_cache, location);
+}
+
+struct swarm_drone *swarm_next(struct swarm *swarm, enum transport transport, const struct timespec *now) {
+    struct swarm_drone *drone = &swarm->drones[swarm->next[transport]];
+    double secs = (double) now->tv_sec + (double) now->tv_nsec * 1e-9;
+
+    if (swarm->start_secs == 0)
+        swarm->start_secs = secs;
+    swarm->next[transport] = (swarm->next[transport] + 1) % swarm->count;
+    update_location(drone, secs - swarm->start_secs, now);
+    return drone;
+}
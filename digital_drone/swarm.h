@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#ifndef _SWARM_H_
+#define _SWARM_H_
+
+#include <time.h>
+#include <opendroneid.h>
+#include "utils.h"
+
+#define SWARM_MAX_DRONES 4096
+
+// A virtual drone flying in a circle around its center
+struct swarm_drone {
+    struct ODID_UAS_Data uasData;
+    struct ODID_PackCache pack_cache;
+    uint8_t mac[6];
+    uint8_t msg_counters[TRANSPORT_AMOUNT]; // Message pack counters
+    uint8_t message_counters[ODID_MSG_COUNTER_AMOUNT]; // Single message counters on BT4
+    int next_message;                       // Position in the single messages on BT4
+    uint8_t bt_sets[TRANSPORT_AMOUNT];      // BT4 and BT5 advertising sets
+
+    double center_lat;
+    double center_lon;
+    double radius_m;
+    double speed_mps;
+    double phase_rad;                       // Position on the circle at the start
+};
+
+struct swarm {
+    struct swarm_drone *drones;
+    int count;
+    int next[TRANSPORT_AMOUNT];             // The drone that sends the next pack on each transport
+    double start_secs;                      // CLOCK_REALTIME of the first pack
+};
+
+/*
+ * Creates count drones around the location of uasData, which is the template for
+ * all other data. Returns 0 or -1.
+ */
+int swarm_generate(struct swarm *swarm, int count, const struct ODID_UAS_Data *uasData);
+
+/*
+ * Loads one drone per line from a profile file:
+ *     <UAS ID> <latitude> <longitude> <altitude m> [<radius m> [<speed m/s>]]
+ * Empty lines and lines starting with # are skipped. Returns 0 or -1.
+ */
+int swarm_load(struct swarm *swarm, const char *file, const struct ODID_UAS_Data *uasData);
+
+void swarm_free(struct swarm *swarm);
+
+/*
+ * Returns the drone that sends the next pack on the transport, with its Location
+ * updated to the point of its flight path at the wall clock time now.
+ */
+struct swarm_drone *swarm_next(struct swarm *swarm, enum transport transport, const struct timespec *now);
+
+#endif //_SWARM_H_
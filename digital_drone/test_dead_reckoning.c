@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2021, Soren Friis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Open Drone ID Linux transmitter example.
+ *
+ * Maintainer: Soren Friis
+ * friissoren2@gmail.com
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include "dead_reckoning.h"
+
+#define NSEC_PER_SEC 1000000000ULL
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+// Flying north at 10 m/s and climbing at 1 m/s
+static void make_fix(ODID_Location_data *fix) {
+    odid_initLocationData(fix);
+    fix->Latitude = 51.4769999;
+    fix->Longitude = 0.0005;
+    fix->Direction = 0;
+    fix->SpeedHorizontal = 10;
+    fix->SpeedVertical = 1;
+    fix->AltitudeGeo = 100;
+    fix->HorizAccuracy = ODID_HOR_ACC_3_METER;
+    fix->VertAccuracy = ODID_VER_ACC_3_METER;
+    fix->SpeedAccuracy = ODID_SPEED_ACC_1_METERS_PER_SECOND;
+    fix->TimeStamp = 100;
+}
+
+static void test_extrapolate(void) {
+    ODID_Location_data fix, location;
+
+    make_fix(&fix);
+    dead_reckoning_extrapolate(&fix, 1, &location);
+    CHECK(fabs(dead_reckoning_distance(&fix, &location) - 10) < 0.01);
+    CHECK(location.Latitude > fix.Latitude);
+    CHECK(fabsf(location.AltitudeGeo - 101) < 0.001f);
+    CHECK(fabsf(location.TimeStamp - 101) < 0.001f);
+    CHECK(location.HorizAccuracy == ODID_HOR_ACC_10_METER);
+
+    dead_reckoning_extrapolate(&fix, 0, &location);
+    CHECK(location.Latitude == fix.Latitude && location.TimeStamp == fix.TimeStamp);
+}
+
+// Without a newer fix, the Location is held and its time stamp with it
+static void test_held(void) {
+    ODID_Location_data fix, held, location;
+
+    make_fix(&fix);
+    dead_reckoning_extrapolate(&fix, DEAD_RECKONING_MAX_SECS, &held);
+    CHECK(fabsf(held.TimeStamp - (float) (100 + DEAD_RECKONING_MAX_SECS)) < 0.001f);
+
+    for (double secs = DEAD_RECKONING_MAX_SECS + 0.5; secs < 60; secs *= 2) {
+        dead_reckoning_extrapolate(&fix, secs, &location);
+        CHECK(location.Latitude == held.Latitude && location.Longitude == held.Longitude);
+        CHECK(location.AltitudeGeo == held.AltitudeGeo);
+        CHECK(location.TimeStamp == held.TimeStamp);
+        CHECK(location.HorizAccuracy == held.HorizAccuracy);
+        CHECK(location.VertAccuracy == held.VertAccuracy);
+    }
+
+    struct dead_reckoning dr;
+    dead_reckoning_init(&dr);
+    CHECK(!dead_reckoning_predict(&dr, NSEC_PER_SEC, &location));
+    dead_reckoning_update(&dr, &fix, NSEC_PER_SEC);
+    CHECK(dead_reckoning_predict(&dr, 30 * NSEC_PER_SEC, &location));
+    CHECK(location.TimeStamp == held.TimeStamp);
+}
+
+static void test_timestamp(void) {
+    ODID_Location_data fix, location;
+
+    // Seconds since the full hour wrap around
+    make_fix(&fix);
+    fix.TimeStamp = MAX_TIMESTAMP - 0.5f;
+    dead_reckoning_extrapolate(&fix, 1, &location);
+    CHECK(fabsf(location.TimeStamp - 0.5f) < 0.001f);
+
+    fix.TimeStamp = INV_TIMESTAMP;
+    dead_reckoning_extrapolate(&fix, 1, &location);
+    CHECK(location.TimeStamp == INV_TIMESTAMP);
+}
+
+int main(void) {
+    test_extrapolate();
+    test_held();
+    test_timestamp();
+
+    printf("dead reckoning test: %s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -13,35 +13,91 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <pthread.h>
-#include <semaphore.h>
 #include <signal.h>
 #include <errno.h>
 #include <sys/resource.h>
-#include "ap_interface.h"
 #include "bluetooth.h"
 #include "wifi_beacon.h"
 #include "gpsmod.h"
+#include "scheduler.h"
+#include "swarm.h"
+#include "file_transport.h"
+#include "location_channel.h"
+#include "dead_reckoning.h"
+#include "nl80211_inject.h"
 
-sem_t semaphore;
-pthread_t id, gps_thread;
+pthread_t gps_thread;
 
 #define MINIMUM(a,b) (((a)<(b))?(a):(b))
 
 #define BASIC_ID_POS_ZERO 0
 #define BASIC_ID_POS_ONE 1
 
+// ASTM F3411 requires the Location message at least every second and the static messages
+// at least every three seconds. The static messages are sent at a third of the Location rate.
+#define DEFAULT_RATE_HZ 1.0
+#define STATIC_RATE_DIVIDER 3
+#define DEFAULT_DURATION_SECS 40
+
+// Wi-Fi frames written to a pcap file look like the Beacons of beacon.conf
+#define PCAP_SSID "DroneIDTest"
+#define PCAP_BEACON_INTERVAL_TU 200
+#define PCAP_FRAME_SIZE 1024
+
+// The messages that are sent one at a time when message packs are not used
+enum single_message {
+    MSG_BASIC_ID_0,
+    MSG_BASIC_ID_1,
+    MSG_LOCATION,
+    MSG_AUTH_0,
+    MSG_AUTH_1,
+    MSG_AUTH_2,
+    MSG_SELF_ID,
+    MSG_SYSTEM,
+    MSG_OPERATOR_ID,
+    MSG_AMOUNT,
+    MSG_PACK = MSG_AMOUNT,
+    MSG_SWARM,      // The single messages of all drones of a swarm, see send_swarm_message()
+};
+
+static const char *message_names[MSG_AMOUNT + 2] = {
+    "Basic ID 0", "Basic ID 1", "Location", "Auth 0", "Auth 1", "Auth 2",
+    "Self ID", "System", "Operator ID", "Pack", "Messages",
+};
+static const char *transport_names[TRANSPORT_AMOUNT] = { "Beacon", "BT4", "BT5", "NAN" };
+
+// The address of the single drone in the files, the drones of a swarm have their own
+static const uint8_t file_mac[6] = { 0x02, 0x5D, 0xFF, 0xFF, 0xFF, 0xFF };
+static uint8_t inject_mac[6]; // The address of the injecting interface
+
+// What a scheduler slot sends
+struct transmit_job {
+    enum transport transport;
+    enum single_message message;
+    struct ODID_UAS_Data *uasData;
+};
+
 static struct config_data config = { 0 };
-static bool kill_program = false;
+static volatile bool kill_program = false;
+static struct ODID_PackCache pack_cache;
+static struct scheduler scheduler;
+static struct transmit_job jobs[SCHED_MAX_SLOTS];
+static struct swarm swarm;
 
 static struct fixsource_t source;
 static struct gps_data_t gpsdata;
 
 struct gps_loop_args {
     struct gps_data_t *gpsdata;
-    struct ODID_UAS_Data *uasData;
+    struct ODID_UAS_Data *uasData; // Copy of the data that only the gps thread uses
     int exit_status;
 };
 
+// The fixes of the gps thread. The transmitter moves them on to the time of each Location message,
+// see update_gps_location()
+static struct location_channel gps_channel;
+static struct dead_reckoning gps_motion;
+
 static void fill_example_data(struct ODID_UAS_Data *uasData) {
     uasData->BasicID[BASIC_ID_POS_ZERO].UAType = ODID_UATYPE_HELICOPTER_OR_MULTIROTOR;
     uasData->BasicID[BASIC_ID_POS_ZERO].IDType = ODID_IDTYPE_SERIAL_NUMBER;
@@ -120,18 +176,11 @@ static void fill_example_gps_data(struct ODID_UAS_Data *uasData) {
 }
 
 static void cleanup(int exit_code) {
-    if (config.use_btl || config.use_bt4 || config.use_bt5)
-        close_bluetooth(&config);
+    if ((config.use_btl || config.use_bt4 || config.use_bt5) && !config.btsnoop_file)
+        close_bluetooth();
 
-    if (config.use_beacon) {
-        send_quit();
-
-        int *ptr;
-        pthread_join(id, (void **) &ptr);
-        printf("Return value from ap_interface_init: %i\n", *ptr);
-
-        sem_destroy(&semaphore);
-    }
+    if (config.use_beacon && !config.pcap_file && !config.inject_iface)
+        close_beacon();
 
     if(config.use_gps) {
         int *ptr;
@@ -141,6 +190,10 @@ static void cleanup(int exit_code) {
         gps_close(&gpsdata);
     }
 
+    file_close();
+    inject_close();
+    swarm_free(&swarm);
+
     exit(exit_code);
 }
 
@@ -150,105 +203,424 @@ static void sig_handler(int signo) {
     }
 }
 
-static void send_message(union ODID_Message_encoded *encoded, struct config_data *config, uint8_t msg_counter) {
-    if (config->use_btl)
-        send_bluetooth_message(encoded, msg_counter, config);
-    if (config->use_bt4 || config->use_bt5)
-        send_bluetooth_message_extended_api(encoded, msg_counter, config);
-    if (config->use_beacon)
-        send_beacon_message(encoded, msg_counter);
-    usleep(100000);
+static void write_failed(const char *file) {
+    fprintf(stderr, "Error: Failed to write to %s\n", file);
+    kill_program = true;
 }
 
-// When using the WiFi Beacon transport method, the standards require that all messages are wrapped
-// in a message pack and sent together. This single message send function is only for testing purposes.
-static void send_single_messages(struct ODID_UAS_Data *uasData, struct config_data *config) {
-    union ODID_Message_encoded encoded;
-    memset(&encoded, 0, sizeof(union ODID_Message_encoded));
+// Whether the Wi-Fi frames of the transport are built here instead of by hostapd
+static bool wifi_frames(enum transport transport) {
+    return (config.pcap_file || config.inject_iface) &&
+           (transport == TRANSPORT_BEACON || transport == TRANSPORT_NAN);
+}
 
-    for (int i = 0; i < 1; i++) {
-        if (encodeBasicIDMessage((ODID_BasicID_encoded *) &encoded, &uasData->BasicID[BASIC_ID_POS_ZERO]) != ODID_SUCCESS)
-            printf("Error: Failed to encode Basic ID\n");
-        send_message(&encoded, config, config->msg_counters[ODID_MSG_COUNTER_BASIC_ID]++);
-        if (encodeBasicIDMessage((ODID_BasicID_encoded *) &encoded, &uasData->BasicID[BASIC_ID_POS_ONE]) != ODID_SUCCESS)
-            printf("Error: Failed to encode Basic ID\n");
-        send_message(&encoded, config, config->msg_counters[ODID_MSG_COUNTER_BASIC_ID]++);
+// Injects or writes a Beacon or NAN frame with an encoded message pack to the pcap file
+static void send_wifi_pack(enum transport transport, const struct ODID_MessagePack_encoded *pack_enc,
+                           const uint8_t *mac, uint8_t msg_counter) {
+    uint8_t frame[PCAP_FRAME_SIZE];
+    int len;
+
+    if (transport == TRANSPORT_NAN)
+        len = odid_wifi_build_nan_action_frame_from_pack(pack_enc, (char *) mac, msg_counter,
+                                                         frame, sizeof(frame));
+    else
+        len = odid_wifi_build_beacon_frame_from_pack(pack_enc, (char *) mac, PCAP_SSID, strlen(PCAP_SSID),
+                                                     PCAP_BEACON_INTERVAL_TU, msg_counter,
+                                                     frame, sizeof(frame));
+    if (len < 0) {
+        printf("Error: Failed to build the %s frame\n", transport_names[transport]);
+        return;
+    }
+
+    if (config.inject_iface) {
+        int ret = inject_frame(frame, (size_t) len);
+        if (ret < 0)
+            printf("Error: Failed to inject the %s frame on %s: %s\n", transport_names[transport],
+                   config.inject_iface, strerror(-ret));
+        return;
+    }
+
+    struct timespec now;
+    sched_realtime(&scheduler, &now);
+    if (file_write_wifi_frame(&now, frame, (size_t) len) < 0)
+        write_failed(config.pcap_file);
+}
 
-        if (encodeLocationMessage((ODID_Location_encoded *) &encoded, &uasData->Location) != ODID_SUCCESS)
-            printf("Error: Failed to encode Location\n");
-        send_message(&encoded, config, config->msg_counters[ODID_MSG_COUNTER_LOCATION]++);
+// Writes the advertising data of an encoded message or message pack to the btsnoop file
+static void write_bluetooth(enum transport transport, const uint8_t *data, int size, const uint8_t *mac,
+                            uint8_t msg_counter) {
+    uint8_t ad[BT_ADVERTISING_DATA_MAX];
+    uint8_t address[6];
+    struct timespec now;
+
+    memcpy(address, mac, sizeof(address));
+    address[0] |= 0xC0; // Bluetooth Random Static Address, as set up by init_bluetooth()
+    int len = build_bluetooth_advertising_data(ad, data, size, msg_counter);
+    sched_realtime(&scheduler, &now);
+    if (file_write_bt_advertising(&now, address, transport == TRANSPORT_BT5, ad, len) < 0)
+        write_failed(config.btsnoop_file);
+}
+
+static void send_message(enum transport transport, union ODID_Message_encoded *encoded,
+                         struct config_data *config, uint8_t msg_counter) {
+    if (config->btsnoop_file && transport != TRANSPORT_BEACON) {
+        write_bluetooth(transport, encoded->rawData, ODID_MESSAGE_SIZE, file_mac, msg_counter);
+        return;
+    }
+
+    switch (transport) {
+        case TRANSPORT_BEACON:
+            send_beacon_message(encoded, msg_counter);
+            break;
+        case TRANSPORT_BT4:
+            if (config->use_btl)
+                send_bluetooth_message(encoded, msg_counter, config);
+            if (config->use_bt4)
+                send_bluetooth_message_extended_api(encoded, msg_counter, config->handle_bt4);
+            break;
+        case TRANSPORT_BT5:
+            send_bluetooth_message_extended_api(encoded, msg_counter, config->handle_bt5);
+            break;
+        default:
+            break;
+    }
+}
 
-        if (encodeAuthMessage((ODID_Auth_encoded *) &encoded, &uasData->Auth[0]) != ODID_SUCCESS)
-            printf("Error: Failed to encode Auth 0\n");
-        send_message(&encoded, config, config->msg_counters[ODID_MSG_COUNTER_AUTH]++);
-        if (encodeAuthMessage((ODID_Auth_encoded *) &encoded, &uasData->Auth[1]) != ODID_SUCCESS)
-            printf("Error: Failed to encode Auth 1\n");
-        send_message(&encoded, config, config->msg_counters[ODID_MSG_COUNTER_AUTH]++);
-        if (encodeAuthMessage((ODID_Auth_encoded *) &encoded, &uasData->Auth[2]) != ODID_SUCCESS)
-            printf("Error: Failed to encode Auth 2\n");
-        send_message(&encoded, config, config->msg_counters[ODID_MSG_COUNTER_AUTH]++);
+// Returns the message counter type of the message, or -1 if encoding failed
+static int encode_single_message(struct ODID_UAS_Data *uasData, enum single_message message,
+                                 union ODID_Message_encoded *encoded) {
+    switch (message) {
+        case MSG_BASIC_ID_0:
+        case MSG_BASIC_ID_1:
+            if (encodeBasicIDMessage((ODID_BasicID_encoded *) encoded,
+                                     &uasData->BasicID[message - MSG_BASIC_ID_0]) != ODID_SUCCESS)
+                return -1;
+            return ODID_MSG_COUNTER_BASIC_ID;
+        case MSG_LOCATION:
+            if (encodeLocationMessage((ODID_Location_encoded *) encoded, &uasData->Location) != ODID_SUCCESS)
+                return -1;
+            return ODID_MSG_COUNTER_LOCATION;
+        case MSG_AUTH_0:
+        case MSG_AUTH_1:
+        case MSG_AUTH_2:
+            if (encodeAuthMessage((ODID_Auth_encoded *) encoded,
+                                  &uasData->Auth[message - MSG_AUTH_0]) != ODID_SUCCESS)
+                return -1;
+            return ODID_MSG_COUNTER_AUTH;
+        case MSG_SELF_ID:
+            if (encodeSelfIDMessage((ODID_SelfID_encoded *) encoded, &uasData->SelfID) != ODID_SUCCESS)
+                return -1;
+            return ODID_MSG_COUNTER_SELF_ID;
+        case MSG_SYSTEM:
+            if (encodeSystemMessage((ODID_System_encoded *) encoded, &uasData->System) != ODID_SUCCESS)
+                return -1;
+            return ODID_MSG_COUNTER_SYSTEM;
+        case MSG_OPERATOR_ID:
+            if (encodeOperatorIDMessage((ODID_OperatorID_encoded *) encoded, &uasData->OperatorID) != ODID_SUCCESS)
+                return -1;
+            return ODID_MSG_COUNTER_OPERATOR_ID;
+        default:
+            return -1;
+    }
+}
 
-        if (encodeSelfIDMessage((ODID_SelfID_encoded *) &encoded, &uasData->SelfID) != ODID_SUCCESS)
-            printf("Error: Failed to encode Self ID\n");
-        send_message(&encoded, config, config->msg_counters[ODID_MSG_COUNTER_SELF_ID]++);
+/*
+ * Moves the Location of uasData to the time of the running call of the scheduler, from the latest fix
+ * of the gps thread. Returns true if the Location changed, which it does at every call once there
+ * is a fix.
+ */
+static bool update_gps_location(struct ODID_UAS_Data *uasData) {
+    static uint32_t seen = 0;
+    struct location_fix fix;
+
+    if (!config.use_gps)
+        return false;
+    if (location_channel_read(&gps_channel, &fix, &seen))
+        dead_reckoning_update(&gps_motion, &fix.location, fix.read_ns);
+    return dead_reckoning_predict(&gps_motion, scheduler.now_ns, &uasData->Location);
+}
 
-        if (encodeSystemMessage((ODID_System_encoded *) &encoded, &uasData->System) != ODID_SUCCESS)
-            printf("Error: Failed to encode System\n");
-        send_message(&encoded, config, config->msg_counters[ODID_MSG_COUNTER_SYSTEM]++);
+// Without gpsd, the Location message is encoded only once
+static int encode_location_message(struct ODID_UAS_Data *uasData, union ODID_Message_encoded *encoded) {
+    static ODID_Location_encoded location_enc;
+    static bool encoded_once = false;
 
-        if (encodeOperatorIDMessage((ODID_OperatorID_encoded *) &encoded, &uasData->OperatorID) != ODID_SUCCESS)
-            printf("Error: Failed to encode Operator ID\n");
-        send_message(&encoded, config, config->msg_counters[ODID_MSG_COUNTER_OPERATOR_ID]++);
+    if (update_gps_location(uasData) || !encoded_once) {
+        if (encodeLocationMessage(&location_enc, &uasData->Location) != ODID_SUCCESS)
+            return -1;
+        encoded_once = true;
     }
+    memcpy(encoded, &location_enc, sizeof(location_enc));
+    return ODID_MSG_COUNTER_LOCATION;
+}
+
+// When using the WiFi Beacon transport method, the standards require that all messages are wrapped
+// in a message pack and sent together. Sending single messages is only for testing purposes.
+static void send_single_message(void *arg) {
+    struct transmit_job *job = arg;
+    union ODID_Message_encoded encoded;
+    memset(&encoded, 0, sizeof(union ODID_Message_encoded));
+
+    int counter;
+    if (job->message == MSG_LOCATION)
+        counter = encode_location_message(job->uasData, &encoded);
+    else
+        counter = encode_single_message(job->uasData, job->message, &encoded);
+    if (counter < 0) {
+        printf("Error: Failed to encode %s\n", message_names[job->message]);
+        return;
+    }
+    send_message(job->transport, &encoded, &config, config.msg_counters[job->transport][counter]++);
+}
+
+// The static messages are encoded once into the pack cache. After that, only the Location
+// message is encoded again when a pack is created and only when there is a fix from gpsd.
+static void init_message_pack(struct ODID_UAS_Data *uasData) {
+    odid_initPackCache(&pack_cache);
+    odid_packCacheSetBasicID(&pack_cache, BASIC_ID_POS_ZERO, &uasData->BasicID[BASIC_ID_POS_ZERO]);
+    odid_packCacheSetBasicID(&pack_cache, BASIC_ID_POS_ONE, &uasData->BasicID[BASIC_ID_POS_ONE]);
+    odid_packCacheSetLocation(&pack_cache, &uasData->Location);
+    for (int i = 0; i < 3; i++)
+        odid_packCacheSetAuth(&pack_cache, i, &uasData->Auth[i]);
+    odid_packCacheSetSelfID(&pack_cache, &uasData->SelfID);
+    odid_packCacheSetSystem(&pack_cache, &uasData->System);
+    odid_packCacheSetOperatorID(&pack_cache, &uasData->OperatorID);
 }
 
 static void create_message_pack(struct ODID_UAS_Data *uasData, struct ODID_MessagePack_encoded *pack_enc) {
-    union ODID_Message_encoded encoded = { 0 };
-    ODID_MessagePack_data pack_data = { 0 };
-    pack_data.SingleMessageSize = ODID_MESSAGE_SIZE;
-    pack_data.MsgPackSize = 9;
-    if (encodeBasicIDMessage((ODID_BasicID_encoded *) &encoded, &uasData->BasicID[BASIC_ID_POS_ZERO]) != ODID_SUCCESS)
-        printf("Error: Failed to encode Basic ID\n");
-    memcpy(&pack_data.Messages[0], &encoded, ODID_MESSAGE_SIZE);
-    if (encodeBasicIDMessage((ODID_BasicID_encoded *) &encoded, &uasData->BasicID[BASIC_ID_POS_ONE]) != ODID_SUCCESS)
-        printf("Error: Failed to encode Basic ID\n");
-    memcpy(&pack_data.Messages[1], &encoded, ODID_MESSAGE_SIZE);
-    if (encodeLocationMessage((ODID_Location_encoded *) &encoded, &uasData->Location) != ODID_SUCCESS)
-        printf("Error: Failed to encode Location\n");
-    memcpy(&pack_data.Messages[2], &encoded, ODID_MESSAGE_SIZE);
-    if (encodeAuthMessage((ODID_Auth_encoded *) &encoded, &uasData->Auth[0]) != ODID_SUCCESS)
-        printf("Error: Failed to encode Auth 0\n");
-    memcpy(&pack_data.Messages[3], &encoded, ODID_MESSAGE_SIZE);
-    if (encodeAuthMessage((ODID_Auth_encoded *) &encoded, &uasData->Auth[1]) != ODID_SUCCESS)
-        printf("Error: Failed to encode Auth 1\n");
-    memcpy(&pack_data.Messages[4], &encoded, ODID_MESSAGE_SIZE);
-    if (encodeAuthMessage((ODID_Auth_encoded *) &encoded, &uasData->Auth[2]) != ODID_SUCCESS)
-        printf("Error: Failed to encode Auth 2\n");
-    memcpy(&pack_data.Messages[5], &encoded, ODID_MESSAGE_SIZE);
-    if (encodeSelfIDMessage((ODID_SelfID_encoded *) &encoded, &uasData->SelfID) != ODID_SUCCESS)
-        printf("Error: Failed to encode Self ID\n");
-    memcpy(&pack_data.Messages[6], &encoded, ODID_MESSAGE_SIZE);
-    if (encodeSystemMessage((ODID_System_encoded *) &encoded, &uasData->System) != ODID_SUCCESS)
-        printf("Error: Failed to encode System\n");
-    memcpy(&pack_data.Messages[7], &encoded, ODID_MESSAGE_SIZE);
-    if (encodeOperatorIDMessage((ODID_OperatorID_encoded *) &encoded, &uasData->OperatorID) != ODID_SUCCESS)
-        printf("Error: Failed to encode Operator ID\n");
-    memcpy(&pack_data.Messages[8], &encoded, ODID_MESSAGE_SIZE);
-    if (encodeMessagePack(pack_enc, &pack_data) != ODID_SUCCESS)
+    if (update_gps_location(uasData))
+        odid_packCacheSetLocation(&pack_cache, &uasData->Location);
+    if (encodePackCache(&pack_cache, pack_enc) != ODID_SUCCESS)
         printf("Error: Failed to encode message pack_data\n");
 }
 
-static void send_packs(struct ODID_UAS_Data *uasData, struct config_data *config) {
+static void send_pack(void *arg) {
+    struct transmit_job *job = arg;
     struct ODID_MessagePack_encoded pack_enc = { 0 };
-    create_message_pack(uasData, &pack_enc);
+    create_message_pack(job->uasData, &pack_enc);
+
+    uint8_t msg_counter = config.msg_counters[job->transport][ODID_MSG_COUNTER_PACKED]++;
+    if (wifi_frames(job->transport))
+        send_wifi_pack(job->transport, &pack_enc, config.inject_iface ? inject_mac : file_mac, msg_counter);
+    else if (config.btsnoop_file && job->transport == TRANSPORT_BT5)
+        write_bluetooth(job->transport, (const uint8_t *) &pack_enc,
+                        3 + pack_enc.MsgPackSize*ODID_MESSAGE_SIZE, file_mac, msg_counter);
+    else if (job->transport == TRANSPORT_BEACON)
+        send_beacon_message_pack(&pack_enc, msg_counter);
+    else if (job->transport == TRANSPORT_BT5)
+        send_bluetooth_message_pack(&pack_enc, msg_counter, config.handle_bt5);
+}
 
-    for (int i = 0; i < 10; i++) {
-        if (config->use_beacon)
-            send_beacon_message_pack(&pack_enc, config->msg_counters[ODID_MSG_COUNTER_PACKED]++);
-        if (config->use_bt5)
-            send_bluetooth_message_pack(&pack_enc, config->msg_counters[ODID_MSG_COUNTER_PACKED]++, config);
-        sleep(4);
+// Sends the pack of the next drone of the swarm. Each call moves on to the next drone,
+// so the packs of all drones are interleaved on each transport.
+static void send_swarm_pack(void *arg) {
+    struct transmit_job *job = arg;
+    struct timespec now;
+    sched_realtime(&scheduler, &now);
+    struct swarm_drone *drone = swarm_next(&swarm, job->transport, &now);
+    uint8_t msg_counter = drone->msg_counters[job->transport]++;
+
+    struct ODID_MessagePack_encoded pack_enc = { 0 };
+    if (encodePackCache(&drone->pack_cache, &pack_enc) != ODID_SUCCESS) {
+        printf("Error: Failed to encode message pack_data\n");
+        return;
     }
+    if (wifi_frames(job->transport))
+        send_wifi_pack(job->transport, &pack_enc, drone->mac, msg_counter);
+    else if (config.btsnoop_file && job->transport == TRANSPORT_BT5)
+        write_bluetooth(job->transport, (const uint8_t *) &pack_enc,
+                        3 + pack_enc.MsgPackSize*ODID_MESSAGE_SIZE, drone->mac, msg_counter);
+    else if (job->transport == TRANSPORT_BEACON)
+        send_beacon_message_pack(&pack_enc, msg_counter);
+    else if (job->transport == TRANSPORT_BT5)
+        send_bluetooth_message_pack(&pack_enc, msg_counter, drone->bt_sets[TRANSPORT_BT5]);
+}
+
+// A message pack does not fit in the legacy advertising data of BT4, so a swarm sends the single
+// messages of its drones there. Each call sends the next message of the next drone. Every other
+// message of a drone is its Location message, in between are its static messages in turn.
+static void send_swarm_message(void *arg) {
+    struct transmit_job *job = arg;
+    struct timespec now;
+    sched_realtime(&scheduler, &now);
+    struct swarm_drone *drone = swarm_next(&swarm, job->transport, &now);
+
+    enum single_message message = MSG_LOCATION;
+    if (drone->next_message % 2) {
+        int n = (int) (drone->next_message / 2) % (MSG_AMOUNT - 1);
+        message = (enum single_message) (n < MSG_LOCATION ? n : n + 1);
+    }
+    drone->next_message = (drone->next_message + 1) % (2*(MSG_AMOUNT - 1));
+
+    union ODID_Message_encoded encoded;
+    memset(&encoded, 0, sizeof(union ODID_Message_encoded));
+    int counter = encode_single_message(&drone->uasData, message, &encoded);
+    if (counter < 0) {
+        printf("Error: Failed to encode %s\n", message_names[message]);
+        return;
+    }
+
+    uint8_t msg_counter = drone->message_counters[counter]++;
+    if (config.btsnoop_file)
+        write_bluetooth(job->transport, encoded.rawData, ODID_MESSAGE_SIZE, drone->mac, msg_counter);
+    else
+        send_bluetooth_message_extended_api(&encoded, msg_counter, drone->bt_sets[TRANSPORT_BT4]);
+}
+
+static void add_job(enum transport transport, enum single_message message, double rate_hz,
+                    uint64_t offset_ns, struct ODID_UAS_Data *uasData) {
+    char name[SCHED_NAME_SIZE];
+    snprintf(name, sizeof(name), "%s %s", transport_names[transport], message_names[message]);
+
+    struct transmit_job *job = &jobs[scheduler.count];
+    job->transport = transport;
+    job->message = message;
+    job->uasData = uasData;
+    sched_fn fn = send_single_message;
+    if (message == MSG_PACK)
+        fn = swarm.count ? send_swarm_pack : send_pack;
+    else if (message == MSG_SWARM)
+        fn = send_swarm_message;
+    if (sched_add(&scheduler, name, rate_hz, offset_ns, fn, job) < 0) {
+        fprintf(stderr, "Error: Failed to schedule %s\n", name);
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Each transport gets its own deadlines. The static messages of a transport are spread
+// evenly over their period, so they don't delay the Location message all at the same time.
+static void schedule_transport(enum transport transport, struct ODID_UAS_Data *uasData,
+                               struct config_data *config) {
+    double rate = config->rates[transport];
+
+    // A swarm sends the packs of all drones, each drone at the configured rate.
+    // On BT4, the Location messages of each drone are sent at the rate, see send_swarm_message()
+    if (swarm.count && transport == TRANSPORT_BT4) {
+        add_job(transport, MSG_SWARM, 2 * rate * swarm.count, 0, uasData);
+        return;
+    }
+    if (config->use_packs && transport != TRANSPORT_BT4) {
+        add_job(transport, MSG_PACK, swarm.count ? rate * swarm.count : rate, 0, uasData);
+        return;
+    }
+
+    double static_rate = rate / STATIC_RATE_DIVIDER;
+    uint64_t static_period_ns = (uint64_t) (1e9 / static_rate);
+    int static_messages = MSG_AMOUNT - 1;
+    int n = 0;
+    for (int msg = 0; msg < MSG_AMOUNT; msg++) {
+        if (msg == MSG_LOCATION) {
+            add_job(transport, MSG_LOCATION, rate, 0, uasData);
+            continue;
+        }
+        add_job(transport, (enum single_message) msg, static_rate,
+                static_period_ns * (uint64_t) n++ / (uint64_t) static_messages, uasData);
+    }
+}
+
+static void init_swarm(struct ODID_UAS_Data *uasData, struct config_data *config) {
+    int ret;
+
+    if (config->swarm_file)
+        ret = swarm_load(&swarm, config->swarm_file, uasData);
+    else
+        ret = swarm_generate(&swarm, config->swarm_size, uasData);
+    if (ret < 0)
+        exit(EXIT_FAILURE);
+    printf("Swarm of %d drones\n", swarm.count);
+}
+
+static void init_files(struct config_data *config) {
+    if (config->pcap_file && file_open_pcap(config->pcap_file) < 0)
+        exit(EXIT_FAILURE);
+    if (config->btsnoop_file && file_open_btsnoop(config->btsnoop_file) < 0)
+        exit(EXIT_FAILURE);
+}
+
+static void init_inject(struct config_data *config) {
+    if (inject_open(config->inject_iface, inject_mac) < 0)
+        exit(EXIT_FAILURE);
+    if (config->use_beacon && !inject_is_monitor()) {
+        fprintf(stderr, "Error: Beacons can only be injected on a monitor interface, not on %s\n",
+                config->inject_iface);
+        cleanup(EXIT_FAILURE);
+    }
+}
+
+// Each drone gets its own BT4 and BT5 advertising sets with its own address, as far as the
+// controller supports them. Otherwise the drones take turns on the sets and share their addresses.
+static void init_swarm_bluetooth(struct config_data *config) {
+    enum transport transports[2];
+    int n = 0;
+
+    if (config->use_bt4)
+        transports[n++] = TRANSPORT_BT4;
+    if (config->use_bt5)
+        transports[n++] = TRANSPORT_BT5;
+    int count = MINIMUM(swarm.count, bluetooth_available_advertising_sets() / n);
+    if (count < 1) {
+        fprintf(stderr, "Error: The controller has too few Extended Advertising sets\n");
+        cleanup(EXIT_FAILURE);
+    }
+
+    for (int t = 0; t < n; t++) {
+        bool long_range = transports[t] == TRANSPORT_BT5;
+        int interval_ms = long_range ? BT5_ADVERTISING_INTERVAL_MS : BT4_ADVERTISING_INTERVAL_MS;
+        int first = 0;
+
+        for (int i = 0; i < count; i++) {
+            uint8_t address[6];
+            memcpy(address, swarm.drones[i].mac, sizeof(address));
+            address[0] |= 0xC0; // Bluetooth Random Static Address, see generate_random_mac_address()
+            int set = bluetooth_add_advertising_set(address, interval_ms, long_range);
+            if (i == 0)
+                first = set;
+        }
+        for (int i = 0; i < swarm.count; i++)
+            swarm.drones[i].bt_sets[transports[t]] = (uint8_t) (first + i % count);
+
+        // Each set gets the packs of its drones, a new pack in every periodic advertisement
+        if (long_range && config->use_periodic) {
+            int drones_per_set = (swarm.count + count - 1) / count;
+            for (int i = 0; i < count; i++)
+                bluetooth_enable_periodic_advertising((uint8_t) (first + i),
+                                                      (int) (1000 / (config->rates[TRANSPORT_BT5] * drones_per_set)));
+        }
+        printf("Using %d %s advertising sets for %d drones\n", count, transport_names[transports[t]], swarm.count);
+    }
+    bluetooth_enable_advertising_sets();
+}
+
+static void print_swarm_stats(void) {
+    double rates[MSG_SWARM + 1] = { 0 };
+
+    for (int i = 0; i < scheduler.count; i++) {
+        const struct sched_slot *slot = &scheduler.slots[i];
+        if (slot->count > 1)
+            rates[jobs[i].message] += (double) (slot->count - 1) * 1e9 / (double) (slot->last_ns - slot->first_ns);
+    }
+    printf("Swarm: %d drones, %.1f packs per second in total, %.3f per drone\n",
+           swarm.count, rates[MSG_PACK], rates[MSG_PACK] / swarm.count);
+    if (rates[MSG_SWARM] > 0)
+        printf("       %.1f BT4 messages per second in total, %.3f per drone\n",
+               rates[MSG_SWARM], rates[MSG_SWARM] / swarm.count);
+}
+
+static void init_schedule(struct ODID_UAS_Data *uasData, struct config_data *config) {
+    sched_init(&scheduler);
+    if (config->use_beacon)
+        schedule_transport(TRANSPORT_BEACON, uasData, config);
+    if (config->use_btl || config->use_bt4)
+        schedule_transport(TRANSPORT_BT4, uasData, config);
+    if (config->use_bt5)
+        schedule_transport(TRANSPORT_BT5, uasData, config);
+    if (config->use_nan)
+        schedule_transport(TRANSPORT_NAN, uasData, config);
+
+    // Without radios, the files are written as fast as possible with the timestamps of the deadlines
+    bool bluetooth = config->use_btl || config->use_bt4 || config->use_bt5;
+    bool wifi = config->use_beacon || config->use_nan;
+    scheduler.simulated = (!wifi || config->pcap_file) && (!bluetooth || config->btsnoop_file);
 }
 
 void print_help() {
@@ -261,7 +633,29 @@ void print_help() {
     printf("           using the Extended Advertising HCI API commands\n");
     printf("         5 Enable Bluetooth 5 Long Range + Extended Advertising transmission\n");
     printf("         p Use message packs instead of single messages\n");
-    printf("         g Use gpsd to dynamically update location messages after each loop of messages\n");
+    printf("           BT4 always sends single messages, a message pack does not fit in them\n");
+    printf("         g Use gpsd to dynamically update location messages\n");
+    printf("         r=<Hz> Message packs or Location messages per second on all transports (default: %.0f)\n",
+           DEFAULT_RATE_HZ);
+    printf("         rb=<Hz>, r4=<Hz>, r5=<Hz>, rn=<Hz> The same for Wi-Fi Beacon, Bluetooth 4, Bluetooth 5\n");
+    printf("           or Wi-Fi NAN only\n");
+    printf("           The static single messages are sent at a third of the rate\n");
+    printf("         t=<seconds> Transmit duration, 0 until stopped (default: %d, with g: 0)\n",
+           DEFAULT_DURATION_SECS);
+    printf("         n=<N> Swarm of N generated drones, each with its own ID, MAC address and flight path\n");
+    printf("         f=<file> Swarm of the drones in a profile file, one per line:\n");
+    printf("           <UAS ID> <latitude> <longitude> <altitude> [<radius m> [<speed m/s>]]\n");
+    printf("           The rate applies to each drone of the swarm\n");
+    printf("         N Enable Wi-Fi NAN transmission, only to a pcap file or injected\n");
+    printf("         P Send the Bluetooth 5 message packs with Periodic Advertising, to which receivers\n");
+    printf("           synchronize instead of scanning for them\n");
+    printf("         w=<file> Write the Wi-Fi frames to a pcap file instead of sending them with hostapd\n");
+    printf("         i=<interface> Inject the Wi-Fi frames with nl80211 instead of using hostapd.\n");
+    printf("           Beacons need a monitor interface, NAN frames also work on a station interface\n");
+    printf("         s=<file> Write the Bluetooth advertisements to a btsnoop file instead of sending them\n");
+    printf("           Files are written with the timestamps of the transmit schedule, without waiting\n");
+    printf("           for it when no radio is used, to benchmark receivers\n");
+    printf("The achieved rate and jitter of each message are printed at the end.\n");
     printf("E.g. sudo ./transmit b p\n\n");
     printf("Wi-Fi Beacon transmit only works when running\n");
     printf("\"sudo hostapd/hostapd/hostapd beacon.conf\" in a separate shell.\n");
@@ -274,12 +668,71 @@ void print_help() {
     printf("   \"sudo btmgmt power on\".\n");
 }
 
+static double parse_value(const char *arg) {
+    const char *value = strchr(arg, '=');
+    char *end;
+
+    if (!value) {
+        printf("\nError: Missing value in %s.\n\n", arg);
+        exit(EXIT_FAILURE);
+    }
+    double result = strtod(value + 1, &end);
+    if (end == value + 1 || *end || result < 0) {
+        printf("\nError: Invalid value in %s.\n\n", arg);
+        exit(EXIT_FAILURE);
+    }
+    return result;
+}
+
+static const char *parse_string(const char *arg) {
+    const char *value = strchr(arg, '=');
+    if (!value || !value[1]) {
+        printf("\nError: Missing value in %s.\n\n", arg);
+        exit(EXIT_FAILURE);
+    }
+    return value + 1;
+}
+
+static void parse_rate(const char *arg, struct config_data *config) {
+    double rate = parse_value(arg);
+    if (rate <= 0) {
+        printf("\nError: The rate must be above 0 in %s.\n\n", arg);
+        exit(EXIT_FAILURE);
+    }
+
+    switch (arg[1]) {
+        case '=':
+            for (int t = 0; t < TRANSPORT_AMOUNT; t++)
+                config->rates[t] = rate;
+            break;
+        case 'b':
+            config->rates[TRANSPORT_BEACON] = rate;
+            break;
+        case '4':
+            config->rates[TRANSPORT_BT4] = rate;
+            break;
+        case '5':
+            config->rates[TRANSPORT_BT5] = rate;
+            break;
+        case 'n':
+            config->rates[TRANSPORT_NAN] = rate;
+            break;
+        default:
+            printf("\nError: Unknown transport in %s.\n\n", arg);
+            exit(EXIT_FAILURE);
+    }
+}
+
 static void parse_command_line(int argc, char *argv[], struct config_data *config) {
     if (argc == 1) {
         print_help();
         exit(EXIT_SUCCESS);
     }
 
+    for (int t = 0; t < TRANSPORT_AMOUNT; t++)
+        config->rates[t] = DEFAULT_RATE_HZ;
+    config->duration = -1;
+
     for (int i = 1; i < argc; i++) {
         switch (*argv[i]) {
             case 'b':
@@ -300,11 +753,64 @@ static void parse_command_line(int argc, char *argv[], struct config_data *confi
             case 'g':
                 config->use_gps = true;
                 break;
+            case 'r':
+                parse_rate(argv[i], config);
+                break;
+            case 't':
+                config->duration = parse_value(argv[i]);
+                break;
+            case 'n':
+                config->swarm_size = (int) parse_value(argv[i]);
+                break;
+            case 'f':
+                config->swarm_file = parse_string(argv[i]);
+                break;
+            case 'N':
+                config->use_nan = true;
+                break;
+            case 'P':
+                config->use_periodic = true;
+                break;
+            case 'w':
+                config->pcap_file = parse_string(argv[i]);
+                break;
+            case 's':
+                config->btsnoop_file = parse_string(argv[i]);
+                break;
+            case 'i':
+                config->inject_iface = parse_string(argv[i]);
+                break;
             default:
                 break;
         }
     }
-    if (config->use_beacon)
+    if (config->pcap_file && config->inject_iface) {
+        printf("\nError: Wi-Fi frames are either written to a pcap file or injected.\n\n");
+        exit(EXIT_FAILURE);
+    }
+    // The Wi-Fi frames in a pcap file or injected are built from message packs
+    if (config->pcap_file || config->inject_iface) {
+        if (!config->use_nan)
+            config->use_beacon = true;
+        config->use_packs = true;
+    }
+    if (config->use_nan && !config->pcap_file && !config->inject_iface) {
+        printf("\nError: Wi-Fi NAN can only be written to a pcap file or injected.\n\n");
+        exit(EXIT_FAILURE);
+    }
+    if (config->btsnoop_file && !config->use_btl && !config->use_bt4 && !config->use_bt5) {
+        printf("\nError: A btsnoop file needs Bluetooth 4 or 5 transmission.\n\n");
+        exit(EXIT_FAILURE);
+    }
+    if (config->swarm_size || config->swarm_file) {
+        if (config->use_btl || config->use_gps) {
+            printf("\nError: A swarm can only use Wi-Fi and the Extended Advertising API, without gpsd.\n\n");
+            exit(EXIT_FAILURE);
+        }
+        config->use_packs = true;
+    }
+
+    if (config->use_beacon && !config->pcap_file && !config->inject_iface)
         printf("\nReminder: Wi-Fi Beacon only works when running\n\"sudo hostapd/hostapd/hostapd beacon.conf\" in a separate shell.\n\n");
     if (config->use_beacon && !config->use_packs)
         printf("\nWarning: Transmitting single messages on Wi-Fi beacon is violating\nthe standards. Enable message packs.\n\n");
@@ -313,22 +819,25 @@ static void parse_command_line(int argc, char *argv[], struct config_data *confi
         printf("\nError: Cannot use both old API and Extended Advertising API at the same time.\n\n");
         exit(EXIT_FAILURE);
     }
-    if ((config->use_btl || config->use_bt4) && config->use_packs) {
-        printf("\nError: BT4 cannot use message packs.\n\n");
-        exit(EXIT_FAILURE);
-    }
     if (config->use_bt4 && config->use_bt5)
         printf("\nWarning: Doing simultaneous BT4 and BT5 will not necessarily work.\n\n");
+    if (config->use_periodic && (!config->use_bt5 || !config->use_packs)) {
+        printf("\nError: Periodic Advertising needs Bluetooth 5 and message packs.\n\n");
+        exit(EXIT_FAILURE);
+    }
     if (config->use_bt5 && !config->use_packs)
         printf("\nWarning: Transmitting single messages on Bluetooth 5 Long Range is violating\nthe standards. Enable message packs.\n\n");
 
-    if (!config->use_beacon && !config->use_btl && !config->use_bt4 && !config->use_bt5) {
+    if (!config->use_beacon && !config->use_nan && !config->use_btl && !config->use_bt4 && !config->use_bt5) {
         print_help();
         exit(EXIT_SUCCESS);
     }
 
     if (config->use_gps)
         printf("\nWarning: Fetching GPS data requires a configured GPS sensor.\n\n");
+
+    if (config->duration < 0)
+        config->duration = config->use_gps ? 0 : DEFAULT_DURATION_SECS;
 }
 
 void gps_loop(struct gps_loop_args *args) {
@@ -338,12 +847,13 @@ void gps_loop(struct gps_loop_args *args) {
     char gpsd_message[GPS_JSON_RESPONSE_MAX];
     int retries = 0;      // cycles to wait before gpsd timeout
     int read_retries = 0;
+    struct gps_last_fix last_fix = { 0 };
     while(true) {
         if(kill_program)
             break;
 
         int ret;
-        ret = gps_waiting(gpsdata, GPS_WAIT_TIME_MICROSECS);
+        ret = wait_gps_data(gpsdata, &last_fix, GPS_WAIT_TIME_MICROSECS);
         if (!ret) {
             printf("Socket not ready, retrying...\n");
             if (retries++ > MAX_GPS_WAIT_RETRIES) {
@@ -369,7 +879,11 @@ void gps_loop(struct gps_loop_args *args) {
             }
             read_retries = 0;
 
-            process_gps_data(gpsdata, uasData);
+            // Other reports, e.g. the satellites, do not change the fix
+            if (is_new_gps_fix(gpsdata, &last_fix) && process_gps_data(gpsdata, uasData)) {
+                struct location_fix fix = { .location = uasData->Location, .read_ns = now_ns() };
+                location_channel_publish(&gps_channel, &fix);
+            }
         }
     }
 
@@ -381,13 +895,9 @@ int main(int argc, char *argv[])
 {
     parse_command_line(argc, argv, &config);
 
-    config.handle_bt4 = 0; // The Extended Advertising set number used for BT4
-    config.handle_bt5 = 1; // The Extended Advertising set number used for BT5
-
-    if (config.use_beacon) {
-        sem_init(&semaphore,0,0);
-        pthread_create(&id, NULL, ap_interface_init, NULL);
-        sem_wait(&semaphore);
+    if (config.use_beacon && !config.pcap_file && !config.inject_iface) {
+        if (init_beacon(&kill_program) < 0)
+            exit(EXIT_FAILURE);
     }
 
     struct ODID_UAS_Data uasData;
@@ -395,45 +905,57 @@ int main(int argc, char *argv[])
     fill_example_data(&uasData);
     if(!config.use_gps)
         fill_example_gps_data(&uasData);
+    if (config.use_packs)
+        init_message_pack(&uasData);
+    if (config.swarm_size || config.swarm_file)
+        init_swarm(&uasData, &config);
+
+    init_files(&config);
+    if (config.inject_iface)
+        init_inject(&config);
 
-    if (config.use_btl || config.use_bt4 || config.use_bt5)
+    if ((config.use_btl || config.use_bt4 || config.use_bt5) && !config.btsnoop_file)
         init_bluetooth(&config);
+    if (swarm.count && (config.use_bt4 || config.use_bt5) && !config.btsnoop_file)
+        init_swarm_bluetooth(&config);
 
-    if(config.use_gps) {
-        signal(SIGINT,  sig_handler);
-        signal(SIGKILL, sig_handler);
-        signal(SIGSTOP, sig_handler);
-        signal(SIGTERM, sig_handler);
+    init_schedule(&uasData, &config);
 
-        if(init_gps(&source, &gpsdata) != 0) {
+    signal(SIGINT,  sig_handler);
+    signal(SIGKILL, sig_handler);
+    signal(SIGSTOP, sig_handler);
+    signal(SIGTERM, sig_handler);
+
+    struct gps_loop_args args;
+    if(config.use_gps) {
+        if(init_gps(&source, &gpsdata, true) != 0) {
             fprintf(stderr,
                     "No gpsd running or network error: %d, %s\n",
                     errno, gps_errstr(errno));
             cleanup(EXIT_FAILURE);
         }
 
-        struct gps_loop_args args;
+        static struct ODID_UAS_Data gpsUasData;
+        gpsUasData = uasData;
+        location_channel_init(&gps_channel);
+        dead_reckoning_init(&gps_motion);
         args.gpsdata = &gpsdata;
-        args.uasData = &uasData;
+        args.uasData = &gpsUasData;
         pthread_create(&gps_thread, NULL, (void*) &gps_loop, &args);
+    }
 
-        while (true)
-        {
-            if(kill_program)
-                break;
-
-            printf("Transmitting...\n");
-            if (config.use_packs)
-                send_packs(&uasData, &config);
-            else
-                send_single_messages(&uasData, &config);
-        }
-    } else {
-        if (config.use_packs)
-            send_packs(&uasData, &config);
-        else
-            send_single_messages(&uasData, &config);
+    printf("Transmitting...\n");
+    sched_run(&scheduler, &kill_program, config.duration);
+    kill_program = true;
+    sched_print_stats(&scheduler);
+    if (config.use_beacon && !config.pcap_file && !config.inject_iface) {
+        close_beacon();
+        print_beacon_stats();
     }
+    if ((config.use_btl || config.use_bt4 || config.use_bt5) && !config.btsnoop_file)
+        print_bluetooth_stats();
+    if (swarm.count)
+        print_swarm_stats();
 
     cleanup(EXIT_SUCCESS);
 }
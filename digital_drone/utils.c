@@ -11,21 +11,104 @@
 
 #include "utils.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <tmmintrin.h>
+#define HEX_SSSE3
+#endif
+
+static const char hex_upper[16] __attribute__((aligned(16))) = "0123456789ABCDEF";
+static const char hex_lower[16] = "0123456789abcdef";
+
+// 0x10 | the value of each hex digit, 0 for other characters
+#define HEX_DIGIT 0x10
+static const uint8_t hex_values[256] = {
+    ['0'] = 0x10, ['1'] = 0x11, ['2'] = 0x12, ['3'] = 0x13, ['4'] = 0x14,
+    ['5'] = 0x15, ['6'] = 0x16, ['7'] = 0x17, ['8'] = 0x18, ['9'] = 0x19,
+    ['A'] = 0x1A, ['B'] = 0x1B, ['C'] = 0x1C, ['D'] = 0x1D, ['E'] = 0x1E, ['F'] = 0x1F,
+    ['a'] = 0x1A, ['b'] = 0x1B, ['c'] = 0x1C, ['d'] = 0x1D, ['e'] = 0x1E, ['f'] = 0x1F,
+};
+
 // Convert a single uint8_t to two chars representing the value in ASCII format
 // 0 - 9 => 0x30 - 0x39, A - F => 0x41 - 0x46
 void uchar_to_ascii(char *out, uint8_t in) {
     if (!out)
         return;
 
-    unsigned char high = (in & 0xF0) >> 4;
-    if (high < 0xA)
-        *out++ = (char) (0x30 + high);
-    else
-        *out++ = (char) (0x41 + high - 0xA);
-    unsigned char low = in & 0x0F;
-    if (low < 0xA)
-        *out = (char) (0x30 + low);
-    else
-        *out = (char) (0x41 + low - 0xA);
+    out[0] = hex_upper[in >> 4];
+    out[1] = hex_upper[in & 0x0F];
+}
+
+void hex_encode_scalar(char *out, const uint8_t *in, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        out[2*i] = hex_upper[in[i] >> 4];
+        out[2*i + 1] = hex_upper[in[i] & 0x0F];
+    }
+}
+
+#ifdef HEX_SSSE3
+// Looks up the digits of 32 nibbles at a time with PSHUFB and interleaves the high and low ones
+__attribute__((target("ssse3")))
+static void hex_encode_ssse3(char *out, const uint8_t *in, size_t len) {
+    const __m128i digits = _mm_load_si128((const __m128i *) hex_upper);
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *) &in[i]);
+        __m128i high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(bytes, 4), mask));
+        __m128i low = _mm_shuffle_epi8(digits, _mm_and_si128(bytes, mask));
+        _mm_storeu_si128((__m128i *) &out[2*i], _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128((__m128i *) &out[2*i + 16], _mm_unpackhi_epi8(high, low));
+    }
+    hex_encode_scalar(&out[2*i], &in[i], len - i);
+}
+#endif
+
+void hex_encode(char *out, const uint8_t *in, size_t len) {
+#ifdef HEX_SSSE3
+    static int ssse3 = -1;
+
+    if (ssse3 < 0)
+        ssse3 = __builtin_cpu_supports("ssse3") ? 1 : 0;
+    if (ssse3) {
+        hex_encode_ssse3(out, in, len);
+        return;
+    }
+#endif
+    hex_encode_scalar(out, in, len);
+}
+
+int hex_decode(uint8_t *out, size_t size, const char *in, size_t len) {
+    size_t count = 0;
+
+    for (size_t i = 0; i < len; ) {
+        unsigned char c = (unsigned char) in[i];
+        if (c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == ':') {
+            i++;
+            continue;
+        }
+        if (i + 1 >= len || count == size)
+            return -1;
+
+        uint8_t high = hex_values[c];
+        uint8_t low = hex_values[(unsigned char) in[i + 1]];
+        if (!(high & low & HEX_DIGIT))
+            return -1;
+        out[count++] = (uint8_t) ((high & 0x0F) << 4 | (low & 0x0F));
+        i += 2;
+    }
+    return (int) count;
 }
 
+size_t hex_dump(char *out, const uint8_t *in, size_t len) {
+    char *p = out;
+
+    for (size_t i = 0; i < len; i++) {
+        *p++ = hex_lower[in[i] >> 4];
+        *p++ = hex_lower[in[i] & 0x0F];
+        *p++ = ' ';
+        if ((i + 1) % HEX_DUMP_LINE_BYTES == 0)
+            *p++ = '\n';
+    }
+    return (size_t) (p - out);
+}
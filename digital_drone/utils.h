@@ -13,10 +13,21 @@
 #define _UTILS_H_
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <opendroneid.h>
 
+// Transports that are scheduled separately. BT4 is Legacy Advertising with either HCI API
+enum transport {
+    TRANSPORT_BEACON,
+    TRANSPORT_BT4,
+    TRANSPORT_BT5,
+    TRANSPORT_NAN,  // Wi-Fi NAN Service Discovery Frames, only written to a pcap file or injected
+    TRANSPORT_AMOUNT,
+};
+
 struct config_data {
     bool use_beacon;
+    bool use_nan;
 
     bool use_btl; // Bluetooth Legacy Advertising
     bool use_bt4; // Bluetooth Legacy Advertising using Extended Advertising APIs
@@ -24,14 +35,43 @@ struct config_data {
 
     bool use_gps;
     
-    uint8_t handle_bt4;
+    uint8_t handle_bt4; // Extended Advertising sets of a single drone, see init_bluetooth()
     uint8_t handle_bt5;
 
     bool use_packs; // Message packs
+    bool use_periodic; // BT5 message packs with Periodic Advertising
+
+    double rates[TRANSPORT_AMOUNT]; // Message packs or Location messages per second
+    double duration; // Seconds to transmit, 0 transmits until stopped
 
-    uint8_t msg_counters[ODID_MSG_COUNTER_AMOUNT];
+    int swarm_size; // Number of generated drones, 0 for a single drone
+    const char *swarm_file; // Drone profiles
+    const char *pcap_file; // Write Wi-Fi frames to this file instead of sending them with hostapd
+    const char *btsnoop_file; // Write Bluetooth advertisements to this file instead of the HCI device
+    const char *inject_iface; // Inject Wi-Fi frames on this interface instead of using hostapd
+
+    uint8_t msg_counters[TRANSPORT_AMOUNT][ODID_MSG_COUNTER_AMOUNT];
 };
 
 void uchar_to_ascii(char *out, uint8_t in);
 
+// Writes 2*len uppercase hex digits without a terminator, with SSSE3 when the CPU has it
+void hex_encode(char *out, const uint8_t *in, size_t len);
+void hex_encode_scalar(char *out, const uint8_t *in, size_t len);
+
+/*
+ * Decodes pairs of hex digits in either case, skipping white space and colons between
+ * the bytes, e.g. "DD 1E FA" or "dd:1e:fa". Returns the number of bytes, or -1 for
+ * invalid digits or when the data does not fit in size bytes.
+ */
+int hex_decode(uint8_t *out, size_t size, const char *in, size_t len);
+
+/*
+ * Writes the lowercase hex dump of the capture tools, "xx " per byte and a new line
+ * after every HEX_DUMP_LINE_BYTES bytes, without a terminator. Returns the characters written.
+ */
+#define HEX_DUMP_LINE_BYTES 16
+#define HEX_DUMP_SIZE(len) (3*(len) + (len)/HEX_DUMP_LINE_BYTES)
+size_t hex_dump(char *out, const uint8_t *in, size_t len);
+
 #endif //_UTILS_H_
@@ -9,19 +9,40 @@
  * friissoren2@gmail.com
  */
 
-#include <unistd.h>
-#include <semaphore.h>
-#include "ap_interface.h"
+#include <stdio.h>
+#include <string.h>
+#include "hostapd_ctrl.h"
 #include "utils.h"
 #include "wifi_beacon.h"
 
-extern struct wpa_ctrl *ctrl_conn;
-extern sem_t semaphore;
+static struct hostapd_ctrl ctrl;
 
-static void send_update_beacon() {
-    char *cmd[] = { "update_beacon" };
-    wpa_request(ctrl_conn, sizeof(cmd)/sizeof(cmd[0]), cmd);
-    sem_wait(&semaphore);
+static void command_reply(void *arg, const char *reply, size_t len) {
+    if (strncmp(reply, "OK", 2) != 0)
+        fprintf(stderr, "hostapd: '%s' command failed: %.*s", (const char *) arg, (int) len, reply);
+}
+
+int init_beacon(const volatile bool *stop) {
+    return hostapd_ctrl_open(&ctrl, stop);
+}
+
+void close_beacon() {
+    hostapd_ctrl_close(&ctrl);
+}
+
+void print_beacon_stats() {
+    hostapd_ctrl_print_stats(&ctrl);
+}
+
+/*
+ * Both commands are sent back to back. hostapd handles them in order, so UPDATE_BEACON
+ * uses the new vendor elements without waiting for the reply to SET. The replies of the
+ * previous update are handled here, the next ones when the following update is sent.
+ */
+static void send_vendor_elements(const char *cmd) {
+    hostapd_ctrl_poll(&ctrl, 0);
+    if (hostapd_ctrl_send(&ctrl, cmd, command_reply, "set vendor_elements") == 0)
+        hostapd_ctrl_send(&ctrl, "UPDATE_BEACON", command_reply, "update_beacon");
 }
 
 /*
@@ -32,62 +53,30 @@ static void send_update_beacon() {
  *     FA, 0B, BC = The OUI reserved for ASD-STAN
  *     0D = The indicator within the ASD-STAN OUI address space indicating Direct Remote ID
  *     xx = 8-bit message counter starting at 0x00 and wrapping around at 0xFF
+ * The element is built in binary and converted to hex in one go.
  */
 #define WIFI_BEACON_HEADER_SIZE 7
-void send_beacon_message(const union ODID_Message_encoded *encoded, uint8_t msg_counter) {
-    char *cmd[] = { "set", "vendor_elements", "dd1EFA0BBC0D00" };
-
-    // The buffers cmd points to are in read-only memory. Create a writable buffer
-    uint8_t data[2*(WIFI_BEACON_HEADER_SIZE + ODID_MESSAGE_SIZE) + 1] = { 0 };
-    memcpy(data, cmd[2], 2*WIFI_BEACON_HEADER_SIZE);
-    cmd[2] = (char *) data;
-
-    // Insert the message counter
-    uchar_to_ascii((char *) &data[12], msg_counter);
-
-    // Insert the encoded message data
-    for (int i = 0; i < ODID_MESSAGE_SIZE; i++)
-        uchar_to_ascii((char *) &data[2*(WIFI_BEACON_HEADER_SIZE + i)], encoded->rawData[i]);
-
-    wpa_request(ctrl_conn, sizeof(cmd)/sizeof(cmd[0]), cmd);
-    sem_wait(&semaphore);
+#define WIFI_BEACON_DATA_MAX (3 + ODID_PACK_MAX_MESSAGES*ODID_MESSAGE_SIZE)
+#define SET_VENDOR_ELEMENTS "SET vendor_elements "
+#define SET_VENDOR_ELEMENTS_SIZE (sizeof(SET_VENDOR_ELEMENTS) - 1)
+static void send_odid_element(const uint8_t *data, int size, uint8_t msg_counter) {
+    uint8_t element[WIFI_BEACON_HEADER_SIZE + WIFI_BEACON_DATA_MAX] = { 0xDD, 0x00, 0xFA, 0x0B, 0xBC, 0x0D };
+    char cmd[SET_VENDOR_ELEMENTS_SIZE + 2*sizeof(element) + 1] = SET_VENDOR_ELEMENTS;
+
+    element[1] = (WIFI_BEACON_HEADER_SIZE - 2) + size;
+    element[6] = msg_counter;
+    memcpy(&element[WIFI_BEACON_HEADER_SIZE], data, size);
+    hex_encode(&cmd[SET_VENDOR_ELEMENTS_SIZE], element, WIFI_BEACON_HEADER_SIZE + size);
+    cmd[SET_VENDOR_ELEMENTS_SIZE + 2*(WIFI_BEACON_HEADER_SIZE + size)] = '\0';
+
+    send_vendor_elements(cmd);
+}
 
-    send_update_beacon();
-    sleep(1);
+void send_beacon_message(const union ODID_Message_encoded *encoded, uint8_t msg_counter) {
+    send_odid_element(encoded->rawData, ODID_MESSAGE_SIZE, msg_counter);
 }
 
 // See also description for send_beacon_message()
 void send_beacon_message_pack(struct ODID_MessagePack_encoded *pack_enc, uint8_t msg_counter) {
-    char *cmd[] = { "set", "vendor_elements", "dd1EFA0BBC0D00" };
-
-    // The buffers cmd points to are in read-only memory. Create a writable buffer
-    char data[2*(WIFI_BEACON_HEADER_SIZE + 3 + ODID_PACK_MAX_MESSAGES*ODID_MESSAGE_SIZE) + 1] = { 0 };
-    memcpy(data, cmd[2], 2*WIFI_BEACON_HEADER_SIZE);
-    cmd[2] = data;
-
-    // Update the data length
-    int amount = pack_enc->MsgPackSize;
-    uchar_to_ascii(&data[2], (WIFI_BEACON_HEADER_SIZE - 2) + 3 + amount*ODID_MESSAGE_SIZE);
-
-    // Insert the message counter
-    uchar_to_ascii(&data[12], msg_counter);
-
-    // Insert the encoded message data
-    for (int i = 0; i < 3 + amount*ODID_MESSAGE_SIZE; i++)
-        uchar_to_ascii(&data[2*(WIFI_BEACON_HEADER_SIZE + i)], ((char *) pack_enc)[i]);
-
-    wpa_request(ctrl_conn, sizeof(cmd)/sizeof(cmd[0]), cmd);
-    sem_wait(&semaphore);
-    sleep(1);
-
-    send_update_beacon();
-    sleep(1);
-}
-
-void send_quit() {
-    char *cmd[] = { "quit" };
-    wpa_request(ctrl_conn, sizeof(cmd)/sizeof(cmd[0]), cmd);
-    sem_wait(&semaphore);
+    send_odid_element((const uint8_t *) pack_enc, 3 + pack_enc->MsgPackSize*ODID_MESSAGE_SIZE, msg_counter);
 }
-
-#include "wifi_beacon.h"
@@ -12,10 +12,15 @@
 #ifndef _WIFI_BEACON_H_
 #define _WIFI_BEACON_H_
 
+#include <stdbool.h>
 #include <opendroneid.h>
 
+// Connects to hostapd, retrying until it runs or *stop is set. Returns 0 or -1
+int init_beacon(const volatile bool *stop);
+void close_beacon();
+void print_beacon_stats();
+
 void send_beacon_message(const union ODID_Message_encoded *encoded, uint8_t msg_counter);
 void send_beacon_message_pack(struct ODID_MessagePack_encoded *pack_enc, uint8_t msg_counter);
-void send_quit();
 
 #endif //_WIFI_BEACON_H_
@@ -4,6 +4,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <signal.h>
+#include "utils.h"
 
 #define SNAP_LEN 1518
 
@@ -18,12 +19,9 @@ void packet_handler(u_char *args, const struct pcap_pkthdr *header, const u_char
         fprintf(log_file, "Packet size: %d bytes\n", data_length);
         fprintf(log_file, "Payload:\n");
 
-        for (int i = data_start; i < header->caplen; ++i) {
-            fprintf(log_file, "%02x ", packet[i]);
-            if ((i - data_start + 1) % 16 == 0) {
-                fprintf(log_file, "\n");
-            }
-        }
+        // Formats the whole payload at once instead of calling fprintf for every byte
+        static char dump[HEX_DUMP_SIZE(SNAP_LEN)];
+        fwrite(dump, hex_dump(dump, &packet[data_start], data_length), 1, log_file);
         fprintf(log_file, "\n\n");
     }
 }
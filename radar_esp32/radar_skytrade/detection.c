@@ -0,0 +1,219 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID C Library
+*/
+
+#include <string.h>
+
+#include "odid_detection.h"
+#include "odid_json.h"
+
+#define CRC_OFFSET (ODID_DETECTION_SIZE - 2)
+
+// CRC-16/CCITT-FALSE, a nibble at a time
+static uint16_t crc16(const uint8_t *data, size_t len)
+{
+    static const uint16_t table[16] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    };
+    uint16_t crc = 0xFFFF;
+
+    while (len--) {
+        crc = (uint16_t) ((crc << 4) ^ table[(crc >> 12) ^ (*data >> 4)]);
+        crc = (uint16_t) ((crc << 4) ^ table[(crc >> 12) ^ (*data & 0x0F)]);
+        data++;
+    }
+    return crc;
+}
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t) v;
+    p[1] = (uint8_t) (v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t) v;
+    p[1] = (uint8_t) (v >> 8);
+    p[2] = (uint8_t) (v >> 16);
+    p[3] = (uint8_t) (v >> 24);
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) |
+           ((uint32_t) p[3] << 24);
+}
+
+static int32_t encodeDegrees(double deg)
+{
+    if (deg > 180 || deg < -180)
+        return 0;
+    return (int32_t) (deg * 1e7 + (deg >= 0 ? 0.5 : -0.5));
+}
+
+// Same encoding as the altitudes of the Location message
+static uint16_t encodeMeters(float m)
+{
+    if (m <= MIN_ALT)
+        return 0;
+    if (m >= MAX_ALT)
+        return UINT16_MAX;
+    return (uint16_t) ((m - MIN_ALT) * 2 + 0.5f);
+}
+
+static uint16_t encodeScaled(float value, float scale)
+{
+    float v = value * scale + 0.5f;
+
+    if (v <= 0)
+        return 0;
+    return v >= UINT16_MAX ? UINT16_MAX : (uint16_t) v;
+}
+
+void odid_detectionFromUasData(ODID_Detection *det, const ODID_UAS_Data *UAS_Data)
+{
+    const ODID_Location_data *loc = &UAS_Data->Location;
+
+    det->Valid &= ODID_DETECTION_VALID_RSSI | ODID_DETECTION_VALID_CHANNEL;
+    memset(det->UASID, 0, sizeof(det->UASID));
+    det->Latitude = det->Longitude = 0;
+    det->OperatorLatitude = det->OperatorLongitude = 0;
+    det->AltitudeGeo = det->Height = INV_ALT;
+    det->SpeedHorizontal = INV_SPEED_H;
+    det->Direction = INV_DIR;
+
+    for (int i = 0; i < ODID_BASIC_ID_MAX_MESSAGES; i++) {
+        if (UAS_Data->BasicIDValid[i]) {
+            memcpy(det->UASID, UAS_Data->BasicID[i].UASID, ODID_ID_SIZE);
+            det->Valid |= ODID_DETECTION_VALID_ID;
+            break;
+        }
+    }
+
+    if (UAS_Data->LocationValid) {
+        if (loc->Latitude != 0 || loc->Longitude != 0) {
+            det->Latitude = loc->Latitude;
+            det->Longitude = loc->Longitude;
+            det->Valid |= ODID_DETECTION_VALID_POSITION;
+        }
+        if (loc->AltitudeGeo > INV_ALT) {
+            det->AltitudeGeo = loc->AltitudeGeo;
+            det->Valid |= ODID_DETECTION_VALID_ALTITUDE;
+        }
+        if (loc->Height > INV_ALT) {
+            det->Height = loc->Height;
+            det->Valid |= ODID_DETECTION_VALID_HEIGHT;
+        }
+        if (loc->SpeedHorizontal < INV_SPEED_H) {
+            det->SpeedHorizontal = loc->SpeedHorizontal;
+            det->Valid |= ODID_DETECTION_VALID_SPEED;
+        }
+        if (loc->Direction < INV_DIR) {
+            det->Direction = loc->Direction;
+            det->Valid |= ODID_DETECTION_VALID_DIRECTION;
+        }
+    }
+
+    if (UAS_Data->SystemValid &&
+        (UAS_Data->System.OperatorLatitude != 0 || UAS_Data->System.OperatorLongitude != 0)) {
+        det->OperatorLatitude = UAS_Data->System.OperatorLatitude;
+        det->OperatorLongitude = UAS_Data->System.OperatorLongitude;
+        det->Valid |= ODID_DETECTION_VALID_OPERATOR_POS;
+    }
+}
+
+int encodeDetectionRecord(uint8_t *outRecord, const ODID_Detection *inDet)
+{
+    if (!outRecord || !inDet)
+        return ODID_FAIL;
+
+    outRecord[0] = ODID_DETECTION_VERSION;
+    outRecord[1] = ODID_DETECTION_SIZE;
+    put16(&outRecord[2], inDet->Valid);
+    put32(&outRecord[4], inDet->Timestamp);
+    memcpy(&outRecord[8], inDet->MAC, 6);
+    outRecord[14] = (uint8_t) inDet->RSSI;
+    outRecord[15] = inDet->Channel;
+    strncpy((char *) &outRecord[16], inDet->UASID, ODID_ID_SIZE);
+    put32(&outRecord[36], (uint32_t) encodeDegrees(inDet->Latitude));
+    put32(&outRecord[40], (uint32_t) encodeDegrees(inDet->Longitude));
+    put32(&outRecord[44], (uint32_t) encodeDegrees(inDet->OperatorLatitude));
+    put32(&outRecord[48], (uint32_t) encodeDegrees(inDet->OperatorLongitude));
+    put16(&outRecord[52], encodeMeters(inDet->AltitudeGeo));
+    put16(&outRecord[54], encodeMeters(inDet->Height));
+    put16(&outRecord[56], encodeScaled(inDet->SpeedHorizontal, 100));
+    put16(&outRecord[58], encodeScaled(inDet->Direction, 100));
+    put16(&outRecord[60], 0);
+    put16(&outRecord[CRC_OFFSET], crc16(outRecord, CRC_OFFSET));
+    return ODID_SUCCESS;
+}
+
+int decodeDetectionRecord(ODID_Detection *outDet, const uint8_t *inRecord, size_t size)
+{
+    uint8_t recordSize;
+
+    if (!outDet || !inRecord || size < 2 || inRecord[0] != ODID_DETECTION_VERSION)
+        return ODID_FAIL;
+    recordSize = inRecord[1];
+    if (recordSize != ODID_DETECTION_SIZE || size < recordSize ||
+        get16(&inRecord[CRC_OFFSET]) != crc16(inRecord, CRC_OFFSET))
+        return ODID_FAIL;
+
+    outDet->Valid = get16(&inRecord[2]);
+    outDet->Timestamp = get32(&inRecord[4]);
+    memcpy(outDet->MAC, &inRecord[8], 6);
+    outDet->RSSI = (int8_t) inRecord[14];
+    outDet->Channel = inRecord[15];
+    memcpy(outDet->UASID, &inRecord[16], ODID_ID_SIZE);
+    outDet->UASID[ODID_ID_SIZE] = 0;
+    outDet->Latitude = (int32_t) get32(&inRecord[36]) * 1e-7;
+    outDet->Longitude = (int32_t) get32(&inRecord[40]) * 1e-7;
+    outDet->OperatorLatitude = (int32_t) get32(&inRecord[44]) * 1e-7;
+    outDet->OperatorLongitude = (int32_t) get32(&inRecord[48]) * 1e-7;
+    outDet->AltitudeGeo = get16(&inRecord[52]) / 2.0f + MIN_ALT;
+    outDet->Height = get16(&inRecord[54]) / 2.0f + MIN_ALT;
+    outDet->SpeedHorizontal = get16(&inRecord[56]) / 100.0f;
+    outDet->Direction = get16(&inRecord[58]) / 100.0f;
+    return ODID_SUCCESS;
+}
+
+int odid_detectionToJson(char *buf, size_t size, const ODID_Detection *det)
+{
+    const uint8_t *mac = det->MAC;
+    int len;
+
+    len = odid_jsonAppend(buf, size, 0, "{\"t\":%lu,\"mac\":\"%02x:%02x:%02x:%02x:%02x:%02x\"",
+                          (unsigned long) det->Timestamp, mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    if (det->Valid & ODID_DETECTION_VALID_RSSI)
+        len = odid_jsonAppend(buf, size, len, ",\"rssi\":%d", det->RSSI);
+    if (det->Valid & ODID_DETECTION_VALID_CHANNEL)
+        len = odid_jsonAppend(buf, size, len, ",\"ch\":%u", det->Channel);
+    if (det->Valid & ODID_DETECTION_VALID_ID) {
+        len = odid_jsonAppend(buf, size, len, ",\"id\":");
+        len = odid_jsonAppendString(buf, size, len, det->UASID, ODID_ID_SIZE);
+    }
+    if (det->Valid & ODID_DETECTION_VALID_POSITION)
+        len = odid_jsonAppend(buf, size, len, ",\"lat\":%.7f,\"lon\":%.7f", det->Latitude, det->Longitude);
+    if (det->Valid & ODID_DETECTION_VALID_ALTITUDE)
+        len = odid_jsonAppend(buf, size, len, ",\"alt\":%.1f", (double) det->AltitudeGeo);
+    if (det->Valid & ODID_DETECTION_VALID_HEIGHT)
+        len = odid_jsonAppend(buf, size, len, ",\"height\":%.1f", (double) det->Height);
+    if (det->Valid & ODID_DETECTION_VALID_SPEED)
+        len = odid_jsonAppend(buf, size, len, ",\"speed\":%.2f", (double) det->SpeedHorizontal);
+    if (det->Valid & ODID_DETECTION_VALID_DIRECTION)
+        len = odid_jsonAppend(buf, size, len, ",\"dir\":%.2f", (double) det->Direction);
+    if (det->Valid & ODID_DETECTION_VALID_OPERATOR_POS)
+        len = odid_jsonAppend(buf, size, len, ",\"op_lat\":%.7f,\"op_lon\":%.7f",
+                              det->OperatorLatitude, det->OperatorLongitude);
+    return odid_jsonAppend(buf, size, len, "}");
+}
@@ -0,0 +1,63 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID C Library
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "odid_json.h"
+
+int odid_jsonAppend(char *buf, size_t size, int len, const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    if (len < 0)
+        return len;
+
+    va_start(ap, fmt);
+    if ((size_t) len < size)
+        n = vsnprintf(buf + len, size - (size_t) len, fmt, ap);
+    else
+        n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    return n < 0 ? n : len + n;
+}
+
+// Appends one character and keeps the text terminated, as snprintf() would
+static int appendChar(char *buf, size_t size, int len, char c)
+{
+    if ((size_t) len + 1 < size) {
+        buf[len] = c;
+        buf[len + 1] = '\0';
+    } else if ((size_t) len < size) {
+        buf[len] = '\0';
+    }
+    return len + 1;
+}
+
+int odid_jsonAppendString(char *buf, size_t size, int len, const char *str, size_t maxLen)
+{
+    if (len < 0)
+        return len;
+
+    len = appendChar(buf, size, len, '"');
+    for (size_t i = 0; i < maxLen && str[i]; i++) {
+        unsigned char c = (unsigned char) str[i];
+
+        if (c == '"' || c == '\\') {
+            len = appendChar(buf, size, len, '\\');
+            len = appendChar(buf, size, len, (char) c);
+        } else if (c < 0x20 || c >= 0x7F) {
+            len = odid_jsonAppend(buf, size, len, "\\u%04x", c);
+            if (len < 0)
+                return len;
+        } else {
+            len = appendChar(buf, size, len, (char) c);
+        }
+    }
+    return appendChar(buf, size, len, '"');
+}
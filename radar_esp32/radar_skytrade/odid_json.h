@@ -0,0 +1,48 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID C Library
+*/
+
+#ifndef _ODID_JSON_H_
+#define _ODID_JSON_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+* Building one line JSON records into a fixed buffer.
+*
+* Each call appends at @len and returns the new length. Like snprintf(), the
+* length also counts the text that did not fit in @size, so the caller can
+* tell that the record was truncated. The text in @buf stays NULL terminated.
+* A negative @len, from an output error of an earlier call, is returned as it
+* is, so a record can be built with a sequence of calls and checked once.
+*/
+
+/**
+ * odid_jsonAppend - appends printf formatted text
+ *
+ * Returns the new length or < 0 on an output error
+ */
+int odid_jsonAppend(char *buf, size_t size, int len, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+/**
+ * odid_jsonAppendString - appends at most @maxLen characters of @str as a
+ * quoted JSON string. Quotes, backslashes, control characters and bytes
+ * outside of ASCII are escaped, so that a received ID can't break the record
+ *
+ * Returns the new length or < 0 on an output error
+ */
+int odid_jsonAppendString(char *buf, size_t size, int len, const char *str, size_t maxLen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ODID_JSON_H_
@@ -0,0 +1,138 @@
+/* -*- tab-width: 4; mode: c; -*-
+
+SPDX-License-Identifier: Apache-2.0
+
+Open Drone ID C Library
+*/
+
+#ifndef _ODID_TRACK_H_
+#define _ODID_TRACK_H_
+
+#include <stdint.h>
+#include "opendroneid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+* Table of the drones seen by a receiver.
+*
+* Tracks are looked up by MAC address and by UAS ID through two open
+* addressing hash indexes. The tracks are kept on a LRU list, so a new
+* drone replaces the least recently seen one when the table is full, and
+* on a timing wheel, so expiring the silent tracks only visits the tracks
+* that are due. All operations are O(1).
+*
+* The table does not allocate memory. The caller provides the track array
+* and the index array, and keeps any per drone data of its own in an array
+* indexed the same way as the tracks.
+*/
+
+#define ODID_TRACK_NONE         0xFFFF
+#define ODID_TRACK_MAX_CAPACITY 0xFFFE
+#define ODID_TRACK_WHEEL_SLOTS  64
+
+typedef struct ODID_Track {
+    uint8_t MAC[6];
+    uint8_t InUse;
+    uint8_t IDIndexed;          // The UAS ID index points to this track
+    char UASID[ODID_ID_SIZE+1]; // Empty until set with odid_trackSetID()
+    uint32_t FirstSeen;         // ms
+    uint32_t LastSeen;          // ms
+    uint32_t Expires;           // ms, LastSeen + the table timeout
+    uint32_t MACHash;
+    uint32_t IDHash;
+    uint16_t LruPrev;
+    uint16_t LruNext;
+    uint16_t WheelPrev;
+    uint16_t WheelNext;
+    uint8_t WheelSlot;
+} ODID_Track;
+
+// Called for every track that is removed by expiry or to make room for a new
+// one, before the track is reused
+typedef void (*ODID_TrackEvictFn)(void *ctx, int index, const ODID_Track *track);
+
+typedef struct ODID_TrackTable {
+    ODID_Track *Tracks;
+    uint16_t *MACIndex;
+    uint16_t *IDIndex;
+    uint32_t IndexMask;
+    uint16_t Capacity;
+    uint16_t Count;
+    uint16_t FreeList;
+    uint16_t LruHead;           // Most recently seen
+    uint16_t LruTail;           // Least recently seen
+    uint16_t Wheel[ODID_TRACK_WHEEL_SLOTS];
+    uint32_t Timeout;           // ms
+    uint8_t TickShift;          // A wheel slot covers 2^TickShift ms
+    uint32_t NextTick;          // Next wheel slot to expire, from the first time passed in
+    uint8_t WheelStarted;
+    uint32_t Now;               // Latest time passed in, ms
+    ODID_TrackEvictFn Evict;
+    void *EvictCtx;
+} ODID_TrackTable;
+
+/**
+ * odid_initTrackTable - initializes an empty track table
+ * @table: table to initialize
+ * @tracks: array of @capacity tracks
+ * @capacity: maximum number of tracks, at most ODID_TRACK_MAX_CAPACITY
+ * @index: array of 2 * @buckets entries for the MAC and the UAS ID indexes
+ * @buckets: size of each index, a power of two larger than @capacity.
+ *           Twice the capacity keeps the probe sequences short
+ * @timeout: ms after which a track that has not been seen expires
+ * @evict: called for every expired or replaced track. Can be NULL
+ * @ctx: passed to @evict
+ *
+ * Returns ODID_SUCCESS or ODID_FAIL
+ */
+int odid_initTrackTable(ODID_TrackTable *table, ODID_Track *tracks, uint16_t capacity,
+                        uint16_t *index, uint32_t buckets, uint32_t timeout,
+                        ODID_TrackEvictFn evict, void *ctx);
+
+// Return the index of the track or -1 if there is none
+int odid_trackFind(const ODID_TrackTable *table, const uint8_t *mac);
+int odid_trackFindID(const ODID_TrackTable *table, const char *uasId);
+
+/**
+ * odid_trackUpdate - finds or creates the track of a MAC address and marks it
+ *                    as seen at @now. A new track replaces the least recently
+ *                    seen one when the table is full.
+ * @table: track table
+ * @mac: MAC address of the received frame
+ * @now: current time in ms. May wrap around like e.g. the Arduino millis().
+ *       A time before the latest one passed to the table counts as the
+ *       latest one, so frames may be handed over slightly out of order
+ *
+ * Returns the index of the track
+ */
+int odid_trackUpdate(ODID_TrackTable *table, const uint8_t *mac, uint32_t now);
+
+/**
+ * odid_trackSetID - sets the UAS ID of a track, so it can be found with
+ *                   odid_trackFindID(). If another track already has the
+ *                   same ID, the ID index moves to this track.
+ *
+ * Returns ODID_SUCCESS or ODID_FAIL
+ */
+int odid_trackSetID(ODID_TrackTable *table, int index, const char *uasId);
+
+void odid_trackRemove(ODID_TrackTable *table, int index);
+
+/**
+ * odid_trackExpire - removes all tracks that have not been seen for the
+ *                    timeout of the table. Tracks are removed at most one
+ *                    wheel slot (about 1/32 of the timeout) late.
+ *                    Like for odid_trackUpdate(), the time does not go back.
+ *
+ * Returns the number of removed tracks
+ */
+int odid_trackExpire(ODID_TrackTable *table, uint32_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ODID_TRACK_H_
@@ -616,6 +616,27 @@ typedef struct ODID_MessagePack_data {
     ODID_Message_encoded Messages[ODID_PACK_MAX_MESSAGES];
 } ODID_MessagePack_data;
 
+// Entries of the message pack cache, in the order they are placed in the pack
+#define ODID_PACK_CACHE_BASIC_ID    0
+#define ODID_PACK_CACHE_LOCATION    (ODID_PACK_CACHE_BASIC_ID + ODID_BASIC_ID_MAX_MESSAGES)
+#define ODID_PACK_CACHE_AUTH        (ODID_PACK_CACHE_LOCATION + 1)
+#define ODID_PACK_CACHE_SELF_ID     (ODID_PACK_CACHE_AUTH + ODID_AUTH_MAX_PAGES)
+#define ODID_PACK_CACHE_SYSTEM      (ODID_PACK_CACHE_SELF_ID + 1)
+#define ODID_PACK_CACHE_OPERATOR_ID (ODID_PACK_CACHE_SYSTEM + 1)
+#define ODID_PACK_CACHE_ENTRIES     (ODID_PACK_CACHE_OPERATOR_ID + 1)
+
+// Keeps the encoded form of each message, so that only the messages whose data
+// has changed since the last call to encodePackCache() are encoded again.
+// Modify the data via the odid_packCacheSet*() functions or odid_packCacheUpdate().
+typedef struct ODID_PackCache {
+    ODID_UAS_Data Data;                   // Data of the cached messages incl. the Valid flags
+    ODID_MessagePack_encoded Pack;        // The encoded message pack
+    int8_t Slot[ODID_PACK_CACHE_ENTRIES]; // Position of each entry in Pack. -1 if not present
+    uint32_t Valid;                       // Bitmask of the entries with valid data
+    uint32_t Layout;                      // Bitmask of the entries present in Pack
+    uint32_t Dirty;                       // Bitmask of the entries that must be encoded again
+} ODID_PackCache;
+
 // API Calls
 void odid_initBasicIDData(ODID_BasicID_data *data);
 void odid_initLocationData(ODID_Location_data *data);
@@ -625,6 +646,7 @@ void odid_initSystemData(ODID_System_data *data);
 void odid_initOperatorIDData(ODID_OperatorID_data *data);
 void odid_initMessagePackData(ODID_MessagePack_data *data);
 void odid_initUasData(ODID_UAS_Data *data);
+void odid_initPackCache(ODID_PackCache *cache);
 
 int encodeBasicIDMessage(ODID_BasicID_encoded *outEncoded, ODID_BasicID_data *inData);
 int encodeLocationMessage(ODID_Location_encoded *outEncoded, ODID_Location_data *inData);
@@ -633,6 +655,15 @@ int encodeSelfIDMessage(ODID_SelfID_encoded *outEncoded, ODID_SelfID_data *inDat
 int encodeSystemMessage(ODID_System_encoded *outEncoded, ODID_System_data *inData);
 int encodeOperatorIDMessage(ODID_OperatorID_encoded *outEncoded, ODID_OperatorID_data *inData);
 int encodeMessagePack(ODID_MessagePack_encoded *outEncoded, ODID_MessagePack_data *inData);
+int encodePackCache(ODID_PackCache *cache, ODID_MessagePack_encoded *outEncoded);
+
+int odid_packCacheSetBasicID(ODID_PackCache *cache, int index, const ODID_BasicID_data *data);
+int odid_packCacheSetLocation(ODID_PackCache *cache, const ODID_Location_data *data);
+int odid_packCacheSetAuth(ODID_PackCache *cache, int page, const ODID_Auth_data *data);
+int odid_packCacheSetSelfID(ODID_PackCache *cache, const ODID_SelfID_data *data);
+int odid_packCacheSetSystem(ODID_PackCache *cache, const ODID_System_data *data);
+int odid_packCacheSetOperatorID(ODID_PackCache *cache, const ODID_OperatorID_data *data);
+int odid_packCacheUpdate(ODID_PackCache *cache, const ODID_UAS_Data *uasData);
 
 int decodeBasicIDMessage(ODID_BasicID_data *outData, ODID_BasicID_encoded *inEncoded);
 int decodeLocationMessage(ODID_Location_data *outData, ODID_Location_encoded *inEncoded);
@@ -641,12 +672,29 @@ int decodeSelfIDMessage(ODID_SelfID_data *outData, ODID_SelfID_encoded *inEncode
 int decodeSystemMessage(ODID_System_data *outData, ODID_System_encoded *inEncoded);
 int decodeOperatorIDMessage(ODID_OperatorID_data *outData, ODID_OperatorID_encoded *inEncoded);
 int decodeMessagePack(ODID_UAS_Data *uasData, ODID_MessagePack_encoded *pack);
+int decodeMessagePackBatch(ODID_UAS_Data *uasData, uint8_t *packs[],
+                           size_t lengths[], int status[], int count);
 
 int getBasicIDType(ODID_BasicID_encoded *inEncoded, enum ODID_idtype *idType);
 int getAuthPageNum(ODID_Auth_encoded *inEncoded, int *pageNum);
 ODID_messagetype_t decodeMessageType(uint8_t byte);
 ODID_messagetype_t decodeOpenDroneID(ODID_UAS_Data *uas_data, uint8_t *msg_data);
 
+// Accessors that read individual fields directly from the encoded data,
+// without decoding the full message into the data structures
+ODID_messagetype_t odid_view_type(const ODID_Message_encoded *msg);
+int odid_view_uasid(const ODID_Message_encoded *msg, char *uasId);
+int odid_view_lat(const ODID_Message_encoded *msg, double *lat);
+int odid_view_lon(const ODID_Message_encoded *msg, double *lon);
+int odid_view_altitude_geo(const ODID_Message_encoded *msg, float *alt);
+int odid_view_velocity(const ODID_Message_encoded *msg, float *speed, float *direction);
+int odid_view_timestamp(const ODID_Message_encoded *msg, float *timestamp);
+int odid_view_operator_id(const ODID_Message_encoded *msg, char *operatorId);
+const ODID_Message_encoded *odid_view_pack_find(const ODID_MessagePack_encoded *pack,
+                                                size_t buflen, ODID_messagetype_t type,
+                                                int start);
+uint32_t odid_view_fingerprint(const uint8_t *data, size_t len);
+
 // Helper Functions
 ODID_Horizontal_accuracy_t createEnumHorizontalAccuracy(float Accuracy);
 ODID_Vertical_accuracy_t createEnumVerticalAccuracy(float Accuracy);
@@ -682,6 +730,21 @@ void drone_export_gps_data(ODID_UAS_Data *UAS_Data, char *buf, size_t buf_size);
  */
 int odid_message_build_pack(ODID_UAS_Data *UAS_Data, void *pack, size_t buflen);
 
+/**
+ * odid_message_build_pack_cached - like odid_message_build_pack, but only
+ * encodes the messages that have changed since the previous call with @cache
+ * @cache: message pack cache, initialized with odid_initPackCache
+ * @UAS_Data: general drone status information. Can be NULL if the data
+ *            is updated via the odid_packCacheSet*() functions instead
+ * @pack: buffer space to write to
+ * @buflen: maximum length of buffer space
+ *
+ * Returns length on success, < 0 on failure. @buf only contains a valid message
+ * if the return code is >0
+ */
+int odid_message_build_pack_cached(ODID_PackCache *cache, ODID_UAS_Data *UAS_Data,
+                                   void *pack, size_t buflen);
+
 /* odid_wifi_build_nan_sync_beacon_frame - creates a NAN sync beacon frame
  * that shall be send just before the NAN action frame.
  * @mac: mac address of the wifi adapter where the NAN frame will be sent
@@ -706,6 +769,17 @@ int odid_wifi_build_message_pack_nan_action_frame(ODID_UAS_Data *UAS_Data, char
                                                   uint8_t send_counter,
                                                   uint8_t *buf, size_t buf_size);
 
+/* odid_wifi_build_nan_action_frame_from_pack - like
+ * odid_wifi_build_message_pack_nan_action_frame, but with a message pack that
+ * is already encoded, e.g. by encodePackCache
+ * @pack: encoded message pack, with 1 to ODID_PACK_MAX_MESSAGES messages
+ *
+ * Returns the packet length on success, or < 0 on error.
+ */
+int odid_wifi_build_nan_action_frame_from_pack(const ODID_MessagePack_encoded *pack, char *mac,
+                                               uint8_t send_counter,
+                                               uint8_t *buf, size_t buf_size);
+
 /* odid_wifi_build_message_pack_beacon_frame - creates a message pack
  * with each type of message from the drone information into an Beacon frame.
  * @UAS_Data: general drone status information
@@ -724,6 +798,18 @@ int odid_wifi_build_message_pack_beacon_frame(ODID_UAS_Data *UAS_Data, char *mac
                                               uint16_t interval_tu, uint8_t send_counter,
                                               uint8_t *buf, size_t buf_size);
 
+/* odid_wifi_build_beacon_frame_from_pack - like
+ * odid_wifi_build_message_pack_beacon_frame, but with a message pack that is
+ * already encoded, e.g. by encodePackCache
+ * @pack: encoded message pack, with 1 to ODID_PACK_MAX_MESSAGES messages
+ *
+ * Returns the packet length on success, or < 0 on error.
+ */
+int odid_wifi_build_beacon_frame_from_pack(const ODID_MessagePack_encoded *pack, char *mac,
+                                           const char *SSID, size_t SSID_len,
+                                           uint16_t interval_tu, uint8_t send_counter,
+                                           uint8_t *buf, size_t buf_size);
+
 /* odid_message_process_pack - decodes the messages from the odid message pack
  * @UAS_Data: general drone status information
  * @pack: buffer space to read from
@@ -745,6 +831,35 @@ int odid_message_process_pack(ODID_UAS_Data *UAS_Data, uint8_t *pack, size_t buf
 int odid_wifi_receive_message_pack_nan_action_frame(ODID_UAS_Data *UAS_Data,
                                                     char *mac, uint8_t *buf, size_t buf_size);
 
+/* odid_wifi_receive_beacon_frame - processes a received Wi-Fi Beacon frame
+ * carrying a message pack in the ASD-STAN vendor specific information element,
+ * or in the Parrot one.
+ * The information elements are walked once, bounded by @buf_size, and the
+ * message pack is decoded directly from @buf
+ * @UAS_Data: general drone status information
+ * @mac: filled with the source address of the frame
+ * @buf: pointer to buffer space where the beacon frame is stored,
+ *       starting with the IEEE 802.11 management header
+ * @buf_size: maximum size of the buffer
+ *
+ * Returns 0 on success, or < 0 on error. Will fill 6 bytes into @mac.
+ */
+int odid_wifi_receive_beacon_frame(ODID_UAS_Data *UAS_Data,
+                                   char *mac, uint8_t *buf, size_t buf_size);
+
+/* odid_wifi_receive_frame - processes a received IEEE 802.11 management frame.
+ * Beacon frames are passed to odid_wifi_receive_beacon_frame and action frames
+ * to odid_wifi_receive_message_pack_nan_action_frame
+ * @UAS_Data: general drone status information
+ * @mac: filled with the source address of the frame
+ * @buf: pointer to buffer space where the frame is stored
+ * @buf_size: maximum size of the buffer
+ *
+ * Returns 0 on success, or < 0 on error or if the frame contains no ODID data.
+ * Will fill 6 bytes into @mac.
+ */
+int odid_wifi_receive_frame(ODID_UAS_Data *UAS_Data, char *mac, uint8_t *buf, size_t buf_size);
+
 #ifndef ODID_DISABLE_PRINTF
 void printByteArray(uint8_t *byteArray, uint16_t asize, int spaced);
 void printBasicID_data(ODID_BasicID_data *BasicID);
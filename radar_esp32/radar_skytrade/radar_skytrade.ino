@@ -20,11 +20,17 @@
 #include <esp_event_loop.h>
 #include <nvs_flash.h>
 #include "opendroneid.h"
+#include "odid_track.h"
+#include "odid_rxlog.h"
+#include "odid_detection.h"
 
 
 #define WIFI_SCAN          1
+#define BINARY_OUTPUT      0   // Binary detection records instead of JSON, see tools/det2json
 #define ID_SIZE     (ODID_ID_SIZE + 1)
-#define MAX_UAVS           8
+#define MAX_UAVS          32
+#define UAV_TIMEOUT   300000L
+#define RX_LOG_SIZE    16384
 #define OP_DISPLAY_LIMIT  16
 
 
@@ -43,7 +49,11 @@ struct id_data {int       flag;
 static void               print_json(int,int,struct id_data *);
 static esp_err_t          event_handler(void *,system_event_t *);
 static void               callback(void *,wifi_promiscuous_pkt_type_t);
+static void               log_task(void *);
+static void               process_frame(ODID_RxFrame *);
 static struct id_data    *next_uav(uint8_t *);
+static void               release_uav(struct id_data *);
+static void               uav_expired(void *,int,const ODID_Track *);
 static void               parse_odid(struct id_data *,ODID_UAS_Data *);
                         
 static void               dump_frame(uint8_t *,int);
@@ -52,12 +62,21 @@ static char              *format_op_id(char *);
 
 static double             base_lat_d = 0.0, base_long_d = 0.0, m_deg_lat = 110000.0, m_deg_long = 110000.0;
 
-volatile char             ssid[10];
-volatile unsigned int     callback_counter = 0, french_wifi = 0, odid_wifi = 0, odid_ble = 0;
+volatile unsigned int     callback_counter = 0, odid_wifi = 0, odid_ble = 0;
 volatile struct id_data   uavs[MAX_UAVS + 1];
 
+// uavs[] is indexed like the tracks. The table is updated from log_task() and from loop().
+static ODID_TrackTable    track_table;
+static ODID_Track         tracks[MAX_UAVS];
+static uint16_t           track_index[4 * MAX_UAVS];
+static portMUX_TYPE       track_mux = portMUX_INITIALIZER_UNLOCKED;
+
 volatile ODID_UAS_Data    UAS_data;
 
+// Frames received by callback(), waiting for log_task().
+static ODID_RxLog         rx_log;
+static uint8_t            rx_log_buf[RX_LOG_SIZE] __attribute__((aligned(ODID_RXLOG_ALIGN)));
+
 //
 
 static const char        *title = "RID Scanner", *build_date = __DATE__,
@@ -79,9 +98,12 @@ void setup() {
 
   memset((void *) &UAS_data,0,sizeof(ODID_UAS_Data));
   memset((void *) uavs,0,(MAX_UAVS + 1) * sizeof(struct id_data));
-  memset((void *) ssid,0,10);
   strcpy((char *) uavs[MAX_UAVS].op_id,"NONE");
 
+  odid_initTrackTable(&track_table,tracks,MAX_UAVS,track_index,2 * MAX_UAVS,
+                      UAV_TIMEOUT,uav_expired,NULL);
+  odid_initRxLog(&rx_log,rx_log_buf,RX_LOG_SIZE);
+
   //
 
   delay(100);
@@ -98,6 +120,8 @@ void setup() {
 
 #if WIFI_SCAN
 
+  xTaskCreatePinnedToCore(log_task,"odid_log",8192,NULL,tskIDLE_PRIORITY + 1,NULL,1);
+
   wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
   esp_wifi_init(&cfg);
   esp_wifi_set_storage(WIFI_STORAGE_RAM);
@@ -111,11 +135,6 @@ void setup() {
 #endif
 
 
-#if MAX_UAVS != 8
-#warning "Align MAX_UAVS and colour assignments."
-#endif
-
-
 #if 0
 
   const char *id[3] = {"OP-12345678901234567890", "GBR-OP-123456789012", "GBR-OP-12345678901234567890"};
@@ -154,19 +173,17 @@ void loop() {
   msecs = millis();
   secs  = msecs / 1000;
 
-  for (i = 0; i < MAX_UAVS; ++i) {
-
-    if ((uavs[i].last_seen)&&
-        ((msecs - uavs[i].last_seen) > 300000L)) {
+  portENTER_CRITICAL(&track_mux);
+  odid_trackExpire(&track_table,msecs);
+  portEXIT_CRITICAL(&track_mux);
 
-      uavs[i].last_seen = 0;
-      uavs[i].mac[0]    = 0;
-
-    }
+  for (i = 0; i < MAX_UAVS; ++i) {
 
     if (uavs[i].flag) {
 
+#if !BINARY_OUTPUT
       print_json(i,secs,(id_data *) &uavs[i]);
+#endif
 
       if ((uavs[i].lat_d)&&(uavs[i].base_lat_d)) 
             // Imprimir a variável lat_d
@@ -190,7 +207,9 @@ void loop() {
     }
   if ((msecs - last_json) > 1500000UL) { // Keep the serial link active
 
+#if !BINARY_OUTPUT
       print_json(MAX_UAVS,msecs / 1000,(id_data *) &uavs[MAX_UAVS]); 
+#endif
 
       last_json = msecs;
   }
@@ -208,131 +227,122 @@ esp_err_t event_handler(void *ctx, system_event_t *event) {
 }
 
 /*
- * This function handles WiFi packets.
+ * This function handles WiFi packets. It runs in the WiFi task, so it only
+ * copies the frame into rx_log, log_task() does the rest.
  */
 
 void callback(void* buffer,wifi_promiscuous_pkt_type_t type) {
 
-  int                     length, typ, len, i, j, offset;
-  char                    ssid_tmp[10], *a;
-  uint8_t                *packet_u8, *payload, *val;
+  uint8_t                *payload;
   wifi_promiscuous_pkt_t *packet;
-  struct id_data         *UAV = NULL;
-  static uint8_t          mac[6], nan_dest[6] = {0x51, 0x6f, 0x9a, 0x01, 0x00, 0x00};
-
-  a = NULL;
-  
-//
 
   ++callback_counter;
 
-  memset(ssid_tmp,0,10);
+  packet  = (wifi_promiscuous_pkt_t *) buffer;
+  payload = packet->payload;
 
-  packet    = (wifi_promiscuous_pkt_t *) buffer;
-  packet_u8 = (uint8_t *) buffer;
-  
-  payload   = packet->payload;
-  length    = packet->rx_ctrl.sig_len;
-  offset    = 36;
-  
+  // Beacons and action frames (NAN).
 
-    int rssi = packet->rx_ctrl.rssi;      // Intensidade do sinal
+  if ((type == WIFI_PKT_MGMT)&&((payload[0] == 0x80)||(payload[0] == 0xd0))) {
 
-    // Imprime informações básicas do pacote
-    Serial.print("Pacote capturado: Comprimento = ");
-    Serial.print(length);
-    Serial.print(" bytes, RSSI = ");
-    Serial.println(rssi);
+    odid_rxLogPush(&rx_log,payload,(uint16_t) packet->rx_ctrl.sig_len,
+                   (int8_t) packet->rx_ctrl.rssi,(uint8_t) packet->rx_ctrl.channel,millis());
+  }
 
-// Imprime mais bytes do payload para análise detalhada
-Serial.print("Payload: ");
-for (int i = 0; i < length; i++) {  // Ajuste 'length' para limitar a saída se necessário
-    Serial.printf("%02X ", payload[i]);
-    if ((i+1) % 16 == 0) Serial.println();
+  return;
 }
-Serial.println();
-
 
-  UAV = next_uav(&payload[10]);
-
-  memcpy(UAV->mac,&payload[10],6);
+/*
+ * Decodes the frames from rx_log, at a lower priority than the WiFi task.
+ */
 
-  UAV->rssi      = packet->rx_ctrl.rssi;
-  UAV->last_seen = millis();
+void log_task(void *param) {
 
-//
+  ODID_RxFrame *frame;
+  uint32_t      last_stats = 0, msecs;
 
-  if (memcmp(nan_dest,&payload[4],6) == 0) {
+  for (;;) {
 
-    // dump_frame(payload,length);
+    while ((frame = odid_rxLogPeek(&rx_log))) {
 
-    if (odid_wifi_receive_message_pack_nan_action_frame((ODID_UAS_Data *) &UAS_data,(char *) mac,payload,length) == 0) {
+      process_frame(frame);
+      odid_rxLogPop(&rx_log);
+    }
 
-      ++odid_wifi;
+    if (((msecs = millis()) - last_stats) > 60000UL) {
 
-      parse_odid(UAV,(ODID_UAS_Data *) &UAS_data);
+      Serial.printf("{ \"frames\": %u, \"dropped\": %u, \"max queued\": %u }\r\n",
+                    (unsigned) rx_log.Frames,(unsigned) rx_log.Dropped,(unsigned) rx_log.HighWater);
+      last_stats = msecs;
     }
 
-  } else if (payload[0] == 0x80) { // beacon
+    vTaskDelay(1);
+  }
+}
 
-    offset = 36;
+/*
+ *
+ */
 
+void process_frame(ODID_RxFrame *frame) {
 
-    while (offset < length) {
+  uint8_t         mac[6];
+  struct id_data *UAV;
+#if BINARY_OUTPUT
+  ODID_Detection  det;
+  uint8_t         record[ODID_DETECTION_SIZE];
+#else
+  char            text[256];
+#endif
 
-      typ =  payload[offset];
-      len =  payload[offset + 1];
-      val = &payload[offset + 2];
+  if (odid_rxFrameDecode((ODID_UAS_Data *) &UAS_data,mac,odid_rxFrameData(frame),frame->Length) != ODID_SUCCESS) {
 
-      
+    return;
+  }
 
-       if ((typ      == 0xdd)&&
-                 (((val[0] == 0x90)&&(val[1] == 0x3a)&&(val[2] == 0xe6))|| // Parrot
-                  ((val[0] == 0xfa)&&(val[1] == 0x0b)&&(val[2] == 0xbc)))) { // ODID
+  ++odid_wifi;
 
-        ++odid_wifi;
-       
-        if ((j = offset + 7) < length) {
+#if BINARY_OUTPUT
 
-          memset((void *) &UAS_data,0,sizeof(UAS_data));
-          
-          odid_message_process_pack((ODID_UAS_Data *) &UAS_data,&payload[j],length - j);
-          Serial.print(odid_message_process_pack((ODID_UAS_Data *) &UAS_data,&payload[j],length - j));
-          Serial.println();
-          Serial.println();
-          Serial.println();
-          Serial.println();
-          parse_odid(UAV,(ODID_UAS_Data *) &UAS_data);
-        }
+  // 64 bytes instead of about 200 characters of JSON per frame.
 
-      } else if ((typ == 0)&&(!ssid_tmp[0])) {
+  det.Timestamp = frame->Timestamp;
+  det.RSSI      = frame->RSSI;
+  det.Channel   = frame->Channel;
+  det.Valid     = ODID_DETECTION_VALID_RSSI | ODID_DETECTION_VALID_CHANNEL;
+  memcpy(det.MAC,mac,6);
+  odid_detectionFromUasData(&det,(ODID_UAS_Data *) &UAS_data);
+  encodeDetectionRecord(record,&det);
+  Serial.write(record,sizeof(record));
 
-        for (i = 0; (i < 8)&&(i < len); ++i) {
+#else
 
-          ssid_tmp[i] = val[i];
-        }
-      }
+  odid_rxFrameFormat(text,sizeof(text),frame,mac,(ODID_UAS_Data *) &UAS_data);
+  Serial.print(text);
+  Serial.print("\r\n");
 
-      offset += len + 2;
-    }
+#endif
 
-    if (ssid_tmp[0]) {
+  // Only frames with ODID data create or refresh a track.
 
-      strncpy((char *) ssid,ssid_tmp,8);
-    }
-#if 0
-  } else if (a = (char *) memchr(payload,'G',length)) {
+  UAV = next_uav(mac);
 
-    if (memcmp(a,"GBR-OP-",7) == 0) {
+  memcpy(UAV->mac,mac,6);
 
-      dump_frame(payload,length);     
-    }
-#endif
-  }
+  UAV->rssi      = frame->RSSI;
+  UAV->last_seen = frame->Timestamp;
+
+  parse_odid(UAV,(ODID_UAS_Data *) &UAS_data);
 
   if ((!UAV->op_id[0])&&(!UAV->lat_d)) {
 
-    UAV->mac[0] = 0;
+    release_uav(UAV);
+
+  } else if (UAV->uav_id[0]) {
+
+    portENTER_CRITICAL(&track_mux);
+    odid_trackSetID(&track_table,UAV - (struct id_data *) uavs,UAV->uav_id);
+    portEXIT_CRITICAL(&track_mux);
   }
 
   return;
@@ -344,35 +354,41 @@ Serial.println();
 
  struct id_data *next_uav(uint8_t *mac) {
 
-  int             i;
-  struct id_data *UAV = NULL;
+  int i;
 
-  for (i = 0; i < MAX_UAVS; ++i) {
+  // Finds the drone by MAC address, a new drone replaces the least recently seen one.
 
-    if (memcmp((void *) uavs[i].mac,mac,6) == 0) {
+  portENTER_CRITICAL(&track_mux);
+  i = odid_trackUpdate(&track_table,mac,millis());
+  portEXIT_CRITICAL(&track_mux);
 
-      UAV = (struct id_data *) &uavs[i];
-    }
-  }
+  return (struct id_data *) &uavs[i];
+}
 
-  if (!UAV) {
+/*
+ *
+ */
 
-    for (i = 0; i < MAX_UAVS; ++i) {
+void release_uav(struct id_data *UAV) {
 
-      if (!uavs[i].mac[0]) {
+  portENTER_CRITICAL(&track_mux);
+  odid_trackRemove(&track_table,UAV - (struct id_data *) uavs);
+  portEXIT_CRITICAL(&track_mux);
 
-        UAV = (struct id_data *) &uavs[i];
-        break;
-      }
-    }
-  }
+  memset((void *) UAV,0,sizeof(struct id_data));
 
-  if (!UAV) {
+  return;
+}
 
-     UAV = (struct id_data *) &uavs[MAX_UAVS - 1];
-  }
+/*
+ * Called by the track table with track_mux held.
+ */
+
+void uav_expired(void *ctx,int index,const ODID_Track *track) {
 
-  return UAV;
+  memset((void *) &uavs[index],0,sizeof(struct id_data));
+
+  return;
 }
 
 
@@ -30,10 +30,34 @@ const char* payload_hex =
     "31 32 6B 38 00 00 00 00 AC 01 00 78 56 AD BA";
 
 // Função para converter string hexadecimal em array de bytes
-void hexStringToByteArray(const char* hexString, uint8_t* byteArray, int byteArraySize) {
-    for (int i = 0; i < byteArraySize; i++) {
-        sscanf(hexString + 2 * i, "%2hhx", &byteArray[i]);
+// Com uma tabela em vez de sscanf, como hex_decode() em digital_drone/utils.c. Ignora os espaços
+// entre os bytes e retorna o número de bytes convertidos
+static uint8_t hexDigitValue(char c) {
+    static uint8_t values[256];
+    if (!values['0']) {
+        for (int i = 0; i < 10; i++)
+            values['0' + i] = 0x10 | i;
+        for (int i = 0; i < 6; i++)
+            values['A' + i] = values['a' + i] = 0x10 | (10 + i);
+    }
+    return values[(unsigned char) c];
+}
+
+int hexStringToByteArray(const char* hexString, uint8_t* byteArray, int byteArraySize) {
+    int count = 0;
+    while (*hexString && count < byteArraySize) {
+        if (*hexString == ' ') {
+            hexString++;
+            continue;
+        }
+        uint8_t high = hexDigitValue(hexString[0]);
+        uint8_t low = hexDigitValue(hexString[1]);
+        if (!(high & low & 0x10))
+            break;
+        byteArray[count++] = (high & 0x0F) << 4 | (low & 0x0F);
+        hexString += 2;
     }
+    return count;
 }
 
 // Função para processar o payload e exibir os dados decodificados
@@ -41,7 +65,7 @@ void processPayload() {
     int byteArraySize = strlen(payload_hex) / 3 + 1; // Cada byte ocupa 2 caracteres + 1 espaço
     uint8_t byteArray[byteArraySize];
     
-    hexStringToByteArray(payload_hex, byteArray, byteArraySize);
+    byteArraySize = hexStringToByteArray(payload_hex, byteArray, byteArraySize);
 
     // Inicializa a estrutura para armazenar os dados decodificados
     memset(&uasData, 0, sizeof(ODID_UAS_Data));